@@ -1,15 +1,81 @@
 #include "dxdiag.hpp"
 #include "yolo.hpp"
 #include "utils.hpp"
+#include "display.hpp"
+#include "quality_controller.hpp"
+#include "detection_cache.hpp"
+#include "detector_cascade.hpp"
+#include "alloc_tracker.hpp"
+#include <atomic>
+#include <csignal>
 #include <cstdlib>
+#include <future>
 
 cv::dnn::Net yolo_net;
+cv::dnn::Net cascade_net; // Small first-stage model, only loaded with --cascade
 std::vector<std::string> class_names_vec;
 
-int main()
+static std::atomic<bool> quit_requested{false};
+
+static void onSignal(int)
+{
+    quit_requested = true;
+}
+
+int main(int argc, char **argv)
 {
+    StartupTrace trace;
+
+    // --headless skips the preview window entirely, e.g. for services and remote sessions
+    // --latency-slo <ms> enables the adaptive quality controller with that detection latency target
+    // --max-input <size> sets the full-quality input size it recovers to (default 640)
+    // --classes a,b,c restricts detection to those class names
+    // --no-detection-cache always runs the network, even on screens seen before
+    // --cascade <model> runs that small model on every frame and yolo11l only where it is unsure
+    // --track-allocs counts heap and cv::Mat allocations per pipeline stage and logs them per frame
+    // --trace <seconds> records a timeline of the pipeline threads from startup; --trace-file sets
+    //   where it goes (agent_trace.json). Ctrl+Break records a 10 s trace at any time.
+    bool headless = false;
+    bool track_allocs = false;
+    bool use_detection_cache = true;
+    double latency_slo_ms = 0.0;
+    int max_input_size = YOLO_INPUT_WIDTH;
+    std::vector<std::string> wanted_classes;
+    std::string cascade_model_path;
+    double trace_seconds = 0.0;
+    std::string trace_path = "agent_trace.json";
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--latency-slo" && i + 1 < argc)
+            latency_slo_ms = std::atof(argv[++i]);
+        else if (arg == "--max-input" && i + 1 < argc)
+            max_input_size = std::atoi(argv[++i]);
+        else if (arg == "--classes" && i + 1 < argc)
+            wanted_classes = splitString(argv[++i], ',');
+        else if (arg == "--no-detection-cache")
+            use_detection_cache = false;
+        else if (arg == "--cascade" && i + 1 < argc)
+            cascade_model_path = (std::filesystem::current_path() / argv[++i]).generic_string();
+        else if (arg == "--track-allocs")
+            track_allocs = true;
+        else if (arg == "--trace" && i + 1 < argc)
+            trace_seconds = std::atof(argv[++i]);
+        else if (arg == "--trace-file" && i + 1 < argc)
+            trace_path = argv[++i];
+    }
+    if (track_allocs)
+        enableAllocTracking();
+    setTraceThreadName("main");
+    armTraceSignal(TRACE_DEFAULT_SECONDS, std::filesystem::path(trace_path).replace_extension().generic_string());
+    if (trace_seconds > 0.0)
+        startTracing(trace_seconds, trace_path);
+
     LOG("Starting continuous screen capture...");
-    LOG("Press Ctrl+C or ESC in the window to stop.");
+    LOG("Press Ctrl+C or ESC in the window to stop; send " << TRACE_SIGNAL_NAME << " for a " << TRACE_DEFAULT_SECONDS << " s trace.");
+    std::signal(SIGINT, onSignal);
 
     if (!setUpEnv())
         return -1;
@@ -21,27 +87,75 @@ int main()
 
     const std::string YOLO_MODEL_PATH = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
     const std::string CLASS_NAMES_PATH = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
-
-    // Create a resizable OpenCV window before the main loop
-    std::string windowName = "Live Feed DXGI";
-    cv::namedWindow(windowName, cv::WINDOW_NORMAL);
-    cv::setWindowProperty(windowName, cv::WND_PROP_ASPECT_RATIO, cv::WINDOW_KEEPRATIO);
-    cv::resizeWindow(windowName, 1280, 720);
+    const std::string HARDWARE_CACHE_PATH = (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string();
 
     cv::ocl::setUseOpenCL(true);
 
-    HARDWARE_INFO hw_info;
+    if (!loadClassNames(CLASS_NAMES_PATH, class_names_vec) || class_names_vec.empty())
+    {
+        LOG_ERR("Failed to load class names from " << CLASS_NAMES_PATH);
+        return -1;
+    }
+
+    // The hardware probe, model load and warm-up run in the background while DXGI initializes
+    auto probeHardware = [&]()
+    {
+        HARDWARE_INFO info;
+        detectSystemArchCached(info, HARDWARE_CACHE_PATH);
+        trace.mark("hardware probe done");
+        return info;
+    };
+    std::shared_future<HARDWARE_INFO> hw_future = std::async(std::launch::async, probeHardware).share();
 
-    detectSystemArch(hw_info);
-    // Log detected hardware
-    LOG("Hardware Detection Summary:");
-    LOG("CUDA Available: " << (hw_info.has_cuda ? "Yes" : "No"));
-    LOG("OpenCL Available: " << (hw_info.has_opencl ? "Yes" : "No"));
-    LOG("AMD GPU: " << (hw_info.has_amd ? "Yes" : "No"));
-    LOG("Intel GPU: " << (hw_info.has_intel ? "Yes" : "No"));
-    LOG("NVIDIA GPU: " << (hw_info.has_nvidia ? "Yes" : "No"));
+    std::vector<int> supported_sizes;
+    std::vector<int> ladder_sizes;
+    if (latency_slo_ms > 0.0)
+    {
+        for (const QualityLevel &level : DEFAULT_QUALITY_LADDER)
+            ladder_sizes.push_back(level.input_size);
+    }
+    auto prepareNetwork = [&]()
+    {
+        if (!loadYoloNetwork(yolo_net, YOLO_MODEL_PATH))
+            return false;
+        trace.mark("model loaded");
+        configureYoloBackend(yolo_net, hw_future.get());
+        if (!warmUpYoloNetwork(yolo_net, class_names_vec))
+            return false;
+        trace.mark("warm-up inference done");
+        supported_sizes = prepareYoloInputSizes(yolo_net, ladder_sizes);
+        if (!cascade_model_path.empty())
+        {
+            if (!loadYoloNetwork(cascade_net, cascade_model_path))
+                return false;
+            configureYoloBackend(cascade_net, hw_future.get());
+            if (!warmUpYoloNetwork(cascade_net, class_names_vec))
+                return false;
+            trace.mark("cascade model ready");
+        }
+        return true;
+    };
+    std::future<bool> network_future = std::async(std::launch::async, prepareNetwork);
+
+    // The preview window lives on its own thread so repaints never stall capture or inference;
+    // creating it now also overlaps window creation with the rest of startup
+    std::unique_ptr<DisplayWorker> display;
+    if (!headless)
+    {
+        display = std::make_unique<DisplayWorker>(class_names_vec);
+        display->addWindow("Live Feed DXGI");
+        display->start();
+    }
+
+    std::unique_ptr<QualityController> quality;
+    DetectionCache detection_cache;
+    FrameAllocMeter alloc_meter;
+    std::unique_ptr<DetectorCascade> cascade;
+    YoloSettings yolo_settings;
+    HARDWARE_INFO hw_info;
+    bool network_ready = false;
 
-    while (!quit)
+    while (!quit && !quit_requested)
     {
         DXGIContext ctx;
         LOG("Attempting to initialize DXGI...");
@@ -52,11 +166,42 @@ int main()
             continue;
         }
         LOG("DXGI Initialized successfully.");
+        trace.mark("DXGI ready");
 
-        // Re-initialize YOLO network after DXGI is ready
-        // Clear previous class names before loading new ones to avoid accumulation if setup is retried.
-        class_names_vec.clear();
-        if (!setupYoloNetwork(yolo_net, YOLO_MODEL_PATH, CLASS_NAMES_PATH, class_names_vec, hw_info))
+        if (!network_ready)
+        {
+            if (network_future.valid())
+            {
+                hw_info = hw_future.get();
+                // Log detected hardware
+                LOG("Hardware Detection Summary:");
+                LOG("CUDA Available: " << (hw_info.has_cuda ? "Yes" : "No"));
+                LOG("OpenCL Available: " << (hw_info.has_opencl ? "Yes" : "No"));
+                LOG("AMD GPU: " << (hw_info.has_amd ? "Yes" : "No"));
+                LOG("Intel GPU: " << (hw_info.has_intel ? "Yes" : "No"));
+                LOG("NVIDIA GPU: " << (hw_info.has_nvidia ? "Yes" : "No"));
+                network_ready = network_future.get();
+            }
+            else
+            {
+                // Re-initialize the YOLO network after a processing error
+                // Clear previous class names before loading new ones to avoid accumulation if setup is retried.
+                class_names_vec.clear();
+                network_ready = setupYoloNetwork(yolo_net, YOLO_MODEL_PATH, CLASS_NAMES_PATH, class_names_vec, hw_info);
+                if (network_ready)
+                    supported_sizes = prepareYoloInputSizes(yolo_net, ladder_sizes);
+                if (network_ready && !cascade_model_path.empty())
+                {
+                    network_ready = loadYoloNetwork(cascade_net, cascade_model_path);
+                    if (network_ready)
+                    {
+                        configureYoloBackend(cascade_net, hw_info);
+                        network_ready = warmUpYoloNetwork(cascade_net, class_names_vec);
+                    }
+                }
+            }
+        }
+        if (!network_ready)
         {
             LOG_ERR("Failed to setup YOLO network. Cleaning up DXGI and retrying.");
             CleanupDXGI(ctx); // Cleanup DXGI if YOLO setup fails
@@ -64,16 +209,51 @@ int main()
             continue;
         }
 
+        if (!wanted_classes.empty() && !buildClassFilter(class_names_vec, wanted_classes, yolo_settings.class_filter))
+        {
+            LOG_ERR("Invalid --classes list; detecting all classes instead.");
+            yolo_settings.class_filter.clear();
+        }
+
+        // Recreated per session: after a network re-init its tracking state no longer applies
+        if (!cascade_model_path.empty())
+            cascade = std::make_unique<DetectorCascade>(cascade_net, yolo_net);
+
+        if (latency_slo_ms > 0.0)
+        {
+            std::vector<QualityLevel> ladder = filterQualityLadder(DEFAULT_QUALITY_LADDER, supported_sizes);
+            QualityControllerConfig config;
+            config.latency_slo_ms = latency_slo_ms;
+            quality = std::make_unique<QualityController>(ladder, config, max_input_size);
+            quality->applyTo(yolo_settings);
+            LOG("Adaptive quality enabled: SLO " << latency_slo_ms << " ms, starting at input " << yolo_settings.input_width);
+        }
+
         int width = 0, height = 0;
         std::vector<BYTE> pixelBuffer;
         bool duplication_active = true;
         int consecutive_failures = 0;
         const int MAX_CONSECUTIVE_FAILURES = 5;
 
+        std::vector<Detection> detections;
+
         while (duplication_active && !quit)
         {
+            if (quit_requested || (display && display->quitRequested()))
+            {
+                duplication_active = false;
+                quit = true;
+                break;
+            }
+
             auto startTime = std::chrono::high_resolution_clock::now();
-            if (!GetScreenPixelsDXGI(ctx.pDesktopDupl, ctx.pDevice, ctx.pImmediateContext, width, height, pixelBuffer))
+            bool captured;
+            {
+                AllocStageScope stage(ALLOC_STAGE_CAPTURE);
+                TRACE_SCOPE_FRAME("capture", frameCount + 1);
+                captured = GetScreenPixelsDXGI(ctx.pDesktopDupl, ctx.pDevice, ctx.pImmediateContext, width, height, pixelBuffer);
+            }
+            if (!captured)
             {
                 DXGI_OUTDUPL_FRAME_INFO frameInfoCheck;
                 IDXGIResource *resourceCheck = nullptr;
@@ -82,7 +262,7 @@ int main()
 
                 if (checkHr == DXGI_ERROR_ACCESS_LOST)
                 {
-                    LOG_ERR("Desktop Duplication access lost. Re-initializing DXGI and YOLO setup...");
+                    LOG_ERR("Desktop Duplication access lost. Re-initializing DXGI...");
                     duplication_active = false;
                     break;
                 }
@@ -90,7 +270,7 @@ int main()
                 consecutive_failures++;
                 if (consecutive_failures >= MAX_CONSECUTIVE_FAILURES)
                 {
-                    LOG_ERR("Too many consecutive GetScreenPixelsDXGI failures. Re-initializing DXGI and YOLO setup...");
+                    LOG_ERR("Too many consecutive GetScreenPixelsDXGI failures. Re-initializing DXGI...");
                     duplication_active = false;
                     break;
                 }
@@ -107,64 +287,88 @@ int main()
                 frameCount++;
                 cv::Mat frame(height, width, CV_8UC4, pixelBuffer.data());
                 cv::Mat frame_bgr;
-                cv::cvtColor(frame, frame_bgr, cv::COLOR_BGRA2BGR);
+                {
+                    AllocStageScope stage(ALLOC_STAGE_CAPTURE);
+                    TRACE_SCOPE_FRAME("convert", frameCount);
+                    cv::cvtColor(frame, frame_bgr, cv::COLOR_BGRA2BGR);
+                }
 
-                // Process frame with YOLOv11
+                // Process frame with YOLOv11; under load the quality controller may skip frames,
+                // in which case the previous detections are shown again
                 try
                 {
-                    processFrameWithYOLO(frame_bgr, yolo_net, class_names_vec);
+                    if (!quality || quality->shouldDetect(frameCount))
+                    {
+                        TRACE_SCOPE_FRAME("detect", frameCount);
+                        // A revisited screen reuses its detections; only real forward passes feed the controller
+                        if (!use_detection_cache || !detection_cache.lookup(frame_bgr, yolo_settings, detections))
+                        {
+                            auto detectStart = std::chrono::high_resolution_clock::now();
+                            if (cascade)
+                                cascade->detect(frame_bgr, detections, yolo_settings);
+                            else
+                                detectObjectsWithYOLO(frame_bgr, yolo_net, detections, yolo_settings);
+                            if (use_detection_cache)
+                                detection_cache.insert(yolo_settings, detections);
+                            if (quality)
+                            {
+                                quality->recordLatency(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - detectStart).count());
+                                quality->applyTo(yolo_settings);
+                            }
+                        }
+                    }
                 }
                 catch (const cv::Exception &e)
                 {
                     LOG_ERR("OpenCV error during YOLO processing: " << e.what());
                     LOG_ERR("Attempting to re-initialize DXGI and YOLO due to OpenCV error during processing.");
                     duplication_active = false; // Force re-initialization of DXGI and YOLO
+                    network_ready = false;
                     break;
                 }
                 catch (const std::exception &e)
                 {
                     LOG_ERR("Error during YOLO processing: " << e.what());
                     duplication_active = false; // Force re-initialization for other std exceptions too
+                    network_ready = false;
                     break;
                 }
 
-                if (cv::getWindowProperty(windowName, cv::WND_PROP_VISIBLE) >= 1)
-                {
-                    cv::imshow(windowName, frame_bgr);
-                }
-
-                int key = cv::waitKey(1);
-                // Check for ESC key
-                if (key == 27)
+                // frame_bgr is reallocated every iteration, so the display thread can keep this buffer
+                if (display)
                 {
-                    duplication_active = false;
-                    quit = true;
-                }
-                // Check if window was closed
-                if (cv::getWindowProperty(windowName, cv::WND_PROP_VISIBLE) < 1)
-                {
-                    duplication_active = false;
-                    quit = true;
+                    display->submit(0, frame_bgr, detections, frameCount);
                 }
+                trace.firstFrame();
+                if (track_allocs)
+                    alloc_meter.addFrames();
 
                 // Maintain target frame rate
                 auto endTime = std::chrono::high_resolution_clock::now();
                 auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
                 if (elapsedTime < frameDelayMs)
                 {
+                    TRACE_SCOPE_FRAME("frame pacing", frameCount);
                     std::this_thread::sleep_for(std::chrono::milliseconds(frameDelayMs - elapsedTime));
                 }
 
                 if (frameCount % 100 == 0)
                 {
                     LOG("Processed " << frameCount << " frames via DXGI.");
+                    if (use_detection_cache)
+                        LOG("Detection cache: " << detection_cache.hits() << " hits, " << detection_cache.misses() << " misses ("
+                                                << detection_cache.hitRate() * 100.0 << "% hit rate)");
+                    if (cascade)
+                        LOG("Cascade: " << cascade->stats().escalated_boxes << " boxes escalated, " << cascade->stats().large_crop_passes
+                                        << " large crop passes, " << cascade->stats().large_full_passes << " large full-frame passes");
+                    if (track_allocs)
+                        LOG(alloc_meter.report());
                 }
             }
         }
         LOG("Cleaning up DXGI context for this session.");
         CleanupDXGI(ctx);
-        // yolo_net = cv::dnn::Net(); // Optionally clear the network object if it's large and reloaded.
-        // setupYoloNetwork will reassign it anyway.
+        // The network is kept across DXGI sessions; setupYoloNetwork only runs again after a YOLO error.
         if (!quit && !duplication_active) // If exited inner loop due to error, not user quit
         {
             LOG_ERR("DXGI session ended or failed. Attempting to re-initialize in 2 seconds...");
@@ -172,6 +376,10 @@ int main()
         }
     }
     LOG("Screen capture stopped.");
-    cv::destroyAllWindows(); // Ensure OpenCV windows are closed
+    if (display)
+    {
+        display->stop(); // Closes the preview window
+    }
+    stopTracing();
     return 0;
 }
\ No newline at end of file
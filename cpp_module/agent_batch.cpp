@@ -0,0 +1,629 @@
+#include "yolo.hpp"
+#include "remote_inference.hpp"
+#include "detector_pool.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <set>
+#include <thread>
+
+// Annotates a directory (or glob) of saved screenshots offline. Decoder threads read and
+// preprocess images while the main thread runs batched inference, so decode, preprocessing and
+// the forward pass overlap. Results are appended one image at a time; rerunning with the same
+// output skips images it already contains, so an interrupted run resumes where it stopped.
+// With --remote, inference runs on agent_worker processes instead, falling back to the local
+// model while none is reachable; "image" ships the files as stored, "blob" preprocessed tensors.
+// --replicas N runs N copies of the network side by side instead of batching on one; on CPUs
+// with many cores that usually scales better than more intra-op threads (see bench_replicas).
+//   agent_batch --input screenshots/ [--output detections.jsonl] [--format jsonl|csv] [--batch 8]
+//               [--decoders N] [--recursive] [--model PATH] [--names PATH] [--input-size 640]
+//               [--conf 0.5] [--classes a,b,c] [--remote host:port,...] [--remote-format image|blob]
+//               [--replicas N] [--threads-per-replica N]
+
+const int BATCH_DEFAULT_SIZE = 8;
+const int BATCH_PROGRESS_INTERVAL_S = 5;
+
+struct DecodedImage
+{
+    std::string path;
+    cv::Size size;
+    cv::Mat blob; // Empty if the image could not be read
+    std::vector<uchar> encoded; // The file as stored, instead of blob for --remote-format image
+};
+
+// Bounded hand-off from the decoder threads to the inference thread
+class DecodedQueue
+{
+public:
+    explicit DecodedQueue(size_t capacity) : capacity_(capacity) {}
+
+    void push(DecodedImage item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&]
+                       { return items_.size() < capacity_; });
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+    }
+
+    // Blocks until max_items are queued or the producers are done; empty only at the end
+    std::vector<DecodedImage> popBatch(size_t max_items)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&]
+                        { return items_.size() >= max_items || closed_; });
+        std::vector<DecodedImage> batch;
+        while (!items_.empty() && batch.size() < max_items)
+        {
+            batch.push_back(std::move(items_.front()));
+            items_.pop_front();
+        }
+        not_full_.notify_all();
+        return batch;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    std::deque<DecodedImage> items_;
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+static void printUsage()
+{
+    LOG("Usage: agent_batch --input DIR|GLOB [--output PATH] [--format jsonl|csv] [--batch N] [--decoders N] [--recursive]");
+    LOG("                   [--model PATH] [--names PATH] [--input-size N] [--conf X] [--classes a,b,c]");
+    LOG("                   [--remote host:port[,host:port...]] [--remote-format image|blob] [--replicas N] [--threads-per-replica N]");
+}
+
+static std::vector<std::string> collectImages(const std::string &input, bool recursive)
+{
+    std::vector<std::string> images;
+    if (std::filesystem::is_directory(input))
+    {
+        auto add = [&](const std::filesystem::directory_entry &entry)
+        {
+            if (entry.is_regular_file() && cv::haveImageReader(entry.path().generic_string()))
+                images.push_back(entry.path().generic_string());
+        };
+        if (recursive)
+        {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(input))
+                add(entry);
+        }
+        else
+        {
+            for (const auto &entry : std::filesystem::directory_iterator(input))
+                add(entry);
+        }
+    }
+    else
+    {
+        std::vector<cv::String> matches;
+        cv::glob(input, matches, recursive);
+        for (const cv::String &match : matches)
+            images.push_back(std::filesystem::path(match).generic_string());
+    }
+    std::sort(images.begin(), images.end());
+    return images;
+}
+
+static std::string csvQuote(const std::string &text)
+{
+    std::string out = "\"";
+    for (char c : text)
+    {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// The path is the first field of every record in both formats. A CSV row also carries the
+// number of rows its image has (its detection count, or 1 for an image without detections).
+static bool parseRecordPath(const std::string &line, bool csv, std::string &out_path, int *out_rows = nullptr)
+{
+    out_path.clear();
+    size_t i;
+    if (csv)
+    {
+        if (line.empty() || line[0] != '"')
+            return false;
+        for (i = 1; i < line.size(); ++i)
+        {
+            if (line[i] == '"')
+            {
+                if (i + 1 < line.size() && line[i + 1] == '"')
+                {
+                    ++i;
+                }
+                else
+                {
+                    int width, height, detection_count;
+                    if (std::sscanf(line.c_str() + i + 1, ",%d,%d,%d,", &width, &height, &detection_count) != 3)
+                        return false;
+                    if (out_rows)
+                        *out_rows = std::max(1, detection_count);
+                    return true;
+                }
+            }
+            out_path += line[i];
+        }
+        return false;
+    }
+
+    const std::string prefix = "{\"path\": \"";
+    if (line.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    for (i = prefix.size(); i < line.size(); ++i)
+    {
+        if (line[i] == '\\' && i + 1 < line.size())
+        {
+            const char escaped = line[++i];
+            if (escaped == 'u' && i + 4 < line.size())
+            {
+                out_path += static_cast<char>(std::strtol(line.substr(i + 1, 4).c_str(), nullptr, 16));
+                i += 4;
+            }
+            else
+            {
+                out_path += escaped;
+            }
+        }
+        else if (line[i] == '"')
+        {
+            return true;
+        }
+        else
+        {
+            out_path += line[i];
+        }
+    }
+    return false;
+}
+
+// Collects the images already in the output. A record cut off by an interruption (no trailing
+// newline, or in CSV fewer rows than its image has) is removed from the file so the image is
+// processed again.
+static std::set<std::string> loadCompleted(const std::string &output_path, bool csv)
+{
+    std::set<std::string> completed;
+    std::ifstream ifs(output_path, std::ios::binary);
+    if (!ifs.is_open())
+        return completed;
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ifs.close();
+
+    size_t complete_bytes = content.rfind('\n');
+    complete_bytes = complete_bytes == std::string::npos ? 0 : complete_bytes + 1;
+
+    // Rows are appended in order, so only the last image can be short of rows
+    std::string line, path, group_path;
+    int group_rows = 0, group_expected = 0;
+    size_t group_start = 0;
+    for (size_t line_start = 0; line_start < complete_bytes;)
+    {
+        const size_t line_end = content.find('\n', line_start);
+        line = content.substr(line_start, line_end - line_start);
+        int rows = 1;
+        if (parseRecordPath(line, csv, path, &rows))
+        {
+            if (!csv || path != group_path || group_rows == group_expected)
+            {
+                group_path = path;
+                group_start = line_start;
+                group_rows = 0;
+                group_expected = rows;
+            }
+            if (++group_rows == group_expected)
+                completed.insert(path);
+        }
+        line_start = line_end + 1;
+    }
+    if (csv && group_rows < group_expected)
+        complete_bytes = group_start;
+
+    if (complete_bytes < content.size())
+    {
+        LOG("Dropping a partial record at the end of " << output_path);
+        std::filesystem::resize_file(output_path, complete_bytes);
+    }
+    return completed;
+}
+
+static void appendRecord(std::string &out, const DecodedImage &image, const std::vector<Detection> &detections,
+                         const std::vector<std::string> &class_names, bool csv)
+{
+    auto className = [&](int class_id)
+    {
+        return class_id >= 0 && class_id < static_cast<int>(class_names.size()) ? class_names[class_id] : std::string("unknown");
+    };
+
+    if (csv)
+    {
+        // Every row says how many detections its image has, so a resumed run can tell a cut-off image
+        const std::string prefix = csvQuote(image.path) + cv::format(",%d,%d,%zu,", image.size.width, image.size.height, detections.size());
+        // An image without detections still gets a row so a resumed run knows it is done
+        if (detections.empty())
+            out += prefix + "-1,,,,,,\n";
+        for (const Detection &det : detections)
+        {
+            out += prefix + std::to_string(det.class_id) + "," + csvQuote(className(det.class_id)) +
+                   cv::format(",%.4f,%d,%d,%d,%d\n", det.confidence, det.box.x, det.box.y, det.box.width, det.box.height);
+        }
+        return;
+    }
+
+    out += "{\"path\": \"" + jsonEscape(image.path) + "\"" + cv::format(", \"width\": %d, \"height\": %d, \"detections\": [", image.size.width, image.size.height);
+    for (size_t i = 0; i < detections.size(); ++i)
+    {
+        const Detection &det = detections[i];
+        out += (i > 0 ? ", " : "") + std::string("{\"class_id\": ") + std::to_string(det.class_id) + ", \"class\": \"" + jsonEscape(className(det.class_id)) + "\"" +
+               cv::format(", \"confidence\": %.4f, \"box\": [%d, %d, %d, %d]}", det.confidence, det.box.x, det.box.y, det.box.width, det.box.height);
+    }
+    out += "]}\n";
+}
+
+int main(int argc, char **argv)
+{
+    std::string input, output_path = "detections.jsonl", format;
+    std::string model_path = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
+    std::string names_path = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+    int batch_size = BATCH_DEFAULT_SIZE;
+    int decoders = std::max(2, static_cast<int>(std::thread::hardware_concurrency()) / 2);
+    bool recursive = false;
+    YoloSettings settings;
+    std::vector<std::string> wanted_classes;
+    std::vector<std::string> remote_endpoints;
+    std::string remote_format = "image";
+    int replicas = 1;
+    int threads_per_replica = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--input" && has_value)
+            input = argv[++i];
+        else if (arg == "--output" && has_value)
+            output_path = argv[++i];
+        else if (arg == "--format" && has_value)
+            format = argv[++i];
+        else if (arg == "--batch" && has_value)
+            batch_size = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--decoders" && has_value)
+            decoders = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--recursive")
+            recursive = true;
+        else if (arg == "--model" && has_value)
+            model_path = argv[++i];
+        else if (arg == "--names" && has_value)
+            names_path = argv[++i];
+        else if (arg == "--input-size" && has_value)
+            settings.input_width = settings.input_height = std::atoi(argv[++i]);
+        else if (arg == "--conf" && has_value)
+            settings.confidence_threshold = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--classes" && has_value)
+            wanted_classes = splitString(argv[++i], ',');
+        else if (arg == "--remote" && has_value)
+            remote_endpoints = splitString(argv[++i], ',');
+        else if (arg == "--remote-format" && has_value)
+            remote_format = argv[++i];
+        else if (arg == "--replicas" && has_value)
+            replicas = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads-per-replica" && has_value)
+            threads_per_replica = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+    if (input.empty())
+    {
+        printUsage();
+        return -1;
+    }
+    if (format.empty())
+        format = std::filesystem::path(output_path).extension() == ".csv" ? "csv" : "jsonl";
+    if ((format != "jsonl" && format != "csv") || (remote_format != "image" && remote_format != "blob"))
+    {
+        printUsage();
+        return -1;
+    }
+    const bool csv = format == "csv";
+    const bool remote_images = !remote_endpoints.empty() && remote_format == "image";
+
+    if (!setUpEnv())
+        return -1;
+
+    std::vector<std::string> images = collectImages(input, recursive);
+    std::set<std::string> completed = loadCompleted(output_path, csv);
+    std::vector<std::string> todo;
+    for (const std::string &path : images)
+    {
+        if (!completed.count(path))
+            todo.push_back(path);
+    }
+    LOG("Found " << images.size() << " images, " << images.size() - todo.size() << " already in " << output_path << ", " << todo.size() << " to process.");
+    if (todo.empty())
+        return 0;
+
+    cv::ocl::setUseOpenCL(true);
+    HARDWARE_INFO hw_info;
+    detectSystemArchCached(hw_info, (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string());
+    cv::dnn::Net net;
+    std::vector<std::string> class_names;
+    if (!setupYoloNetwork(net, model_path, names_path, class_names, hw_info))
+    {
+        LOG_ERR("Failed to setup YOLO network for batch processing.");
+        return -1;
+    }
+    if (prepareYoloInputSizes(net, {settings.input_width}).empty())
+    {
+        LOG_ERR("The model does not accept input size " << settings.input_width);
+        return -1;
+    }
+    if (!wanted_classes.empty() && !buildClassFilter(class_names, wanted_classes, settings.class_filter))
+    {
+        LOG_ERR("Invalid --classes list.");
+        return -1;
+    }
+
+    bool write_header = csv && (!std::filesystem::exists(output_path) || std::filesystem::file_size(output_path) == 0);
+    std::ofstream out(output_path, std::ios::app | std::ios::binary);
+    if (!out.is_open())
+    {
+        LOG_ERR("Failed to open " << output_path << " for writing.");
+        return -1;
+    }
+    if (write_header)
+        out << "path,width,height,detections,class_id,class,confidence,x,y,w,h\n";
+
+    std::unique_ptr<RemoteDetector> remote;
+    if (!remote_endpoints.empty())
+    {
+        // The local network is the fallback while no worker is reachable
+        RemoteOptions options;
+        options.payload = remote_images ? REMOTE_PAYLOAD_IMAGE : REMOTE_PAYLOAD_BLOB;
+        remote = std::make_unique<RemoteDetector>(remote_endpoints, options, &net);
+        if (!remote->start())
+        {
+            LOG_ERR("No valid --remote worker address.");
+            return -1;
+        }
+    }
+
+    std::unique_ptr<DetectorPool> pool;
+    if (replicas > 1 && !remote)
+    {
+        // The already loaded network becomes the first replica
+        if (threads_per_replica == 0)
+            threads_per_replica = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / replicas);
+        pool = std::make_unique<DetectorPool>(replicas, threads_per_replica);
+        if (!pool->load(model_path, hw_info, {settings.input_width}, net))
+        {
+            LOG_ERR("Failed to set up " << replicas << " detector replicas.");
+            return -1;
+        }
+        LOG("Running " << replicas << " detector replicas with " << threads_per_replica << " threads each");
+    }
+
+    // Decoders claim images by index; a few batches of headroom keep inference from waiting
+    DecodedQueue queue(static_cast<size_t>(batch_size) * 3);
+    std::atomic<size_t> next_image{0};
+    std::atomic<int> active_decoders{decoders};
+    std::vector<std::thread> decode_threads;
+    for (int d = 0; d < decoders; ++d)
+    {
+        decode_threads.emplace_back([&]
+                                    {
+            for (size_t i = next_image++; i < todo.size(); i = next_image++)
+            {
+                DecodedImage item;
+                item.path = todo[i];
+                if (remote_images)
+                {
+                    std::ifstream file(item.path, std::ios::binary);
+                    item.encoded.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                    queue.push(std::move(item));
+                    continue;
+                }
+                cv::Mat image = cv::imread(item.path, cv::IMREAD_COLOR);
+                if (!image.empty())
+                {
+                    item.size = image.size();
+                    prepareYoloBlob(image, item.blob, settings);
+                }
+                queue.push(std::move(item));
+            }
+            if (--active_decoders == 0)
+                queue.close(); });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto last_report = start;
+    size_t processed = 0, failed = 0;
+    std::vector<std::vector<Detection>> detections;
+    std::string records;
+
+    // Remote results are recorded in submission order; the window keeps every worker's pipeline full
+    std::deque<std::pair<DecodedImage, std::future<RemoteResult>>> in_flight;
+    const size_t remote_window = remote_endpoints.size() * REMOTE_MAX_IN_FLIGHT * 2 + static_cast<size_t>(batch_size);
+    std::deque<DecodedImage> pooled;
+    PoolResult pool_result;
+    auto completePooled = [&]()
+    {
+        DecodedImage &item = pooled.front();
+        pool_result = PoolResult();
+        if (!pool->collect(pool_result))
+        {
+            LOG_ERR("Inference failed for " << item.path << ": the detector pool returned no result");
+            failed++;
+        }
+        else if (pool_result.ok)
+        {
+            appendRecord(records, item, pool_result.detections, class_names, csv);
+            processed++;
+        }
+        else
+        {
+            LOG_ERR("Inference failed for " << item.path << ": " << pool_result.error);
+            failed++;
+        }
+        pooled.pop_front();
+    };
+    auto completeRemote = [&]()
+    {
+        DecodedImage &item = in_flight.front().first;
+        try
+        {
+            RemoteResult result = in_flight.front().second.get();
+            item.size = result.frame_size;
+            appendRecord(records, item, result.detections, class_names, csv);
+            processed++;
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERR("Inference failed for " << item.path << ": " << e.what());
+            failed++;
+        }
+        in_flight.pop_front();
+    };
+    while (true)
+    {
+        std::vector<DecodedImage> batch = queue.popBatch(static_cast<size_t>(batch_size));
+        if (batch.empty())
+            break;
+
+        std::vector<DecodedImage> readable;
+        for (DecodedImage &item : batch)
+        {
+            if (item.blob.empty() && item.encoded.empty())
+            {
+                LOG_ERR("Could not read " << item.path << ", skipping it.");
+                failed++;
+            }
+            else
+            {
+                readable.push_back(std::move(item));
+            }
+        }
+
+        // One write per batch; each record ends in a newline only once it is complete
+        records.clear();
+        if (remote)
+        {
+            for (DecodedImage &item : readable)
+            {
+                std::future<RemoteResult> result = item.encoded.empty() ? remote->submitBlob(item.blob, item.size, settings)
+                                                                        : remote->submitEncoded(std::move(item.encoded), settings);
+                in_flight.emplace_back(std::move(item), std::move(result));
+            }
+            while (in_flight.size() > remote_window)
+                completeRemote();
+        }
+        else if (pool)
+        {
+            // Results come back in submission order, one image per replica pass
+            for (DecodedImage &item : readable)
+            {
+                pool->submitBlob(item.blob, item.size, settings);
+                pooled.push_back(std::move(item));
+            }
+            while (pooled.size() > static_cast<size_t>(replicas) * (POOL_QUEUE_DEPTH + 1))
+                completePooled();
+        }
+        else
+        {
+            std::vector<cv::Mat> blobs;
+            std::vector<cv::Size> sizes;
+            for (const DecodedImage &item : readable)
+            {
+                blobs.push_back(item.blob);
+                sizes.push_back(item.size);
+            }
+            std::vector<bool> inferred(readable.size(), true);
+            try
+            {
+                detectObjectsWithYOLOBlobs(blobs, sizes, net, detections, settings);
+            }
+            catch (const cv::Exception &e)
+            {
+                if (batch_size > 1)
+                    LOG_ERR("Batched inference failed, falling back to one image per forward pass: " << e.what());
+                batch_size = 1;
+                detections.assign(readable.size(), std::vector<Detection>());
+                for (size_t k = 0; k < readable.size(); ++k)
+                {
+                    std::vector<std::vector<Detection>> single;
+                    try
+                    {
+                        detectObjectsWithYOLOBlobs({blobs[k]}, {sizes[k]}, net, single, settings);
+                        detections[k] = single[0];
+                    }
+                    catch (const cv::Exception &single_error)
+                    {
+                        LOG_ERR("Inference failed for " << readable[k].path << ": " << single_error.what());
+                        inferred[k] = false;
+                        failed++;
+                    }
+                }
+            }
+
+            for (size_t k = 0; k < readable.size(); ++k)
+            {
+                if (!inferred[k])
+                    continue;
+                appendRecord(records, readable[k], detections[k], class_names, csv);
+                processed++;
+            }
+        }
+        out.write(records.data(), static_cast<std::streamsize>(records.size()));
+        out.flush();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(BATCH_PROGRESS_INTERVAL_S))
+        {
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            LOG("Processed " << processed << "/" << todo.size() << " images, " << cv::format("%.1f", processed / elapsed) << " images/sec");
+            last_report = now;
+        }
+    }
+    records.clear();
+    while (!in_flight.empty())
+        completeRemote();
+    while (!pooled.empty())
+        completePooled();
+    out.write(records.data(), static_cast<std::streamsize>(records.size()));
+    if (remote)
+    {
+        for (const RemoteWorkerStats &worker : remote->stats())
+        {
+            LOG("Worker " << worker.endpoint << ": " << worker.completed << " images, " << cv::format("%.1f", worker.avg_round_trip_ms) << " ms average round trip, "
+                          << worker.failovers << " failed over, " << worker.reconnects << " reconnects");
+        }
+        LOG(remote->localFallbacks() << " images ran locally");
+        remote->stop();
+    }
+    for (std::thread &t : decode_threads)
+        t.join();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG("Annotated " << processed << " images in " << cv::format("%.1f", elapsed) << " s (" << cv::format("%.1f", elapsed > 0 ? processed / elapsed : 0.0)
+                     << " images/sec, batch " << batch_size << ", " << decoders << " decoders), " << failed << " failed. Results in " << output_path);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+#include "inference_scheduler.hpp"
+#include "alloc_tracker.hpp"
+#include "synthetic_desktop.hpp"
+#include "display.hpp"
+#include "yolo.hpp"
+#include "utils.hpp"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#ifdef _WIN32
+#include "dxdiag.hpp"
+#endif
+#ifdef AGENT_HAS_X11_CAPTURE
+#include "x11_capture.hpp"
+#endif
+
+static std::atomic<bool> quit_requested{false};
+
+static void onSignal(int)
+{
+    quit_requested = true;
+}
+
+static void printUsage()
+{
+    LOG("Usage: agent_multi [--all-screens] [--webcam N] [--replay PATH] [--x11 DISPLAY] [--synthetic SCENARIO[@WxH]] [--seed N] [--change-every N] [--fps F] [--weight W] [--batch N] [--duration S] [--classes a,b] [--headless] [--track-allocs] [--alloc-budget N] [--trace S] [--trace-file PATH]");
+    LOG("  --fps and --weight apply to every source listed after them.");
+    LOG("  --replay accepts an image directory or a video file and may be repeated.");
+    LOG("  --x11 captures an X11 display such as :0 (Linux builds with MIT-SHM and XDamage only).");
+    LOG("  --synthetic renders a reproducible desktop: static, typing, scrolling, video or drag (default 1920x1080).");
+    LOG("  --seed and --change-every apply to every --synthetic source listed after them.");
+    LOG("  --alloc-budget tracks allocations and exits with 1 if a steady-state frame averages more than N.");
+    LOG("  --trace records S seconds of pipeline spans to --trace-file (agent_trace.json); " << TRACE_SIGNAL_NAME << " records " << TRACE_DEFAULT_SECONDS << " s at any time.");
+}
+
+static uint64_t totalInferred(const std::vector<SourceMetrics> &metrics)
+{
+    uint64_t total = 0;
+    for (const SourceMetrics &m : metrics)
+        total += m.frames_inferred;
+    return total;
+}
+
+static void logMetrics(const std::vector<SourceMetrics> &metrics)
+{
+    for (const SourceMetrics &m : metrics)
+    {
+        LOG(m.name << " | target " << m.target_fps << " fps, weight " << m.weight
+                   << " | captured " << m.frames_captured << " (" << cv::format("%.1f", m.capture_fps) << " fps)"
+                   << ", inferred " << m.frames_inferred << " (" << cv::format("%.1f", m.inference_fps) << " fps)"
+                   << ", dropped " << m.frames_dropped << ", unchanged " << m.frames_unchanged
+                   << (m.changed_fraction > 0.0 ? cv::format(" (%.1f%% of pixels changed per frame)", m.changed_fraction * 100.0) : std::string())
+                   << " | latency avg " << cv::format("%.1f", m.avg_latency_ms) << " ms, max " << cv::format("%.1f", m.max_latency_ms) << " ms"
+                   << " | errors " << m.capture_failures << "/" << m.inference_errors);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (!setUpEnv())
+        return -1;
+
+    std::signal(SIGINT, onSignal);
+
+    cv::dnn::Net yolo_net;
+    std::vector<std::string> class_names_vec;
+    cv::ocl::setUseOpenCL(true);
+    const std::string YOLO_MODEL_PATH = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
+    const std::string CLASS_NAMES_PATH = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+    const std::string HARDWARE_CACHE_PATH = (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string();
+
+    HARDWARE_INFO hw_info;
+    detectSystemArchCached(hw_info, HARDWARE_CACHE_PATH);
+
+    bool headless = false;
+    bool track_allocs = false;
+    double alloc_budget = 0.0;
+    double trace_seconds = 0.0;
+    std::string trace_path = "agent_trace.json";
+    int max_batch = 1;
+    std::vector<std::string> wanted_classes;
+    double duration_s = 0.0;
+    double fps = 30.0;
+    double weight = 1.0;
+    SyntheticDesktopConfig synthetic_config;
+    std::vector<std::unique_ptr<FrameSource>> sources;
+    std::vector<std::pair<double, double>> source_rates; // fps, weight per source
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--track-allocs")
+            track_allocs = true;
+        else if (arg == "--alloc-budget" && has_value)
+        {
+            alloc_budget = std::atof(argv[++i]);
+            track_allocs = true;
+        }
+        else if (arg == "--trace" && has_value)
+            trace_seconds = std::atof(argv[++i]);
+        else if (arg == "--trace-file" && has_value)
+            trace_path = argv[++i];
+        else if (arg == "--fps" && has_value)
+            fps = std::atof(argv[++i]);
+        else if (arg == "--weight" && has_value)
+            weight = std::atof(argv[++i]);
+        else if (arg == "--batch" && has_value)
+            max_batch = std::atoi(argv[++i]);
+        else if (arg == "--duration" && has_value)
+            duration_s = std::atof(argv[++i]);
+        else if (arg == "--classes" && has_value)
+            wanted_classes = splitString(argv[++i], ',');
+        else if (arg == "--replay" && has_value)
+        {
+            sources.push_back(std::make_unique<ReplaySource>(argv[++i]));
+            source_rates.emplace_back(fps, weight);
+        }
+        else if (arg == "--seed" && has_value)
+            synthetic_config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--change-every" && has_value)
+            synthetic_config.change_every = std::atoi(argv[++i]);
+        else if (arg == "--synthetic" && has_value)
+        {
+            SyntheticDesktopConfig config = synthetic_config;
+            std::vector<std::string> parts = splitString(argv[++i], '@');
+            int width = 0, height = 0;
+            if (parts.empty() || !parseSyntheticScenario(parts[0], config.scenario) ||
+                (parts.size() > 1 && (std::sscanf(parts[1].c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)))
+            {
+                printUsage();
+                return -1;
+            }
+            if (width > 0)
+                config.resolution = cv::Size(width, height);
+            sources.push_back(std::make_unique<SyntheticDesktopSource>(config));
+            source_rates.emplace_back(fps, weight);
+        }
+        else if (arg == "--webcam" && has_value)
+        {
+            sources.push_back(std::make_unique<WebcamSource>(std::atoi(argv[++i])));
+            source_rates.emplace_back(fps, weight);
+        }
+#ifdef AGENT_HAS_X11_CAPTURE
+        else if (arg == "--x11" && has_value)
+        {
+            X11CaptureOptions options;
+            options.display_name = argv[++i];
+            sources.push_back(std::make_unique<X11ScreenSource>(options));
+            source_rates.emplace_back(fps, weight);
+        }
+#endif
+#ifdef _WIN32
+        else if (arg == "--all-screens")
+        {
+            for (const DXGIOutputInfo &output : EnumerateDXGIOutputs())
+            {
+                LOG("Found display " << output.device_name << " (adapter " << output.adapter_index << ", output " << output.output_index << ")");
+                sources.push_back(std::make_unique<DxgiScreenSource>(output.adapter_index, output.output_index));
+                source_rates.emplace_back(fps, weight);
+            }
+        }
+#endif
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+
+    if (sources.empty())
+    {
+        printUsage();
+        return -1;
+    }
+
+    if (track_allocs)
+        enableAllocTracking();
+
+    LOG("Initializing YOLO network...");
+    if (!setupYoloNetwork(yolo_net, YOLO_MODEL_PATH, CLASS_NAMES_PATH, class_names_vec, hw_info))
+    {
+        LOG_ERR("Failed to setup YOLO network for multi-source agent.");
+        return -1;
+    }
+
+    // One display thread paints a window per source; it only ever sees the latest frame of each
+    std::unique_ptr<DisplayWorker> display;
+    if (!headless)
+    {
+        display = std::make_unique<DisplayWorker>(class_names_vec);
+        for (const auto &source : sources)
+        {
+            display->addWindow(source->name());
+        }
+    }
+
+    YoloSettings yolo_settings;
+    if (!wanted_classes.empty() && !buildClassFilter(class_names_vec, wanted_classes, yolo_settings.class_filter))
+    {
+        LOG_ERR("Invalid --classes list; detecting all classes instead.");
+        yolo_settings.class_filter.clear();
+    }
+
+    MultiSourceEngine engine(yolo_net, max_batch);
+    engine.setSettings(yolo_settings);
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        engine.addSource(std::move(sources[i]), source_rates[i].first, source_rates[i].second);
+    }
+    if (display)
+    {
+        engine.setCallback([&display](size_t source_index, const cv::Mat &frame, const std::vector<Detection> &detections, const std::vector<cv::Rect> &)
+                           { display->submit(source_index, frame, detections); });
+        display->start();
+    }
+
+    if (!engine.start())
+    {
+        LOG_ERR("Failed to start multi-source engine.");
+        return -1;
+    }
+    LOG("Multi-source engine started. Press Ctrl+C to stop.");
+    setTraceThreadName("main");
+    armTraceSignal(TRACE_DEFAULT_SECONDS, std::filesystem::path(trace_path).replace_extension().generic_string());
+    if (trace_seconds > 0.0)
+        startTracing(trace_seconds, trace_path);
+
+    // Per-frame numbers cover every thread, divided by the frames inferred in the period
+    FrameAllocMeter alloc_meter;
+    uint64_t metered_frames = 0;
+    auto meterAllocations = [&](const std::vector<SourceMetrics> &metrics)
+    {
+        uint64_t inferred = totalInferred(metrics);
+        alloc_meter.addFrames(inferred - metered_frames);
+        metered_frames = inferred;
+        LOG(alloc_meter.report());
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto lastReport = startTime;
+    while (engine.running() && !quit_requested && !(display && display->quitRequested()))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        if (duration_s > 0.0 && std::chrono::duration<double>(now - startTime).count() >= duration_s)
+            break;
+        if (now - lastReport >= std::chrono::seconds(5))
+        {
+            std::vector<SourceMetrics> metrics = engine.metrics();
+            logMetrics(metrics);
+            if (track_allocs)
+                meterAllocations(metrics);
+            lastReport = now;
+        }
+    }
+
+    // Metered before stopping, so teardown does not count against the last period
+    if (track_allocs)
+        meterAllocations(engine.metrics());
+    engine.stop();
+    if (display)
+    {
+        display->stop();
+    }
+    stopTracing();
+    LOG("Final per-source metrics:");
+    logMetrics(engine.metrics());
+    if (alloc_budget > 0.0 && !alloc_meter.checkBudget(alloc_budget))
+        return 1;
+    return 0;
+}
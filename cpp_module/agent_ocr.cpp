@@ -0,0 +1,93 @@
+#include "dxdiag.hpp"
+#include "ocr.hpp"
+#include "utils.hpp"
+
+// Line-oriented OCR service over stdin/stdout so the Python tool can query screen text
+// without shelling out to pytesseract on a full screenshot:
+//   read          -> one "x y w h<TAB>text" line per region, then "END"
+//   find <text>   -> "FOUND x y w h<TAB>text" or "NOT_FOUND"
+//   quit
+// Log lines share stdout and always start with "[INFO]" or "[ERROR]", so clients skip them.
+// Replies go out through writeStdout(), so a log line never lands inside one.
+int main()
+{
+    if (!setUpEnv())
+        return -1;
+
+    cv::ocl::setUseOpenCL(true);
+    HARDWARE_INFO hw_info;
+    detectSystemArch(hw_info);
+
+    const std::string DET_MODEL_PATH = (std::filesystem::current_path() / "models/ocr/text_detection_DB_TD500_resnet18.onnx").generic_string();
+    const std::string REC_MODEL_PATH = (std::filesystem::current_path() / "models/ocr/text_recognition_CRNN_EN.onnx").generic_string();
+    const std::string VOCABULARY_PATH = (std::filesystem::current_path() / "models/ocr/alphabet_36.txt").generic_string();
+
+    OcrContext ocr;
+    if (!setupOcr(ocr, DET_MODEL_PATH, REC_MODEL_PATH, VOCABULARY_PATH, hw_info))
+    {
+        LOG_ERR("Failed to setup OCR models.");
+        return -1;
+    }
+
+    DXGIContext ctx;
+    if (!InitializeDXGI(ctx))
+    {
+        LOG_ERR("DXGI Initialization failed.");
+        return -1;
+    }
+
+    int width = 0, height = 0;
+    std::vector<BYTE> pixelBuffer;
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (line == "quit")
+            break;
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        // A timeout means the desktop has not changed, so the previous pixels are still current
+        if (!GetScreenPixelsDXGI(ctx.pDesktopDupl, ctx.pDevice, ctx.pImmediateContext, width, height, pixelBuffer) && pixelBuffer.empty())
+        {
+            writeStdout("ERROR no frame\n");
+            continue;
+        }
+        cv::Mat frame(height, width, CV_8UC4, pixelBuffer.data());
+
+        std::ostringstream reply;
+        if (line == "read")
+        {
+            std::vector<TextRegion> regions;
+            readScreenText(ocr, frame, regions);
+            for (const TextRegion &region : regions)
+            {
+                reply << region.box.x << " " << region.box.y << " " << region.box.width << " " << region.box.height << "\t" << region.text << "\n";
+            }
+            reply << "END\n";
+        }
+        else if (line.rfind("find ", 0) == 0)
+        {
+            TextRegion match;
+            if (findTextOnScreen(ocr, frame, line.substr(5), match))
+            {
+                reply << "FOUND " << match.box.x << " " << match.box.y << " " << match.box.width << " " << match.box.height << "\t" << match.text << "\n";
+            }
+            else
+            {
+                reply << "NOT_FOUND\n";
+            }
+        }
+        else
+        {
+            writeStdout("ERROR unknown command\n");
+            continue;
+        }
+        writeStdout(reply.str());
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - startTime).count();
+        LOG("OCR query took " << elapsed / 1000.0 << " ms (cache hits: " << ocr.cache_hits << ", misses: " << ocr.cache_misses << ")");
+    }
+
+    CleanupDXGI(ctx);
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "dxdiag.hpp"
+#include "yolo.hpp"
+#include "ocr.hpp"
+#include "detection_bus.hpp"
+#include "task_runner.hpp"
+#include "roi_detector.hpp"
+#include "template_matcher.hpp"
+#include "detection_eval.hpp"
+#include "utils.hpp"
+#include <atomic>
+#include <cstdlib>
+
+// Runs python_module/tasks.json style task lists natively. A capture thread publishes every
+// changed desktop frame with its detections (and OCR text while a wait_for_text step is
+// pending) to a DetectionBus; the task steps wait on that bus instead of sleeping. While every
+// pending step waits on a "region", only those regions are searched. Elements with template
+// images in --templates (templates/<class name>/*.png) are looked for by template matching
+// first, and the network only runs when some waited-for element is not found that way.
+//   agent_tasks [tasks.json] [--model PATH] [--names PATH] [--templates DIR]
+
+const int TASK_CAPTURE_MIN_BACKOFF_MS = 10;   // First sleep after a failed capture, doubled per failure
+const int TASK_CAPTURE_MAX_BACKOFF_MS = 1000;
+const int TASK_CAPTURE_FAILURE_REPORT = 20;   // Failures in a row before it is reported
+// A network box of the same class overlapping a template hit by more than this is the same element
+const float TASK_TEMPLATE_MERGE_IOU = 0.5f;
+
+// Adds the template hits to the network's detections, replacing network boxes of the same
+// element so a waiter does not see it twice
+static void mergeTemplateHits(std::vector<Detection> &detections, const std::vector<Detection> &matched)
+{
+    auto is_matched = [&](const Detection &det)
+    {
+        for (const Detection &hit : matched)
+        {
+            if (hit.class_id == det.class_id && rectIoU(hit.box, det.box) > TASK_TEMPLATE_MERGE_IOU)
+                return true;
+        }
+        return false;
+    };
+    detections.erase(std::remove_if(detections.begin(), detections.end(), is_matched), detections.end());
+    detections.insert(detections.end(), matched.begin(), matched.end());
+}
+
+int main(int argc, char **argv)
+{
+    std::string tasks_path = "tasks.json";
+    std::string model_path = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
+    std::string names_path = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+    std::string templates_dir = (std::filesystem::current_path() / "templates").generic_string();
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--model" && i + 1 < argc)
+            model_path = argv[++i];
+        else if (arg == "--names" && i + 1 < argc)
+            names_path = argv[++i];
+        else if (arg == "--templates" && i + 1 < argc)
+            templates_dir = argv[++i];
+        else
+            tasks_path = arg;
+    }
+
+    if (!setUpEnv())
+        return -1;
+    // Detection boxes are in physical pixels; clicks must be too
+    SetProcessDPIAware();
+
+    std::vector<TaskStep> steps;
+    if (!loadTasks(tasks_path, steps))
+        return -1;
+    LOG("Loaded " << steps.size() << " tasks from " << tasks_path);
+
+    cv::ocl::setUseOpenCL(true);
+    HARDWARE_INFO hw_info;
+    detectSystemArchCached(hw_info, (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string());
+
+    cv::dnn::Net yolo_net;
+    std::vector<std::string> class_names_vec;
+    if (!setupYoloNetwork(yolo_net, model_path, names_path, class_names_vec, hw_info))
+    {
+        LOG_ERR("Failed to setup YOLO network for task runner.");
+        return -1;
+    }
+
+    // OCR is only loaded when some step waits for text
+    OcrContext ocr;
+    bool ocr_ready = false;
+    if (std::any_of(steps.begin(), steps.end(), [](const TaskStep &s)
+                    { return s.action == "wait_for_text"; }))
+    {
+        ocr_ready = setupOcr(ocr,
+                             (std::filesystem::current_path() / "models/ocr/text_detection_DB_TD500_resnet18.onnx").generic_string(),
+                             (std::filesystem::current_path() / "models/ocr/text_recognition_CRNN_EN.onnx").generic_string(),
+                             (std::filesystem::current_path() / "models/ocr/alphabet_36.txt").generic_string(), hw_info);
+        if (!ocr_ready)
+        {
+            LOG_ERR("Failed to setup OCR; wait_for_text steps will time out.");
+        }
+    }
+
+    // Region queries run at native scale; smaller inputs make them cheaper when the model allows
+    const std::vector<int> ROI_INPUT_SIZES = {256, 320, 416, 512, 640};
+    std::vector<int> roi_sizes = {YOLO_INPUT_WIDTH};
+    if (std::any_of(steps.begin(), steps.end(), [](const TaskStep &s)
+                    { return !s.get("region").empty(); }))
+    {
+        roi_sizes = prepareYoloInputSizes(yolo_net, ROI_INPUT_SIZES);
+    }
+    RoiDetector roi_detector(yolo_net, roi_sizes);
+
+    // Without a templates folder every lookup goes to the network as before
+    TemplateRegistry templates(class_names_vec);
+    if (std::filesystem::is_directory(templates_dir))
+        templates.loadDirectory(templates_dir);
+
+    DetectionBus bus;
+    std::atomic<bool> stop{false};
+    std::thread capture_thread([&]
+                               {
+        DxgiScreenSource screen(0, 0);
+        DetectionEvent last;
+        cv::Mat frame_bgra;
+        std::vector<cv::Rect> regions;
+        std::vector<int> classes;
+        std::vector<Detection> matched;
+
+        // Searches only the wanted regions when every waiter has one, the whole frame otherwise.
+        // When every waiter wants an element that has templates, those are matched first and the
+        // event only answers for those classes.
+        auto detect = [&](DetectionEvent &event, const cv::Mat &image)
+        {
+            event.detections.clear();
+            event.regions.clear();
+            event.classes.clear();
+            try
+            {
+                const bool region_only = bus.wantedRegions(regions);
+                matched.clear();
+                if (templates.templateCount() && bus.wantedClasses(classes) && templates.hasAll(classes) &&
+                    templates.match(image, classes, region_only ? regions : std::vector<cv::Rect>(), matched))
+                {
+                    event.detections = matched;
+                    event.classes = classes;
+                    if (region_only)
+                        event.regions = regions;
+                    return;
+                }
+                if (region_only)
+                {
+                    roi_detector.detect(image, regions, event.detections);
+                    event.regions = regions;
+                }
+                else
+                {
+                    detectObjectsWithYOLO(event.frame, yolo_net, event.detections);
+                }
+                // Some element had no match; whatever templates did find still counts
+                mergeTemplateHits(event.detections, matched);
+            }
+            catch (const cv::Exception &e)
+            {
+                LOG_ERR("OpenCV error during YOLO processing in task runner: " << e.what());
+            }
+        };
+
+        // A timeout means the desktop did not change; anything else is a failed capture, retried
+        // with a growing sleep so a lost or missing output does not keep a core busy
+        int failed_reads = 0;
+        while (!stop)
+        {
+            if (!screen.readBgra(frame_bgra))
+            {
+                if (!screen.unchanged())
+                {
+                    if (++failed_reads == TASK_CAPTURE_FAILURE_REPORT)
+                    {
+                        if (last.frame.empty())
+                            LOG_ERR("Screen capture could not start after " << failed_reads << " attempts; still retrying.");
+                        else
+                            LOG_ERR("Screen capture has failed " << failed_reads << " times in a row; still retrying.");
+                    }
+                    const int backoff_ms = TASK_CAPTURE_MIN_BACKOFF_MS << std::min(failed_reads - 1, 6);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(backoff_ms, TASK_CAPTURE_MAX_BACKOFF_MS)));
+                }
+                if (last.frame.empty())
+                    continue;
+                // Unchanged desktop: re-publish when the last event did not search where waiters look
+                // or for what they look for
+                const bool region_only = bus.wantedRegions(regions);
+                const bool class_only = bus.wantedClasses(classes);
+                const bool stale = (region_only ? !std::all_of(regions.begin(), regions.end(), [&](const cv::Rect &r)
+                                                               { return last.covers(r); })
+                                                : !last.regions.empty()) ||
+                                   (class_only ? !std::all_of(classes.begin(), classes.end(), [&](int class_id)
+                                                              { return last.searched(class_id); })
+                                               : !last.classes.empty());
+                if (stale)
+                {
+                    detect(last, last.frame);
+                    bus.publish(last);
+                }
+                // Only re-publish for OCR when a text waiter needs it for the current frame
+                if (ocr_ready && !last.has_text && bus.wantsText())
+                {
+                    last.has_text = readScreenText(ocr, last.frame, last.text_regions);
+                    bus.publish(last);
+                }
+                continue;
+            }
+
+            if (failed_reads >= TASK_CAPTURE_FAILURE_REPORT)
+                LOG("Screen capture recovered after " << failed_reads << " failed attempts.");
+            failed_reads = 0;
+
+            DetectionEvent event;
+            event.captured_at = std::chrono::steady_clock::now();
+            cv::cvtColor(frame_bgra, event.frame, cv::COLOR_BGRA2BGR); // Also detaches from the capture buffer
+            detect(event, frame_bgra);
+            if (ocr_ready && bus.wantsText())
+                event.has_text = readScreenText(ocr, event.frame, event.text_regions);
+            last = event;
+            bus.publish(event);
+        }
+        screen.close(); });
+
+    TaskRunner runner(bus, class_names_vec);
+    bool ok = runner.run(steps);
+
+    stop = true;
+    bus.close();
+    capture_thread.join();
+    return ok ? 0 : 1;
+}
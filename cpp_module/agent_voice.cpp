@@ -0,0 +1,208 @@
+#include "voice_commands.hpp"
+#include "wav_file.hpp"
+#include "intent_classifier.hpp"
+#include "detection_eval.hpp"
+#include "utils.hpp"
+#include <csignal>
+#include <cstdlib>
+
+// Listens for voice commands with Vosk, natively, in place of automation_tool.py's listener.
+// Live input needs the PortAudio build; a WAV file (16-bit PCM, any rate) is fed through the
+// same ring in real time, 10 ms per push like a microphone callback, followed by a second of
+// silence. Every command is also turned into a tasks.json step by the IntentClassifier, which
+// fills in the free-text slots ("type ...") when decoding without the grammar. --expect checks the commands heard in order and exits non-zero on a mismatch.
+// --compare also runs the file the way the Python listener decodes: 250 ms reads, open
+// vocabulary, Vosk's own endpoint.
+//   agent_voice [--model DIR] [--commands FILE] [--wav FILE [--expect "open chrome,read text"] [--compare]]
+//               [--no-grammar] [--early-ms 250]
+
+const int VOICE_TAIL_MS = 1000;
+const int VOICE_PUSH_MS = 10;
+
+static std::atomic<bool> quit_requested{false};
+
+static void onSignal(int)
+{
+    quit_requested = true;
+}
+
+static std::string describeIntent(const std::string &heard)
+{
+    static const IntentClassifier intents;
+    const Intent intent = intents.classify(heard);
+    std::string text = intent.action.empty() ? "no action" : intent.action;
+    for (const auto &param : intent.params)
+        text += " " + param.first + "=\"" + param.second + "\"";
+    return text;
+}
+
+struct VoiceRun
+{
+    std::string label;
+    std::vector<VoiceCommand> commands;
+    VoiceMetrics metrics;
+};
+
+static void logMetrics(const std::vector<VoiceRun> &runs)
+{
+    LOG_REPORT(cv::format("%-26s %8s %8s %6s %11s %11s %11s %6s", "config", "commands", "rejected", "early", "p50 lat ms", "p99 lat ms", "max lat ms", "RTF"));
+    for (const VoiceRun &run : runs)
+    {
+        const VoiceMetrics &m = run.metrics;
+        LOG_REPORT(cv::format("%-26s %8llu %8llu %6llu %11.0f %11.0f %11.0f %6.3f", run.label.c_str(), static_cast<unsigned long long>(m.commands),
+                       static_cast<unsigned long long>(m.rejected), static_cast<unsigned long long>(m.early_commits), percentile(m.recent_latencies_ms, 50.0),
+                       percentile(m.recent_latencies_ms, 99.0), m.max_latency_ms, m.audio_seconds > 0.0 ? m.decode_seconds / m.audio_seconds : 0.0)
+            << (m.dropped_samples ? "  (" + std::to_string(m.dropped_samples) + " samples dropped)" : std::string()));
+    }
+}
+
+static bool runWav(const std::string &model_dir, const std::vector<std::string> &phrases, const VoiceOptions &options, const std::vector<int16_t> &samples,
+                   VoiceRun &run)
+{
+    VoiceCommandRecognizer recognizer(options);
+    if (!recognizer.load(model_dir, phrases))
+        return false;
+    // Only read once stop() has joined the decoder
+    recognizer.setCommandCallback([&](const VoiceCommand &command)
+                                  {
+        run.commands.push_back(command);
+        LOG(run.label << ": \"" << command.phrase << "\" at " << cv::format("%.2f", command.end_s) << " s, " << cv::format("%.0f", command.latency_ms) << " ms"
+                      << (command.early ? " (early)" : "") << " -> " << describeIntent(command.heard)); });
+    recognizer.setRejectCallback([&](const std::string &text)
+                                 { LOG(run.label << ": no command in \"" << text << "\""); });
+    if (!recognizer.start())
+        return false;
+
+    std::vector<int16_t> audio = samples;
+    audio.resize(audio.size() + static_cast<size_t>(options.sample_rate) * VOICE_TAIL_MS / 1000, 0);
+    const size_t step = std::max(1, options.sample_rate * VOICE_PUSH_MS / 1000);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < audio.size() && !quit_requested; offset += step)
+    {
+        const size_t n = std::min(step, audio.size() - offset);
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                  std::chrono::duration<double>(static_cast<double>(offset + n) / options.sample_rate)));
+        recognizer.pushAudio(&audio[offset], n);
+    }
+    while (recognizer.pending() && !quit_requested)
+        std::this_thread::sleep_for(std::chrono::milliseconds(VOICE_POLL_MS));
+    recognizer.stop();
+    run.metrics = recognizer.metrics();
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string model_dir = (std::filesystem::current_path() / "models/vosk/vosk-model-small-en-us").generic_string();
+    std::string commands_path;
+    std::string wav_path;
+    std::string expect;
+    bool compare = false;
+    VoiceOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--model" && has_value)
+            model_dir = argv[++i];
+        else if (arg == "--commands" && has_value)
+            commands_path = argv[++i];
+        else if (arg == "--wav" && has_value)
+            wav_path = argv[++i];
+        else if (arg == "--expect" && has_value)
+            expect = argv[++i];
+        else if (arg == "--compare")
+            compare = true;
+        else if (arg == "--no-grammar")
+            options.use_grammar = false;
+        else if (arg == "--early-ms" && has_value)
+            options.early_commit_ms = std::max(0, std::atoi(argv[++i]));
+        else
+        {
+            LOG("Usage: agent_voice [--model DIR] [--commands FILE] [--wav FILE [--expect \"a,b\"] [--compare]] [--no-grammar] [--early-ms N]");
+            return -1;
+        }
+    }
+
+    std::vector<std::string> phrases = defaultCommandPhrases();
+    if (!commands_path.empty() && !loadCommandPhrases(commands_path, phrases))
+        return -1;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (!wav_path.empty())
+    {
+        std::vector<int16_t> samples;
+        if (!readWavFile(wav_path, samples, options.sample_rate))
+            return -1;
+        LOG(wav_path << ": " << cv::format("%.1f", static_cast<double>(samples.size()) / options.sample_rate) << " s at " << options.sample_rate << " Hz");
+
+        std::vector<VoiceRun> runs(1);
+        runs[0].label = options.use_grammar ? "native, command grammar" : "native, open vocabulary";
+        if (!runWav(model_dir, phrases, options, samples, runs[0]))
+            return -1;
+        if (compare)
+        {
+            VoiceOptions python_like = options;
+            python_like.chunk_ms = 250; // stream.read(4000) at 16 kHz
+            python_like.use_grammar = false;
+            python_like.early_commit_ms = 0;
+            runs.emplace_back();
+            runs[1].label = "as automation_tool.py";
+            if (!runWav(model_dir, phrases, python_like, samples, runs[1]))
+                return -1;
+        }
+        logMetrics(runs);
+
+        if (!expect.empty())
+        {
+            std::vector<std::string> expected;
+            for (const std::string &item : splitString(expect, ','))
+                expected.push_back(normalizeCommandPhrase(item));
+            std::vector<std::string> heard;
+            for (const VoiceCommand &command : runs[0].commands)
+                heard.push_back(command.phrase);
+            if (heard != expected)
+            {
+                std::string heard_list;
+                for (const std::string &phrase : heard)
+                    heard_list += (heard_list.empty() ? "" : ",") + phrase;
+                LOG_ERR("Expected \"" << expect << "\", heard \"" << heard_list << "\"");
+                return 1;
+            }
+            LOG("All " << expected.size() << " expected commands heard in order.");
+        }
+        return 0;
+    }
+
+#ifdef AGENT_HAS_PORTAUDIO
+    VoiceCommandRecognizer recognizer(options);
+    if (!recognizer.load(model_dir, phrases))
+        return -1;
+    recognizer.setPartialCallback([](const std::string &partial)
+                                  { LOG("... " << partial); });
+    recognizer.setCommandCallback([](const VoiceCommand &command)
+                                  {
+        LOG("Voice command: " << command.heard << " (" << cv::format("%.0f", command.latency_ms) << " ms) -> " << describeIntent(command.heard));
+        if (command.phrase == "stop listening")
+            quit_requested = true; });
+    recognizer.setRejectCallback([](const std::string &text)
+                                 { LOG("Unknown command: " << text); });
+    MicrophoneInput microphone;
+    if (!recognizer.start() || !microphone.open(recognizer))
+        return -1;
+    LOG("Listening; say \"stop listening\" or press Ctrl+C to quit.");
+    while (!quit_requested)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    microphone.close();
+    recognizer.stop();
+    std::vector<VoiceRun> runs(1);
+    runs[0].label = "microphone";
+    runs[0].metrics = recognizer.metrics();
+    logMetrics(runs);
+    return 0;
+#else
+    LOG_ERR("Built without PortAudio; pass --wav FILE.");
+    return -1;
+#endif
+}
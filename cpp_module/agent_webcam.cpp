@@ -1,15 +1,58 @@
 #include "yolo.hpp"
+#include "display.hpp"
+#include "quality_controller.hpp"
+#include "alloc_tracker.hpp"
+#include <atomic>
+#include <csignal>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <cstdlib>
 
-int main()
+static std::atomic<bool> quit_requested{false};
+
+static void onSignal(int)
+{
+    quit_requested = true;
+}
+
+int main(int argc, char **argv)
 {
+    StartupTrace trace;
+
+    // --headless skips the preview window entirely
+    // --latency-slo <ms> enables the adaptive quality controller with that detection latency target
+    // --max-input <size> sets the full-quality input size it recovers to (default 640)
+    // --classes a,b,c restricts detection to those class names
+    // --track-allocs counts heap and cv::Mat allocations per pipeline stage, logged every 100 frames
+    bool headless = false;
+    bool track_allocs = false;
+    double latency_slo_ms = 0.0;
+    int max_input_size = YOLO_INPUT_WIDTH;
+    std::vector<std::string> wanted_classes;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--latency-slo" && i + 1 < argc)
+            latency_slo_ms = std::atof(argv[++i]);
+        else if (arg == "--max-input" && i + 1 < argc)
+            max_input_size = std::atoi(argv[++i]);
+        else if (arg == "--classes" && i + 1 < argc)
+            wanted_classes = splitString(argv[++i], ',');
+        else if (arg == "--track-allocs")
+            track_allocs = true;
+    }
+    if (track_allocs)
+        enableAllocTracking();
+
     if (!setUpEnv())
         return -1;
+    std::signal(SIGINT, onSignal);
 
     LOG("Starting Webcam Feed...");
     LOG("Press CTRL + C to exit");
@@ -19,23 +62,66 @@ int main()
     long long frameCount = 0;
     bool quit = false;
 
-    // Initialize webcam first with default resolution for quick start
-    cv::VideoCapture webcam;
-    const int MAX_INIT_ATTEMPTS = 3;
-    bool webcam_initialized = false;
-    HARDWARE_INFO hw_info;
-    detectSystemArch(hw_info);
+    cv::dnn::Net yolo_net;
+    std::vector<std::string> class_names_vec;
+    cv::ocl::setUseOpenCL(true);
 
-    LOG("Device: " << hw_info.gpu_name);
-    if (hw_info.has_cuda)
+    const std::string YOLO_MODEL_PATH = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
+    const std::string CLASS_NAMES_PATH = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+    const std::string HARDWARE_CACHE_PATH = (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string();
+
+    if (!loadClassNames(CLASS_NAMES_PATH, class_names_vec) || class_names_vec.empty())
     {
-        LOG("Cuda Available: Yes");
+        LOG_ERR("Failed to load class names from " << CLASS_NAMES_PATH);
+        return -1;
     }
-    else if (hw_info.has_nvidia && !hw_info.has_cuda)
+
+    // The hardware probe, model load and warm-up run in the background while the webcam opens
+    auto probeHardware = [&]()
     {
-        LOG("No Cuda Toolkit found, Install CUDA for best Performance")
+        HARDWARE_INFO info;
+        detectSystemArchCached(info, HARDWARE_CACHE_PATH);
+        trace.mark("hardware probe done");
+        return info;
+    };
+    std::shared_future<HARDWARE_INFO> hw_future = std::async(std::launch::async, probeHardware).share();
+
+    std::vector<int> supported_sizes;
+    auto prepareNetwork = [&]()
+    {
+        if (!loadYoloNetwork(yolo_net, YOLO_MODEL_PATH))
+            return false;
+        trace.mark("model loaded");
+        configureYoloBackend(yolo_net, hw_future.get());
+        if (!warmUpYoloNetwork(yolo_net, class_names_vec))
+            return false;
+        trace.mark("warm-up inference done");
+        if (latency_slo_ms > 0.0)
+        {
+            std::vector<int> sizes;
+            for (const QualityLevel &level : DEFAULT_QUALITY_LADDER)
+                sizes.push_back(level.input_size);
+            supported_sizes = prepareYoloInputSizes(yolo_net, sizes);
+            trace.mark("quality ladder warmed up");
+        }
+        return true;
+    };
+    std::future<bool> network_future = std::async(std::launch::async, prepareNetwork);
+
+    // The preview window is created on its own thread, also in parallel with capture init
+    std::unique_ptr<DisplayWorker> display;
+    if (!headless)
+    {
+        display = std::make_unique<DisplayWorker>(class_names_vec);
+        display->addWindow("Webcam Live Feed");
+        display->start();
     }
 
+    // Initialize webcam first with default resolution for quick start
+    cv::VideoCapture webcam;
+    const int MAX_INIT_ATTEMPTS = 3;
+    bool webcam_initialized = false;
+
     for (int attempt = 0; attempt < MAX_INIT_ATTEMPTS && !webcam_initialized; attempt++)
     {
         if (attempt > 0)
@@ -62,32 +148,55 @@ int main()
     if (!webcam_initialized)
     {
         LOG_ERR("Failed to initialize webcam after " << MAX_INIT_ATTEMPTS << " attempts");
+        network_future.wait();
+        if (display)
+            display->stop();
         return -1;
     }
 
     LOG("Webcam Initialized successfully at default resolution");
+    trace.mark("webcam ready");
 
-    // Create window after webcam is initialized
-    static const std::string windowName = "Webcam Live Feed";
-    cv::namedWindow(windowName, cv::WINDOW_NORMAL);
-    cv::setWindowProperty(windowName, cv::WND_PROP_ASPECT_RATIO, cv::WINDOW_KEEPRATIO);
-    cv::resizeWindow(windowName, 1280, 720);
-
-    // Now initialize YOLO
-    cv::dnn::Net yolo_net;
-    std::vector<std::string> class_names_vec;
-    cv::ocl::setUseOpenCL(true);
-
-    const std::string YOLO_MODEL_PATH = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
-    const std::string CLASS_NAMES_PATH = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+    const HARDWARE_INFO &hw_info = hw_future.get();
+    LOG("Device: " << hw_info.gpu_name);
+    if (hw_info.has_cuda)
+    {
+        LOG("Cuda Available: Yes");
+    }
+    else if (hw_info.has_nvidia && !hw_info.has_cuda)
+    {
+        LOG("No Cuda Toolkit found, Install CUDA for best Performance")
+    }
 
-    LOG("Initializing YOLO network...");
-    if (!setupYoloNetwork(yolo_net, YOLO_MODEL_PATH, CLASS_NAMES_PATH, class_names_vec, hw_info))
+    LOG("Waiting for YOLO network...");
+    if (!network_future.get())
     {
         LOG_ERR("Failed to setup YOLO network for webcam agent.");
         webcam.release();
+        if (display)
+            display->stop();
         return -1;
     }
+    std::vector<Detection> detections;
+
+    YoloSettings yolo_settings;
+    std::unique_ptr<QualityController> quality;
+    if (!wanted_classes.empty() && !buildClassFilter(class_names_vec, wanted_classes, yolo_settings.class_filter))
+    {
+        LOG_ERR("Invalid --classes list; detecting all classes instead.");
+        yolo_settings.class_filter.clear();
+    }
+    if (latency_slo_ms > 0.0)
+    {
+        std::vector<QualityLevel> ladder = filterQualityLadder(DEFAULT_QUALITY_LADDER, supported_sizes);
+        QualityControllerConfig config;
+        config.latency_slo_ms = latency_slo_ms;
+        quality = std::make_unique<QualityController>(ladder, config, max_input_size);
+        quality->applyTo(yolo_settings);
+        LOG("Adaptive quality enabled: SLO " << latency_slo_ms << " ms, starting at input " << yolo_settings.input_width);
+    }
+
+    FrameAllocMeter alloc_meter;
 
     // Phase 2: Switch to high resolution after first frame
     bool high_res_initialized = false;
@@ -100,8 +209,11 @@ int main()
 
         cv::Mat frame_bgr;
         cv::Mat flippedFrame;
-        webcam >> frame_bgr;
-        cv::flip(frame_bgr, flippedFrame, 1);
+        {
+            AllocStageScope stage(ALLOC_STAGE_CAPTURE);
+            webcam >> frame_bgr;
+            cv::flip(frame_bgr, flippedFrame, 1);
+        }
 
         if (!flippedFrame.empty())
         {
@@ -138,9 +250,19 @@ int main()
                 }
             }
 
+            // Under load the quality controller may skip frames; the previous detections are shown again
             try
             {
-                processFrameWithYOLO(flippedFrame, yolo_net, class_names_vec);
+                if (!quality || quality->shouldDetect(frameCount))
+                {
+                    auto detectStart = std::chrono::high_resolution_clock::now();
+                    detectObjectsWithYOLO(flippedFrame, yolo_net, detections, yolo_settings);
+                    if (quality)
+                    {
+                        quality->recordLatency(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - detectStart).count());
+                        quality->applyTo(yolo_settings);
+                    }
+                }
             }
             catch (const cv::Exception &e)
             {
@@ -153,19 +275,21 @@ int main()
                 quit = true; // Stop processing
             }
 
-            if (cv::getWindowProperty(windowName, cv::WND_PROP_VISIBLE) >= 1)
+            // flippedFrame is reallocated every iteration, so the display thread can keep this buffer
+            if (display)
             {
-                cv::imshow(windowName, flippedFrame);
+                display->submit(0, flippedFrame, detections);
+                if (display->quitRequested())
+                    quit = true;
             }
-
-            int key = cv::waitKey(1);
-            // Check for ESC key
-            if (key == 27)
+            trace.firstFrame();
+            if (track_allocs)
             {
-                quit = true;
+                alloc_meter.addFrames();
+                if (frameCount % 100 == 0)
+                    LOG(alloc_meter.report());
             }
-            // Check if window was closed
-            if (cv::getWindowProperty(windowName, cv::WND_PROP_VISIBLE) < 1)
+            if (quit_requested)
             {
                 quit = true;
             }
@@ -186,7 +310,10 @@ int main()
     }
 
     webcam.release();
-    cv::destroyAllWindows();
+    if (display)
+    {
+        display->stop();
+    }
     LOG("Webcam Feed Ended");
     return 0;
 }
\ No newline at end of file
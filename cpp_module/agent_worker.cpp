@@ -0,0 +1,92 @@
+#include "remote_inference.hpp"
+#include "utils.hpp"
+#include <csignal>
+#include <cstdlib>
+
+// Serves detection requests from other machines (agent_batch --remote) over TCP with the local
+// network. Several workers on one host with different ports are fine for trying it out:
+//   agent_worker --port 5555 & agent_worker --port 5556 &
+//   agent_batch --input screenshots/ --remote 127.0.0.1:5555,127.0.0.1:5556
+//   agent_worker [--port 5555] [--model PATH] [--names PATH] [--batch 8]
+
+const int WORKER_REPORT_INTERVAL_S = 10;
+
+static std::atomic<bool> quit_requested{false};
+
+static void onSignal(int)
+{
+    quit_requested = true;
+}
+
+int main(int argc, char **argv)
+{
+    int port = REMOTE_DEFAULT_PORT;
+    int max_batch = 8;
+    std::string model_path = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
+    std::string names_path = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--port" && has_value)
+            port = std::atoi(argv[++i]);
+        else if (arg == "--batch" && has_value)
+            max_batch = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--model" && has_value)
+            model_path = argv[++i];
+        else if (arg == "--names" && has_value)
+            names_path = argv[++i];
+        else
+        {
+            LOG("Usage: agent_worker [--port 5555] [--model PATH] [--names PATH] [--batch 8]");
+            return -1;
+        }
+    }
+    if (port <= 0 || port > 65535)
+    {
+        LOG_ERR("Invalid --port " << port);
+        return -1;
+    }
+
+    if (!setUpEnv())
+        return -1;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    cv::ocl::setUseOpenCL(true);
+    HARDWARE_INFO hw_info;
+    detectSystemArchCached(hw_info, (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string());
+    cv::dnn::Net net;
+    std::vector<std::string> class_names;
+    if (!setupYoloNetwork(net, model_path, names_path, class_names, hw_info))
+    {
+        LOG_ERR("Failed to setup YOLO network for the inference worker.");
+        return -1;
+    }
+
+    InferenceWorker worker(net, max_batch);
+    if (!worker.start(static_cast<uint16_t>(port)))
+        return -1;
+    LOG("Inference worker listening on port " << port << " (" << hw_info.gpu_name << "), press CTRL + C to exit");
+
+    auto last_report = std::chrono::steady_clock::now();
+    uint64_t last_served = 0;
+    while (!quit_requested)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(WORKER_REPORT_INTERVAL_S))
+        {
+            const uint64_t served = worker.requestsServed();
+            const double elapsed = std::chrono::duration<double>(now - last_report).count();
+            if (served != last_served)
+                LOG("Served " << served << " requests, " << cv::format("%.1f", (served - last_served) / elapsed) << " requests/sec, " << worker.connections() << " clients");
+            last_served = served;
+            last_report = now;
+        }
+    }
+
+    worker.stop();
+    LOG("Inference worker stopped after " << worker.requestsServed() << " requests");
+    return 0;
+}
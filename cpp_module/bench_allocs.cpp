@@ -0,0 +1,168 @@
+#include "alloc_tracker.hpp"
+#include "synthetic_desktop.hpp"
+#include "yolo_decode.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+
+// Checks the allocation tracker, then holds the per-frame pipeline paths that need no model to a
+// steady-state allocation budget: synthetic desktop frames are copied into the capture buffer,
+// preprocessed into a blob, and a YOLOv8-shaped output with the frame's boxes planted in it is
+// decoded. Exits non-zero when the tracker miscounts, the decode loses a box, or any
+// steady-state period averages more than --budget allocations per frame. --check runs fewer
+// frames (the ctest run).
+//   bench_allocs [--frames 600] [--budget 64] [--check]
+
+const int ALLOC_FRAME_RING = 8;     // Distinct frames replayed; rendering them is not measured
+const int ALLOC_METER_PERIOD = 10;  // Frames per meter period
+const int ALLOC_PLANTED_BOXES = 16; // Most boxes planted in one output
+
+// Every counted allocation must land in the stage that made it, with its size
+static bool checkTracker()
+{
+    AllocSnapshot before = allocSnapshot();
+    {
+        AllocStageScope stage(ALLOC_STAGE_DISPLAY);
+        cv::Mat mat(10, 100, CV_8U);
+        mat.release();
+    }
+#ifndef AGENT_NO_ALLOC_HOOKS
+    {
+        // A stage of its own: OpenCV allocates the Mat's bookkeeping with operator new
+        AllocStageScope stage(ALLOC_STAGE_INFERENCE);
+        int *values = new int[10];
+        delete[] values;
+    }
+#endif
+    AllocSnapshot after = allocSnapshot();
+
+    const AllocCounters &mat = after.mat[ALLOC_STAGE_DISPLAY];
+    const AllocCounters &mat_before = before.mat[ALLOC_STAGE_DISPLAY];
+    if (mat.allocations - mat_before.allocations != 1 || mat.bytes - mat_before.bytes != 1000 || mat.frees - mat_before.frees != 1)
+    {
+        LOG_ERR("A 1000-byte cv::Mat was counted as " << mat.allocations - mat_before.allocations << " allocations of "
+                                                      << mat.bytes - mat_before.bytes << " bytes, " << mat.frees - mat_before.frees << " frees.");
+        return false;
+    }
+#ifndef AGENT_NO_ALLOC_HOOKS
+    const AllocCounters &heap = after.heap[ALLOC_STAGE_INFERENCE];
+    const AllocCounters &heap_before = before.heap[ALLOC_STAGE_INFERENCE];
+    if (heap.allocations - heap_before.allocations != 1 || heap.bytes - heap_before.bytes != 10 * sizeof(int) || heap.frees - heap_before.frees != 1)
+    {
+        LOG_ERR("new int[10] was counted as " << heap.allocations - heap_before.allocations << " allocations of "
+                                              << heap.bytes - heap_before.bytes << " bytes, " << heap.frees - heap_before.frees << " frees.");
+        return false;
+    }
+#endif
+    LOG("Allocation tracker check passed.");
+    return true;
+}
+
+// A [1, 4 + 80, N] output for the input size with one confident proposal per box, in input
+// coordinates; boxes that overlap an earlier one are skipped so NMS keeps every planted box
+static void plantOutput(const std::vector<GroundTruthBox> &truth, const cv::Size &frame_size, const YoloSettings &settings, cv::Mat &out_output,
+                        std::vector<cv::Rect> &out_planted)
+{
+    const int num_classes = 80;
+    const int num_proposals = yoloProposalCount(settings.input_width, settings.input_height, 1);
+    const int shape[] = {1, 4 + num_classes, num_proposals};
+    out_output.create(3, shape, CV_32F);
+    out_output.setTo(cv::Scalar(0));
+    out_planted.clear();
+
+    float *data = out_output.ptr<float>();
+    const float x_scale = settings.input_width / static_cast<float>(frame_size.width);
+    const float y_scale = settings.input_height / static_cast<float>(frame_size.height);
+    for (const GroundTruthBox &gt : truth)
+    {
+        if (static_cast<int>(out_planted.size()) == ALLOC_PLANTED_BOXES)
+            break;
+        bool overlaps = false;
+        for (const cv::Rect &planted : out_planted)
+            overlaps = overlaps || (planted & gt.box).area() > 0;
+        if (overlaps)
+            continue;
+
+        // Spread over the proposals so the decode walks past empty ones in between
+        const int i = static_cast<int>(out_planted.size()) * (num_proposals / ALLOC_PLANTED_BOXES);
+        data[i] = (gt.box.x + gt.box.width / 2.0f) * x_scale;
+        data[num_proposals + i] = (gt.box.y + gt.box.height / 2.0f) * y_scale;
+        data[2 * num_proposals + i] = gt.box.width * x_scale;
+        data[3 * num_proposals + i] = gt.box.height * y_scale;
+        data[static_cast<size_t>(4 + gt.class_id) * num_proposals + i] = 0.9f;
+        out_planted.push_back(gt.box);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 600;
+    double budget = 64.0; // Blob resize and color conversion temporaries, decode vectors and NMS
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc)
+            frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--budget" && i + 1 < argc)
+            budget = std::atof(argv[++i]);
+        else if (arg == "--check")
+            frames = 120;
+    }
+
+    enableAllocTracking();
+    if (!checkTracker())
+        return 1;
+
+    SyntheticDesktopConfig config;
+    config.resolution = cv::Size(1280, 720);
+    config.scenario = SyntheticScenario::WindowDrag;
+    SyntheticDesktopSource source(config);
+    if (!source.open())
+        return -1;
+
+    const YoloSettings settings;
+    std::vector<cv::Mat> ring(ALLOC_FRAME_RING), outputs(ALLOC_FRAME_RING);
+    std::vector<std::vector<cv::Rect>> planted(ALLOC_FRAME_RING);
+    for (int r = 0; r < ALLOC_FRAME_RING; ++r)
+    {
+        if (!source.read(ring[r]))
+            return -1;
+        plantOutput(source.groundTruth(), ring[r].size(), settings, outputs[r], planted[r]);
+    }
+    const YoloOutputInfo info = describeYoloOutput(outputs[0], settings.input_width, settings.input_height);
+    const YoloDecodeFn decode = selectYoloDecoder(info);
+    if (!decode)
+    {
+        LOG_ERR("The planted output was not recognized as a YOLO layout.");
+        return 1;
+    }
+
+    FrameAllocMeter meter;
+    cv::Mat frame, blob;
+    std::vector<Detection> detections;
+    for (int i = 0; i < frames; ++i)
+    {
+        const int r = i % ALLOC_FRAME_RING;
+        {
+            AllocStageScope stage(ALLOC_STAGE_CAPTURE);
+            ring[r].copyTo(frame);
+        }
+        prepareYoloBlob(frame, blob, settings);
+        {
+            AllocStageScope stage(ALLOC_STAGE_POSTPROCESS);
+            decode(outputs[r].ptr<float>(), info, frame.size(), settings, detections);
+        }
+
+        if (detections.size() != planted[r].size())
+        {
+            LOG_ERR("Frame " << i << ": decoded " << detections.size() << " boxes, planted " << planted[r].size() << ".");
+            return 1;
+        }
+        if ((i + 1) % ALLOC_METER_PERIOD == 0)
+        {
+            meter.addFrames(ALLOC_METER_PERIOD);
+            if ((i + 1) % (ALLOC_METER_PERIOD * 10) == 0)
+                LOG(meter.report());
+        }
+    }
+    return meter.checkBudget(budget) ? 0 : 1;
+}
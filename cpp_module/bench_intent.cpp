@@ -0,0 +1,111 @@
+#include "intent_classifier.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+
+// Checks the built-in command phrases against known commands, then times building the
+// classifier and classifying. Exits non-zero on the first wrong intent. Extra arguments are
+// classified and printed, which is handy when adding phrases. --check stops after the checks.
+//   bench_intent [--iterations 100000] [--check] [--fallback intent.onnx intent_labels.txt] ["open chrome" ...]
+
+struct IntentCase
+{
+    const char *command;
+    const char *action;
+    const char *param; // Checked when not null
+    const char *value;
+};
+
+static const IntentCase INTENT_CASES[] = {
+    {"open chrome", "open", "app", "chrome"},
+    {"please open the calculator", "open", "app", "calculator"},
+    {"launch notepad", "open", "app", "notepad"},
+    {"go to example dot com", "navigate", "url", "https://example.com"},
+    {"open the website google dot com slash maps", "navigate", "url", "https://google.com/maps"},
+    {"navigate to https://example.com/login", "navigate", "url", "https://example.com/login"},
+    {"log in", "login", "url", "https://example.com"},
+    {"Log in to github.com", "login", "url", "https://github.com"},
+    {"take a screenshot", "screenshot", "prefix", "voice"},
+    {"screenshot", "screenshot", nullptr, nullptr},
+    {"type Hello, World!", "type", "value", "Hello, World!"},
+    {"type open chrome", "type", "value", "open chrome"},
+    {"type", "type", "value", "Hello from voice command!"},
+    {"find the login button", "wait_for_element", "element", "login button"},
+    {"click on the search button", "wait_for_element", "click", "true"},
+    {"wait for text Sign in", "wait_for_text", "text", "Sign in"},
+    {"click text Submit", "wait_for_text", "text", "Submit"},
+    {"read the screen", "read_text", nullptr, nullptr},
+    {"execute tasks", "execute_tasks", nullptr, nullptr},
+    {"stop listening", "stop_listening", nullptr, nullptr},
+    {"what time is it", "", nullptr, nullptr},
+};
+
+static std::string describe(const Intent &intent)
+{
+    std::string text = intent.action.empty() ? "(no intent)" : intent.action;
+    for (const auto &param : intent.params)
+        text += " " + param.first + "=\"" + param.second + "\"";
+    return text + cv::format(" [%.2f%s]", intent.confidence, intent.from_fallback ? ", fallback" : "");
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 100000;
+    std::string fallback_model, fallback_labels;
+    std::vector<std::string> commands;
+    bool check_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc)
+            iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--check")
+            check_only = true;
+        else if (arg == "--fallback" && i + 2 < argc)
+        {
+            fallback_model = argv[++i];
+            fallback_labels = argv[++i];
+        }
+        else
+            commands.push_back(arg);
+    }
+
+    const size_t rss_before = getCurrentRssBytes();
+    auto start = std::chrono::steady_clock::now();
+    IntentClassifier classifier;
+    const double build_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    const size_t rss_after = getCurrentRssBytes();
+    LOG("Compiled " << classifier.patternCount() << " phrases in " << cv::format("%.0f", build_us) << " us, "
+                    << cv::format("%.2f", (rss_after > rss_before ? rss_after - rss_before : 0) / (1024.0 * 1024.0)) << " MB");
+    if (!fallback_model.empty() && !classifier.loadFallback(fallback_model, fallback_labels))
+        return -1;
+
+    for (const IntentCase &c : INTENT_CASES)
+    {
+        const Intent intent = classifier.classify(c.command);
+        // Without a fallback nothing may match the last case; with one it may classify it
+        if (!*c.action && !fallback_model.empty())
+            continue;
+        auto param = c.param ? intent.params.find(c.param) : intent.params.end();
+        if (intent.action != c.action || (c.param && (param == intent.params.end() || param->second != c.value)))
+        {
+            LOG_ERR("\"" << c.command << "\" gave " << describe(intent) << ", expected " << (*c.action ? c.action : "no intent")
+                         << (c.param ? std::string(" ") + c.param + "=\"" + c.value + "\"" : std::string()));
+            return 1;
+        }
+    }
+    const size_t case_count = sizeof(INTENT_CASES) / sizeof(INTENT_CASES[0]);
+    LOG("All " << case_count << " commands classified as expected.");
+    if (check_only)
+        return 0;
+
+    size_t matched = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        matched += !classifier.classify(INTENT_CASES[i % case_count].command).action.empty();
+    const double classify_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+    LOG("Classify: " << cv::format("%.2f", classify_us) << " us per command over " << iterations << " commands (" << matched << " matched)");
+
+    for (const std::string &command : commands)
+        LOG("\"" << command << "\" -> " << describe(classifier.classify(command)));
+    return 0;
+}
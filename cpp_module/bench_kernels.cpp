@@ -0,0 +1,187 @@
+#include "vision_kernels.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+
+// Checks every vision kernel level this CPU supports against the scalar reference, then times
+// them. Exits non-zero on the first mismatch; --check stops after the checks (the ctest run).
+//   bench_kernels [--iterations N] [--check]
+// AGENT_CPU_ISA does not restrict this tool; it always covers every supported level.
+
+static bool checkClassArgmax(const VisionKernels &kernels, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> score(0.0f, 1.0f);
+    // Lengths around every vector width exercise the remainder paths
+    for (int n : {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 63, 65, 8400})
+    {
+        const int classes = 5;
+        std::vector<float> rows(static_cast<size_t>(classes) * n);
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            // Repeated values test that ties keep the earlier class; NaNs must never win
+            rows[i] = i % 13 == 0 ? 0.5f : score(rng);
+            if (i % 97 == 5)
+                rows[i] = std::numeric_limits<float>::quiet_NaN();
+        }
+
+        std::vector<float> expected_scores(n, 0.0f), actual_scores(n, 0.0f);
+        std::vector<int> expected_classes(n, -1), actual_classes(n, -1);
+        for (int c = 0; c < classes; ++c)
+        {
+            VISION_KERNELS_SCALAR.update_class_argmax(rows.data() + static_cast<size_t>(c) * n, n, c, expected_scores.data(), expected_classes.data());
+            kernels.update_class_argmax(rows.data() + static_cast<size_t>(c) * n, n, c, actual_scores.data(), actual_classes.data());
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            if (expected_classes[i] != actual_classes[i] || std::memcmp(&expected_scores[i], &actual_scores[i], sizeof(float)) != 0)
+            {
+                LOG_ERR(cpuIsaName(kernels.isa) << " update_class_argmax differs at n=" << n << ", i=" << i);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool checkMaxAbsDiff(const VisionKernels &kernels, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 6144, 6151})
+    {
+        std::vector<uint8_t> a(n), b(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = static_cast<uint8_t>(byte(rng));
+            // Mostly small differences, so the maximum depends on a few bytes
+            b[i] = static_cast<uint8_t>(std::clamp(a[i] + byte(rng) % 7 - 3, 0, 255));
+        }
+        // Plant the largest difference in the last byte, where remainder handling matters
+        if (n > 0)
+        {
+            a[n - 1] = 255;
+            b[n - 1] = 0;
+        }
+        for (int trial = 0; trial < 2; ++trial)
+        {
+            int expected = VISION_KERNELS_SCALAR.max_abs_diff_u8(a.data(), b.data(), n);
+            int actual = kernels.max_abs_diff_u8(a.data(), b.data(), n);
+            if (expected != actual)
+            {
+                LOG_ERR(cpuIsaName(kernels.isa) << " max_abs_diff_u8 differs at n=" << n << ": " << actual << " vs " << expected);
+                return false;
+            }
+            if (n > 0)
+                b[n - 1] = 255; // Second trial: the maximum comes from the body
+        }
+    }
+    return true;
+}
+
+static bool checkDot(const VisionKernels &kernels, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (size_t n : {0, 1, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 6144, 6151, 66051})
+    {
+        std::vector<uint8_t> a(n), b(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = static_cast<uint8_t>(byte(rng));
+            b[i] = static_cast<uint8_t>(byte(rng));
+        }
+        for (int trial = 0; trial < 2; ++trial)
+        {
+            uint32_t expected = VISION_KERNELS_SCALAR.dot_u8(a.data(), b.data(), n);
+            uint32_t actual = kernels.dot_u8(a.data(), b.data(), n);
+            if (expected != actual)
+            {
+                LOG_ERR(cpuIsaName(kernels.isa) << " dot_u8 differs at n=" << n << ": " << actual << " vs " << expected);
+                return false;
+            }
+            // Second trial: all 255, the largest sums, which must not saturate
+            std::fill(a.begin(), a.end(), 255);
+            std::fill(b.begin(), b.end(), 255);
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 200;
+    bool check_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc)
+            iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--check")
+            check_only = true;
+    }
+
+    LOG("CPU supports " << cpuIsaName(detectCpuIsa()) << "; runtime selection is " << cpuIsaName(selectedCpuIsa()));
+
+    std::mt19937 rng(1234);
+    std::vector<const VisionKernels *> levels;
+    for (CpuIsa isa : {CpuIsa::Scalar, CpuIsa::SSE42, CpuIsa::AVX2, CpuIsa::AVX512})
+    {
+        const VisionKernels *kernels = visionKernelsFor(isa);
+        if (!kernels)
+        {
+            LOG(cpuIsaName(isa) << ": not available");
+            continue;
+        }
+        if (!checkClassArgmax(*kernels, rng) || !checkMaxAbsDiff(*kernels, rng) || !checkDot(*kernels, rng))
+            return 1;
+        levels.push_back(kernels);
+    }
+    LOG("All " << levels.size() << " available levels match the scalar kernels.");
+    if (check_only)
+        return 0;
+
+    // Timing on a COCO-sized YOLOv8 output at 640 and a 96x64 thumbnail, which also stands in
+    // for a button-sized template
+    const int num_classes = 80, num_proposals = 8400;
+    std::uniform_real_distribution<float> score(0.0f, 1.0f);
+    std::vector<float> scores(static_cast<size_t>(num_classes) * num_proposals);
+    for (float &s : scores)
+        s = score(rng);
+    std::vector<uint8_t> thumb_a(96 * 64), thumb_b(96 * 64);
+    for (size_t i = 0; i < thumb_a.size(); ++i)
+    {
+        thumb_a[i] = static_cast<uint8_t>(rng());
+        thumb_b[i] = static_cast<uint8_t>(rng());
+    }
+
+    std::vector<float> best_scores(num_proposals);
+    std::vector<int> best_classes(num_proposals);
+    LOG_REPORT(cv::format("%-8s %16s %16s %16s", "level", "argmax us", "maxdiff us", "dot us"));
+    for (const VisionKernels *kernels : levels)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it)
+        {
+            std::fill(best_scores.begin(), best_scores.end(), 0.0f);
+            for (int c = 0; c < num_classes; ++c)
+                kernels->update_class_argmax(scores.data() + static_cast<size_t>(c) * num_proposals, num_proposals, c, best_scores.data(), best_classes.data());
+        }
+        double argmax_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+        volatile int sink = 0;
+        start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations * 100; ++it)
+            sink = sink + kernels->max_abs_diff_u8(thumb_a.data(), thumb_b.data(), thumb_a.size());
+        double diff_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / (iterations * 100);
+
+        start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations * 100; ++it)
+            sink = sink + static_cast<int>(kernels->dot_u8(thumb_a.data(), thumb_b.data(), thumb_a.size()));
+        double dot_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / (iterations * 100);
+
+        LOG_REPORT(cv::format("%-8s %16.2f %16.3f %16.3f", cpuIsaName(kernels->isa), argmax_us, diff_us, dot_us));
+    }
+    return 0;
+}
@@ -0,0 +1,349 @@
+#include "yolo.hpp"
+#include "detection_eval.hpp"
+#include "detector_cascade.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+
+// A named detector configuration to score against the reference labels
+struct BenchConfig
+{
+    std::string name;
+    std::string model_path;
+    YoloSettings settings;
+    std::vector<std::string> classes;
+    // Set to run model_path as the large stage of a cascade behind this small model
+    std::string cascade_model_path;
+    CascadeConfig cascade;
+};
+
+struct BenchResult
+{
+    std::string name;
+    double map50 = 0.0;
+    double recall = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    double mean_ms = 0.0;
+    size_t rss_growth_bytes = 0; // Peak RSS over the config's run minus RSS just before it
+    size_t images = 0;
+    bool pareto = false;
+};
+
+static void printUsage()
+{
+    LOG("Usage: bench_pareto --images DIR [--labels DIR] [--config SPEC]... [--json PATH] [--limit N] [--write-reference]");
+    LOG("  SPEC is comma separated: name=fast,input=320,conf=0.4,nms=0.45,classes=person|car,model=models/yolo/yolo11n.onnx");
+    LOG("  Cascade keys: cascade=models/yolo/yolo11n.onnx (small first stage), accept=0.6, escalate=0.25, audit=30, crop_input=320");
+    LOG("  Without --config a sweep over input sizes 320, 480, 640 and 960 is run.");
+    LOG("  --write-reference runs the first config and saves its detections as the reference labels.");
+}
+
+static bool parseConfig(const std::string &spec, const std::string &default_model, BenchConfig &out_config)
+{
+    out_config = BenchConfig();
+    out_config.model_path = default_model;
+    for (const std::string &item : splitString(spec, ','))
+    {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos)
+        {
+            LOG_ERR("Config item without '=': " << item);
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        if (key == "name")
+            out_config.name = value;
+        else if (key == "input")
+            out_config.settings.input_width = out_config.settings.input_height = std::atoi(value.c_str());
+        else if (key == "conf")
+            out_config.settings.confidence_threshold = static_cast<float>(std::atof(value.c_str()));
+        else if (key == "nms")
+            out_config.settings.nms_threshold = static_cast<float>(std::atof(value.c_str()));
+        else if (key == "classes")
+            out_config.classes = splitString(value, '|');
+        else if (key == "model")
+            out_config.model_path = (std::filesystem::current_path() / value).generic_string();
+        else if (key == "cascade")
+            out_config.cascade_model_path = (std::filesystem::current_path() / value).generic_string();
+        else if (key == "accept")
+            out_config.cascade.accept_confidence = static_cast<float>(std::atof(value.c_str()));
+        else if (key == "escalate")
+            out_config.cascade.escalate_confidence = static_cast<float>(std::atof(value.c_str()));
+        else if (key == "audit")
+            out_config.cascade.audit_interval = std::atoi(value.c_str());
+        else if (key == "crop_input")
+            out_config.cascade.crop_input_size = std::atoi(value.c_str());
+        else
+        {
+            LOG_ERR("Unknown config key: " << key);
+            return false;
+        }
+    }
+    if (out_config.name.empty())
+        out_config.name = spec;
+    return out_config.settings.input_width > 0;
+}
+
+static std::vector<std::string> listImages(const std::string &dir)
+{
+    std::vector<std::string> images;
+    for (const auto &entry : std::filesystem::directory_iterator(dir))
+    {
+        if (entry.is_regular_file() && cv::haveImageReader(entry.path().generic_string()))
+            images.push_back(entry.path().generic_string());
+    }
+    std::sort(images.begin(), images.end());
+    return images;
+}
+
+static std::string labelPathFor(const std::string &labels_dir, const std::string &image_path)
+{
+    return (std::filesystem::path(labels_dir) / std::filesystem::path(image_path).stem()).generic_string() + ".txt";
+}
+
+static void writeJson(const std::string &path, const std::vector<BenchResult> &results)
+{
+    std::ofstream ofs(path);
+    if (!ofs.is_open())
+    {
+        LOG_ERR("Failed to write " << path);
+        return;
+    }
+    ofs << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult &r = results[i];
+        ofs << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"images\": " << r.images
+            << cv::format(", \"map50\": %.4f, \"recall\": %.4f, \"p50_ms\": %.2f, \"p99_ms\": %.2f, \"mean_ms\": %.2f", r.map50, r.recall, r.p50_ms, r.p99_ms, r.mean_ms)
+            << ", \"rss_growth_mb\": " << cv::format("%.1f", r.rss_growth_bytes / (1024.0 * 1024.0))
+            << ", \"pareto\": " << (r.pareto ? "true" : "false") << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    ofs << "  ]\n}\n";
+    LOG("Results written to " << path);
+}
+
+int main(int argc, char **argv)
+{
+    if (!setUpEnv())
+        return -1;
+
+    const std::string YOLO_MODEL_PATH = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
+    const std::string CLASS_NAMES_PATH = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+
+    std::string images_dir, labels_dir, json_path;
+    std::vector<std::string> config_specs;
+    size_t limit = 0;
+    bool write_reference = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--images" && has_value)
+            images_dir = argv[++i];
+        else if (arg == "--labels" && has_value)
+            labels_dir = argv[++i];
+        else if (arg == "--config" && has_value)
+            config_specs.push_back(argv[++i]);
+        else if (arg == "--json" && has_value)
+            json_path = argv[++i];
+        else if (arg == "--limit" && has_value)
+            limit = static_cast<size_t>(std::atoi(argv[++i]));
+        else if (arg == "--write-reference")
+            write_reference = true;
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+    if (images_dir.empty() || !std::filesystem::is_directory(images_dir))
+    {
+        printUsage();
+        return -1;
+    }
+    if (labels_dir.empty())
+        labels_dir = (std::filesystem::path(images_dir) / "labels").generic_string();
+
+    std::vector<BenchConfig> configs;
+    for (const std::string &spec : config_specs)
+    {
+        BenchConfig config;
+        if (!parseConfig(spec, YOLO_MODEL_PATH, config))
+        {
+            printUsage();
+            return -1;
+        }
+        configs.push_back(config);
+    }
+    if (configs.empty())
+    {
+        for (int size : {320, 480, 640, 960})
+        {
+            BenchConfig config;
+            config.name = "input" + std::to_string(size);
+            config.model_path = YOLO_MODEL_PATH;
+            config.settings.input_width = config.settings.input_height = size;
+            configs.push_back(config);
+        }
+    }
+
+    std::vector<std::string> images = listImages(images_dir);
+    if (limit > 0 && images.size() > limit)
+        images.resize(limit);
+    if (images.empty())
+    {
+        LOG_ERR("No images found in " << images_dir);
+        return -1;
+    }
+    LOG("Benchmarking " << configs.size() << " configs on " << images.size() << " images from " << images_dir);
+
+    HARDWARE_INFO hw_info;
+    cv::ocl::setUseOpenCL(true);
+    detectSystemArch(hw_info);
+
+    // One network per distinct model; configs that share a model share its net
+    std::map<std::string, cv::dnn::Net> nets;
+    std::vector<std::string> class_names_vec;
+    for (const BenchConfig &config : configs)
+    {
+        for (const std::string &model_path : {config.model_path, config.cascade_model_path})
+        {
+            if (model_path.empty() || nets.count(model_path))
+                continue;
+            class_names_vec.clear();
+            if (!setupYoloNetwork(nets[model_path], model_path, CLASS_NAMES_PATH, class_names_vec, hw_info))
+            {
+                LOG_ERR("Failed to setup YOLO network " << model_path);
+                return -1;
+            }
+        }
+    }
+    for (BenchConfig &config : configs)
+    {
+        if (!config.classes.empty() && !buildClassFilter(class_names_vec, config.classes, config.settings.class_filter))
+        {
+            LOG_ERR("Invalid classes in config " << config.name);
+            return -1;
+        }
+    }
+
+    if (write_reference)
+    {
+        const BenchConfig &reference = configs.front();
+        std::filesystem::create_directories(labels_dir);
+        std::vector<Detection> detections;
+        for (const std::string &image_path : images)
+        {
+            cv::Mat image = cv::imread(image_path);
+            if (image.empty())
+                continue;
+            detectObjectsWithYOLO(image, nets[reference.model_path], detections, reference.settings);
+            writeYoloLabels(labelPathFor(labels_dir, image_path), image.size(), detections);
+        }
+        LOG("Reference labels from config " << reference.name << " written to " << labels_dir);
+        return 0;
+    }
+
+    // Decode once up front so the timed loop measures detection only
+    std::vector<cv::Mat> frames;
+    std::vector<std::vector<GroundTruthBox>> truths;
+    for (const std::string &image_path : images)
+    {
+        cv::Mat image = cv::imread(image_path);
+        std::vector<GroundTruthBox> truth;
+        if (image.empty())
+            continue;
+        if (!loadYoloLabels(labelPathFor(labels_dir, image_path), image.size(), truth))
+        {
+            LOG_ERR("Missing reference labels for " << image_path << ", skipping it.");
+            continue;
+        }
+        frames.push_back(image);
+        truths.push_back(truth);
+    }
+    if (frames.empty())
+    {
+        LOG_ERR("No labelled images; run with --write-reference first or point --labels at the reference set.");
+        return -1;
+    }
+
+    std::vector<BenchResult> results;
+    for (const BenchConfig &config : configs)
+    {
+        // Every network is loaded already, so this leaves out the weights and what earlier configs
+        // allocated and counts what this config adds: its input size's buffers and its cascade
+        const size_t rss_before = getCurrentRssBytes();
+        size_t rss_peak = rss_before;
+        cv::dnn::Net &net = nets[config.model_path];
+        if (prepareYoloInputSizes(net, {config.settings.input_width}).empty())
+        {
+            LOG_ERR("Config " << config.name << " skipped: model does not accept input " << config.settings.input_width);
+            continue;
+        }
+
+        std::unique_ptr<DetectorCascade> cascade;
+        if (!config.cascade_model_path.empty())
+            cascade = std::make_unique<DetectorCascade>(nets[config.cascade_model_path], net, config.cascade);
+
+        DetectionEvaluator evaluator;
+        std::vector<double> latencies;
+        std::vector<Detection> detections;
+        BenchResult result;
+        result.name = config.name;
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (cascade)
+                cascade->detect(frames[i], detections, config.settings);
+            else
+                detectObjectsWithYOLO(frames[i], net, detections, config.settings);
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            rss_peak = std::max(rss_peak, getCurrentRssBytes());
+            evaluator.addImage(truths[i], detections);
+        }
+
+        result.rss_growth_bytes = rss_peak - rss_before;
+        result.images = frames.size();
+        result.map50 = evaluator.meanAveragePrecision();
+        result.recall = evaluator.recall();
+        result.p50_ms = percentile(latencies, 50.0);
+        result.p99_ms = percentile(latencies, 99.0);
+        double sum = 0.0;
+        for (double ms : latencies)
+            sum += ms;
+        result.mean_ms = sum / latencies.size();
+        results.push_back(result);
+        if (cascade)
+        {
+            const CascadeStats &stats = cascade->stats();
+            LOG("Cascade " << config.name << ": " << stats.escalated_boxes << " boxes escalated, " << stats.large_crop_passes
+                           << " large crop passes, " << stats.large_full_passes << " large full-frame passes over " << stats.frames << " frames");
+        }
+    }
+
+    std::vector<double> cost, value;
+    for (const BenchResult &r : results)
+    {
+        cost.push_back(r.p50_ms);
+        value.push_back(r.map50);
+    }
+    std::vector<bool> frontier = paretoFrontier(cost, value);
+    for (size_t i = 0; i < results.size(); ++i)
+        results[i].pareto = frontier[i];
+
+    LOG_REPORT(cv::format("%-20s %8s %8s %9s %9s %10s %7s", "config", "mAP50", "recall", "p50 ms", "p99 ms", "RSS +MB", "pareto"));
+    for (const BenchResult &r : results)
+    {
+        LOG_REPORT(cv::format("%-20s %8.4f %8.4f %9.2f %9.2f %10.1f %7s", r.name.c_str(), r.map50, r.recall, r.p50_ms, r.p99_ms,
+                       r.rss_growth_bytes / (1024.0 * 1024.0), r.pareto ? "*" : ""));
+    }
+    LOG("Process peak RSS: " << cv::format("%.1f", getPeakRssBytes() / (1024.0 * 1024.0)) << " MB");
+
+    if (!json_path.empty())
+        writeJson(json_path, results);
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "remote_inference.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+#include <thread>
+
+// Checks the remote inference protocol over loopback, then times the two payload kinds. Two
+// workers listen on free ports with an empty network, which answers every request with no
+// detections, so no model is needed. A blob request, an image request and malformed ones must
+// get the right replies, the workers must keep serving after the bad ones, and requests must
+// complete on the other worker when one is stopped while they are in flight. Exits non-zero on
+// the first failure; --check stops after the checks (the ctest run).
+//   bench_remote [--requests 200] [--check]
+
+const int REMOTE_BENCH_FAILOVER_REQUESTS = 32;
+
+static bool waitConnected(const RemoteDetector &detector, size_t workers)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(4 * REMOTE_CONNECT_TIMEOUT_MS))
+    {
+        size_t connected = 0;
+        for (const RemoteWorkerStats &s : detector.stats())
+            connected += s.connected;
+        if (connected == workers)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    LOG_ERR("The client did not connect to both workers.");
+    return false;
+}
+
+static bool checkReply(std::future<RemoteResult> reply, cv::Size frame_size, const char *what)
+{
+    try
+    {
+        RemoteResult result = reply.get();
+        if (result.local || result.frame_size != frame_size || !result.detections.empty())
+        {
+            LOG_ERR(what << ": got " << result.detections.size() << " detections for a " << result.frame_size << " frame"
+                         << (result.local ? " locally" : "") << ", expected none for " << frame_size << " from a worker.");
+            return false;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERR(what << " failed: " << e.what());
+        return false;
+    }
+    return true;
+}
+
+static bool checkRejected(std::future<RemoteResult> reply, const char *what)
+{
+    try
+    {
+        reply.get();
+    }
+    catch (const std::exception &e)
+    {
+        LOG(what << " rejected: " << e.what());
+        return true;
+    }
+    LOG_ERR(what << " was answered as if it were valid.");
+    return false;
+}
+
+static bool checkProtocol(RemoteDetector &detector, const cv::Mat &frame)
+{
+    YoloSettings settings;
+    cv::Mat blob;
+    prepareYoloBlob(frame, blob, settings);
+    if (!checkReply(detector.submitBlob(blob, frame.size(), settings), frame.size(), "Blob request") ||
+        !checkReply(detector.submit(frame, settings), frame.size(), "Image request"))
+        return false;
+
+    std::vector<uchar> garbage(1000);
+    for (size_t i = 0; i < garbage.size(); ++i)
+        garbage[i] = static_cast<uchar>(i * 7);
+    YoloSettings huge_input;
+    huge_input.input_width = huge_input.input_height = 100000;
+    YoloSettings huge_filter;
+    huge_filter.class_filter.assign(100000, 0);
+    if (!checkRejected(detector.submitEncoded(garbage, settings), "An image that does not decode") ||
+        !checkRejected(detector.submitEncoded(std::vector<uchar>(), settings), "An empty image") ||
+        !checkRejected(detector.submit(frame, huge_input), "A 100000x100000 input size") ||
+        !checkRejected(detector.submit(frame, huge_filter), "A 100000-class filter"))
+        return false;
+
+    // Both workers must still answer after the bad requests
+    std::vector<std::future<RemoteResult>> replies;
+    for (int i = 0; i < 2 * REMOTE_MAX_IN_FLIGHT; ++i)
+        replies.push_back(detector.submit(frame, settings));
+    for (auto &reply : replies)
+    {
+        if (!checkReply(std::move(reply), frame.size(), "Request after the malformed ones"))
+            return false;
+    }
+    LOG("Protocol check passed: blob and image requests answered, malformed requests rejected.");
+    return true;
+}
+
+static bool checkFailover(RemoteDetector &detector, InferenceWorker &stopped, const cv::Mat &frame)
+{
+    std::vector<std::future<RemoteResult>> replies;
+    for (int i = 0; i < REMOTE_BENCH_FAILOVER_REQUESTS; ++i)
+        replies.push_back(detector.submit(frame));
+    stopped.stop();
+    for (int i = 0; i < REMOTE_BENCH_FAILOVER_REQUESTS; ++i)
+        replies.push_back(detector.submit(frame));
+    for (auto &reply : replies)
+    {
+        if (!checkReply(std::move(reply), frame.size(), "Request while a worker stopped"))
+            return false;
+    }
+    uint64_t failovers = 0;
+    for (const RemoteWorkerStats &s : detector.stats())
+        failovers += s.failovers;
+    LOG("Failover check passed: " << replies.size() << " requests answered while a worker stopped, " << failovers << " moved to the other.");
+    return true;
+}
+
+// Mean milliseconds per request with max_in_flight requests pipelined
+static double timeRequests(RemoteDetector &detector, const cv::Mat &frame, RemotePayload payload, int requests)
+{
+    YoloSettings settings;
+    std::deque<std::future<RemoteResult>> replies;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; ++i)
+    {
+        if (payload == REMOTE_PAYLOAD_BLOB)
+        {
+            cv::Mat blob;
+            prepareYoloBlob(frame, blob, settings);
+            replies.push_back(detector.submitBlob(blob, frame.size(), settings));
+        }
+        else
+        {
+            std::vector<uchar> bytes;
+            cv::imencode(".jpg", frame, bytes);
+            replies.push_back(detector.submitEncoded(std::move(bytes), settings));
+        }
+        if (static_cast<int>(replies.size()) >= REMOTE_MAX_IN_FLIGHT)
+        {
+            replies.front().get();
+            replies.pop_front();
+        }
+    }
+    for (auto &reply : replies)
+        reply.get();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / requests;
+}
+
+int main(int argc, char **argv)
+{
+    int requests = 200;
+    bool check_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--requests" && i + 1 < argc)
+            requests = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--check")
+            check_only = true;
+    }
+
+    // Something a JPEG encoder has to work on, like a screenshot
+    cv::Mat frame(720, 1280, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(frame, frame, cv::Size(9, 9), 0);
+
+    cv::dnn::Net empty_a, empty_b;
+    InferenceWorker worker_a(empty_a), worker_b(empty_b);
+    if (!worker_a.start(0) || !worker_b.start(0))
+        return -1;
+    const std::vector<std::string> endpoints = {"127.0.0.1:" + std::to_string(worker_a.port()), "127.0.0.1:" + std::to_string(worker_b.port())};
+
+    {
+        RemoteDetector detector(endpoints);
+        if (!detector.start() || !waitConnected(detector, endpoints.size()) || !checkProtocol(detector, frame) ||
+            !checkFailover(detector, worker_a, frame))
+            return 1;
+    }
+    if (check_only)
+        return 0;
+
+    if (!worker_a.start(0))
+        return -1;
+    RemoteDetector detector({"127.0.0.1:" + std::to_string(worker_a.port()), endpoints[1]});
+    if (!detector.start() || !waitConnected(detector, 2))
+        return 1;
+    LOG(requests << " requests of a " << frame.cols << "x" << frame.rows << " frame over loopback, " << REMOTE_MAX_IN_FLIGHT
+                 << " in flight, empty network");
+    LOG_REPORT(cv::format("%-8s %14s", "payload", "ms/request"));
+    LOG_REPORT(cv::format("%-8s %14.3f", "blob", timeRequests(detector, frame, REMOTE_PAYLOAD_BLOB, requests)));
+    LOG_REPORT(cv::format("%-8s %14.3f", "image", timeRequests(detector, frame, REMOTE_PAYLOAD_IMAGE, requests)));
+    return 0;
+}
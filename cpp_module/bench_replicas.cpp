@@ -0,0 +1,154 @@
+#include "detector_pool.hpp"
+#include "synthetic_desktop.hpp"
+#include "detection_eval.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+
+// Measures how detection throughput scales with network replicas compared with giving one
+// network more intra-op threads. Every configuration gets the same total thread budget, split
+// evenly between its replicas, and runs the same synthetic desktop frames.
+//   bench_replicas [--model PATH] [--frames 200] [--threads N] [--max-replicas N] [--input-size 640]
+//                  [--resolution 1280x720]
+
+const int BENCH_FRAME_RING = 16; // Distinct frames cycled through, so memory stays small
+
+struct ReplicaRun
+{
+    int replicas = 0;
+    int threads_per_replica = 0;
+    double fps = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    size_t rss_bytes = 0;
+    uint64_t errors = 0;
+};
+
+static bool runConfig(const std::string &model_path, const HARDWARE_INFO &hw_info, const std::vector<cv::Mat> &frames, int frame_count,
+                      const YoloSettings &settings, int replicas, int threads_per_replica, ReplicaRun &out_run)
+{
+    out_run = ReplicaRun();
+    out_run.replicas = replicas;
+    out_run.threads_per_replica = threads_per_replica;
+
+    DetectorPool pool(replicas, threads_per_replica);
+    if (!pool.load(model_path, hw_info, {settings.input_width}))
+        return false;
+    out_run.rss_bytes = getCurrentRssBytes();
+
+    // Keep every replica's queue full; collect in order as the window fills
+    const size_t window = static_cast<size_t>(replicas) * (POOL_QUEUE_DEPTH + 1);
+    std::vector<double> latencies;
+    PoolResult result;
+    auto drain = [&](size_t keep)
+    {
+        while (pool.outstanding() > keep && pool.collect(result))
+        {
+            latencies.push_back(result.latency_ms);
+            if (!result.ok)
+                out_run.errors++;
+        }
+    };
+
+    // One round per replica first, so first-inference costs stay out of the timing
+    for (int i = 0; i < replicas * 2; ++i)
+        pool.submit(frames[i % frames.size()], settings);
+    drain(0);
+    latencies.clear();
+    out_run.errors = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frame_count; ++i)
+    {
+        pool.submit(frames[i % frames.size()], settings);
+        drain(window);
+    }
+    drain(0);
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    pool.stop();
+
+    out_run.fps = elapsed > 0.0 ? frame_count / elapsed : 0.0;
+    out_run.p50_ms = percentile(latencies, 50.0);
+    out_run.p99_ms = percentile(latencies, 99.0);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string model_path = (std::filesystem::current_path() / "models/yolo/yolo11l.onnx").generic_string();
+    int frame_count = 200;
+    int total_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int max_replicas = 0;
+    YoloSettings settings;
+    SyntheticDesktopConfig desktop;
+    desktop.resolution = cv::Size(1280, 720);
+    desktop.scenario = SyntheticScenario::Video;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--model" && has_value)
+            model_path = argv[++i];
+        else if (arg == "--frames" && has_value)
+            frame_count = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && has_value)
+            total_threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-replicas" && has_value)
+            max_replicas = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--input-size" && has_value)
+            settings.input_width = settings.input_height = std::atoi(argv[++i]);
+        else if (arg == "--resolution" && has_value && std::sscanf(argv[i + 1], "%dx%d", &desktop.resolution.width, &desktop.resolution.height) == 2)
+            ++i;
+        else
+        {
+            LOG("Usage: bench_replicas [--model PATH] [--frames N] [--threads N] [--max-replicas N] [--input-size N] [--resolution WxH]");
+            return -1;
+        }
+    }
+    if (max_replicas == 0)
+        max_replicas = total_threads;
+
+    if (!setUpEnv())
+        return -1;
+    HARDWARE_INFO hw_info;
+    detectSystemArchCached(hw_info, (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string());
+
+    SyntheticDesktopSource source(desktop);
+    if (!source.open())
+        return -1;
+    std::vector<cv::Mat> frames(BENCH_FRAME_RING);
+    for (cv::Mat &frame : frames)
+        source.read(frame);
+
+    // 1 x 1 is the reference; then the whole budget as intra-op threads of one network, and
+    // the same budget split between more and more replicas
+    std::vector<std::pair<int, int>> configs = {{1, 1}};
+    for (int replicas = 1; replicas <= max_replicas && replicas <= total_threads; replicas *= 2)
+        configs.push_back({replicas, total_threads / replicas});
+    if (configs.back().first != std::min(max_replicas, total_threads))
+    {
+        const int replicas = std::min(max_replicas, total_threads);
+        configs.push_back({replicas, total_threads / replicas});
+    }
+    configs.erase(std::unique(configs.begin(), configs.end()), configs.end());
+
+    LOG("Budget " << total_threads << " threads, " << frame_count << " frames of " << desktop.resolution.width << "x" << desktop.resolution.height
+                  << " at input " << settings.input_width << ", device " << hw_info.gpu_name);
+    std::vector<ReplicaRun> runs;
+    for (const auto &config : configs)
+    {
+        ReplicaRun run;
+        if (!runConfig(model_path, hw_info, frames, frame_count, settings, config.first, config.second, run))
+            return -1;
+        runs.push_back(run);
+    }
+
+    const double reference_fps = runs[0].fps > 0.0 ? runs[0].fps : 1.0;
+    LOG_REPORT(cv::format("%-9s %-15s %9s %8s %9s %9s %9s", "replicas", "threads/replica", "fps", "speedup", "p50 ms", "p99 ms", "RSS MB"));
+    for (const ReplicaRun &run : runs)
+    {
+        LOG_REPORT(cv::format("%-9d %-15d %9.2f %7.2fx %9.1f %9.1f %9.0f", run.replicas, run.threads_per_replica, run.fps, run.fps / reference_fps,
+                       run.p50_ms, run.p99_ms, run.rss_bytes / (1024.0 * 1024.0))
+            << (run.errors ? "  (" + std::to_string(run.errors) + " errors)" : std::string()));
+    }
+    return 0;
+}
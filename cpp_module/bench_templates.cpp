@@ -0,0 +1,266 @@
+#include "template_matcher.hpp"
+#include "synthetic_desktop.hpp"
+#include "detection_eval.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+
+// Checks and times TemplateRegistry on a synthetic desktop. Distinctive buttons and text fields
+// are cut out of the first frame as templates, then looked for on that frame, on a shifted copy
+// and on a copy scaled by 1.25 (the registry also holds 1.25x templates). Every element must be
+// found at its true box and a noise template must not be found; exits with 1 otherwise. With
+// --model the same frame also goes through the network once for comparison. --check repeats each
+// lookup only twice (the ctest run).
+//   bench_templates [--elements 8] [--repeat 20] [--seed 1] [--check] [--model PATH] [--names PATH]
+
+const float BENCH_MIN_IOU = 0.9f;
+// An element is only used when nothing else on screen correlates with it this well
+const float BENCH_MAX_LOOKALIKE_SCORE = 0.8f;
+const cv::Point BENCH_SHIFT(7, 5);
+const double BENCH_SCALE = 1.25;
+
+struct TemplateCase
+{
+    std::string name;
+    cv::Mat screen;
+    std::vector<cv::Rect> boxes; // Expected box per element
+};
+
+struct TemplateRun
+{
+    std::string name;
+    int found = 0;
+    int elements = 0;
+    double cold_ms = 0.0;   // Per element, whole screen, no previous hit
+    double hint_ms = 0.0;   // Per element, next to the previous hit
+    double region_ms = 0.0; // Per element, inside a region around the element
+};
+
+static double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// True if nothing outside box correlates with its content as well as BENCH_MAX_LOOKALIKE_SCORE
+static bool isDistinctive(const cv::Mat &gray, const cv::Rect &box)
+{
+    cv::Mat scores;
+    cv::matchTemplate(gray, gray(box), scores, cv::TM_CCOEFF_NORMED);
+    cv::Rect own(box.x - box.width / 2, box.y - box.height / 2, box.width, box.height);
+    scores(own & cv::Rect(0, 0, scores.cols, scores.rows)).setTo(-1.0f);
+    double peak;
+    cv::minMaxLoc(scores, nullptr, &peak);
+    return peak < BENCH_MAX_LOOKALIKE_SCORE;
+}
+
+// Looks for each element alone so every lookup is timed and checked separately
+static bool runCase(TemplateRegistry &registry, const TemplateCase &c, int repeat, TemplateRun &out_run)
+{
+    out_run = TemplateRun();
+    out_run.name = c.name;
+    out_run.elements = static_cast<int>(c.boxes.size());
+    std::vector<Detection> detections;
+    bool ok = true;
+
+    for (int k = 0; k < out_run.elements; ++k)
+    {
+        const cv::Rect &expected = c.boxes[k];
+        registry.clearHints();
+        detections.clear();
+        auto start = std::chrono::steady_clock::now();
+        const bool found = registry.match(c.screen, {k}, {}, detections);
+        out_run.cold_ms += msSince(start);
+        if (!found || rectIoU(detections[0].box, expected) < BENCH_MIN_IOU)
+        {
+            LOG_ERR(c.name << ": element_" << k << " at (" << expected.x << ", " << expected.y << ") "
+                           << (found ? "found at (" + std::to_string(detections[0].box.x) + ", " + std::to_string(detections[0].box.y) + ")" : std::string("not found")));
+            ok = false;
+            continue;
+        }
+        out_run.found++;
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; ++r)
+        {
+            detections.clear();
+            registry.match(c.screen, {k}, {}, detections);
+        }
+        out_run.hint_ms += msSince(start) / repeat;
+        if (detections.empty() || rectIoU(detections[0].box, expected) < BENCH_MIN_IOU)
+        {
+            LOG_ERR(c.name << ": element_" << k << " lost on the hinted lookup");
+            ok = false;
+        }
+
+        const cv::Rect region(expected.x - expected.width, expected.y - expected.height, expected.width * 3, expected.height * 3);
+        registry.clearHints();
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; ++r)
+        {
+            detections.clear();
+            registry.match(c.screen, {k}, {region}, detections);
+        }
+        out_run.region_ms += msSince(start) / repeat;
+        if (detections.empty() || rectIoU(detections[0].box, expected) < BENCH_MIN_IOU)
+        {
+            LOG_ERR(c.name << ": element_" << k << " not found inside its region");
+            ok = false;
+        }
+    }
+    if (out_run.elements > 0)
+    {
+        out_run.cold_ms /= out_run.elements;
+        out_run.hint_ms /= out_run.elements;
+        out_run.region_ms /= out_run.elements;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    int element_count = 8;
+    int repeat = 20;
+    std::string model_path;
+    std::string names_path = (std::filesystem::current_path() / "models/yolo/coco.names.txt").generic_string();
+    SyntheticDesktopConfig desktop;
+    desktop.scenario = SyntheticScenario::Static;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--elements" && has_value)
+            element_count = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--repeat" && has_value)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--check")
+            repeat = 2;
+        else if (arg == "--seed" && has_value)
+            desktop.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--model" && has_value)
+            model_path = argv[++i];
+        else if (arg == "--names" && has_value)
+            names_path = argv[++i];
+        else
+        {
+            LOG("Usage: bench_templates [--elements N] [--repeat N] [--seed N] [--check] [--model PATH] [--names PATH]");
+            return -1;
+        }
+    }
+
+    if (!setUpEnv())
+        return -1;
+
+    SyntheticDesktopSource source(desktop);
+    cv::Mat frame;
+    if (!source.open() || !source.read(frame))
+        return -1;
+    cv::Mat gray;
+    cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+
+    // Elements that only appear once, fully on screen after the shift
+    const cv::Rect inner(0, 0, frame.cols - BENCH_SHIFT.x, frame.rows - BENCH_SHIFT.y);
+    std::vector<cv::Rect> boxes;
+    for (const GroundTruthBox &gt : source.groundTruth())
+    {
+        if (static_cast<int>(boxes.size()) == element_count)
+            break;
+        if ((gt.class_id == SYNTHETIC_BUTTON || gt.class_id == SYNTHETIC_TEXT_FIELD) && (gt.box & inner) == gt.box &&
+            isDistinctive(gray, gt.box))
+        {
+            boxes.push_back(gt.box);
+        }
+    }
+    if (boxes.empty())
+    {
+        LOG_ERR("No distinctive elements on the synthetic desktop; try another --seed");
+        return -1;
+    }
+
+    std::vector<std::string> class_names;
+    for (size_t k = 0; k < boxes.size(); ++k)
+        class_names.push_back("element_" + std::to_string(k));
+    class_names.push_back("noise");
+
+    TemplateRegistry registry(class_names, {1.0, BENCH_SCALE});
+    auto setup_start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < boxes.size(); ++k)
+    {
+        if (!registry.addTemplate(class_names[k], frame(boxes[k])))
+            return -1;
+    }
+    const double setup_ms = msSince(setup_start);
+    cv::Mat noise(48, 96, CV_8UC3);
+    std::mt19937 rng(desktop.seed);
+    for (uchar *p = noise.data; p != noise.dataend; ++p)
+        *p = static_cast<uchar>(rng() & 0xFF);
+    if (!registry.addTemplate("noise", noise))
+        return -1;
+
+    std::vector<TemplateCase> cases(3);
+    cases[0].name = "original";
+    cases[0].screen = frame;
+    cases[0].boxes = boxes;
+
+    cases[1].name = "shifted";
+    cases[1].screen = cv::Mat(frame.size(), frame.type(), cv::Scalar::all(0));
+    frame(inner).copyTo(cases[1].screen(inner + BENCH_SHIFT));
+    for (const cv::Rect &box : boxes)
+        cases[1].boxes.push_back(box + BENCH_SHIFT);
+
+    cases[2].name = cv::format("scaled %.2f", BENCH_SCALE);
+    cv::resize(frame, cases[2].screen, cv::Size(), BENCH_SCALE, BENCH_SCALE, cv::INTER_LINEAR);
+    for (const cv::Rect &box : boxes)
+    {
+        cases[2].boxes.push_back(cv::Rect(static_cast<int>(std::lround(box.x * BENCH_SCALE)), static_cast<int>(std::lround(box.y * BENCH_SCALE)),
+                                          static_cast<int>(std::lround(box.width * BENCH_SCALE)), static_cast<int>(std::lround(box.height * BENCH_SCALE))));
+    }
+
+    bool ok = true;
+    std::vector<TemplateRun> runs;
+    for (const TemplateCase &c : cases)
+    {
+        TemplateRun run;
+        ok = runCase(registry, c, repeat, run) && ok;
+        runs.push_back(run);
+    }
+
+    std::vector<Detection> detections;
+    registry.clearHints();
+    auto negative_start = std::chrono::steady_clock::now();
+    const bool noise_found = registry.match(frame, {static_cast<int>(boxes.size())}, {}, detections);
+    const double negative_ms = msSince(negative_start);
+    if (noise_found)
+    {
+        LOG_ERR("Noise template matched at (" << detections[0].box.x << ", " << detections[0].box.y << ") with " << detections[0].confidence);
+        ok = false;
+    }
+
+    LOG(boxes.size() << " elements on a " << frame.cols << "x" << frame.rows << " synthetic desktop, templates prepared in "
+                     << cv::format("%.1f", setup_ms) << " ms");
+    LOG_REPORT(cv::format("%-12s %7s %10s %10s %10s", "screen", "found", "cold ms", "hint ms", "region ms"));
+    for (const TemplateRun &run : runs)
+        LOG_REPORT(cv::format("%-12s %3d/%-3d %10.2f %10.3f %10.3f", run.name.c_str(), run.found, run.elements, run.cold_ms, run.hint_ms, run.region_ms));
+    LOG_REPORT(cv::format("%-12s %7s %10.2f", "miss", noise_found ? "FOUND" : "none", negative_ms));
+
+    if (!model_path.empty())
+    {
+        HARDWARE_INFO hw_info;
+        detectSystemArchCached(hw_info, (std::filesystem::current_path() / "kernel_cache/hardware_probe.txt").generic_string());
+        cv::dnn::Net net;
+        std::vector<std::string> network_names;
+        if (!setupYoloNetwork(net, model_path, names_path, network_names, hw_info))
+            return -1;
+        detectObjectsWithYOLO(frame, net, detections); // First inference sets up the backend
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; ++r)
+            detectObjectsWithYOLO(frame, net, detections);
+        LOG_REPORT(cv::format("%-12s %7s %10.2f", "network", "-", msSince(start) / repeat) << " ms per frame on " << hw_info.gpu_name);
+    }
+
+    if (!ok)
+    {
+        LOG_ERR("Template matching check failed");
+        return 1;
+    }
+    LOG("Every element was found at its box");
+    return 0;
+}
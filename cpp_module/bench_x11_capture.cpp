@@ -0,0 +1,314 @@
+#include "x11_capture.hpp"
+#include "detection_eval.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <thread>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+// Checks and times X11 screen capture. A scripted client paints known rectangles through its
+// own connection, like any other application would; the MIT-SHM + XDamage source must report
+// each one as damaged and return its pixels, and must return nothing while the screen is still.
+// Exits non-zero on the first mismatch. Then every capture mode is timed on the same script
+// (one small repaint every --change-every frames, the rest idle), against a plain XGetImage
+// loop. CPU time is this process only; the X server's share of a grab is not included.
+// --check stops after the damage checks; without a display it then exits with
+// CAPTURE_SKIP_EXIT_CODE, which ctest reports as skipped.
+//   Xvfb :99 -screen 0 1920x1080x24 &
+//   bench_x11_capture --display :99 [--frames 300] [--change-every 4] [--checks 50] [--check]
+
+const int CAPTURE_WAIT_MS = 500; // Longest a damage event may take to arrive after a paint
+const cv::Size PAINT_SIZE(120, 40); // Roughly a changed text line or button
+const int CAPTURE_SKIP_EXIT_CODE = 77;
+
+// Paints on an override-redirect window covering the screen, so no window manager is needed
+class ScriptedClient
+{
+public:
+    ~ScriptedClient() { close(); }
+
+    bool open(const std::string &display_name, cv::Size size)
+    {
+        display_ = XOpenDisplay(display_name.empty() ? nullptr : display_name.c_str());
+        if (!display_)
+            return false;
+        XSetWindowAttributes attributes;
+        attributes.override_redirect = True;
+        attributes.background_pixel = BlackPixel(display_, DefaultScreen(display_));
+        attributes.event_mask = StructureNotifyMask;
+        window_ = XCreateWindow(display_, DefaultRootWindow(display_), 0, 0, size.width, size.height, 0, CopyFromParent, InputOutput, CopyFromParent,
+                                CWOverrideRedirect | CWBackPixel | CWEventMask, &attributes);
+        gc_ = XCreateGC(display_, window_, 0, nullptr);
+        XMapRaised(display_, window_);
+        XEvent event;
+        do
+        {
+            XWindowEvent(display_, window_, StructureNotifyMask, &event);
+        } while (event.type != MapNotify);
+        XSync(display_, False);
+        return true;
+    }
+
+    // Returns once the server has drawn it
+    void paint(const cv::Rect &rect, const cv::Vec3b &bgr)
+    {
+        XSetForeground(display_, gc_, (static_cast<unsigned long>(bgr[2]) << 16) | (static_cast<unsigned long>(bgr[1]) << 8) | bgr[0]);
+        XFillRectangle(display_, window_, gc_, rect.x, rect.y, rect.width, rect.height);
+        XSync(display_, False);
+    }
+
+    void close()
+    {
+        if (!display_)
+            return;
+        XFreeGC(display_, gc_);
+        XDestroyWindow(display_, window_);
+        XCloseDisplay(display_);
+        display_ = nullptr;
+    }
+
+private:
+    Display *display_ = nullptr;
+    Window window_ = 0;
+    GC gc_ = nullptr;
+};
+
+struct CaptureRun
+{
+    std::string mode;
+    size_t reads = 0;
+    size_t frames = 0;
+    double idle_read_ms = 0.0; // Mean cost of a read while nothing changed
+    double p50_latency_ms = 0.0; // Paint finished to frame returned
+    double p99_latency_ms = 0.0;
+    double cpu_ms_per_read = 0.0;
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Reads until a frame comes back or CAPTURE_WAIT_MS pass
+static bool readWithin(X11ScreenSource &source, cv::Mat &frame)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (!source.read(frame))
+    {
+        if (!source.unchanged() || elapsedMs(start) > CAPTURE_WAIT_MS)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+static cv::Vec3b randomColor(std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int> channel(0, 255);
+    cv::Vec3b color;
+    for (int c = 0; c < 3; ++c)
+        color[c] = static_cast<uchar>(channel(rng));
+    return color;
+}
+
+static cv::Rect randomRect(std::mt19937 &rng, cv::Size screen)
+{
+    std::uniform_int_distribution<int> x(0, screen.width - PAINT_SIZE.width), y(0, screen.height - PAINT_SIZE.height);
+    return cv::Rect(cv::Point(x(rng), y(rng)), PAINT_SIZE);
+}
+
+static bool checkDamageCapture(const std::string &display_name, ScriptedClient &client, cv::Size screen, int checks)
+{
+    X11ScreenSource source({display_name, true, true});
+    X11ScreenSource reference({display_name, false, false});
+    if (!source.open() || !reference.open())
+        return false;
+    if (!source.usingShm() || !source.usingDamage())
+    {
+        LOG_ERR("The display does not offer MIT-SHM and XDamage to this client.");
+        return false;
+    }
+
+    cv::Mat frame, expected;
+    if (!source.read(frame))
+    {
+        LOG_ERR("The first read must return the whole screen.");
+        return false;
+    }
+    // Let damage from before the source opened drain, then the screen is still
+    for (int i = 0; i < 100 && readWithin(source, frame); ++i)
+    {
+    }
+    if (source.read(frame) || !source.unchanged())
+    {
+        LOG_ERR("A read returned a frame although nothing was drawn.");
+        return false;
+    }
+
+    std::mt19937 rng(7);
+    std::vector<cv::Rect> regions;
+    for (int i = 0; i < checks; ++i)
+    {
+        const cv::Rect rect = randomRect(rng, screen);
+        const cv::Vec3b color = randomColor(rng);
+        client.paint(rect, color);
+        if (!readWithin(source, frame))
+        {
+            LOG_ERR("Paint " << i << " at " << rect << " was not reported as damage.");
+            return false;
+        }
+        if (!source.changedRegions(regions))
+            return false;
+        cv::Mat covered = cv::Mat::zeros(screen, CV_8U);
+        for (const cv::Rect &r : regions)
+            covered(r).setTo(255);
+        if (cv::countNonZero(covered(rect)) != rect.area())
+        {
+            LOG_ERR("Paint " << i << " at " << rect << " is not covered by the " << regions.size() << " damaged rectangles.");
+            return false;
+        }
+        if (frame.at<cv::Vec3b>(rect.y + rect.height / 2, rect.x + rect.width / 2) != color)
+        {
+            LOG_ERR("Paint " << i << " at " << rect << " has the wrong pixels in the captured frame.");
+            return false;
+        }
+        // Both capture paths must return the same screen
+        if (!reference.read(expected) || cv::norm(frame, expected, cv::NORM_INF) != 0.0)
+        {
+            LOG_ERR("The MIT-SHM frame differs from XGetImage after paint " << i << ".");
+            return false;
+        }
+    }
+    LOG("Damage check passed: " << checks << " paints reported with the right rectangles and pixels, no frames while idle.");
+    return true;
+}
+
+static bool timeCapture(const std::string &mode, const X11CaptureOptions &options, ScriptedClient &client, cv::Size screen, int frames, int change_every,
+                        CaptureRun &out_run)
+{
+    out_run = CaptureRun();
+    out_run.mode = mode;
+    X11ScreenSource source(options);
+    if (!source.open())
+        return false;
+    cv::Mat frame;
+    readWithin(source, frame);
+
+    std::mt19937 rng(11);
+    std::vector<double> latencies;
+    double idle_sum_ms = 0.0;
+    size_t idle_reads = 0;
+    std::clock_t cpu = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        const bool paint = i % change_every == 0;
+        if (paint)
+            client.paint(randomRect(rng, screen), randomColor(rng));
+
+        auto start = std::chrono::steady_clock::now();
+        const std::clock_t cpu_start = std::clock();
+        bool got = paint ? readWithin(source, frame) : source.read(frame);
+        cpu += std::clock() - cpu_start;
+        const double ms = elapsedMs(start);
+        out_run.reads++;
+        if (got)
+            out_run.frames++;
+        if (paint)
+        {
+            if (!got)
+            {
+                LOG_ERR(mode << ": paint " << i << " was not captured.");
+                return false;
+            }
+            latencies.push_back(ms);
+        }
+        else
+        {
+            idle_sum_ms += ms;
+            idle_reads++;
+        }
+    }
+    out_run.idle_read_ms = idle_reads ? idle_sum_ms / idle_reads : 0.0;
+    out_run.p50_latency_ms = percentile(latencies, 50.0);
+    out_run.p99_latency_ms = percentile(latencies, 99.0);
+    out_run.cpu_ms_per_read = 1000.0 * cpu / CLOCKS_PER_SEC / std::max<size_t>(1, out_run.reads);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string display_name;
+    int frames = 300;
+    int change_every = 4;
+    int checks = 50;
+    bool check_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--display" && has_value)
+            display_name = argv[++i];
+        else if (arg == "--frames" && has_value)
+            frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--change-every" && has_value)
+            change_every = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--checks" && has_value)
+            checks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--check")
+            check_only = true;
+        else
+        {
+            LOG("Usage: bench_x11_capture [--display :99] [--frames N] [--change-every N] [--checks N] [--check]");
+            return -1;
+        }
+    }
+
+    X11ScreenSource probe({display_name, false, false});
+    if (!probe.open())
+    {
+        if (check_only)
+        {
+            LOG("No X display to check against; skipping.");
+            return CAPTURE_SKIP_EXIT_CODE;
+        }
+        return -1;
+    }
+    const cv::Size screen = probe.size();
+    probe.close();
+
+    ScriptedClient client;
+    if (!client.open(display_name, screen))
+    {
+        LOG_ERR("The scripted client cannot connect to the display.");
+        return -1;
+    }
+    if (!checkDamageCapture(display_name, client, screen, checks))
+        return 1;
+    if (check_only)
+        return 0;
+
+    const std::vector<std::pair<std::string, X11CaptureOptions>> modes = {
+        {"XGetImage", {display_name, false, false}},
+        {"MIT-SHM", {display_name, true, false}},
+        {"MIT-SHM + XDamage", {display_name, true, true}},
+    };
+    std::vector<CaptureRun> runs;
+    for (const auto &mode : modes)
+    {
+        CaptureRun run;
+        if (!timeCapture(mode.first, mode.second, client, screen, frames, change_every, run))
+            return 1;
+        runs.push_back(run);
+    }
+
+    LOG(screen.width << "x" << screen.height << ", " << frames << " reads, one paint every " << change_every << " reads");
+    LOG_REPORT(cv::format("%-18s %7s %7s %13s %14s %14s %13s", "mode", "reads", "frames", "idle read ms", "p50 latency ms", "p99 latency ms", "CPU ms/read"));
+    for (const CaptureRun &run : runs)
+    {
+        LOG_REPORT(cv::format("%-18s %7zu %7zu %13.3f %14.2f %14.2f %13.3f", run.mode.c_str(), run.reads, run.frames, run.idle_read_ms, run.p50_latency_ms,
+                       run.p99_latency_ms, run.cpu_ms_per_read));
+    }
+    return 0;
+}
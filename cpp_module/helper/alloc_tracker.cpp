@@ -0,0 +1,308 @@
+#include "alloc_tracker.hpp"
+#include "utils.hpp"
+#include <cstdlib>
+#include <new>
+
+// Everything touched from operator new is either constant-initialized or trivially thread-local,
+// so counting is safe during static initialization and thread start-up
+static std::atomic<bool> tracking_enabled{false};
+static thread_local int current_stage = ALLOC_STAGE_OTHER;
+
+struct AtomicCounters
+{
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> frees;
+};
+
+static AtomicCounters heap_counters[ALLOC_STAGE_COUNT];
+static AtomicCounters mat_counters[ALLOC_STAGE_COUNT];
+
+static inline void countAllocation(AtomicCounters *counters, size_t size)
+{
+    if (!tracking_enabled.load(std::memory_order_relaxed))
+        return;
+    AtomicCounters &c = counters[current_stage];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static inline void countFree(AtomicCounters *counters)
+{
+    if (tracking_enabled.load(std::memory_order_relaxed))
+        counters[current_stage].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifndef AGENT_NO_ALLOC_HOOKS
+// Aligned new keeps the library implementation; over-aligned types are rare in this pipeline
+void *operator new(std::size_t size)
+{
+    countAllocation(heap_counters, size);
+    for (;;)
+    {
+        if (void *p = std::malloc(size ? size : 1))
+            return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept
+{
+    if (!p)
+        return;
+    countFree(heap_counters);
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+#endif
+
+// Wraps the standard Mat allocator. Buffers it hands out point back to this wrapper, so their
+// release is counted as well.
+class TrackingMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step, cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override
+    {
+        cv::UMatData *u = cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+        if (u)
+        {
+            u->currAllocator = this;
+            if (!data)
+                countAllocation(mat_counters, u->size);
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData *u, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(u, access_flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData *u) const override
+    {
+        if (u && !(u->flags & cv::UMatData::USER_ALLOCATED))
+            countFree(mat_counters);
+        cv::Mat::getStdAllocator()->deallocate(u);
+    }
+};
+
+const char *allocStageName(AllocStage stage)
+{
+    switch (stage)
+    {
+    case ALLOC_STAGE_CAPTURE:
+        return "capture";
+    case ALLOC_STAGE_PREPROCESS:
+        return "preprocess";
+    case ALLOC_STAGE_INFERENCE:
+        return "inference";
+    case ALLOC_STAGE_POSTPROCESS:
+        return "postprocess";
+    case ALLOC_STAGE_DISPLAY:
+        return "display";
+    default:
+        return "other";
+    }
+}
+
+AllocStageScope::AllocStageScope(AllocStage stage)
+    : previous_(current_stage)
+{
+    current_stage = stage;
+}
+
+AllocStageScope::~AllocStageScope()
+{
+    current_stage = previous_;
+}
+
+void enableAllocTracking()
+{
+    if (tracking_enabled)
+        return;
+    // Never freed: Mats that outlive main still point at it when they are released
+    static TrackingMatAllocator *mat_allocator = new TrackingMatAllocator();
+    cv::Mat::setDefaultAllocator(mat_allocator);
+    tracking_enabled = true;
+#ifdef AGENT_NO_ALLOC_HOOKS
+    LOG_WARN("Allocation tracking enabled without operator new hooks; only cv::Mat buffers are counted.");
+#else
+    LOG("Allocation tracking enabled.");
+#endif
+}
+
+bool allocTrackingEnabled()
+{
+    return tracking_enabled;
+}
+
+uint64_t AllocSnapshot::totalAllocations() const
+{
+    uint64_t total = 0;
+    for (int s = 0; s < ALLOC_STAGE_COUNT; ++s)
+        total += heap[s].allocations + mat[s].allocations;
+    return total;
+}
+
+uint64_t AllocSnapshot::totalFrees() const
+{
+    uint64_t total = 0;
+    for (int s = 0; s < ALLOC_STAGE_COUNT; ++s)
+        total += heap[s].frees + mat[s].frees;
+    return total;
+}
+
+static AllocCounters load(const AtomicCounters &c)
+{
+    AllocCounters out;
+    out.allocations = c.allocations.load(std::memory_order_relaxed);
+    out.bytes = c.bytes.load(std::memory_order_relaxed);
+    out.frees = c.frees.load(std::memory_order_relaxed);
+    return out;
+}
+
+AllocSnapshot allocSnapshot()
+{
+    AllocSnapshot snapshot;
+    for (int s = 0; s < ALLOC_STAGE_COUNT; ++s)
+    {
+        snapshot.heap[s] = load(heap_counters[s]);
+        snapshot.mat[s] = load(mat_counters[s]);
+    }
+    return snapshot;
+}
+
+static AllocCounters operator-(const AllocCounters &after, const AllocCounters &before)
+{
+    AllocCounters delta;
+    delta.allocations = after.allocations - before.allocations;
+    delta.bytes = after.bytes - before.bytes;
+    delta.frees = after.frees - before.frees;
+    return delta;
+}
+
+static void operator+=(AllocCounters &total, const AllocCounters &delta)
+{
+    total.allocations += delta.allocations;
+    total.bytes += delta.bytes;
+    total.frees += delta.frees;
+}
+
+FrameAllocMeter::FrameAllocMeter(uint64_t warmup_frames)
+    : warmup_frames_(warmup_frames), previous_(allocSnapshot())
+{
+}
+
+void FrameAllocMeter::addFrames(uint64_t frames)
+{
+    if (frames == 0)
+        return;
+    AllocSnapshot now = allocSnapshot();
+    for (int s = 0; s < ALLOC_STAGE_COUNT; ++s)
+    {
+        last_period_.heap[s] = now.heap[s] - previous_.heap[s];
+        last_period_.mat[s] = now.mat[s] - previous_.mat[s];
+    }
+    last_period_frames_ = frames;
+    previous_ = now;
+
+    const bool steady = frames_ >= warmup_frames_;
+    frames_ += frames;
+    if (!steady)
+        return;
+    for (int s = 0; s < ALLOC_STAGE_COUNT; ++s)
+    {
+        steady_total_.heap[s] += last_period_.heap[s];
+        steady_total_.mat[s] += last_period_.mat[s];
+    }
+    steady_frames_ += frames;
+    worst_per_frame_ = std::max(worst_per_frame_, static_cast<double>(last_period_.totalAllocations()) / frames);
+}
+
+std::string FrameAllocMeter::report() const
+{
+    std::ostringstream out;
+    out << "Allocations per frame:";
+    if (last_period_frames_ > 0)
+    {
+        const double n = static_cast<double>(last_period_frames_);
+        for (int s = 0; s < ALLOC_STAGE_COUNT; ++s)
+        {
+            const AllocCounters &heap = last_period_.heap[s];
+            const AllocCounters &mat = last_period_.mat[s];
+            if (heap.allocations + mat.allocations == 0)
+                continue;
+            out << " " << allocStageName(static_cast<AllocStage>(s)) << " " << cv::format("%.1f new/%.1f mat (%.2f MB)", heap.allocations / n, mat.allocations / n, (heap.bytes + mat.bytes) / n / (1024.0 * 1024.0)) << ",";
+        }
+    }
+    if (steady_frames_ > 0)
+    {
+        const double n = static_cast<double>(steady_frames_);
+        // Allocations minus frees; a steady positive value means the pipeline is holding on to memory
+        const double net = (static_cast<double>(steady_total_.totalAllocations()) - static_cast<double>(steady_total_.totalFrees())) / n;
+        out << cv::format(" steady avg %.1f, worst %.1f, net %+.2f", steady_total_.totalAllocations() / n, worst_per_frame_, net);
+    }
+    else
+    {
+        out << " warming up";
+    }
+    out << cv::format(" | RSS %.1f MB, peak %.1f MB", getCurrentRssBytes() / (1024.0 * 1024.0), getPeakRssBytes() / (1024.0 * 1024.0));
+    return out.str();
+}
+
+bool FrameAllocMeter::checkBudget(double max_allocations_per_frame) const
+{
+    if (steady_frames_ == 0)
+    {
+        LOG_ERR("Allocation budget not checked: no frames after the " << warmup_frames_ << "-frame warm-up.");
+        return false;
+    }
+    if (worst_per_frame_ > max_allocations_per_frame)
+    {
+        LOG_ERR("Allocation budget exceeded: " << cv::format("%.1f", worst_per_frame_) << " allocations per frame, budget "
+                                               << max_allocations_per_frame << ".");
+        return false;
+    }
+    LOG("Allocation budget met: worst " << cv::format("%.1f", worst_per_frame_) << " allocations per frame over "
+                                        << steady_frames_ << " steady frames, budget " << max_allocations_per_frame << ".");
+    return true;
+}
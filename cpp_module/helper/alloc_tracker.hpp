@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Pipeline stages allocations are attributed to; indexes the counter arrays
+enum AllocStage
+{
+    ALLOC_STAGE_OTHER = 0,
+    ALLOC_STAGE_CAPTURE,
+    ALLOC_STAGE_PREPROCESS,
+    ALLOC_STAGE_INFERENCE,
+    ALLOC_STAGE_POSTPROCESS,
+    ALLOC_STAGE_DISPLAY,
+    ALLOC_STAGE_COUNT,
+};
+
+const char *allocStageName(AllocStage stage);
+
+// Attributes the allocations this thread makes to a stage until it goes out of scope.
+// Costs a thread-local store, so it can stay in hot paths with tracking off.
+class AllocStageScope
+{
+public:
+    explicit AllocStageScope(AllocStage stage);
+    ~AllocStageScope();
+    AllocStageScope(const AllocStageScope &) = delete;
+    AllocStageScope &operator=(const AllocStageScope &) = delete;
+
+private:
+    int previous_;
+};
+
+// Starts counting heap (global operator new) and cv::Mat buffer allocations per stage. Call it
+// early in main, before the pipeline threads start; Mats allocated earlier are not counted.
+// The operator new/delete replacements are compiled in unless AGENT_ALLOC_HOOKS is OFF; with
+// tracking off they cost one relaxed atomic load per call.
+void enableAllocTracking();
+bool allocTrackingEnabled();
+
+struct AllocCounters
+{
+    uint64_t allocations = 0;
+    uint64_t bytes = 0; // Requested bytes, not including allocator overhead
+    uint64_t frees = 0;
+};
+
+struct AllocSnapshot
+{
+    AllocCounters heap[ALLOC_STAGE_COUNT]; // operator new
+    AllocCounters mat[ALLOC_STAGE_COUNT];  // cv::Mat data buffers
+
+    uint64_t totalAllocations() const;
+    uint64_t totalFrees() const;
+};
+
+// Totals since enableAllocTracking(), summed over every thread
+AllocSnapshot allocSnapshot();
+
+// Turns the running totals into per-frame numbers for one pipeline loop. Periods that end
+// within the first warmup_frames frames (model warm-up, first-frame buffer growth) are left
+// out of the steady-state figures. Not thread-safe; call it from one thread.
+class FrameAllocMeter
+{
+public:
+    explicit FrameAllocMeter(uint64_t warmup_frames = 30);
+    // Closes the period since the previous call, which covered this many frames
+    void addFrames(uint64_t frames = 1);
+    // Per-stage allocations of the last period, steady-state averages and RSS, on one line
+    std::string report() const;
+    uint64_t steadyFrames() const { return steady_frames_; }
+    // Highest per-frame allocation count of any steady-state period
+    double worstAllocationsPerFrame() const { return worst_per_frame_; }
+    // Logs and returns false when a steady-state period went over the budget, or none was measured
+    bool checkBudget(double max_allocations_per_frame) const;
+
+private:
+    uint64_t warmup_frames_;
+    uint64_t frames_ = 0;
+    uint64_t steady_frames_ = 0;
+    uint64_t last_period_frames_ = 0;
+    double worst_per_frame_ = 0.0;
+    AllocSnapshot previous_;
+    AllocSnapshot last_period_;
+    AllocSnapshot steady_total_;
+};
@@ -0,0 +1,132 @@
+#include "cpu_features.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define AGENT_X86_64 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef AGENT_X86_64
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i)
+        regs[i] = static_cast<unsigned>(out[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switch (XCR0)
+static unsigned long long xgetbv0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return static_cast<unsigned long long>(edx) << 32 | eax;
+#endif
+}
+#endif
+
+CpuIsa detectCpuIsa()
+{
+#ifdef AGENT_X86_64
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    const unsigned ecx1 = regs[2];
+    const bool sse41 = ecx1 & (1u << 19);
+    const bool sse42 = ecx1 & (1u << 20);
+    const bool osxsave = ecx1 & (1u << 27);
+    const bool avx = ecx1 & (1u << 28);
+    if (!sse41 || !sse42)
+        return CpuIsa::Scalar;
+    if (!osxsave || !avx || max_leaf < 7)
+        return CpuIsa::SSE42;
+
+    const unsigned long long xcr0 = xgetbv0();
+    cpuid(7, 0, regs);
+    const unsigned ebx7 = regs[1];
+    const bool ymm_state = (xcr0 & 0x6) == 0x6;    // SSE and AVX state
+    const bool zmm_state = (xcr0 & 0xE6) == 0xE6; // Plus opmask and both ZMM halves
+    if (!ymm_state || !(ebx7 & (1u << 5)))
+        return CpuIsa::SSE42;
+    if (zmm_state && (ebx7 & (1u << 16)) && (ebx7 & (1u << 30)))
+        return CpuIsa::AVX512;
+    return CpuIsa::AVX2;
+#else
+    return CpuIsa::Scalar;
+#endif
+}
+
+CpuIsa selectedCpuIsa()
+{
+    static const CpuIsa selected = []
+    {
+        CpuIsa isa = detectCpuIsa();
+        const char *env = std::getenv("AGENT_CPU_ISA");
+        if (env && *env)
+        {
+            CpuIsa requested;
+            if (!parseCpuIsa(env, requested))
+            {
+                LOG_ERR("Ignoring unknown AGENT_CPU_ISA value: " << env);
+            }
+            else if (requested > isa)
+            {
+                LOG_ERR("AGENT_CPU_ISA=" << env << " is not supported by this CPU; using " << cpuIsaName(isa));
+            }
+            else
+            {
+                isa = requested;
+            }
+        }
+        LOG("Vision kernels: " << cpuIsaName(isa) << " (CPU supports " << cpuIsaName(detectCpuIsa()) << ")");
+        return isa;
+    }();
+    return selected;
+}
+
+const char *cpuIsaName(CpuIsa isa)
+{
+    switch (isa)
+    {
+    case CpuIsa::SSE42:
+        return "sse4.2";
+    case CpuIsa::AVX2:
+        return "avx2";
+    case CpuIsa::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+bool parseCpuIsa(const std::string &name, CpuIsa &out_isa)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    for (CpuIsa isa : {CpuIsa::Scalar, CpuIsa::SSE42, CpuIsa::AVX2, CpuIsa::AVX512})
+    {
+        if (lower == cpuIsaName(isa))
+        {
+            out_isa = isa;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+// Instruction set levels the vision kernels are built for, in increasing order
+enum class CpuIsa
+{
+    Scalar = 0,
+    SSE42 = 1,
+    AVX2 = 2,
+    AVX512 = 3, // AVX-512 F + BW
+};
+
+// Highest level this CPU and OS support (CPUID, plus XGETBV for the AVX register state)
+CpuIsa detectCpuIsa();
+// detectCpuIsa() capped by the AGENT_CPU_ISA environment variable (scalar, sse4.2, avx2 or
+// avx512), so each kernel variant can be benchmarked on one machine. Resolved once per process.
+CpuIsa selectedCpuIsa();
+
+const char *cpuIsaName(CpuIsa isa);
+// Accepts the names cpuIsaName() returns, case-insensitively. Returns false for anything else.
+bool parseCpuIsa(const std::string &name, CpuIsa &out_isa);
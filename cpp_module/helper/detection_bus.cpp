@@ -0,0 +1,134 @@
+#include "detection_bus.hpp"
+#include <algorithm>
+
+bool DetectionEvent::covers(const cv::Rect &region) const
+{
+    if (regions.empty())
+        return true;
+    if (region.empty())
+        return false;
+    return std::any_of(regions.begin(), regions.end(), [&region](const cv::Rect &r)
+                       { return (r & region) == region; });
+}
+
+bool DetectionEvent::searched(int class_id) const
+{
+    if (classes.empty())
+        return true;
+    return class_id >= 0 && std::find(classes.begin(), classes.end(), class_id) != classes.end();
+}
+
+void DetectionBus::publish(DetectionEvent event)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        event.sequence = next_sequence_++;
+        for (Waiter *waiter : waiters_)
+        {
+            if (waiter->matched || (waiter->needs_text && !event.has_text) || !event.covers(waiter->region) ||
+                !event.searched(waiter->class_id))
+                continue;
+            if ((*waiter->predicate)(event))
+            {
+                waiter->matched = true;
+                waiter->event = event;
+            }
+        }
+        latest_ = std::move(event);
+        has_latest_ = true;
+    }
+    matched_.notify_all();
+}
+
+bool DetectionBus::waitFor(const DetectionPredicate &predicate, std::chrono::milliseconds timeout, DetectionEvent &out_event,
+                           bool include_latest, bool needs_text, const cv::Rect &region, int class_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_)
+        return false;
+
+    if (include_latest && has_latest_ && (!needs_text || latest_.has_text) && latest_.covers(region) &&
+        latest_.searched(class_id) && predicate(latest_))
+    {
+        out_event = latest_;
+        return true;
+    }
+
+    Waiter waiter;
+    waiter.predicate = &predicate;
+    waiter.needs_text = needs_text;
+    waiter.region = region;
+    waiter.class_id = class_id;
+    waiters_.push_back(&waiter);
+    matched_.wait_for(lock, timeout, [&]
+                      { return waiter.matched || closed_; });
+    waiters_.remove(&waiter);
+
+    if (!waiter.matched)
+        return false;
+    out_event = std::move(waiter.event);
+    return true;
+}
+
+bool DetectionBus::latest(DetectionEvent &out_event) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_latest_)
+        return false;
+    out_event = latest_;
+    return true;
+}
+
+bool DetectionBus::wantsText() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::any_of(waiters_.begin(), waiters_.end(), [](const Waiter *w)
+                       { return w->needs_text && !w->matched; });
+}
+
+bool DetectionBus::wantedRegions(std::vector<cv::Rect> &out_regions) const
+{
+    out_regions.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Waiter *w : waiters_)
+    {
+        if (w->matched)
+            continue;
+        if (w->region.empty())
+        {
+            out_regions.clear();
+            return false;
+        }
+        if (std::find(out_regions.begin(), out_regions.end(), w->region) == out_regions.end())
+            out_regions.push_back(w->region);
+    }
+    return !out_regions.empty();
+}
+
+bool DetectionBus::wantedClasses(std::vector<int> &out_classes) const
+{
+    out_classes.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Waiter *w : waiters_)
+    {
+        if (w->matched)
+            continue;
+        if (w->class_id < 0)
+        {
+            out_classes.clear();
+            return false;
+        }
+        if (std::find(out_classes.begin(), out_classes.end(), w->class_id) == out_classes.end())
+            out_classes.push_back(w->class_id);
+    }
+    return !out_classes.empty();
+}
+
+void DetectionBus::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    matched_.notify_all();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include "yolo.hpp"
+#include "ocr.hpp"
+
+struct DetectionEvent
+{
+    uint64_t sequence = 0;
+    std::chrono::steady_clock::time_point captured_at;
+    cv::Mat frame; // BGR; shared with the publisher, do not write into it
+    std::vector<Detection> detections;
+    bool has_text = false; // text_regions is only filled while a waiter needs text
+    std::vector<TextRegion> text_regions;
+    // Empty when detections cover the whole frame; otherwise only these areas were searched
+    std::vector<cv::Rect> regions;
+    // Empty when every class was looked for; otherwise only these were
+    std::vector<int> classes;
+
+    // Whether the detections cover region; an empty region asks for the whole frame
+    bool covers(const cv::Rect &region) const;
+    // Whether class_id was looked for; -1 asks for every class
+    bool searched(int class_id) const;
+};
+
+typedef std::function<bool(const DetectionEvent &event)> DetectionPredicate;
+
+// Hands the live detection stream from the capture thread to tasks waiting for something to
+// appear. Predicates run on the publishing thread as each event arrives, so a waiter wakes on
+// the first matching frame instead of polling. Screen capture only publishes when the desktop
+// changes, so the latest event always describes what is on screen now.
+class DetectionBus
+{
+public:
+    void publish(DetectionEvent event);
+    // Waits for an event matching predicate. With include_latest the event already published is
+    // checked first; otherwise only later events count. needs_text asks the publisher for OCR
+    // results while this waiter is pending. A non-empty region means the waiter only looks
+    // there, so events searched in that region alone also count; likewise a class_id other than -1
+    // means the waiter only looks for that class. Returns false on timeout or close().
+    bool waitFor(const DetectionPredicate &predicate, std::chrono::milliseconds timeout, DetectionEvent &out_event,
+                 bool include_latest = true, bool needs_text = false, const cv::Rect &region = cv::Rect(), int class_id = -1);
+    bool latest(DetectionEvent &out_event) const;
+    // True while some pending waiter needs text. The publisher then runs OCR on new frames, and
+    // re-publishes the current frame with text if the latest event has none.
+    bool wantsText() const;
+    // True, with the regions, when every pending waiter looks only at a region: the publisher
+    // can then detect in those regions instead of the whole frame. False when nobody waits or
+    // some waiter needs the whole frame.
+    bool wantedRegions(std::vector<cv::Rect> &out_regions) const;
+    // True, with the classes, when every pending waiter looks for one class: the publisher can
+    // then look for just those (e.g. with templates) instead of running the network
+    bool wantedClasses(std::vector<int> &out_classes) const;
+    // Wakes every waiter; later waits fail immediately
+    void close();
+
+private:
+    struct Waiter
+    {
+        const DetectionPredicate *predicate = nullptr;
+        bool needs_text = false;
+        cv::Rect region;
+        int class_id = -1;
+        bool matched = false;
+        DetectionEvent event;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable matched_;
+    std::list<Waiter *> waiters_;
+    DetectionEvent latest_;
+    bool has_latest_ = false;
+    bool closed_ = false;
+    uint64_t next_sequence_ = 1;
+};
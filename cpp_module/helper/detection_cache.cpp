@@ -0,0 +1,100 @@
+#include "detection_cache.hpp"
+#include "vision_kernels.hpp"
+#include <bitset>
+
+static uint64_t settingsKey(const YoloSettings &settings)
+{
+    uint64_t key = static_cast<uint64_t>(settings.input_width) << 48 | static_cast<uint64_t>(settings.input_height) << 32;
+    key ^= static_cast<uint64_t>(settings.confidence_threshold * 1000.0f) << 16 ^ static_cast<uint64_t>(settings.nms_threshold * 1000.0f);
+    for (int class_id : settings.class_filter)
+    {
+        key = (key ^ static_cast<uint64_t>(class_id)) * 0x9E3779B97F4A7C15ull;
+    }
+    return key;
+}
+
+// dHash: one bit per horizontally adjacent pair of a 9x8 downscale, set where brightness increases
+static uint64_t differenceHash(const cv::Mat &sample)
+{
+    cv::Mat small;
+    cv::resize(sample, small, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+    uint64_t hash = 0;
+    for (int y = 0; y < 8; ++y)
+    {
+        const uchar *row = small.ptr<uchar>(y);
+        for (int x = 0; x < 8; ++x)
+        {
+            hash = hash << 1 | (row[x + 1] > row[x] ? 1u : 0u);
+        }
+    }
+    return hash;
+}
+
+DetectionCache::DetectionCache(size_t capacity) : capacity_(std::max<size_t>(capacity, 1))
+{
+}
+
+bool DetectionCache::lookup(const cv::Mat &frame, const YoloSettings &settings, std::vector<Detection> &out_detections)
+{
+    // Shrink first so the color conversion only touches the sample
+    cv::Mat small;
+    const cv::Size sample_size(std::max(frame.cols / DETECTION_CACHE_SAMPLE_SCALE, 9), std::max(frame.rows / DETECTION_CACHE_SAMPLE_SCALE, 8));
+    cv::resize(frame, small, sample_size, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(small, pending_sample_, small.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    pending_phash_ = differenceHash(pending_sample_);
+    pending_frame_size_ = frame.size();
+    pending_frame_type_ = frame.type();
+    has_pending_ = true;
+
+    const uint64_t settings_key = settingsKey(settings);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it)
+    {
+        if (it->settings_key != settings_key || it->frame_size != pending_frame_size_ || it->frame_type != pending_frame_type_)
+            continue;
+        if (static_cast<int>(std::bitset<64>(it->phash ^ pending_phash_).count()) > DETECTION_CACHE_MAX_HASH_DISTANCE)
+            continue;
+        // The dHash only summarizes coarse gradients; the sample catches a moved or relabeled element
+        // (samples are continuous, so the kernel can treat them as flat arrays)
+        if (visionKernels().max_abs_diff_u8(it->sample.data, pending_sample_.data, pending_sample_.total()) > DETECTION_CACHE_MAX_PIXEL_DIFF)
+            continue;
+
+        entries_.splice(entries_.begin(), entries_, it);
+        out_detections = entries_.front().detections;
+        hits_++;
+        return true;
+    }
+    misses_++;
+    return false;
+}
+
+void DetectionCache::insert(const YoloSettings &settings, const std::vector<Detection> &detections)
+{
+    if (!has_pending_)
+        return;
+
+    Entry entry;
+    entry.phash = pending_phash_;
+    entry.sample = pending_sample_;
+    entry.settings_key = settingsKey(settings);
+    entry.frame_size = pending_frame_size_;
+    entry.frame_type = pending_frame_type_;
+    entry.detections = detections;
+    entries_.push_front(std::move(entry));
+    has_pending_ = false;
+    pending_sample_ = cv::Mat(); // The entry owns the buffer now
+    if (entries_.size() > capacity_)
+        entries_.pop_back();
+}
+
+void DetectionCache::clear()
+{
+    entries_.clear();
+    has_pending_ = false;
+    pending_sample_ = cv::Mat();
+}
+
+double DetectionCache::hitRate() const
+{
+    const size_t total = hits_ + misses_;
+    return total > 0 ? static_cast<double>(hits_) / static_cast<double>(total) : 0.0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <list>
+#include "yolo.hpp"
+
+const size_t DETECTION_CACHE_CAPACITY = 64;
+// Candidates are entries whose 64-bit difference hash is within this many bits of the frame's
+const int DETECTION_CACHE_MAX_HASH_DISTANCE = 6;
+// Candidates are verified on the frame in grayscale at 1/DETECTION_CACHE_SAMPLE_SCALE per side,
+// where no pixel may differ by more than DETECTION_CACHE_MAX_PIXEL_DIFF gray levels
+const int DETECTION_CACHE_SAMPLE_SCALE = 4;
+const int DETECTION_CACHE_MAX_PIXEL_DIFF = 24;
+
+// Remembers the detections of recently seen screens (login pages, dialogs, tabs the workflow
+// keeps returning to) so a revisit skips the forward pass. Frames are looked up by a perceptual
+// difference hash, and a candidate is only returned if a grayscale sample of the frame at
+// 1/DETECTION_CACHE_SAMPLE_SCALE per side matches within DETECTION_CACHE_MAX_PIXEL_DIFF
+// (visionKernels().max_abs_diff_u8). A sample pixel averages 16 screen pixels, so a moved dialog
+// or a one-pixel text stroke still shifts it by a quarter of its contrast, while encoder noise,
+// dithering and anti-aliasing jitter stay under the limit. A lookup costs one resize of the
+// frame, a scan of at most DETECTION_CACHE_CAPACITY hashes and a kernel pass per candidate; an
+// entry keeps its sample (130 KB at 1080p).
+// Entries are also keyed on the YoloSettings they were computed with. Not thread-safe.
+class DetectionCache
+{
+public:
+    explicit DetectionCache(size_t capacity = DETECTION_CACHE_CAPACITY);
+
+    // Accepts BGR or BGRA frames. On a hit the cached detections are copied to out_detections.
+    bool lookup(const cv::Mat &frame, const YoloSettings &settings, std::vector<Detection> &out_detections);
+    // Stores the detections of the frame passed to the last lookup() that missed
+    void insert(const YoloSettings &settings, const std::vector<Detection> &detections);
+    void clear();
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    double hitRate() const;
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry
+    {
+        uint64_t phash = 0;
+        cv::Mat sample;
+        uint64_t settings_key = 0;
+        cv::Size frame_size;
+        int frame_type = 0; // BGR and BGRA frames of one screen hash differently
+        std::vector<Detection> detections;
+    };
+
+    size_t capacity_;
+    std::list<Entry> entries_; // Most recently used first
+
+    // The frame from the last lookup, kept so insert() does not recompute it
+    bool has_pending_ = false;
+    cv::Mat pending_sample_;
+    uint64_t pending_phash_ = 0;
+    cv::Size pending_frame_size_;
+    int pending_frame_type_ = 0;
+
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
@@ -0,0 +1,188 @@
+#include "detection_eval.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+bool loadYoloLabels(const std::string &path, const cv::Size &image_size, std::vector<GroundTruthBox> &out_boxes)
+{
+    out_boxes.clear();
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        std::istringstream fields(line);
+        int class_id;
+        float cx, cy, w, h;
+        if (!(fields >> class_id >> cx >> cy >> w >> h))
+            continue;
+
+        GroundTruthBox truth;
+        truth.class_id = class_id;
+        truth.box = cv::Rect(static_cast<int>((cx - w / 2) * image_size.width), static_cast<int>((cy - h / 2) * image_size.height),
+                             static_cast<int>(w * image_size.width), static_cast<int>(h * image_size.height));
+        out_boxes.push_back(truth);
+    }
+    return true;
+}
+
+bool writeYoloLabels(const std::string &path, const cv::Size &image_size, const std::vector<Detection> &detections)
+{
+    std::ofstream ofs(path);
+    if (!ofs.is_open())
+    {
+        LOG_ERR("Failed to write label file: " << path);
+        return false;
+    }
+
+    for (const Detection &det : detections)
+    {
+        float cx = (det.box.x + det.box.width / 2.0f) / image_size.width;
+        float cy = (det.box.y + det.box.height / 2.0f) / image_size.height;
+        ofs << det.class_id << cv::format(" %.6f %.6f %.6f %.6f", cx, cy, det.box.width / (float)image_size.width, det.box.height / (float)image_size.height) << "\n";
+    }
+    return true;
+}
+
+float rectIoU(const cv::Rect &a, const cv::Rect &b)
+{
+    int intersection = (a & b).area();
+    int union_area = a.area() + b.area() - intersection;
+    return union_area > 0 ? static_cast<float>(intersection) / union_area : 0.0f;
+}
+
+void suppressDuplicates(std::vector<Detection> &detections, float iou_threshold)
+{
+    std::sort(detections.begin(), detections.end(), [](const Detection &a, const Detection &b)
+              { return a.confidence > b.confidence; });
+    std::vector<Detection> kept;
+    for (const Detection &det : detections)
+    {
+        bool duplicate = std::any_of(kept.begin(), kept.end(), [&](const Detection &k)
+                                     { return k.class_id == det.class_id && rectIoU(k.box, det.box) > iou_threshold; });
+        if (!duplicate)
+            kept.push_back(det);
+    }
+    detections.swap(kept);
+}
+
+void DetectionEvaluator::addImage(const std::vector<GroundTruthBox> &truth, const std::vector<Detection> &detections)
+{
+    for (const GroundTruthBox &gt : truth)
+        classes_[gt.class_id].ground_truth++;
+    ground_truth_ += truth.size();
+
+    // Greedy matching in confidence order, each ground truth box claimed at most once
+    std::vector<size_t> order(detections.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+              { return detections[a].confidence > detections[b].confidence; });
+
+    std::vector<bool> claimed(truth.size(), false);
+    for (size_t idx : order)
+    {
+        const Detection &det = detections[idx];
+        int best = -1;
+        float best_iou = EVAL_IOU_THRESHOLD;
+        for (size_t t = 0; t < truth.size(); ++t)
+        {
+            if (claimed[t] || truth[t].class_id != det.class_id)
+                continue;
+            float iou = rectIoU(det.box, truth[t].box);
+            if (iou >= best_iou)
+            {
+                best_iou = iou;
+                best = static_cast<int>(t);
+            }
+        }
+        if (best >= 0)
+        {
+            claimed[best] = true;
+            true_positives_++;
+        }
+        classes_[det.class_id].scored.emplace_back(det.confidence, best >= 0);
+    }
+}
+
+double DetectionEvaluator::meanAveragePrecision() const
+{
+    double ap_sum = 0.0;
+    int class_count = 0;
+    for (const auto &entry : classes_)
+    {
+        const ClassRecord &record = entry.second;
+        if (record.ground_truth == 0)
+            continue; // False positives of classes absent from the reference only lower precision elsewhere
+        class_count++;
+
+        std::vector<std::pair<float, bool>> scored = record.scored;
+        std::sort(scored.begin(), scored.end(), [](const std::pair<float, bool> &a, const std::pair<float, bool> &b)
+                  { return a.first > b.first; });
+
+        std::vector<double> precision, recall;
+        size_t tp = 0;
+        for (size_t i = 0; i < scored.size(); ++i)
+        {
+            if (scored[i].second)
+                tp++;
+            precision.push_back(static_cast<double>(tp) / (i + 1));
+            recall.push_back(static_cast<double>(tp) / record.ground_truth);
+        }
+
+        // All-point interpolation: area under the monotone precision envelope
+        for (int i = static_cast<int>(precision.size()) - 2; i >= 0; --i)
+            precision[i] = std::max(precision[i], precision[i + 1]);
+        double ap = 0.0, prev_recall = 0.0;
+        for (size_t i = 0; i < precision.size(); ++i)
+        {
+            ap += (recall[i] - prev_recall) * precision[i];
+            prev_recall = recall[i];
+        }
+        ap_sum += ap;
+    }
+    return class_count > 0 ? ap_sum / class_count : 0.0;
+}
+
+double DetectionEvaluator::recall() const
+{
+    return ground_truth_ > 0 ? static_cast<double>(true_positives_) / ground_truth_ : 0.0;
+}
+
+size_t DetectionEvaluator::groundTruthCount() const
+{
+    return ground_truth_;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+std::vector<bool> paretoFrontier(const std::vector<double> &cost, const std::vector<double> &value)
+{
+    std::vector<bool> frontier(cost.size(), true);
+    for (size_t i = 0; i < cost.size(); ++i)
+    {
+        for (size_t j = 0; j < cost.size(); ++j)
+        {
+            if (i == j)
+                continue;
+            bool no_worse = cost[j] <= cost[i] && value[j] >= value[i];
+            bool better = cost[j] < cost[i] || value[j] > value[i];
+            if (no_worse && better)
+            {
+                frontier[i] = false;
+                break;
+            }
+        }
+    }
+    return frontier;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "yolo.hpp"
+
+const float EVAL_IOU_THRESHOLD = 0.5f;
+
+struct GroundTruthBox
+{
+    int class_id = -1;
+    cv::Rect box; // In image pixel coordinates
+};
+
+// Reads a YOLO-format label file ("class cx cy w h" per line, normalized to the image size).
+// Returns false if the file cannot be opened.
+bool loadYoloLabels(const std::string &path, const cv::Size &image_size, std::vector<GroundTruthBox> &out_boxes);
+// Writes detections in the same format, e.g. to freeze a reference model's output as a golden set
+bool writeYoloLabels(const std::string &path, const cv::Size &image_size, const std::vector<Detection> &detections);
+
+float rectIoU(const cv::Rect &a, const cv::Rect &b);
+// Keeps the most confident of same-class boxes that overlap by more than iou_threshold, e.g. where
+// crops or tiles searched the same element twice. Sorts detections by confidence.
+void suppressDuplicates(std::vector<Detection> &detections, float iou_threshold);
+
+// Accumulates detections against ground truth image by image and reports mAP@0.5 (all-point
+// interpolated AP averaged over classes that have ground truth) and overall recall@0.5.
+class DetectionEvaluator
+{
+public:
+    void addImage(const std::vector<GroundTruthBox> &truth, const std::vector<Detection> &detections);
+
+    double meanAveragePrecision() const;
+    double recall() const;
+    size_t groundTruthCount() const;
+
+private:
+    struct ClassRecord
+    {
+        std::vector<std::pair<float, bool>> scored; // confidence, true positive
+        size_t ground_truth = 0;
+    };
+
+    std::map<int, ClassRecord> classes_;
+    size_t true_positives_ = 0;
+    size_t ground_truth_ = 0;
+};
+
+// Nearest-rank percentile, p in [0, 100]
+double percentile(std::vector<double> values, double p);
+
+// Marks the points not dominated by any other: lower cost and higher value are both better
+std::vector<bool> paretoFrontier(const std::vector<double> &cost, const std::vector<double> &value);
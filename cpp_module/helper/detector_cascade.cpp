@@ -0,0 +1,114 @@
+#include "detector_cascade.hpp"
+#include "detection_eval.hpp"
+#include <algorithm>
+
+DetectorCascade::DetectorCascade(cv::dnn::Net &small_net, cv::dnn::Net &large_net, const CascadeConfig &config)
+    : small_net_(small_net), large_net_(large_net), config_(config)
+{
+}
+
+void DetectorCascade::reset()
+{
+    previous_.clear();
+    stats_ = CascadeStats();
+}
+
+bool DetectorCascade::isTracked(const Detection &det) const
+{
+    return std::any_of(previous_.begin(), previous_.end(), [&](const Detection &p)
+                       { return p.class_id == det.class_id && rectIoU(p.box, det.box) >= config_.track_iou; });
+}
+
+void DetectorCascade::detect(const cv::Mat &frame, std::vector<Detection> &out_detections, const YoloSettings &settings)
+{
+    out_detections.clear();
+    const uint64_t frame_index = stats_.frames++;
+    if (frame.empty())
+        return;
+
+    if (config_.audit_interval > 0 && frame_index % config_.audit_interval == 0)
+    {
+        detectObjectsWithYOLO(frame, large_net_, out_detections, settings);
+        stats_.large_full_passes++;
+        previous_ = out_detections;
+        return;
+    }
+
+    YoloSettings small_settings = settings;
+    small_settings.confidence_threshold = std::min(settings.confidence_threshold, config_.escalate_confidence);
+    std::vector<Detection> candidates;
+    detectObjectsWithYOLO(frame, small_net_, candidates, small_settings);
+
+    const float accept = std::max(config_.accept_confidence, settings.confidence_threshold);
+    std::vector<cv::Rect> escalated;
+    for (const Detection &det : candidates)
+    {
+        if (det.confidence >= accept && isTracked(det))
+            out_detections.push_back(det);
+        else
+            escalated.push_back(det.box);
+    }
+    stats_.escalated_boxes += escalated.size();
+
+    if (!escalated.empty())
+    {
+        // Pad for context, then merge overlapping crops so no region is run twice
+        const cv::Rect frame_rect(0, 0, frame.cols, frame.rows);
+        std::vector<cv::Rect> crops;
+        for (const cv::Rect &box : escalated)
+        {
+            int pad_x = static_cast<int>(box.width * config_.crop_padding);
+            int pad_y = static_cast<int>(box.height * config_.crop_padding);
+            cv::Rect crop = cv::Rect(box.x - pad_x, box.y - pad_y, box.width + 2 * pad_x, box.height + 2 * pad_y) & frame_rect;
+            for (auto it = crops.begin(); it != crops.end();)
+            {
+                if ((*it & crop).area() > 0)
+                {
+                    // The grown crop may now reach crops already passed over
+                    crop |= *it;
+                    crops.erase(it);
+                    it = crops.begin();
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            crops.push_back(crop);
+        }
+
+        double crop_area = 0.0;
+        for (const cv::Rect &crop : crops)
+            crop_area += crop.area();
+
+        std::vector<Detection> large;
+        if (crop_area > config_.max_crop_area_ratio * frame_rect.area())
+        {
+            // Too much of the frame is uncertain: the full-frame result replaces everything
+            detectObjectsWithYOLO(frame, large_net_, out_detections, settings);
+            stats_.large_full_passes++;
+            previous_ = out_detections;
+            return;
+        }
+
+        YoloSettings crop_settings = settings;
+        if (config_.crop_input_size > 0)
+            crop_settings.input_width = crop_settings.input_height = config_.crop_input_size;
+        for (const cv::Rect &crop : crops)
+        {
+            detectObjectsWithYOLO(frame(crop), large_net_, large, crop_settings);
+            stats_.large_crop_passes++;
+            for (Detection det : large)
+            {
+                det.box += crop.tl();
+                // Objects cut by the crop border are only kept if they belong to an escalated box
+                cv::Point center = (det.box.tl() + det.box.br()) / 2;
+                if (std::any_of(escalated.begin(), escalated.end(), [&](const cv::Rect &box)
+                                { return box.contains(center); }))
+                    out_detections.push_back(det);
+            }
+        }
+        suppressDuplicates(out_detections, settings.nms_threshold);
+    }
+    previous_ = out_detections;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "yolo.hpp"
+
+struct CascadeConfig
+{
+    // Small-model detections at or above this confidence that continue an object from the
+    // previous frame are kept without a second opinion
+    float accept_confidence = 0.6f;
+    // The small model runs with this lower threshold so borderline objects can be escalated
+    float escalate_confidence = 0.25f;
+    // Every Nth frame the large model checks the whole frame (0 disables audits)
+    int audit_interval = 30;
+    // A detection is new unless it overlaps a previous-frame box of its class by this IoU
+    float track_iou = 0.3f;
+    // Crops around escalated boxes grow by this share of the box size on each side
+    float crop_padding = 0.5f;
+    // If crops would cover more than this share of the frame, one full-frame pass is cheaper
+    float max_crop_area_ratio = 0.4f;
+    // Large-model input size for crops; 0 uses the YoloSettings input size
+    int crop_input_size = 0;
+};
+
+struct CascadeStats
+{
+    size_t frames = 0;
+    size_t escalated_boxes = 0;
+    size_t large_crop_passes = 0;
+    size_t large_full_passes = 0; // Audits and frames with too much to escalate
+};
+
+// Runs a small model (e.g. yolo11n) on every frame and the large model only where the small
+// one is unsure: low-confidence boxes and newly appeared objects are cropped with some context
+// and re-detected by the large model, whose verdict replaces the small model's. Periodic
+// full-frame audits catch objects the small model misses entirely.
+// Both nets must be set up with the same class list. Not thread-safe.
+class DetectorCascade
+{
+public:
+    DetectorCascade(cv::dnn::Net &small_net, cv::dnn::Net &large_net, const CascadeConfig &config = CascadeConfig());
+
+    // Same contract as detectObjectsWithYOLO: frame is BGR, cv::Exception is re-thrown
+    void detect(const cv::Mat &frame, std::vector<Detection> &out_detections, const YoloSettings &settings = YoloSettings());
+    const CascadeStats &stats() const { return stats_; }
+    void reset();
+
+private:
+    bool isTracked(const Detection &det) const;
+
+    cv::dnn::Net &small_net_;
+    cv::dnn::Net &large_net_;
+    CascadeConfig config_;
+    CascadeStats stats_;
+    std::vector<Detection> previous_;
+};
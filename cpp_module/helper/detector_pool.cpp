@@ -0,0 +1,252 @@
+#include "detector_pool.hpp"
+#include <algorithm>
+
+const double POOL_LATENCY_SMOOTHING = 0.2;
+
+DetectorPool::DetectorPool(int replicas, int threads_per_replica, int queue_depth)
+    : requested_replicas_(std::max(1, replicas)), threads_per_replica_(std::max(0, threads_per_replica)), queue_depth_(std::max(1, queue_depth))
+{
+}
+
+DetectorPool::~DetectorPool()
+{
+    stop();
+}
+
+bool DetectorPool::load(const std::string &model_path, const HARDWARE_INFO &hw_info, const std::vector<int> &input_sizes, const cv::dnn::Net &existing)
+{
+    if (!replicas_.empty())
+        return false;
+    if (threads_per_replica_ > 0)
+        cv::setNumThreads(threads_per_replica_);
+
+    std::vector<std::unique_ptr<Replica>> replicas(requested_replicas_);
+    std::vector<std::string> errors(requested_replicas_);
+    std::vector<std::thread> loaders;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < requested_replicas_; ++r)
+    {
+        replicas[r] = std::make_unique<Replica>();
+        replicas[r]->index = r;
+        replicas[r]->stats.replica = r;
+        if (r == 0 && !existing.empty())
+        {
+            replicas[r]->net = existing;
+            continue;
+        }
+        loaders.emplace_back([&, r]
+                             {
+            try
+            {
+                cv::dnn::Net &net = replicas[r]->net;
+                net = cv::dnn::readNetFromONNX(model_path);
+                if (net.empty())
+                    errors[r] = "empty network";
+            }
+            catch (const cv::Exception &e)
+            {
+                errors[r] = e.what();
+            } });
+    }
+    for (std::thread &t : loaders)
+        t.join();
+    for (int r = 0; r < requested_replicas_; ++r)
+    {
+        if (!errors[r].empty())
+        {
+            LOG_ERR("Failed to load detector replica " << r << " from " << model_path << ": " << errors[r]);
+            return false;
+        }
+    }
+    LOG("Parsed " << loaders.size() << " detector replicas in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms");
+
+    // Warm-up allocates each replica's buffers before the first real frame
+    for (int r = 0; r < requested_replicas_; ++r)
+    {
+        if (r > 0 || existing.empty())
+            configureYoloBackend(replicas[r]->net, hw_info);
+        if (prepareYoloInputSizes(replicas[r]->net, input_sizes).empty())
+        {
+            LOG_ERR("Detector replica " << r << " accepts none of the requested input sizes.");
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = false;
+    replicas_ = std::move(replicas);
+    for (auto &replica : replicas_)
+        replica->thread = std::thread(&DetectorPool::replicaLoop, this, std::ref(*replica));
+    return true;
+}
+
+void DetectorPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_ready_.notify_all();
+    space_free_.notify_all();
+    result_ready_.notify_all();
+    for (auto &replica : replicas_)
+    {
+        if (replica->thread.joinable())
+            replica->thread.join();
+    }
+}
+
+uint64_t DetectorPool::submit(const cv::Mat &frame, const YoloSettings &settings)
+{
+    Job job;
+    job.frame = frame;
+    job.frame_size = frame.size();
+    job.settings = settings;
+    return enqueue(std::move(job));
+}
+
+uint64_t DetectorPool::submitBlob(const cv::Mat &blob, cv::Size frame_size, const YoloSettings &settings)
+{
+    Job job;
+    job.blob = blob;
+    job.frame_size = frame_size;
+    job.settings = settings;
+    return enqueue(std::move(job));
+}
+
+uint64_t DetectorPool::enqueue(Job job)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto hasRoom = [&](const std::unique_ptr<Replica> &r)
+    { return static_cast<int>(r->queue.size()) < queue_depth_; };
+    space_free_.wait(lock, [&]
+                     { return stop_ || replicas_.empty() || std::any_of(replicas_.begin(), replicas_.end(), hasRoom); });
+
+    // Expected time until the replica could finish this job; equal replicas reduce to the
+    // shortest queue, and a replica without measurements yet is tried first
+    Replica *best = nullptr;
+    double best_cost = 0.0;
+    for (auto &replica : replicas_)
+    {
+        if (!hasRoom(replica))
+            continue;
+        const double cost = (replica->queue.size() + (replica->busy ? 1 : 0) + 1) * replica->recent_ms;
+        if (!best || cost < best_cost)
+        {
+            best = replica.get();
+            best_cost = cost;
+        }
+    }
+
+    job.sequence = next_sequence_++;
+    job.submitted_at = std::chrono::steady_clock::now();
+    if (!best)
+    {
+        // Stopped (or never loaded): the job completes as failed so collect() stays in order
+        PoolResult &result = done_[job.sequence];
+        result.sequence = job.sequence;
+        result.frame = job.frame;
+        result.frame_size = job.frame_size;
+        result.error = "detector pool is not running";
+        result_ready_.notify_all();
+        return job.sequence;
+    }
+    const uint64_t sequence = job.sequence;
+    best->queue.push_back(std::move(job));
+    work_ready_.notify_all();
+    return sequence;
+}
+
+bool DetectorPool::collect(PoolResult &out)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (next_collect_ == next_sequence_)
+        return false;
+    result_ready_.wait(lock, [&]
+                       { return stop_ || done_.count(next_collect_); });
+    auto it = done_.find(next_collect_);
+    if (it == done_.end())
+        return false;
+    out = std::move(it->second);
+    done_.erase(it);
+    next_collect_++;
+    return true;
+}
+
+size_t DetectorPool::outstanding() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(next_sequence_ - next_collect_);
+}
+
+std::vector<ReplicaStats> DetectorPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ReplicaStats> out;
+    for (const auto &replica : replicas_)
+        out.push_back(replica->stats);
+    return out;
+}
+
+void DetectorPool::replicaLoop(Replica &replica)
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<std::vector<Detection>> detections;
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&]
+                             { return stop_ || !replica.queue.empty(); });
+            if (stop_)
+                return;
+            job = std::move(replica.queue.front());
+            replica.queue.pop_front();
+            replica.busy = true;
+        }
+        space_free_.notify_one();
+
+        PoolResult result;
+        result.sequence = job.sequence;
+        result.frame = job.frame;
+        result.frame_size = job.frame_size;
+        result.replica = replica.index;
+        auto start = clock::now();
+        try
+        {
+            if (job.blob.empty())
+            {
+                detectObjectsWithYOLO(job.frame, replica.net, result.detections, job.settings);
+            }
+            else
+            {
+                detectObjectsWithYOLOBlobs({job.blob}, {job.frame_size}, replica.net, detections, job.settings);
+                result.detections = std::move(detections[0]);
+            }
+            result.ok = true;
+        }
+        catch (const cv::Exception &e)
+        {
+            result.error = e.what();
+        }
+        auto end = clock::now();
+        const double inference_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.latency_ms = std::chrono::duration<double, std::milli>(end - job.submitted_at).count();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            replica.busy = false;
+            replica.recent_ms = replica.recent_ms > 0.0 ? replica.recent_ms + POOL_LATENCY_SMOOTHING * (inference_ms - replica.recent_ms) : inference_ms;
+            replica.stats.busy_ms += inference_ms;
+            if (result.ok)
+                replica.stats.completed++;
+            else
+                replica.stats.errors++;
+            const uint64_t runs = replica.stats.completed + replica.stats.errors;
+            replica.stats.avg_inference_ms = replica.stats.busy_ms / runs;
+            done_[result.sequence] = std::move(result);
+        }
+        result_ready_.notify_all();
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "yolo.hpp"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+
+const int POOL_QUEUE_DEPTH = 2; // Jobs waiting per replica before submit() blocks
+
+struct PoolResult
+{
+    uint64_t sequence = 0;
+    cv::Mat frame; // As submitted; empty for blob submissions
+    cv::Size frame_size;
+    std::vector<Detection> detections;
+    int replica = -1;
+    bool ok = false; // False if inference threw; error has the message
+    std::string error;
+    double latency_ms = 0.0; // From submit to completion
+};
+
+struct ReplicaStats
+{
+    int replica = 0;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    double busy_ms = 0.0;
+    double avg_inference_ms = 0.0;
+};
+
+// Runs frames on several independent copies of the detector at once. A cv::dnn::Net cannot be
+// used from two threads, so with one network frames serialize on a single forward pass however
+// many cores are idle; each replica here has its own network and thread. Frames go to the
+// replica expected to finish first (its queued work times its recent inference time) and
+// results come back from collect() in submission order.
+// OpenCV cannot share layer weights between networks, so every replica holds its own copy
+// (about 100 MB for yolo11l). OpenCV's intra-op thread pool is process-wide:
+// threads_per_replica sets cv::setNumThreads, and a replica whose forward pass finds the pool
+// busy runs on its own thread only. One thread per replica therefore gives clean data
+// parallelism on CPUs.
+class DetectorPool
+{
+public:
+    // threads_per_replica 0 leaves OpenCV's thread count alone
+    DetectorPool(int replicas, int threads_per_replica = 1, int queue_depth = POOL_QUEUE_DEPTH);
+    ~DetectorPool();
+
+    // Parses the replicas in parallel, configures them for hw_info and warms up input_sizes.
+    // existing, if given, becomes replica 0 instead of parsing the model again; it must not be
+    // used elsewhere while the pool runs.
+    bool load(const std::string &model_path, const HARDWARE_INFO &hw_info, const std::vector<int> &input_sizes = {YOLO_INPUT_WIDTH},
+              const cv::dnn::Net &existing = cv::dnn::Net());
+    void stop();
+    int replicas() const { return static_cast<int>(replicas_.size()); }
+
+    // Both block while every replica has queue_depth jobs waiting. The frame is not copied; do
+    // not write into it until its result is collected.
+    uint64_t submit(const cv::Mat &frame, const YoloSettings &settings = YoloSettings());
+    // blob comes from prepareYoloBlob() with the same settings
+    uint64_t submitBlob(const cv::Mat &blob, cv::Size frame_size, const YoloSettings &settings = YoloSettings());
+    // Blocks until the oldest uncollected submission is done; false when none is outstanding
+    bool collect(PoolResult &out);
+    size_t outstanding() const;
+    std::vector<ReplicaStats> stats() const;
+
+private:
+    struct Job
+    {
+        uint64_t sequence = 0;
+        cv::Mat frame;
+        cv::Mat blob;
+        cv::Size frame_size;
+        YoloSettings settings;
+        std::chrono::steady_clock::time_point submitted_at;
+    };
+
+    struct Replica
+    {
+        int index = 0;
+        cv::dnn::Net net;
+        std::deque<Job> queue;
+        bool busy = false;
+        std::thread thread;
+        double recent_ms = 0.0; // Moving average of inference time; 0 until the first job
+        ReplicaStats stats;
+    };
+
+    uint64_t enqueue(Job job);
+    void replicaLoop(Replica &replica);
+
+    int requested_replicas_;
+    int threads_per_replica_;
+    int queue_depth_;
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    std::map<uint64_t, PoolResult> done_; // Finished out of order, waiting for collect()
+    uint64_t next_sequence_ = 0;
+    uint64_t next_collect_ = 0;
+    bool stop_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable space_free_;
+    std::condition_variable result_ready_;
+};
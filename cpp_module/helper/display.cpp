@@ -0,0 +1,193 @@
+#include "display.hpp"
+#include "alloc_tracker.hpp"
+#include <algorithm>
+
+DisplayWorker::DisplayWorker(const std::vector<std::string> &class_names, cv::Size window_size)
+    : class_names_(class_names), window_size_(window_size)
+{
+}
+
+DisplayWorker::~DisplayWorker()
+{
+    stop();
+}
+
+size_t DisplayWorker::addWindow(const std::string &window_name)
+{
+    View view;
+    view.name = window_name;
+    views_.push_back(view);
+    return views_.size() - 1;
+}
+
+void DisplayWorker::start()
+{
+    if (thread_.joinable())
+        return;
+    stop_ = false;
+    thread_ = std::thread(&DisplayWorker::run, this);
+}
+
+void DisplayWorker::stop()
+{
+    stop_ = true;
+    frame_ready_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void DisplayWorker::submit(size_t window, const cv::Mat &frame, const std::vector<Detection> &detections, int64_t frame_id)
+{
+    if (window >= views_.size())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        View &view = views_[window];
+        view.frame = frame;
+        view.detections = detections;
+        view.has_new_frame = true;
+        view.frame_id = frame_id;
+    }
+    frame_ready_.notify_one();
+}
+
+bool DisplayWorker::quitRequested() const
+{
+    return quit_requested_;
+}
+
+const cv::Mat &DisplayWorker::labelGlyph(int class_id, float confidence)
+{
+    const int percent = std::clamp(static_cast<int>(confidence * 100.0f + 0.5f), 0, 100);
+    const int key = class_id * 101 + percent;
+    auto it = glyph_cache_.find(key);
+    if (it != glyph_cache_.end())
+        return it->second;
+
+    if (glyph_cache_.size() >= DISPLAY_GLYPH_CACHE_CAPACITY)
+        glyph_cache_.clear();
+
+    std::string label = (class_id >= 0 && class_id < static_cast<int>(class_names_.size())) ? class_names_[class_id] : "Unknown";
+    label += cv::format(": %.2f", percent / 100.0);
+
+    // Rasterize once at window scale; later frames only copy the pixels
+    int baseline = 0;
+    const double font_scale = 0.5;
+    const int thickness = 1;
+    cv::Size text_size = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, font_scale, thickness, &baseline);
+    cv::Mat glyph(text_size.height + baseline + 4, text_size.width + 4, CV_8UC3, cv::Scalar(0, 96, 0));
+    cv::putText(glyph, label, cv::Point(2, text_size.height + 2), cv::FONT_HERSHEY_SIMPLEX, font_scale, cv::Scalar(255, 255, 255), thickness, cv::LINE_AA);
+    return glyph_cache_.emplace(key, glyph).first->second;
+}
+
+void DisplayWorker::render(View &view, const cv::Mat &frame, const std::vector<Detection> &detections)
+{
+    // Downsize once to the window's client area; boxes and labels are drawn at that scale
+    cv::Size target = window_size_;
+    cv::Rect image_rect = cv::getWindowImageRect(view.name);
+    if (image_rect.width > 0 && image_rect.height > 0)
+        target = image_rect.size();
+
+    const double scale = std::min({1.0, target.width / (double)frame.cols, target.height / (double)frame.rows});
+    if (scale < 1.0)
+        cv::resize(frame, view.canvas, cv::Size(std::max(1, (int)(frame.cols * scale)), std::max(1, (int)(frame.rows * scale))), 0, 0, cv::INTER_AREA);
+    else
+        frame.copyTo(view.canvas);
+
+    const cv::Rect canvas_rect(0, 0, view.canvas.cols, view.canvas.rows);
+    for (const Detection &det : detections)
+    {
+        cv::Rect box(cvRound(det.box.x * scale), cvRound(det.box.y * scale), cvRound(det.box.width * scale), cvRound(det.box.height * scale));
+        cv::rectangle(view.canvas, box, cv::Scalar(0, 255, 0), 2);
+
+        const cv::Mat &glyph = labelGlyph(det.class_id, det.confidence);
+        cv::Rect label_rect(box.x, box.y - glyph.rows, glyph.cols, glyph.rows);
+        if (label_rect.y < 0)
+            label_rect.y = box.y;
+        cv::Rect visible = label_rect & canvas_rect;
+        if (visible.empty())
+            continue;
+        glyph(cv::Rect(visible.x - label_rect.x, visible.y - label_rect.y, visible.width, visible.height)).copyTo(view.canvas(visible));
+    }
+
+    cv::imshow(view.name, view.canvas);
+}
+
+void DisplayWorker::run()
+{
+    AllocStageScope stage(ALLOC_STAGE_DISPLAY);
+    setTraceThreadName("display");
+    // HighGUI windows belong to the thread that created them, so everything UI happens here
+    for (const View &view : views_)
+    {
+        cv::namedWindow(view.name, cv::WINDOW_NORMAL);
+        cv::setWindowProperty(view.name, cv::WND_PROP_ASPECT_RATIO, cv::WINDOW_KEEPRATIO);
+        cv::resizeWindow(view.name, window_size_.width, window_size_.height);
+    }
+
+    cv::Mat frame;
+    std::vector<Detection> detections;
+    auto last_close_check = std::chrono::steady_clock::now();
+    while (!stop_)
+    {
+        bool repainted = false;
+        for (size_t i = 0; i < views_.size(); ++i)
+        {
+            bool has_new_frame = false;
+            int64_t frame_id = -1;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                View &view = views_[i];
+                if (view.has_new_frame)
+                {
+                    frame = view.frame;
+                    view.frame = cv::Mat();
+                    detections.swap(view.detections);
+                    view.has_new_frame = false;
+                    has_new_frame = true;
+                    frame_id = view.frame_id;
+                }
+            }
+            if (has_new_frame && !frame.empty())
+            {
+                TRACE_SCOPE_FRAME("render", frame_id);
+                render(views_[i], frame, detections);
+                repainted = true;
+            }
+        }
+        frame.release();
+
+        // waitKey pumps the window messages, so it must run even when no new frame arrived
+        int key;
+        {
+            TRACE_SCOPE("waitKey");
+            key = cv::waitKey(1);
+        }
+        if (key == 27)
+            quit_requested_ = true;
+        // Querying the window is a round trip to the window system; do it once per repaint, and
+        // now and then while idle so closing a still preview also quits
+        const auto now = std::chrono::steady_clock::now();
+        if (repainted || now - last_close_check >= std::chrono::milliseconds(DISPLAY_IDLE_CLOSE_CHECK_MS))
+        {
+            last_close_check = now;
+            for (const View &view : views_)
+            {
+                if (cv::getWindowProperty(view.name, cv::WND_PROP_VISIBLE) < 1)
+                    quit_requested_ = true;
+            }
+        }
+        if (quit_requested_)
+            break;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        frame_ready_.wait_for(lock, std::chrono::milliseconds(15), [&]
+                              { return stop_ || std::any_of(views_.begin(), views_.end(), [](const View &v)
+                                                            { return v.has_new_frame; }); });
+    }
+
+    for (const View &view : views_)
+    {
+        cv::destroyWindow(view.name);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "yolo.hpp"
+
+const size_t DISPLAY_GLYPH_CACHE_CAPACITY = 2048;
+// How often a window that gets no new frames is checked for having been closed
+const int DISPLAY_IDLE_CLOSE_CHECK_MS = 250;
+
+// Owns the HighGUI windows on a dedicated thread. Processing threads hand over the latest
+// frame and detections and never wait on repaints or waitKey; frames that arrive faster
+// than the UI can paint simply replace each other.
+class DisplayWorker
+{
+public:
+    DisplayWorker(const std::vector<std::string> &class_names, cv::Size window_size = cv::Size(1280, 720));
+    ~DisplayWorker();
+
+    // Windows must be added before start()
+    size_t addWindow(const std::string &window_name);
+    void start();
+    void stop();
+    // Shares the frame buffer rather than copying it, so callers must not write into it afterwards.
+    // frame_id only tags the render span in traces.
+    void submit(size_t window, const cv::Mat &frame, const std::vector<Detection> &detections, int64_t frame_id = -1);
+    // Set once ESC is pressed or a window is closed
+    bool quitRequested() const;
+
+private:
+    struct View
+    {
+        std::string name;
+        cv::Mat frame;
+        std::vector<Detection> detections;
+        bool has_new_frame = false;
+        int64_t frame_id = -1;
+        cv::Mat canvas;
+    };
+
+    void run();
+    void render(View &view, const cv::Mat &frame, const std::vector<Detection> &detections);
+    const cv::Mat &labelGlyph(int class_id, float confidence);
+
+    std::vector<std::string> class_names_;
+    cv::Size window_size_;
+    std::vector<View> views_;
+    std::map<int, cv::Mat> glyph_cache_; // Keyed by class id and confidence percent
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> quit_requested_{false};
+};
@@ -1,13 +1,22 @@
 #include "dxdiag.hpp"
 #include <opencv2/opencv.hpp>
 
+// Reports why a capture failed; a call that succeeded but returned no object counts as E_FAIL
+static bool failCapture(HRESULT *out_hr, HRESULT hr)
+{
+    if (out_hr)
+        *out_hr = FAILED(hr) ? hr : E_FAIL;
+    return false;
+}
+
 bool GetScreenPixelsDXGI(
     IDXGIOutputDuplication *pDuplication,
     ID3D11Device *pDevice,
     ID3D11DeviceContext *pImmediateContext,
     int &width,
     int &height,
-    std::vector<BYTE> &pixel_data_out)
+    std::vector<BYTE> &pixel_data_out,
+    HRESULT *out_hr)
 {
     static const int MAX_RETRIES = 3;
     static const int RETRY_DELAY_MS = 10;
@@ -18,7 +27,11 @@ bool GetScreenPixelsDXGI(
         DXGI_OUTDUPL_FRAME_INFO frameInfo;
 
         // Try to acquire a new frame with a small timeout
-        HRESULT hr = pDuplication->AcquireNextFrame(100, &frameInfo, &pDesktopResource);
+        HRESULT hr;
+        {
+            TRACE_SCOPE("AcquireNextFrame");
+            hr = pDuplication->AcquireNextFrame(100, &frameInfo, &pDesktopResource);
+        }
 
         if (hr == DXGI_ERROR_WAIT_TIMEOUT)
         {
@@ -29,23 +42,25 @@ bool GetScreenPixelsDXGI(
                 std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
                 continue;
             }
-            return false;
+            return failCapture(out_hr, hr);
         }
 
         if (FAILED(hr) || !pDesktopResource)
         {
-            std::cerr << "Failed to acquire next frame. HR: " << std::hex << hr << std::endl;
+            LOG_EVENT(LogLevel::Warn, "Failed to acquire next frame", LogField::hex("hr", hr), LogField("retry", retry));
+            SafeRelease(&pDesktopResource);
             if (hr == DXGI_ERROR_ACCESS_LOST)
             {
-                std::cerr << "Access to desktop duplication was lost (e.g. mode change, fullscreen app). Re-initialization needed." << std::endl;
+                // Retrying cannot help; the duplication has to be recreated
+                LOG_EVENT(LogLevel::Warn, "Access to desktop duplication was lost (e.g. mode change, fullscreen app). Re-initialization needed.");
+                return failCapture(out_hr, hr);
             }
-            SafeRelease(&pDesktopResource);
             if (retry < MAX_RETRIES - 1)
             {
                 std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
                 continue;
             }
-            return false;
+            return failCapture(out_hr, hr);
         }
 
         // Query the texture interface from the resource
@@ -55,13 +70,13 @@ bool GetScreenPixelsDXGI(
 
         if (FAILED(hr) || !pAcquiredDesktopImage)
         {
-            std::cerr << "Failed to query ID3D11Texture2D from IDXGIResource. HR: " << std::hex << hr << std::endl;
+            LOG_EVENT(LogLevel::Warn, "Failed to query ID3D11Texture2D from IDXGIResource", LogField::hex("hr", hr), LogField("retry", retry));
             if (retry < MAX_RETRIES - 1)
             {
                 std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
                 continue;
             }
-            return false;
+            return failCapture(out_hr, hr);
         }
 
         D3D11_TEXTURE2D_DESC desc;
@@ -78,17 +93,18 @@ bool GetScreenPixelsDXGI(
         hr = pDevice->CreateTexture2D(&stagingDesc, nullptr, &pStagingTexture);
         if (FAILED(hr) || !pStagingTexture)
         {
-            std::cerr << "Failed to create staging texture. HR: " << std::hex << hr << std::endl;
+            LOG_EVENT(LogLevel::Warn, "Failed to create staging texture", LogField::hex("hr", hr), LogField("retry", retry));
             SafeRelease(&pAcquiredDesktopImage);
             if (retry < MAX_RETRIES - 1)
             {
                 std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
                 continue;
             }
-            return false;
+            return failCapture(out_hr, hr);
         }
 
         // Copy the desktop image to the staging texture
+        TRACE_SCOPE("readback");
         pImmediateContext->CopyResource(pStagingTexture, pAcquiredDesktopImage);
         SafeRelease(&pAcquiredDesktopImage);
 
@@ -97,14 +113,14 @@ bool GetScreenPixelsDXGI(
         hr = pImmediateContext->Map(pStagingTexture, 0, D3D11_MAP_READ, 0, &mappedResource);
         if (FAILED(hr))
         {
-            std::cerr << "Failed to map staging texture. HR: " << std::hex << hr << std::endl;
+            LOG_EVENT(LogLevel::Warn, "Failed to map staging texture", LogField::hex("hr", hr), LogField("retry", retry));
             SafeRelease(&pStagingTexture);
             if (retry < MAX_RETRIES - 1)
             {
                 std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
                 continue;
             }
-            return false;
+            return failCapture(out_hr, hr);
         }
 
         // Update the output dimensions
@@ -133,19 +149,21 @@ bool GetScreenPixelsDXGI(
         hr = pDuplication->ReleaseFrame();
         if (FAILED(hr))
         {
-            std::cerr << "Failed to release frame. HR: " << std::hex << hr << std::endl;
+            LOG_EVENT(LogLevel::Warn, "Failed to release frame", LogField::hex("hr", hr), LogField("retry", retry));
             if (retry < MAX_RETRIES - 1)
             {
                 std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
                 continue;
             }
-            return false;
+            return failCapture(out_hr, hr);
         }
 
+        if (out_hr)
+            *out_hr = S_OK;
         return true;
     }
 
-    return false;
+    return failCapture(out_hr, E_FAIL);
 }
 
 void CleanupDXGI(DXGIContext &ctx)
@@ -158,22 +176,22 @@ void CleanupDXGI(DXGIContext &ctx)
     SafeRelease(&ctx.pFactory);
 }
 
-// Initialize DXGI/DirectX and duplication objects. Returns true on success.
-bool InitializeDXGI(DXGIContext &ctx)
+// Initialize DXGI/DirectX and duplication objects for one adapter output. Returns true on success.
+bool InitializeDXGI(DXGIContext &ctx, UINT adapter_index, UINT output_index)
 {
     HRESULT hr;
     // Create DXGI Factory
     hr = CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void **>(&ctx.pFactory));
     if (FAILED(hr))
     {
-        std::cerr << "Failed to create DXGI Factory. HR: " << std::hex << hr << std::endl;
+        LOG_ERR("Failed to create DXGI Factory. HR: 0x" << std::hex << hr);
         return false;
     }
     // Enumerate adapters (graphics cards)
-    hr = ctx.pFactory->EnumAdapters1(0, &ctx.pAdapter);
+    hr = ctx.pFactory->EnumAdapters1(adapter_index, &ctx.pAdapter);
     if (FAILED(hr))
     {
-        std::cerr << "Failed to enumerate adapters. HR: " << std::hex << hr << std::endl;
+        LOG_ERR("Failed to enumerate adapters. HR: 0x" << std::hex << hr);
         SafeRelease(&ctx.pFactory);
         return false;
     }
@@ -200,17 +218,17 @@ bool InitializeDXGI(DXGIContext &ctx)
 
     if (FAILED(hr))
     {
-        std::cerr << "Failed to create D3D11 device. HR: " << std::hex << hr << std::endl;
+        LOG_ERR("Failed to create D3D11 device. HR: 0x" << std::hex << hr);
         SafeRelease(&ctx.pAdapter);
         SafeRelease(&ctx.pFactory);
         return false;
     }
     // Enumerate outputs (monitors) on the adapter
     IDXGIOutput *pOutput = nullptr;
-    hr = ctx.pAdapter->EnumOutputs(0, &pOutput);
+    hr = ctx.pAdapter->EnumOutputs(output_index, &pOutput);
     if (FAILED(hr))
     {
-        std::cerr << "Failed to enumerate outputs. HR: " << std::hex << hr << std::endl;
+        LOG_ERR("Failed to enumerate outputs. HR: 0x" << std::hex << hr);
         SafeRelease(&ctx.pImmediateContext);
         SafeRelease(&ctx.pDevice);
         SafeRelease(&ctx.pAdapter);
@@ -222,7 +240,7 @@ bool InitializeDXGI(DXGIContext &ctx)
     SafeRelease(&pOutput);
     if (FAILED(hr))
     {
-        std::cerr << "Failed to query IDXGIOutput1. HR: " << std::hex << hr << std::endl;
+        LOG_ERR("Failed to query IDXGIOutput1. HR: 0x" << std::hex << hr);
         SafeRelease(&ctx.pImmediateContext);
         SafeRelease(&ctx.pDevice);
         SafeRelease(&ctx.pAdapter);
@@ -233,14 +251,14 @@ bool InitializeDXGI(DXGIContext &ctx)
     hr = ctx.pOutput1->DuplicateOutput(ctx.pDevice, &ctx.pDesktopDupl);
     if (FAILED(hr))
     {
-        std::cerr << "Failed to create duplicate output. HR: " << std::hex << hr << std::endl;
+        LOG_ERR("Failed to create duplicate output. HR: 0x" << std::hex << hr);
         if (hr == DXGI_ERROR_NOT_CURRENTLY_AVAILABLE)
         {
-            std::cerr << "Desktop Duplication is not available. Max number of applications using it already reached?" << std::endl;
+            LOG_ERR("Desktop Duplication is not available. Max number of applications using it already reached?");
         }
         else if (hr == E_ACCESSDENIED)
         {
-            std::cerr << "Access denied. Possibly due to protected content or system settings." << std::endl;
+            LOG_ERR("Access denied. Possibly due to protected content or system settings.");
         }
         SafeRelease(&ctx.pOutput1);
         SafeRelease(&ctx.pImmediateContext);
@@ -252,6 +270,116 @@ bool InitializeDXGI(DXGIContext &ctx)
     return true;
 }
 
+// Lists every monitor attached to the desktop, across all adapters
+std::vector<DXGIOutputInfo> EnumerateDXGIOutputs()
+{
+    std::vector<DXGIOutputInfo> outputs;
+    IDXGIFactory1 *pFactory = nullptr;
+    HRESULT hr = CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void **>(&pFactory));
+    if (FAILED(hr))
+    {
+        LOG_ERR("Failed to create DXGI Factory. HR: 0x" << std::hex << hr);
+        return outputs;
+    }
+
+    IDXGIAdapter1 *pAdapter = nullptr;
+    for (UINT a = 0; pFactory->EnumAdapters1(a, &pAdapter) != DXGI_ERROR_NOT_FOUND; ++a)
+    {
+        IDXGIOutput *pOutput = nullptr;
+        for (UINT o = 0; pAdapter->EnumOutputs(o, &pOutput) != DXGI_ERROR_NOT_FOUND; ++o)
+        {
+            DXGI_OUTPUT_DESC desc;
+            if (SUCCEEDED(pOutput->GetDesc(&desc)) && desc.AttachedToDesktop)
+            {
+                DXGIOutputInfo info;
+                info.adapter_index = a;
+                info.output_index = o;
+                char name[64] = {};
+                WideCharToMultiByte(CP_UTF8, 0, desc.DeviceName, -1, name, sizeof(name) - 1, nullptr, nullptr);
+                info.device_name = name;
+                info.desktop_rect = desc.DesktopCoordinates;
+                outputs.push_back(info);
+            }
+            SafeRelease(&pOutput);
+        }
+        SafeRelease(&pAdapter);
+    }
+    SafeRelease(&pFactory);
+    return outputs;
+}
+
+DxgiScreenSource::DxgiScreenSource(UINT adapter_index, UINT output_index)
+    : adapter_index_(adapter_index), output_index_(output_index)
+{
+}
+
+DxgiScreenSource::~DxgiScreenSource()
+{
+    close();
+}
+
+bool DxgiScreenSource::open()
+{
+    close();
+    initialized_ = InitializeDXGI(ctx_, adapter_index_, output_index_);
+    consecutive_failures_ = 0;
+    return initialized_;
+}
+
+bool DxgiScreenSource::read(cv::Mat &frame_bgr)
+{
+    cv::Mat frame;
+    if (!readBgra(frame))
+        return false;
+    cv::cvtColor(frame, frame_bgr, cv::COLOR_BGRA2BGR);
+    return true;
+}
+
+bool DxgiScreenSource::readBgra(cv::Mat &frame_bgra)
+{
+    static const int MAX_CONSECUTIVE_FAILURES = 5;
+
+    unchanged_ = false;
+    if (!initialized_ && !open())
+        return false;
+
+    HRESULT hr = S_OK;
+    if (!GetScreenPixelsDXGI(ctx_.pDesktopDupl, ctx_.pDevice, ctx_.pImmediateContext, width_, height_, pixel_buffer_, &hr))
+    {
+        // A static desktop only times out, which is not a failure; lost access or repeated
+        // failures need a fresh duplication
+        if (hr == DXGI_ERROR_WAIT_TIMEOUT)
+        {
+            unchanged_ = true;
+            return false;
+        }
+        if (hr == DXGI_ERROR_ACCESS_LOST || ++consecutive_failures_ >= MAX_CONSECUTIVE_FAILURES)
+        {
+            close();
+        }
+        return false;
+    }
+
+    consecutive_failures_ = 0;
+    frame_bgra = cv::Mat(height_, width_, CV_8UC4, pixel_buffer_.data());
+    return true;
+}
+
+void DxgiScreenSource::close()
+{
+    if (initialized_)
+    {
+        CleanupDXGI(ctx_);
+        ctx_ = DXGIContext();
+        initialized_ = false;
+    }
+}
+
+std::string DxgiScreenSource::name() const
+{
+    return "screen:" + std::to_string(adapter_index_) + "." + std::to_string(output_index_);
+}
+
 // Helper function to get formatted timestamp
 std::string GetTimestampString()
 {
@@ -330,7 +458,7 @@ HRESULT InitDesktopDuplication(DXGIContext &ctx)
         IID_PPV_ARGS(&ctx.pWICFactory));
     CHECK_HR(hr, "Failed to create WIC Imaging Factory. Ensure COM is initialized (CoInitializeEx).");
 
-    std::cout << "DirectX and Desktop Duplication initialized successfully." << std::endl;
+    LOG("DirectX and Desktop Duplication initialized successfully.");
     return hr;
 }
 
@@ -357,7 +485,7 @@ void Cleanup(DXGIContext &ctx)
         ctx.pWICFactory = nullptr;
     }
     CoUninitialize(); // Uninitialize COM
-    std::cout << "DirectX and WIC components cleaned up." << std::endl;
+    LOG("DirectX and WIC components cleaned up.");
 }
 
 bool IsScreenBlack(const BYTE *pixels, UINT width, UINT height, UINT pitch)
@@ -412,7 +540,7 @@ HRESULT SavePixelsToPng(DXGIContext &ctx, const std::string &imageDirectory, con
     }
     catch (const std::filesystem::filesystem_error &e)
     {
-        std::cerr << "Filesystem error creating directory: " << e.what() << std::endl;
+        LOG_ERR("Filesystem error creating directory: " << e.what());
         return E_FAIL; // Return a general failure HRESULT
     }
 
@@ -449,7 +577,7 @@ HRESULT SavePixelsToPng(DXGIContext &ctx, const std::string &imageDirectory, con
     // For Desktop Duplication, BGRA is usually fine.
     if (pixelFormat != GUID_WICPixelFormat32bppBGRA)
     {
-        std::cerr << "Warning: Pixel format conversion occurred, this might affect performance or quality." << std::endl;
+        LOG_ERR("Warning: Pixel format conversion occurred, this might affect performance or quality.");
         // You might need to convert pixels if the format changed. For simplicity, we assume BGRA.
     }
 
@@ -463,7 +591,7 @@ HRESULT SavePixelsToPng(DXGIContext &ctx, const std::string &imageDirectory, con
     hr = pEncoder->Commit();
     CHECK_HR(hr, "Failed to commit encoder");
 
-    std::cout << "Screenshot saved to: " << filename << std::endl;
+    LOG("Screenshot saved to: " << filename);
 
     // Release WIC interfaces
     if (pFrameEncode)
@@ -539,7 +667,7 @@ HRESULT CaptureScreenshot(DXGIContext &ctx, const std::string &outputPath, bool
     // --- Check for blank (entirely black) screen ---
     if (IsScreenBlack(pixels, Desc.Width, Desc.Height, pitch))
     {
-        std::cout << "Screen detected as black, skipping screenshot." << std::endl;
+        LOG("Screen detected as black, skipping screenshot.");
         ctx.pImmediateContext->Unmap(StagingTexture, 0); // Unmap before releasing
         StagingTexture->Release();
         ctx.pDesktopDupl->ReleaseFrame(); // Release the frame acquired earlier
@@ -18,6 +18,8 @@
 #include <wincodec.h>
 
 #include <opencv2/opencv.hpp>
+#include "frame_source.hpp"
+#include "utils.hpp"
 
 using Microsoft::WRL::ComPtr;
 
@@ -31,7 +33,7 @@ using Microsoft::WRL::ComPtr;
 #define CHECK_HR(hr, msg)                                                                            \
     if (FAILED(hr))                                                                                  \
     {                                                                                                \
-        std::cerr << "Error: " << msg << ". HRESULT: 0x" << std::hex << hr << std::dec << std::endl; \
+        LOG_ERR("Error: " << msg << ". HRESULT: 0x" << std::hex << hr);                             \
         return hr;                                                                                   \
     }
 
@@ -51,7 +53,8 @@ bool GetScreenPixelsDXGI(
     ID3D11DeviceContext *pImmediateContext,
     int &width,
     int &height,
-    std::vector<BYTE> &pixel_data_out);
+    std::vector<BYTE> &pixel_data_out,
+    HRESULT *out_hr = nullptr); // S_OK, DXGI_ERROR_WAIT_TIMEOUT when nothing changed, or the failure
 
 // Helper struct to hold DXGI/DirectX objects
 struct DXGIContext
@@ -65,11 +68,48 @@ struct DXGIContext
     IWICImagingFactory *pWICFactory = nullptr;
 };
 
+struct DXGIOutputInfo
+{
+    UINT adapter_index = 0;
+    UINT output_index = 0;
+    std::string device_name;
+    RECT desktop_rect = {};
+};
+
 void CleanupDXGI(DXGIContext &ctx);
-bool InitializeDXGI(DXGIContext &ctx);
+bool InitializeDXGI(DXGIContext &ctx, UINT adapter_index = 0, UINT output_index = 0);
+std::vector<DXGIOutputInfo> EnumerateDXGIOutputs();
 std::string GetTimestampString();
 HRESULT InitDesktopDuplication(DXGIContext &ctx);
 void Cleanup(DXGIContext &ctx);
 HRESULT SavePixelsToPng(DXGIContext &ctx, const std::string &imageDirectory, const BYTE *pixels, UINT width, UINT height, UINT pitch, cv::Mat &out_cv_image);
 bool IsScreenBlack(const BYTE *pixels, UINT width, UINT height, UINT pitch);
-HRESULT CaptureScreenshot(DXGIContext &ctx, const std::string &outputPath, bool &capturedSuccessfully, cv::Mat &out_cv_image);
\ No newline at end of file
+HRESULT CaptureScreenshot(DXGIContext &ctx, const std::string &outputPath, bool &capturedSuccessfully, cv::Mat &out_cv_image);
+
+// Desktop Duplication of one monitor as a FrameSource. Re-initializes itself when access is lost.
+class DxgiScreenSource : public FrameSource
+{
+public:
+    DxgiScreenSource(UINT adapter_index, UINT output_index);
+    ~DxgiScreenSource() override;
+    bool open() override;
+    bool read(cv::Mat &frame_bgr) override;
+    // Like read(), without the color conversion: frame_bgra wraps the capture buffer and stays
+    // valid until the next read, so callers that need only part of the screen convert just that
+    bool readBgra(cv::Mat &frame_bgra);
+    void close() override;
+    std::string name() const override;
+    // The last read timed out because nothing on the screen changed; not a capture failure
+    bool unchanged() const override { return unchanged_; }
+
+private:
+    UINT adapter_index_;
+    UINT output_index_;
+    DXGIContext ctx_;
+    bool initialized_ = false;
+    int consecutive_failures_ = 0;
+    bool unchanged_ = false;
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<BYTE> pixel_buffer_;
+};
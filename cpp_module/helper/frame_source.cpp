@@ -0,0 +1,122 @@
+#include "frame_source.hpp"
+#include <algorithm>
+
+ReplaySource::ReplaySource(const std::string &path, bool loop)
+    : path_(path), loop_(loop)
+{
+}
+
+bool ReplaySource::open()
+{
+    image_paths_.clear();
+    next_image_ = 0;
+    exhausted_ = false;
+
+    std::error_code ec;
+    if (std::filesystem::is_directory(path_, ec))
+    {
+        for (const auto &entry : std::filesystem::directory_iterator(path_, ec))
+        {
+            if (entry.is_regular_file() && cv::haveImageReader(entry.path().generic_string()))
+                image_paths_.push_back(entry.path().generic_string());
+        }
+        std::sort(image_paths_.begin(), image_paths_.end());
+        if (image_paths_.empty())
+        {
+            LOG_ERR("Replay source has no readable images: " << path_);
+            return false;
+        }
+        return true;
+    }
+
+    if (!video_.open(path_))
+    {
+        LOG_ERR("Replay source could not open video: " << path_);
+        return false;
+    }
+    return true;
+}
+
+bool ReplaySource::read(cv::Mat &frame_bgr)
+{
+    if (!image_paths_.empty())
+    {
+        if (next_image_ >= image_paths_.size())
+        {
+            if (!loop_)
+            {
+                exhausted_ = true;
+                return false;
+            }
+            next_image_ = 0;
+        }
+        frame_bgr = cv::imread(image_paths_[next_image_++], cv::IMREAD_COLOR);
+        return !frame_bgr.empty();
+    }
+
+    if (video_.read(frame_bgr))
+        return true;
+    if (!loop_)
+    {
+        exhausted_ = true;
+        return false;
+    }
+    video_.set(cv::CAP_PROP_POS_FRAMES, 0);
+    return video_.read(frame_bgr);
+}
+
+void ReplaySource::close()
+{
+    video_.release();
+}
+
+std::string ReplaySource::name() const
+{
+    return "replay:" + std::filesystem::path(path_).filename().generic_string();
+}
+
+bool ReplaySource::exhausted() const
+{
+    return exhausted_;
+}
+
+WebcamSource::WebcamSource(int device_index, bool mirror)
+    : device_index_(device_index), mirror_(mirror)
+{
+}
+
+bool WebcamSource::open()
+{
+#ifdef _WIN32
+    const int backend = cv::CAP_DSHOW;
+#else
+    const int backend = cv::CAP_ANY;
+#endif
+    if (!webcam_.open(device_index_, backend))
+    {
+        LOG_ERR("Failed to open webcam " << device_index_);
+        return false;
+    }
+    return true;
+}
+
+bool WebcamSource::read(cv::Mat &frame_bgr)
+{
+    if (!mirror_)
+        return webcam_.read(frame_bgr);
+
+    if (!webcam_.read(raw_frame_) || raw_frame_.empty())
+        return false;
+    cv::flip(raw_frame_, frame_bgr, 1);
+    return true;
+}
+
+void WebcamSource::close()
+{
+    webcam_.release();
+}
+
+std::string WebcamSource::name() const
+{
+    return "webcam:" + std::to_string(device_index_);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "opencv2/opencv.hpp"
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "utils.hpp"
+
+// A capture device the multi-source engine can poll from its own thread.
+// read() returns BGR frames and may block until the next frame is available.
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+    virtual bool open() = 0;
+    virtual bool read(cv::Mat &frame_bgr) = 0;
+    virtual void close() {}
+    virtual std::string name() const = 0;
+    // True once the source will never produce another frame (e.g. a replay without looping)
+    virtual bool exhausted() const { return false; }
+    // True when the last read() returned false only because nothing changed on screen
+    virtual bool unchanged() const { return false; }
+    // Areas that changed in the frame the last successful read() returned, in its pixel
+    // coordinates. False when the source cannot tell; the whole frame may then have changed.
+    virtual bool changedRegions(std::vector<cv::Rect> &) const { return false; }
+};
+
+// Replays a directory of images (sorted by file name) or a video file. Used to exercise
+// the engine on machines without a desktop or camera, e.g. Linux CI.
+class ReplaySource : public FrameSource
+{
+public:
+    explicit ReplaySource(const std::string &path, bool loop = true);
+    bool open() override;
+    bool read(cv::Mat &frame_bgr) override;
+    void close() override;
+    std::string name() const override;
+    bool exhausted() const override;
+
+private:
+    std::string path_;
+    bool loop_;
+    std::vector<std::string> image_paths_;
+    size_t next_image_ = 0;
+    bool exhausted_ = false;
+    cv::VideoCapture video_;
+};
+
+class WebcamSource : public FrameSource
+{
+public:
+    explicit WebcamSource(int device_index, bool mirror = true);
+    bool open() override;
+    bool read(cv::Mat &frame_bgr) override;
+    void close() override;
+    std::string name() const override;
+
+private:
+    int device_index_;
+    bool mirror_;
+    cv::VideoCapture webcam_;
+    cv::Mat raw_frame_;
+};
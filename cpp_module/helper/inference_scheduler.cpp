@@ -0,0 +1,315 @@
+#include "inference_scheduler.hpp"
+#include "alloc_tracker.hpp"
+#include <algorithm>
+
+MultiSourceEngine::MultiSourceEngine(cv::dnn::Net &net, int max_batch)
+    : net_(net), max_batch_(std::max(1, max_batch))
+{
+}
+
+MultiSourceEngine::~MultiSourceEngine()
+{
+    stop();
+}
+
+size_t MultiSourceEngine::addSource(std::unique_ptr<FrameSource> source, double target_fps, double weight)
+{
+    auto slot = std::make_unique<SourceSlot>();
+    slot->source = std::move(source);
+    slot->index = static_cast<int>(slots_.size());
+    slot->target_fps = target_fps > 0.0 ? target_fps : 30.0;
+    slot->weight = weight > 0.0 ? weight : 1.0;
+    slots_.push_back(std::move(slot));
+    return slots_.size() - 1;
+}
+
+void MultiSourceEngine::setCallback(DetectionCallback callback)
+{
+    callback_ = std::move(callback);
+}
+
+void MultiSourceEngine::setSettings(const YoloSettings &settings)
+{
+    settings_ = settings;
+}
+
+bool MultiSourceEngine::start()
+{
+    if (running_ || slots_.empty())
+        return false;
+
+    for (auto &slot : slots_)
+    {
+        if (!slot->source->open())
+        {
+            LOG_ERR("Failed to open source " << slot->source->name() << ", it will be skipped.");
+            slot->exhausted = true;
+        }
+    }
+
+    stop_ = false;
+    running_ = true;
+    started_at_ = std::chrono::steady_clock::now();
+    for (auto &slot : slots_)
+    {
+        if (!slot->exhausted)
+            slot->thread = std::thread(&MultiSourceEngine::captureLoop, this, std::ref(*slot));
+    }
+    inference_thread_ = std::thread(&MultiSourceEngine::inferenceLoop, this);
+    return true;
+}
+
+void MultiSourceEngine::stop()
+{
+    stop_ = true;
+    frame_ready_.notify_all();
+    for (auto &slot : slots_)
+    {
+        if (slot->thread.joinable())
+            slot->thread.join();
+    }
+    if (inference_thread_.joinable())
+        inference_thread_.join();
+    for (auto &slot : slots_)
+    {
+        slot->source->close();
+    }
+    running_ = false;
+}
+
+bool MultiSourceEngine::running() const
+{
+    return running_;
+}
+
+void MultiSourceEngine::captureLoop(SourceSlot &slot)
+{
+    using clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / slot.target_fps));
+    auto next_capture = clock::now();
+    cv::Mat frame;
+    std::vector<cv::Rect> regions;
+    AllocStageScope stage(ALLOC_STAGE_CAPTURE); // Capture threads do nothing else
+    setTraceThreadName("capture " + slot.source->name());
+    int64_t frame_id = 0;
+
+    while (!stop_)
+    {
+        bool read_ok;
+        {
+            TRACE_SCOPE_SOURCE("read", frame_id + 1, slot.index);
+            read_ok = slot.source->read(frame) && !frame.empty();
+        }
+        if (!read_ok)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (slot.source->unchanged())
+                slot.frames_unchanged++;
+            else
+                slot.capture_failures++;
+            if (slot.source->exhausted())
+            {
+                slot.exhausted = true;
+                frame_ready_.notify_one();
+                return;
+            }
+        }
+        else
+        {
+            regions.clear();
+            const bool regions_known = slot.source->changedRegions(regions);
+            double changed_area = 0.0;
+            for (const cv::Rect &r : regions)
+                changed_area += r.area();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (regions_known)
+                {
+                    slot.frames_with_regions++;
+                    slot.changed_fraction_sum += std::min(1.0, changed_area / std::max(1, frame.cols * frame.rows));
+                }
+                // A dropped frame's changes are still changes relative to the last inferred one
+                if (slot.has_pending)
+                {
+                    slot.frames_dropped++;
+                    if (slot.pending_regions_known && regions_known)
+                        regions.insert(regions.end(), slot.pending_regions.begin(), slot.pending_regions.end());
+                    else
+                        regions.clear();
+                }
+                slot.pending_regions_known = regions_known && (!slot.has_pending || slot.pending_regions_known);
+                slot.pending_regions.swap(regions);
+                // Swapping hands the dropped frame's buffer back to the source for reuse
+                std::swap(slot.pending, frame);
+                slot.has_pending = true;
+                slot.pending_captured_at = clock::now();
+                slot.pending_frame_id = ++frame_id;
+                slot.frames_captured++;
+            }
+            frame_ready_.notify_one();
+        }
+
+        next_capture += period;
+        auto now = clock::now();
+        if (next_capture < now)
+            next_capture = now; // Fell behind; do not burst to catch up
+        std::this_thread::sleep_until(next_capture);
+    }
+}
+
+void MultiSourceEngine::inferenceLoop()
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<size_t> chosen;
+    std::vector<cv::Mat> frames;
+    std::vector<clock::time_point> captured_at;
+    std::vector<int64_t> frame_ids;
+    std::vector<std::vector<cv::Rect>> changed_regions;
+    std::vector<std::vector<Detection>> detections;
+    setTraceThreadName("inference");
+
+    while (!stop_)
+    {
+        chosen.clear();
+        frames.clear();
+        captured_at.clear();
+        frame_ids.clear();
+        changed_regions.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // An exhausted source only ends the loop once every other one is exhausted too
+            frame_ready_.wait(lock, [&]
+                              { return stop_ || std::any_of(slots_.begin(), slots_.end(), [](const std::unique_ptr<SourceSlot> &s)
+                                                            { return s->has_pending; }) ||
+                                       std::all_of(slots_.begin(), slots_.end(), [](const std::unique_ptr<SourceSlot> &s)
+                                                   { return s->exhausted; }); });
+            if (stop_)
+                break;
+
+            std::vector<size_t> candidates;
+            for (size_t i = 0; i < slots_.size(); ++i)
+            {
+                if (slots_[i]->has_pending)
+                    candidates.push_back(i);
+            }
+            if (candidates.empty())
+                break; // Every source is exhausted and drained
+
+            // Start-time fair queueing: serve the smallest start tag first
+            auto start_tag = [&](size_t i)
+            { return std::max(slots_[i]->virtual_time, virtual_clock_); };
+            std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b)
+                      { return start_tag(a) < start_tag(b); });
+
+            const size_t take = std::min(candidates.size(), static_cast<size_t>(max_batch_));
+            virtual_clock_ = start_tag(candidates[0]);
+            for (size_t k = 0; k < take; ++k)
+            {
+                SourceSlot &slot = *slots_[candidates[k]];
+                slot.virtual_time = start_tag(candidates[k]) + 1.0 / slot.weight;
+                chosen.push_back(candidates[k]);
+                frames.push_back(std::move(slot.pending));
+                slot.pending = cv::Mat();
+                slot.has_pending = false;
+                changed_regions.emplace_back();
+                if (slot.pending_regions_known)
+                    changed_regions.back().swap(slot.pending_regions);
+                slot.pending_regions.clear();
+                captured_at.push_back(slot.pending_captured_at);
+                frame_ids.push_back(slot.pending_frame_id);
+            }
+        }
+
+        std::vector<bool> failed(frames.size(), false);
+        detections.assign(frames.size(), std::vector<Detection>());
+        bool batched = false;
+        if (frames.size() > 1)
+        {
+            try
+            {
+                TRACE_SCOPE("inference batch");
+                detectObjectsWithYOLOBatch(frames, net_, detections, settings_);
+                batched = true;
+            }
+            catch (const cv::Exception &e)
+            {
+                LOG_ERR("Batched inference failed, falling back to one frame per forward pass: " << e.what());
+                max_batch_ = 1;
+            }
+        }
+        if (!batched)
+        {
+            for (size_t k = 0; k < frames.size(); ++k)
+            {
+                try
+                {
+                    TRACE_SCOPE_SOURCE("inference", frame_ids[k], static_cast<int>(chosen[k]));
+                    detectObjectsWithYOLO(frames[k], net_, detections[k], settings_);
+                }
+                catch (const cv::Exception &e)
+                {
+                    LOG_ERR("Inference failed for " << slots_[chosen[k]]->source->name() << ": " << e.what());
+                    failed[k] = true;
+                }
+            }
+        }
+
+        auto done = clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t k = 0; k < chosen.size(); ++k)
+            {
+                SourceSlot &slot = *slots_[chosen[k]];
+                if (failed[k])
+                {
+                    slot.inference_errors++;
+                    continue;
+                }
+                double latency_ms = std::chrono::duration<double, std::milli>(done - captured_at[k]).count();
+                slot.frames_inferred++;
+                slot.latency_sum_ms += latency_ms;
+                slot.latency_max_ms = std::max(slot.latency_max_ms, latency_ms);
+            }
+        }
+
+        if (callback_)
+        {
+            for (size_t k = 0; k < chosen.size(); ++k)
+            {
+                if (failed[k])
+                    continue;
+                TRACE_SCOPE_SOURCE("callback", frame_ids[k], static_cast<int>(chosen[k]));
+                callback_(chosen[k], frames[k], detections[k], changed_regions[k]);
+            }
+        }
+    }
+    running_ = false;
+}
+
+std::vector<SourceMetrics> MultiSourceEngine::metrics() const
+{
+    std::vector<SourceMetrics> out;
+    const double elapsed_s = std::max(1e-3, std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at_).count());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &slot : slots_)
+    {
+        SourceMetrics m;
+        m.name = slot->source->name();
+        m.target_fps = slot->target_fps;
+        m.weight = slot->weight;
+        m.frames_captured = slot->frames_captured;
+        m.frames_dropped = slot->frames_dropped;
+        m.frames_inferred = slot->frames_inferred;
+        m.frames_unchanged = slot->frames_unchanged;
+        m.capture_failures = slot->capture_failures;
+        m.changed_fraction = slot->frames_with_regions ? slot->changed_fraction_sum / slot->frames_with_regions : 0.0;
+        m.inference_errors = slot->inference_errors;
+        m.capture_fps = slot->frames_captured / elapsed_s;
+        m.inference_fps = slot->frames_inferred / elapsed_s;
+        m.avg_latency_ms = slot->frames_inferred ? slot->latency_sum_ms / slot->frames_inferred : 0.0;
+        m.max_latency_ms = slot->latency_max_ms;
+        out.push_back(m);
+    }
+    return out;
+}
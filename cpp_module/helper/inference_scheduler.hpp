@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "frame_source.hpp"
+#include "yolo.hpp"
+
+struct SourceMetrics
+{
+    std::string name;
+    double target_fps = 0.0;
+    double weight = 1.0;
+    uint64_t frames_captured = 0;
+    uint64_t frames_dropped = 0; // Replaced by a newer capture before inference reached them
+    uint64_t frames_inferred = 0;
+    uint64_t frames_unchanged = 0; // Reads skipped because nothing changed on screen
+    uint64_t capture_failures = 0;
+    uint64_t inference_errors = 0;
+    // Average share of a captured frame that changed, for sources that report changed regions
+    double changed_fraction = 0.0;
+    double capture_fps = 0.0;
+    double inference_fps = 0.0;
+    double avg_latency_ms = 0.0; // Capture to detections available
+    double max_latency_ms = 0.0;
+};
+
+// Called on the inference thread for every processed frame; keep it short. changed_regions
+// covers everything that changed since the previous frame of that source that reached
+// inference (including frames dropped in between); it is empty when the source cannot tell.
+typedef std::function<void(size_t source_index, const cv::Mat &frame, const std::vector<Detection> &detections,
+                           const std::vector<cv::Rect> &changed_regions)>
+    DetectionCallback;
+
+// Runs every FrameSource on its own capture thread and shares one network between them.
+// Each source keeps only its latest frame; the inference thread picks frames by start-time
+// fair queueing, so a source with weight 2 gets twice the inference share of a source with
+// weight 1 when both are backlogged, and idle sources do not bank credit.
+class MultiSourceEngine
+{
+public:
+    MultiSourceEngine(cv::dnn::Net &net, int max_batch = 1);
+    ~MultiSourceEngine();
+
+    size_t addSource(std::unique_ptr<FrameSource> source, double target_fps, double weight = 1.0);
+    void setCallback(DetectionCallback callback);
+    // Must be called before start()
+    void setSettings(const YoloSettings &settings);
+    bool start();
+    void stop();
+    // False once stopped or once every source is exhausted and drained
+    bool running() const;
+    std::vector<SourceMetrics> metrics() const;
+
+private:
+    struct SourceSlot
+    {
+        std::unique_ptr<FrameSource> source;
+        int index = 0;
+        double target_fps = 30.0;
+        double weight = 1.0;
+        std::thread thread;
+
+        // Guarded by MultiSourceEngine::mutex_
+        cv::Mat pending;
+        bool has_pending = false;
+        std::vector<cv::Rect> pending_regions;
+        bool pending_regions_known = false;
+        bool exhausted = false;
+        std::chrono::steady_clock::time_point pending_captured_at;
+        int64_t pending_frame_id = 0; // Capture sequence number, ties trace spans to the frame
+        double virtual_time = 0.0;
+        uint64_t frames_captured = 0;
+        uint64_t frames_dropped = 0;
+        uint64_t frames_inferred = 0;
+        uint64_t frames_unchanged = 0;
+        uint64_t capture_failures = 0;
+        uint64_t frames_with_regions = 0;
+        double changed_fraction_sum = 0.0;
+        uint64_t inference_errors = 0;
+        double latency_sum_ms = 0.0;
+        double latency_max_ms = 0.0;
+    };
+
+    void captureLoop(SourceSlot &slot);
+    void inferenceLoop();
+
+    cv::dnn::Net &net_;
+    int max_batch_;
+    DetectionCallback callback_;
+    YoloSettings settings_;
+    std::vector<std::unique_ptr<SourceSlot>> slots_;
+    std::thread inference_thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> running_{false};
+    double virtual_clock_ = 0.0;
+    std::chrono::steady_clock::time_point started_at_;
+};
@@ -0,0 +1,409 @@
+#include "intent_classifier.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+struct BuiltinPattern
+{
+    const char *action;
+    const char *pattern;
+};
+
+// Covers the actions of tasks.json and the commands automation_tool.py parses. Where phrases
+// overlap ("wait for {element}" and "wait for text {text}") the one with more fixed words wins.
+static const BuiltinPattern BUILTIN_PATTERNS[] = {
+    {"open", "open {app}"},
+    {"open", "launch {app}"},
+    {"open", "start {app}"},
+    {"navigate", "go to {url}"},
+    {"navigate", "navigate to {url}"},
+    {"navigate", "browse to {url}"},
+    {"navigate", "open [the] website {url}"},
+    {"login", "log in"},
+    {"login", "log in to {url}"},
+    {"login", "log into {url}"},
+    {"login", "login"},
+    {"login", "login to {url}"},
+    {"login", "sign in"},
+    {"login", "sign in to {url}"},
+    {"screenshot", "screenshot"},
+    {"screenshot", "take [a] screenshot"},
+    {"screenshot", "capture [the] screen"},
+    {"screenshot", "grab [the] screen"},
+    {"type", "type"},
+    {"type", "type {value}"},
+    {"type", "write {value}"},
+    {"wait_for_element", "find [the] {element}"},
+    {"wait_for_element", "wait for [the] {element}"},
+    {"wait_for_text", "find text {text}"},
+    {"wait_for_text", "wait for text {text}"},
+    {"read_text", "read [the] text"},
+    {"read_text", "read [the] screen"},
+    {"execute_tasks", "execute [the] tasks"},
+    {"execute_tasks", "run [the] tasks"},
+    {"stop_listening", "stop listening"},
+};
+
+// Clicking is waiting for the target and then clicking it
+static const BuiltinPattern BUILTIN_CLICK_PATTERNS[] = {
+    {"wait_for_element", "click [on] [the] {element}"},
+    {"wait_for_text", "click [on] text {text}"},
+};
+
+// Filled in when the command does not say; the same defaults as TaskRunner and the Python tool
+static const std::map<std::string, std::map<std::string, std::string>> ACTION_DEFAULTS = {
+    {"open", {{"app", "notepad.exe"}}},
+    {"login", {{"url", "https://example.com"}}},
+    {"screenshot", {{"prefix", "voice"}}},
+    {"type", {{"value", "Hello from voice command!"}}},
+};
+
+static std::string stripPunctuation(const std::string &token)
+{
+    size_t begin = 0, end = token.size();
+    while (begin < end && std::ispunct(static_cast<unsigned char>(token[begin])))
+        ++begin;
+    while (end > begin && std::ispunct(static_cast<unsigned char>(token[end - 1])))
+        --end;
+    std::string word = token.substr(begin, end - begin);
+    for (char &c : word)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return word;
+}
+
+// Words for matching, and the same words as written for slot values ("type Hello, World!")
+static void splitCommand(const std::string &text, std::vector<std::string> &out_raw, std::vector<std::string> &out_words)
+{
+    out_raw.clear();
+    out_words.clear();
+    std::istringstream ss(text);
+    std::string token;
+    while (ss >> token)
+    {
+        std::string word = stripPunctuation(token);
+        if (word.empty())
+            continue;
+        out_raw.push_back(token);
+        out_words.push_back(word);
+    }
+}
+
+std::vector<std::string> tokenizeCommand(const std::string &text)
+{
+    std::vector<std::string> raw, words;
+    splitCommand(text, raw, words);
+    return words;
+}
+
+static uint32_t fnv1a(const std::string &text)
+{
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void hashIntentFeatures(const std::vector<std::string> &words, float *out_features)
+{
+    std::fill(out_features, out_features + INTENT_HASH_DIM, 0.0f);
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        out_features[fnv1a(words[i]) % INTENT_HASH_DIM] += 1.0f;
+        if (i + 1 < words.size())
+            out_features[fnv1a(words[i] + " " + words[i + 1]) % INTENT_HASH_DIM] += 1.0f;
+    }
+    float norm = 0.0f;
+    for (int i = 0; i < INTENT_HASH_DIM; ++i)
+        norm += out_features[i] * out_features[i];
+    if (norm > 0.0f)
+    {
+        norm = std::sqrt(norm);
+        for (int i = 0; i < INTENT_HASH_DIM; ++i)
+            out_features[i] /= norm;
+    }
+}
+
+// Spoken addresses: "example dot com slash login" is example.com/login
+static std::string spokenUrl(const std::vector<std::string> &words)
+{
+    std::string url;
+    for (const std::string &word : words)
+    {
+        if (word == "dot")
+            url += ".";
+        else if (word == "slash")
+            url += "/";
+        else
+            url += word;
+    }
+    if (!url.empty() && url.rfind("http://", 0) != 0 && url.rfind("https://", 0) != 0)
+        url = "https://" + url;
+    return url;
+}
+
+IntentClassifier::IntentClassifier()
+{
+    nodes_.emplace_back();
+    for (const BuiltinPattern &p : BUILTIN_PATTERNS)
+        addPattern(p.action, p.pattern);
+    for (const BuiltinPattern &p : BUILTIN_CLICK_PATTERNS)
+        addPattern(p.action, p.pattern, {{"click", "true"}});
+}
+
+int IntentClassifier::childOf(int node, int word_id) const
+{
+    const std::vector<std::pair<int, int>> &children = nodes_[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(word_id, -1));
+    return it != children.end() && it->first == word_id ? it->second : -1;
+}
+
+bool IntentClassifier::addPattern(const std::string &action, const std::string &pattern, const std::map<std::string, std::string> &fixed_params)
+{
+    // Every combination of the optional words becomes its own path through the trie
+    std::vector<std::vector<std::string>> variants(1);
+    std::string slot;
+    std::istringstream ss(pattern);
+    std::string token;
+    while (ss >> token)
+    {
+        if (!slot.empty())
+        {
+            LOG_ERR("Intent pattern \"" << pattern << "\": the slot must be the last word");
+            return false;
+        }
+        if (token.size() > 2 && token.front() == '{' && token.back() == '}')
+        {
+            slot = token.substr(1, token.size() - 2);
+        }
+        else if (token.size() > 2 && token.front() == '[' && token.back() == ']')
+        {
+            const size_t count = variants.size();
+            for (size_t v = 0; v < count; ++v)
+            {
+                variants.push_back(variants[v]);
+                variants.back().push_back(stripPunctuation(token));
+            }
+        }
+        else
+        {
+            for (std::vector<std::string> &variant : variants)
+                variant.push_back(stripPunctuation(token));
+        }
+    }
+    if (variants[0].empty() && slot.empty())
+    {
+        LOG_ERR("Empty intent pattern for " << action);
+        return false;
+    }
+
+    for (const std::vector<std::string> &words : variants)
+    {
+        if (words.empty())
+        {
+            LOG_ERR("Intent pattern \"" << pattern << "\" needs a fixed word before its slot");
+            return false;
+        }
+        int node = 0;
+        for (const std::string &word : words)
+        {
+            const int word_id = vocabulary_.emplace(word, static_cast<int>(vocabulary_.size())).first->second;
+            int child = childOf(node, word_id);
+            if (child < 0)
+            {
+                child = static_cast<int>(nodes_.size());
+                nodes_.emplace_back();
+                std::vector<std::pair<int, int>> &children = nodes_[node].children;
+                children.insert(std::lower_bound(children.begin(), children.end(), std::make_pair(word_id, -1)), {word_id, child});
+            }
+            node = child;
+        }
+        int &accept = slot.empty() ? nodes_[node].accept : nodes_[node].accept_slot;
+        if (accept >= 0 && patterns_[accept].action != action)
+        {
+            LOG_WARN("Intent pattern \"" << pattern << "\" for " << action << " is already taken by " << patterns_[accept].action);
+            continue;
+        }
+        Pattern compiled;
+        compiled.action = action;
+        compiled.slot = slot;
+        compiled.literal_words = static_cast<int>(words.size());
+        compiled.fixed_params = fixed_params;
+        accept = static_cast<int>(patterns_.size());
+        patterns_.push_back(compiled);
+    }
+    return true;
+}
+
+bool IntentClassifier::loadFallback(const std::string &onnx_path, const std::string &labels_path)
+{
+    std::vector<std::string> labels;
+    std::ifstream ifs(labels_path);
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        line = stripPunctuation(line);
+        if (!line.empty())
+            labels.push_back(line);
+    }
+    if (labels.empty())
+    {
+        LOG_ERR("No intent labels in " << labels_path);
+        return false;
+    }
+
+    cv::dnn::Net net;
+    try
+    {
+        net = cv::dnn::readNetFromONNX(onnx_path);
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        std::vector<float> features(INTENT_HASH_DIM, 0.0f);
+        net.setInput(cv::Mat(1, INTENT_HASH_DIM, CV_32F, features.data()));
+        cv::Mat out = net.forward();
+        if (static_cast<size_t>(out.total()) != labels.size())
+        {
+            LOG_ERR("Intent classifier " << onnx_path << " has " << out.total() << " outputs for " << labels.size() << " labels");
+            return false;
+        }
+    }
+    catch (const cv::Exception &e)
+    {
+        LOG_ERR("Failed to load intent classifier " << onnx_path << ": " << e.what());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(fallback_mutex_);
+    fallback_net_ = net;
+    fallback_labels_ = labels;
+    return true;
+}
+
+void IntentClassifier::applyDefaults(Intent &intent) const
+{
+    auto defaults = ACTION_DEFAULTS.find(intent.action);
+    if (defaults == ACTION_DEFAULTS.end())
+        return;
+    for (const auto &entry : defaults->second)
+    {
+        std::string &value = intent.params[entry.first];
+        if (value.empty())
+            value = entry.second;
+    }
+}
+
+Intent IntentClassifier::classify(const std::string &text) const
+{
+    std::vector<std::string> raw, words;
+    splitCommand(text, raw, words);
+    if (words.empty())
+        return Intent();
+
+    // The first phrase in the command wins, so "type open chrome" types; words before it
+    // ("please", "can you") only lower the confidence. Of the phrases starting at the same
+    // word, the one with more fixed words wins, then the one explaining more of the command.
+    const int n = static_cast<int>(words.size());
+    int best = -1, best_slot_begin = 0, best_covered = 0;
+    auto consider = [&](int pattern, int slot_begin, int covered)
+    {
+        if (best >= 0)
+        {
+            const int literal_words = patterns_[pattern].literal_words, best_literal_words = patterns_[best].literal_words;
+            if (literal_words != best_literal_words ? literal_words < best_literal_words : covered <= best_covered)
+                return;
+        }
+        best = pattern;
+        best_slot_begin = slot_begin;
+        best_covered = covered;
+    };
+    for (int start = 0; start < n && best < 0; ++start)
+    {
+        int node = 0;
+        for (int i = start;; ++i)
+        {
+            if (nodes_[node].accept_slot >= 0 && i < n)
+                consider(nodes_[node].accept_slot, i, n - start);
+            if (nodes_[node].accept >= 0)
+                consider(nodes_[node].accept, i, i - start);
+            if (i == n)
+                break;
+            auto word = vocabulary_.find(words[i]);
+            if (word == vocabulary_.end() || (node = childOf(node, word->second)) < 0)
+                break;
+        }
+    }
+    if (best < 0)
+        return classifyWithFallback(words);
+
+    const Pattern &pattern = patterns_[best];
+    Intent intent;
+    intent.action = pattern.action;
+    intent.params = pattern.fixed_params;
+    intent.confidence = static_cast<float>(best_covered) / n;
+    if (!pattern.slot.empty())
+    {
+        int begin = best_slot_begin;
+        if (pattern.slot == "url")
+        {
+            intent.params["url"] = spokenUrl(std::vector<std::string>(words.begin() + begin, words.end()));
+        }
+        else
+        {
+            // "open the calculator" names the calculator; typed text is kept as said
+            if (pattern.slot == "app" || pattern.slot == "element")
+            {
+                while (begin < n && (words[begin] == "the" || words[begin] == "a" || words[begin] == "an"))
+                    ++begin;
+            }
+            std::string value;
+            for (int i = begin; i < n; ++i)
+                value += (value.empty() ? "" : " ") + raw[i];
+            intent.params[pattern.slot] = value;
+        }
+    }
+    applyDefaults(intent);
+    return intent;
+}
+
+Intent IntentClassifier::classifyWithFallback(const std::vector<std::string> &words) const
+{
+    std::lock_guard<std::mutex> lock(fallback_mutex_);
+    if (fallback_net_.empty())
+        return Intent();
+
+    float features[INTENT_HASH_DIM];
+    hashIntentFeatures(words, features);
+    cv::Mat scores;
+    try
+    {
+        fallback_net_.setInput(cv::Mat(1, INTENT_HASH_DIM, CV_32F, features));
+        scores = fallback_net_.forward().reshape(1, 1).clone();
+    }
+    catch (const cv::Exception &e)
+    {
+        LOG_ERR("Intent classifier failed: " << e.what());
+        return Intent();
+    }
+
+    // Softmax probability of the top logit
+    const float *logits = scores.ptr<float>();
+    const int count = static_cast<int>(scores.total());
+    const int best = static_cast<int>(std::max_element(logits, logits + count) - logits);
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i)
+        sum += std::exp(logits[i] - logits[best]);
+    const float probability = 1.0f / sum;
+    if (probability < INTENT_FALLBACK_MIN_SCORE)
+        return Intent();
+
+    Intent intent;
+    intent.action = fallback_labels_[best];
+    intent.confidence = probability;
+    intent.from_fallback = true;
+    applyDefaults(intent);
+    return intent;
+}
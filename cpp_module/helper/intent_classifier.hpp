@@ -0,0 +1,79 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "utils.hpp"
+
+// Turns short commands ("open chrome", "go to example dot com", "click the search button")
+// into tasks.json style steps, in place of the DistilBERT pipeline in automation_tool.py.
+// Command phrases are compiled into a word trie; a phrase may end in a slot that takes the
+// rest of the command. An optional tiny ONNX classifier over hashed words catches commands no
+// phrase matches (see python_module/intent_train); its intents come without slots.
+
+const int INTENT_HASH_DIM = 512; // Input width of the fallback classifier
+const float INTENT_FALLBACK_MIN_SCORE = 0.6f;
+
+struct Intent
+{
+    // A tasks.json action (open, navigate, login, screenshot, type, wait_for_element,
+    // wait_for_text) or one of read_text, execute_tasks, stop_listening; empty if nothing matched
+    std::string action;
+    std::map<std::string, std::string> params; // Keys as in tasks.json; defaults filled in
+    // Share of the command's words the phrase and its slot account for; the classifier's
+    // probability for fallback intents
+    float confidence = 0.0f;
+    bool from_fallback = false;
+};
+
+class IntentClassifier
+{
+public:
+    // Compiles the built-in phrases
+    IntentClassifier();
+
+    // Pattern words are matched exactly (case-insensitive); "[word]" is optional and a final
+    // "{name}" takes the remaining words as params[name]. Fixed params come with the pattern.
+    bool addPattern(const std::string &action, const std::string &pattern, const std::map<std::string, std::string> &fixed_params = {});
+    // A model mapping [1, INTENT_HASH_DIM] hashed words to one logit per line of labels_path
+    bool loadFallback(const std::string &onnx_path, const std::string &labels_path);
+
+    Intent classify(const std::string &text) const;
+    size_t patternCount() const { return patterns_.size(); }
+
+private:
+    struct Pattern
+    {
+        std::string action;
+        std::string slot; // Empty when the pattern has none
+        int literal_words = 0;
+        std::map<std::string, std::string> fixed_params;
+    };
+
+    struct TrieNode
+    {
+        std::vector<std::pair<int, int>> children; // (word id, node), sorted by word id
+        int accept = -1;      // Pattern ending here
+        int accept_slot = -1; // Pattern whose slot starts here
+    };
+
+    int childOf(int node, int word_id) const;
+    void applyDefaults(Intent &intent) const;
+    Intent classifyWithFallback(const std::vector<std::string> &words) const;
+
+    std::vector<Pattern> patterns_;
+    std::vector<TrieNode> nodes_;
+    std::unordered_map<std::string, int> vocabulary_;
+
+    mutable std::mutex fallback_mutex_; // Net::forward is not const
+    mutable cv::dnn::Net fallback_net_;
+    std::vector<std::string> fallback_labels_;
+};
+
+// Lower-case words without surrounding punctuation
+std::vector<std::string> tokenizeCommand(const std::string &text);
+// Bag of hashed words and word pairs (FNV-1a modulo INTENT_HASH_DIM), L2-normalized; the same
+// features python_module/intent_train/train_intent.py trains on
+void hashIntentFeatures(const std::vector<std::string> &words, float *out_features);
@@ -0,0 +1,378 @@
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct LogRecord
+    {
+        int64_t timestamp_ns = 0;
+        LogLevel level = LogLevel::Info;
+        uint32_t suppressed = 0;
+        const char *message = nullptr; // Literal message of a LOG_EVENT
+        std::string *long_text = nullptr; // Owned; set when the text does not fit inline
+        uint16_t text_length = 0;
+        uint8_t field_count = 0;
+        char text[LOG_INLINE_TEXT];
+        LogField fields[LOG_MAX_FIELDS];
+    };
+
+    // Single producer (the owning thread), single consumer (the sink thread)
+    struct LogRing
+    {
+        LogRecord slots[LOG_RING_CAPACITY];
+        std::atomic<uint64_t> head{0}; // Next slot to write
+        std::atomic<uint64_t> tail{0}; // Next slot to read
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> orphaned{false}; // Owning thread has exited
+
+        LogRecord *beginWrite()
+        {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) >= LOG_RING_CAPACITY)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return &slots[h & (LOG_RING_CAPACITY - 1)];
+        }
+
+        void commitWrite()
+        {
+            head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    };
+
+    static_assert((LOG_RING_CAPACITY & (LOG_RING_CAPACITY - 1)) == 0, "LOG_RING_CAPACITY must be a power of two");
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const char *levelPrefix(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Debug:
+            return "[DEBUG] ";
+        case LogLevel::Warn:
+            return "[WARN] ";
+        case LogLevel::Error:
+            return "[ERROR] ";
+        default:
+            return "[INFO] ";
+        }
+    }
+
+    class Logger
+    {
+    public:
+        static Logger &instance()
+        {
+            static Logger logger;
+            return logger;
+        }
+
+        ~Logger()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            if (sink_.joinable())
+                sink_.join();
+        }
+
+        LogRing &threadRing()
+        {
+            // The ring outlives its thread until the sink has drained it
+            struct Owner
+            {
+                std::shared_ptr<LogRing> ring;
+                ~Owner()
+                {
+                    if (ring)
+                        ring->orphaned.store(true, std::memory_order_release);
+                }
+            };
+            thread_local Owner owner;
+            if (!owner.ring)
+            {
+                owner.ring = std::make_shared<LogRing>();
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings_.push_back(owner.ring);
+            }
+            return *owner.ring;
+        }
+
+        void wake()
+        {
+            wake_.notify_one();
+        }
+
+        // Holds the sink's writes off while text goes out, so a block is never split by a batch
+        void writeDirect(const std::string &text)
+        {
+            flush();
+            std::lock_guard<std::mutex> lock(output_mutex_);
+            std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+            std::cout.flush();
+        }
+
+        void flush()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            uint64_t target = ++flush_requested_;
+            wake_.notify_one();
+            flushed_.wait(lock, [&]
+                          { return flush_completed_ >= target || stop_; });
+        }
+
+    private:
+        Logger() : sink_(&Logger::run, this) {}
+
+        void run()
+        {
+            std::vector<LogRecord> batch;
+            std::string out;
+            while (true)
+            {
+                uint64_t flush_target;
+                bool stopping;
+                std::vector<std::shared_ptr<LogRing>> rings;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wake_.wait_for(lock, std::chrono::milliseconds(5), [&]
+                                   { return stop_ || flush_requested_ > flush_completed_; });
+                    flush_target = flush_requested_;
+                    stopping = stop_;
+                    rings = rings_;
+                }
+
+                batch.clear();
+                uint64_t dropped = 0;
+                for (const auto &ring : rings)
+                {
+                    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+                    uint64_t head = ring->head.load(std::memory_order_acquire);
+                    for (; tail != head; ++tail)
+                        batch.push_back(ring->slots[tail & (LOG_RING_CAPACITY - 1)]);
+                    ring->tail.store(tail, std::memory_order_release);
+                    dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+                }
+
+                std::stable_sort(batch.begin(), batch.end(), [](const LogRecord &a, const LogRecord &b)
+                                 { return a.timestamp_ns < b.timestamp_ns; });
+                out.clear();
+                for (LogRecord &record : batch)
+                {
+                    format(record, out);
+                    delete record.long_text;
+                }
+                if (dropped > 0)
+                    out += "[WARN] Logger ring full, dropped " + std::to_string(dropped) + " records\n";
+                if (!out.empty())
+                {
+                    std::lock_guard<std::mutex> output_lock(output_mutex_);
+                    std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+                    std::cout.flush();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<LogRing> &r)
+                                                { return r->orphaned.load(std::memory_order_acquire) &&
+                                                         r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire); }),
+                                 rings_.end());
+                    flush_completed_ = std::max(flush_completed_, flush_target);
+                }
+                flushed_.notify_all();
+                if (stopping)
+                    return;
+            }
+        }
+
+        static void format(const LogRecord &record, std::string &out)
+        {
+            out += levelPrefix(record.level);
+            if (record.long_text)
+                out += *record.long_text;
+            else if (record.message)
+                out += record.message;
+            else
+                out.append(record.text, record.text_length);
+
+            char value[64];
+            for (uint8_t i = 0; i < record.field_count; ++i)
+            {
+                const LogField &field = record.fields[i];
+                switch (field.type)
+                {
+                case LogField::Type::Int:
+                    snprintf(value, sizeof(value), "%lld", static_cast<long long>(field.i));
+                    break;
+                case LogField::Type::Hex:
+                    snprintf(value, sizeof(value), "0x%llx", static_cast<unsigned long long>(field.i) & 0xFFFFFFFFull);
+                    break;
+                case LogField::Type::Double:
+                    snprintf(value, sizeof(value), "%.3f", field.d);
+                    break;
+                case LogField::Type::Text:
+                    snprintf(value, sizeof(value), "%s", field.s);
+                    break;
+                }
+                out += ' ';
+                out += field.key;
+                out += '=';
+                out += value;
+            }
+            if (record.suppressed > 0)
+                out += " (suppressed " + std::to_string(record.suppressed) + " similar)";
+            out += '\n';
+        }
+
+        std::mutex mutex_;
+        std::mutex output_mutex_; // Taken only around writes to stdout, never with mutex_
+        std::condition_variable wake_;
+        std::condition_variable flushed_;
+        std::vector<std::shared_ptr<LogRing>> rings_;
+        uint64_t flush_requested_ = 0;
+        uint64_t flush_completed_ = 0;
+        bool stop_ = false;
+        std::thread sink_;
+    };
+}
+
+LogField::LogField(const char *k, const char *v) : key(k), type(Type::Text)
+{
+    strncpy(s, v ? v : "", LOG_FIELD_TEXT - 1);
+    s[LOG_FIELD_TEXT - 1] = '\0';
+}
+
+LogField LogField::hex(const char *k, int64_t v)
+{
+    LogField field(k, static_cast<long long>(v));
+    field.type = Type::Hex;
+    return field;
+}
+
+bool LogSite::allow()
+{
+    const int64_t now_ms = nowNs() / 1000000;
+    int64_t window = window_start_ms_.load(std::memory_order_relaxed);
+    if (now_ms - window >= 1000 && window_start_ms_.compare_exchange_strong(window, now_ms, std::memory_order_relaxed))
+        count_.store(0, std::memory_order_relaxed);
+
+    if (count_.fetch_add(1, std::memory_order_relaxed) < LOG_SITE_RATE_PER_SEC)
+        return true;
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+namespace
+{
+    thread_local std::vector<std::unique_ptr<std::ostringstream>> lease_streams;
+    thread_local size_t lease_depth = 0;
+
+    std::ostringstream &acquireLogStream()
+    {
+        if (lease_depth == lease_streams.size())
+            lease_streams.push_back(std::make_unique<std::ostringstream>());
+        std::ostringstream &stream = *lease_streams[lease_depth++];
+        stream.str(std::string());
+        stream.clear();
+        // A previous message may have left std::hex or a precision behind
+        stream.flags(std::ios_base::dec | std::ios_base::skipws);
+        stream.precision(6);
+        stream.fill(' ');
+        return stream;
+    }
+}
+
+LogStreamLease::LogStreamLease() : stream(acquireLogStream())
+{
+}
+
+LogStreamLease::~LogStreamLease()
+{
+    lease_depth--;
+}
+
+void logText(LogLevel level, LogSite &site, std::ostringstream &text)
+{
+    Logger &logger = Logger::instance();
+    LogRing &ring = logger.threadRing();
+    LogRecord *record = ring.beginWrite();
+    if (!record)
+        return;
+
+    record->timestamp_ns = nowNs();
+    record->level = level;
+    record->suppressed = site.takeSuppressed();
+    record->message = nullptr;
+    record->field_count = 0;
+    record->long_text = nullptr;
+
+    const std::string str = text.str();
+    if (str.size() <= LOG_INLINE_TEXT)
+    {
+        memcpy(record->text, str.data(), str.size());
+        record->text_length = static_cast<uint16_t>(str.size());
+    }
+    else
+    {
+        record->long_text = new std::string(str);
+        record->text_length = 0;
+    }
+    ring.commitWrite();
+    if (level == LogLevel::Error)
+        logger.wake();
+}
+
+void logEvent(LogLevel level, LogSite &site, const char *message, std::initializer_list<LogField> fields)
+{
+    Logger &logger = Logger::instance();
+    LogRing &ring = logger.threadRing();
+    LogRecord *record = ring.beginWrite();
+    if (!record)
+        return;
+
+    record->timestamp_ns = nowNs();
+    record->level = level;
+    record->suppressed = site.takeSuppressed();
+    record->message = message;
+    record->long_text = nullptr;
+    record->text_length = 0;
+    record->field_count = 0;
+    for (const LogField &field : fields)
+    {
+        if (record->field_count == LOG_MAX_FIELDS)
+            break;
+        record->fields[record->field_count++] = field;
+    }
+    ring.commitWrite();
+}
+
+void flushLogs()
+{
+    Logger::instance().flush();
+}
+
+void writeStdout(const std::string &text)
+{
+    Logger::instance().writeDirect(text);
+}
+
+void logReport(std::ostringstream &text)
+{
+    writeStdout(levelPrefix(LogLevel::Info) + text.str() + "\n");
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <sstream>
+#include <string>
+
+// Asynchronous logger. Each thread appends fixed-size records to its own lock-free
+// single-producer ring; a background sink thread drains the rings, orders the records by
+// time and writes them to stdout in batches. A full ring drops records (and counts them)
+// rather than blocking the caller.
+//
+//   LOG / LOG_WARN / LOG_ERR / LOG_DEBUG   stream-style text, formatted on the calling thread
+//   LOG_EVENT(level, "message", {"key", value}, ...)
+//                                          structured record; values are copied raw and
+//                                          formatted by the sink, for capture and inference loops
+//
+//   LOG_REPORT                             stream-style text written synchronously, for tables
+//                                          and summaries that must not go missing
+//
+// Every LOG and LOG_EVENT call site is rate limited to LOG_SITE_RATE_PER_SEC records per
+// second; the count of suppressed records is reported with the next one that gets through.
+// LOG_REPORT is never rate limited or dropped. Levels below AGENT_LOG_MIN_LEVEL (0 debug,
+// 1 info, 2 warn, 3 error) compile to nothing.
+//
+// Tools that speak a protocol on stdout write it with writeStdout(), so a log batch can never
+// land in the middle of a reply.
+
+#ifndef AGENT_LOG_MIN_LEVEL
+#define AGENT_LOG_MIN_LEVEL 1
+#endif
+
+const int LOG_SITE_RATE_PER_SEC = 50;
+const size_t LOG_RING_CAPACITY = 512; // Records per thread, power of two
+const size_t LOG_INLINE_TEXT = 160;   // Longer text is moved to the heap
+const size_t LOG_MAX_FIELDS = 4;
+const size_t LOG_FIELD_TEXT = 24;
+
+enum class LogLevel : uint8_t
+{
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+};
+
+struct LogField
+{
+    enum class Type : uint8_t
+    {
+        Int,
+        Hex,
+        Double,
+        Text,
+    };
+
+    const char *key = ""; // Must be a string literal
+    Type type = Type::Int;
+    union
+    {
+        int64_t i;
+        double d;
+        char s[LOG_FIELD_TEXT]; // Copied and truncated
+    };
+
+    LogField() : i(0) {}
+    LogField(const char *k, int v) : key(k), type(Type::Int), i(v) {}
+    LogField(const char *k, long v) : key(k), type(Type::Int), i(v) {}
+    LogField(const char *k, long long v) : key(k), type(Type::Int), i(v) {}
+    LogField(const char *k, unsigned v) : key(k), type(Type::Int), i(v) {}
+    LogField(const char *k, unsigned long v) : key(k), type(Type::Int), i(static_cast<int64_t>(v)) {}
+    LogField(const char *k, unsigned long long v) : key(k), type(Type::Int), i(static_cast<int64_t>(v)) {}
+    LogField(const char *k, double v) : key(k), type(Type::Double), d(v) {}
+    LogField(const char *k, const char *v);
+    LogField(const char *k, const std::string &v) : LogField(k, v.c_str()) {}
+
+    // For HRESULTs and other codes that read better in hex
+    static LogField hex(const char *k, int64_t v);
+};
+
+// Per call site state; one static instance per LOG macro expansion
+class LogSite
+{
+public:
+    bool allow();
+    uint32_t takeSuppressed() { return suppressed_.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> window_start_ms_{0};
+    std::atomic<int> count_{0};
+    std::atomic<uint32_t> suppressed_{0};
+};
+
+// Borrows a clean per-thread stream for one LOG statement. Streams are stacked, so a LOG
+// argument that itself logs (e.g. a function that reports on first use) gets its own.
+class LogStreamLease
+{
+public:
+    LogStreamLease();
+    ~LogStreamLease();
+    LogStreamLease(const LogStreamLease &) = delete;
+    LogStreamLease &operator=(const LogStreamLease &) = delete;
+
+    std::ostringstream &stream;
+};
+
+void logText(LogLevel level, LogSite &site, std::ostringstream &text);
+void logEvent(LogLevel level, LogSite &site, const char *message, std::initializer_list<LogField> fields);
+// Blocks until everything logged so far is written. The sink also drains on static destruction.
+void flushLogs();
+// Writes text to stdout after everything this thread logged so far, as one block that log
+// output is never interleaved with
+void writeStdout(const std::string &text);
+void logReport(std::ostringstream &text);
+
+#define AGENT_LOG_TEXT(level, ...)                                      \
+    do                                                                  \
+    {                                                                   \
+        static LogSite log_site_;                                       \
+        if (log_site_.allow())                                          \
+        {                                                               \
+            LogStreamLease log_lease_;                                  \
+            log_lease_.stream << __VA_ARGS__;                           \
+            logText(level, log_site_, log_lease_.stream);               \
+        }                                                               \
+    } while (0);
+
+#define AGENT_LOG_EVENT(level, message, ...)                            \
+    do                                                                  \
+    {                                                                   \
+        static LogSite log_site_;                                       \
+        if (log_site_.allow())                                          \
+            logEvent(level, log_site_, message, {__VA_ARGS__});         \
+    } while (0);
+
+#define LOG_REPORT(...)                                                 \
+    do                                                                  \
+    {                                                                   \
+        LogStreamLease log_lease_;                                      \
+        log_lease_.stream << __VA_ARGS__;                               \
+        logReport(log_lease_.stream);                                   \
+    } while (0);
+
+#define AGENT_LOG_DISABLED \
+    do                     \
+    {                      \
+    } while (0);
+
+#if AGENT_LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(...) AGENT_LOG_TEXT(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) AGENT_LOG_DISABLED
+#endif
+
+#if AGENT_LOG_MIN_LEVEL <= 1
+#define LOG(...) AGENT_LOG_TEXT(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG(...) AGENT_LOG_DISABLED
+#endif
+
+#if AGENT_LOG_MIN_LEVEL <= 2
+#define LOG_WARN(...) AGENT_LOG_TEXT(LogLevel::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) AGENT_LOG_DISABLED
+#endif
+
+#define LOG_ERR(...) AGENT_LOG_TEXT(LogLevel::Error, __VA_ARGS__)
+
+// The level must be a LogLevel constant; levels below AGENT_LOG_MIN_LEVEL are dropped by the optimizer
+#define LOG_EVENT(level, message, ...)                                   \
+    do                                                                   \
+    {                                                                    \
+        if (static_cast<int>(level) >= AGENT_LOG_MIN_LEVEL)              \
+            AGENT_LOG_EVENT(level, message, __VA_ARGS__)                 \
+    } while (0);
@@ -0,0 +1,317 @@
+#include "ocr.hpp"
+#include <algorithm>
+#include <cctype>
+
+static bool loadVocabulary(const std::string &path, std::vector<std::string> &vocabulary_out)
+{
+    std::ifstream ifs(path.c_str());
+    if (!ifs.is_open())
+    {
+        LOG_ERR("Failed to open OCR vocabulary file: " << path);
+        return false;
+    }
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        vocabulary_out.push_back(line);
+    }
+    return !vocabulary_out.empty();
+}
+
+static void applyOcrBackend(cv::dnn::Model &model, const HARDWARE_INFO &hw_info)
+{
+    if (hw_info.has_cuda && hw_info.has_nvidia)
+    {
+        model.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
+        model.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
+    }
+    else if (hw_info.has_opencl && hw_info.has_amd)
+    {
+        model.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        model.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL);
+    }
+    else
+    {
+        model.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        model.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    }
+}
+
+static std::string toLower(std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+bool setupOcr(OcrContext &ctx, const std::string &detection_model_path, const std::string &recognition_model_path, const std::string &vocabulary_path, HARDWARE_INFO &hw_info)
+{
+    LOG("Loading OCR models from: " << detection_model_path << ", " << recognition_model_path);
+    try
+    {
+        std::vector<std::string> vocabulary;
+        if (!loadVocabulary(vocabulary_path, vocabulary))
+        {
+            LOG_ERR("OCR vocabulary is missing or empty.");
+            return false;
+        }
+
+        ctx.detector = std::make_unique<cv::dnn::TextDetectionModel_DB>(detection_model_path);
+        ctx.detector->setBinaryThreshold(OCR_BINARY_THRESHOLD)
+            .setPolygonThreshold(OCR_POLYGON_THRESHOLD)
+            .setUnclipRatio(2.0)
+            .setMaxCandidates(500);
+        ctx.detector->setInputParams(1.0 / 255.0, cv::Size(OCR_DETECTION_MAX_WIDTH, OCR_DETECTION_MAX_HEIGHT),
+                                     cv::Scalar(122.67891434, 116.66876762, 104.00698793));
+        applyOcrBackend(*ctx.detector, hw_info);
+
+        ctx.recognizer = std::make_unique<cv::dnn::TextRecognitionModel>(recognition_model_path);
+        ctx.recognizer->setDecodeType("CTC-greedy");
+        ctx.recognizer->setVocabulary(vocabulary);
+        ctx.recognizer->setInputParams(1.0 / 127.5, cv::Size(100, 32), cv::Scalar(127.5, 127.5, 127.5));
+        applyOcrBackend(*ctx.recognizer, hw_info);
+    }
+    catch (const cv::Exception &e)
+    {
+        LOG_ERR("OpenCV error during OCR model loading: " << e.what());
+        return false;
+    }
+
+    ctx.lru.clear();
+    ctx.cache.clear();
+    ctx.tile_hashes.clear();
+    ctx.regions.clear();
+    LOG("OCR setup complete.");
+    return true;
+}
+
+// Crops and converts only the requested area, so full-frame color conversion is never paid
+static cv::Mat cropBGR(const cv::Mat &frame, const cv::Rect &area)
+{
+    cv::Mat crop = frame(area);
+    cv::Mat crop_bgr;
+    if (crop.channels() == 4)
+        cv::cvtColor(crop, crop_bgr, cv::COLOR_BGRA2BGR);
+    else
+        crop_bgr = crop;
+    return crop_bgr;
+}
+
+static int roundUpTo32(int value)
+{
+    return std::max(32, (value + 31) / 32 * 32);
+}
+
+// Groups dirty tiles into 4-connected components and returns each component's padded pixel bounds
+static std::vector<cv::Rect> dirtyAreas(const std::vector<bool> &dirty, int tiles_x, int tiles_y, const cv::Size &frame_size)
+{
+    std::vector<cv::Rect> areas;
+    std::vector<bool> visited(dirty.size(), false);
+    std::vector<int> stack;
+
+    for (int start = 0; start < static_cast<int>(dirty.size()); ++start)
+    {
+        if (!dirty[start] || visited[start])
+            continue;
+
+        int min_x = tiles_x, min_y = tiles_y, max_x = 0, max_y = 0;
+        stack.push_back(start);
+        visited[start] = true;
+        while (!stack.empty())
+        {
+            int t = stack.back();
+            stack.pop_back();
+            int tx = t % tiles_x, ty = t / tiles_x;
+            min_x = std::min(min_x, tx);
+            min_y = std::min(min_y, ty);
+            max_x = std::max(max_x, tx);
+            max_y = std::max(max_y, ty);
+
+            const int neighbours[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+            for (const auto &n : neighbours)
+            {
+                int nx = tx + n[0], ny = ty + n[1];
+                if (nx < 0 || ny < 0 || nx >= tiles_x || ny >= tiles_y)
+                    continue;
+                int nt = ny * tiles_x + nx;
+                if (dirty[nt] && !visited[nt])
+                {
+                    visited[nt] = true;
+                    stack.push_back(nt);
+                }
+            }
+        }
+
+        // Pad by half a tile so text straddling a tile border is seen whole
+        cv::Rect area((min_x * OCR_TILE_SIZE) - OCR_TILE_SIZE / 2, (min_y * OCR_TILE_SIZE) - OCR_TILE_SIZE / 2,
+                      (max_x - min_x + 2) * OCR_TILE_SIZE, (max_y - min_y + 2) * OCR_TILE_SIZE);
+        areas.push_back(area & cv::Rect(0, 0, frame_size.width, frame_size.height));
+    }
+    return areas;
+}
+
+static void detectTextInArea(OcrContext &ctx, const cv::Mat &frame, const cv::Rect &area, std::vector<TextRegion> &out_regions)
+{
+    cv::Mat crop = cropBGR(frame, area);
+
+    // Run at the crop's own size when it fits, so small dirty areas are cheap
+    double scale = std::min({1.0, OCR_DETECTION_MAX_WIDTH / (double)crop.cols, OCR_DETECTION_MAX_HEIGHT / (double)crop.rows});
+    cv::Size input_size(roundUpTo32(static_cast<int>(crop.cols * scale)), roundUpTo32(static_cast<int>(crop.rows * scale)));
+    ctx.detector->setInputSize(input_size);
+
+    std::vector<cv::RotatedRect> boxes;
+    std::vector<float> confidences;
+    ctx.detector->detectTextRectangles(crop, boxes, confidences);
+
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        cv::Rect box = boxes[i].boundingRect() & cv::Rect(0, 0, crop.cols, crop.rows);
+        if (box.width < 4 || box.height < 4)
+            continue;
+        TextRegion region;
+        region.box = cv::Rect(box.x + area.x, box.y + area.y, box.width, box.height);
+        region.confidence = i < confidences.size() ? confidences[i] : 0.0f;
+        out_regions.push_back(region);
+    }
+}
+
+static const std::string &recognizeCached(OcrContext &ctx, const cv::Mat &frame, const cv::Rect &box)
+{
+    uint64_t key = hashMatRegion(frame, box);
+    auto it = ctx.cache.find(key);
+    if (it != ctx.cache.end())
+    {
+        ctx.cache_hits++;
+        ctx.lru.splice(ctx.lru.begin(), ctx.lru, it->second);
+        return it->second->second;
+    }
+
+    ctx.cache_misses++;
+    cv::Mat crop = frame(box);
+    cv::Mat input;
+    if (ctx.recognizer_grayscale)
+        cv::cvtColor(crop, input, crop.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    else
+        input = cropBGR(frame, box);
+
+    std::string text = ctx.recognizer->recognize(input);
+
+    ctx.lru.emplace_front(key, std::move(text));
+    ctx.cache[key] = ctx.lru.begin();
+    if (ctx.lru.size() > OCR_CACHE_CAPACITY)
+    {
+        ctx.cache.erase(ctx.lru.back().first);
+        ctx.lru.pop_back();
+    }
+    return ctx.lru.front().second;
+}
+
+bool readScreenText(OcrContext &ctx, const cv::Mat &frame, std::vector<TextRegion> &out_regions)
+{
+    out_regions.clear();
+    if (frame.empty() || !ctx.detector || !ctx.recognizer)
+    {
+        LOG_ERR("OCR: readScreenText called with empty frame or uninitialized models.");
+        return false;
+    }
+
+    const int tiles_x = (frame.cols + OCR_TILE_SIZE - 1) / OCR_TILE_SIZE;
+    const int tiles_y = (frame.rows + OCR_TILE_SIZE - 1) / OCR_TILE_SIZE;
+    const bool size_changed = frame.size() != ctx.frame_size;
+    if (size_changed)
+    {
+        ctx.frame_size = frame.size();
+        ctx.tile_hashes.assign(tiles_x * tiles_y, 0);
+        ctx.regions.clear();
+    }
+
+    std::vector<bool> dirty(tiles_x * tiles_y, false);
+    bool any_dirty = false;
+    for (int ty = 0; ty < tiles_y; ++ty)
+    {
+        for (int tx = 0; tx < tiles_x; ++tx)
+        {
+            int t = ty * tiles_x + tx;
+            uint64_t h = hashMatRegion(frame, cv::Rect(tx * OCR_TILE_SIZE, ty * OCR_TILE_SIZE, OCR_TILE_SIZE, OCR_TILE_SIZE));
+            if (size_changed || h != ctx.tile_hashes[t])
+            {
+                ctx.tile_hashes[t] = h;
+                dirty[t] = true;
+                any_dirty = true;
+            }
+        }
+    }
+
+    if (any_dirty)
+    {
+        try
+        {
+            std::vector<cv::Rect> areas = dirtyAreas(dirty, tiles_x, tiles_y, ctx.frame_size);
+
+            // Grow each area over the previous regions it touches so those lines are re-detected whole
+            for (cv::Rect &area : areas)
+            {
+                for (const TextRegion &region : ctx.regions)
+                {
+                    if ((area & region.box).area() > 0)
+                        area |= region.box;
+                }
+            }
+
+            std::vector<TextRegion> kept;
+            for (const TextRegion &region : ctx.regions)
+            {
+                bool touched = std::any_of(areas.begin(), areas.end(), [&](const cv::Rect &area)
+                                           { return (area & region.box).area() > 0; });
+                if (!touched)
+                    kept.push_back(region);
+            }
+
+            std::vector<TextRegion> detected;
+            for (const cv::Rect &area : areas)
+            {
+                detectTextInArea(ctx, frame, area, detected);
+            }
+            for (TextRegion &region : detected)
+            {
+                region.text = recognizeCached(ctx, frame, region.box);
+                if (!region.text.empty())
+                    kept.push_back(std::move(region));
+            }
+            ctx.regions = std::move(kept);
+        }
+        catch (const cv::Exception &e)
+        {
+            LOG_ERR("OCR: OpenCV Exception during text detection or recognition: " << e.what());
+            // Force a full re-detection on the next call rather than keeping partial state
+            ctx.frame_size = cv::Size();
+            return false;
+        }
+    }
+
+    out_regions = ctx.regions;
+    return true;
+}
+
+bool findTextOnScreen(OcrContext &ctx, const cv::Mat &frame, const std::string &query, TextRegion &out_match)
+{
+    std::vector<TextRegion> regions;
+    if (!readScreenText(ctx, frame, regions))
+        return false;
+
+    const std::string needle = toLower(query);
+    const TextRegion *best = nullptr;
+    for (const TextRegion &region : regions)
+    {
+        if (toLower(region.text).find(needle) == std::string::npos)
+            continue;
+        // Prefer the tightest match, e.g. a "Login" button over a "Login to continue" caption
+        if (!best || region.text.size() < best->text.size())
+            best = &region;
+    }
+
+    if (!best)
+        return false;
+    out_match = *best;
+    return true;
+}
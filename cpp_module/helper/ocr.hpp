@@ -0,0 +1,51 @@
+#pragma once
+
+#include "opencv2/opencv.hpp"
+#include "opencv2/dnn.hpp"
+#include <fstream>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "utils.hpp"
+
+// DB text detector input is capped at this size; smaller dirty areas run at their own size
+const int OCR_DETECTION_MAX_WIDTH = 1280;
+const int OCR_DETECTION_MAX_HEIGHT = 736;
+// Frames are compared tile by tile so that only changed areas are re-detected
+const int OCR_TILE_SIZE = 128;
+const size_t OCR_CACHE_CAPACITY = 4096;
+const float OCR_BINARY_THRESHOLD = 0.3f;
+const float OCR_POLYGON_THRESHOLD = 0.5f;
+
+struct TextRegion
+{
+    cv::Rect box;
+    std::string text;
+    float confidence = 0.0f;
+};
+
+struct OcrContext
+{
+    std::unique_ptr<cv::dnn::TextDetectionModel_DB> detector;
+    std::unique_ptr<cv::dnn::TextRecognitionModel> recognizer;
+    bool recognizer_grayscale = true; // CRNN English models take single-channel crops
+
+    // Recognized strings keyed by region content hash, least recently used at the back
+    std::list<std::pair<uint64_t, std::string>> lru;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, std::string>>::iterator> cache;
+
+    // Per-tile hashes and text regions of the previous frame
+    cv::Size frame_size;
+    std::vector<uint64_t> tile_hashes;
+    std::vector<TextRegion> regions;
+
+    size_t cache_hits = 0;
+    size_t cache_misses = 0;
+};
+
+bool setupOcr(OcrContext &ctx, const std::string &detection_model_path, const std::string &recognition_model_path, const std::string &vocabulary_path, HARDWARE_INFO &hw_info);
+// Accepts BGR or BGRA frames. Only tiles that changed since the previous call are re-detected,
+// and only regions whose pixels are not already in the cache are re-recognized.
+bool readScreenText(OcrContext &ctx, const cv::Mat &frame, std::vector<TextRegion> &out_regions);
+// Case-insensitive substring search over the text currently on screen.
+bool findTextOnScreen(OcrContext &ctx, const cv::Mat &frame, const std::string &query, TextRegion &out_match);
@@ -0,0 +1,139 @@
+#include "quality_controller.hpp"
+#include <algorithm>
+#include <fstream>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Reads cumulative idle and total CPU time for the whole system
+static bool readSystemCpuTimes(uint64_t &idle, uint64_t &total)
+{
+#ifdef _WIN32
+    FILETIME idle_time, kernel_time, user_time;
+    if (!GetSystemTimes(&idle_time, &kernel_time, &user_time))
+        return false;
+    auto toU64 = [](const FILETIME &ft)
+    { return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime; };
+    idle = toU64(idle_time);
+    total = toU64(kernel_time) + toU64(user_time); // Kernel time already includes idle time
+    return true;
+#else
+    std::ifstream stat("/proc/stat");
+    std::string cpu;
+    uint64_t user = 0, nice = 0, system = 0, idle_ticks = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+    if (!(stat >> cpu >> user >> nice >> system >> idle_ticks >> iowait >> irq >> softirq >> steal) || cpu != "cpu")
+        return false;
+    idle = idle_ticks + iowait;
+    total = user + nice + system + idle_ticks + iowait + irq + softirq + steal;
+    return true;
+#endif
+}
+
+std::vector<QualityLevel> filterQualityLadder(const std::vector<QualityLevel> &ladder, const std::vector<int> &supported_sizes)
+{
+    std::vector<QualityLevel> filtered;
+    for (const QualityLevel &level : ladder)
+    {
+        if (std::find(supported_sizes.begin(), supported_sizes.end(), level.input_size) != supported_sizes.end())
+            filtered.push_back(level);
+    }
+    return filtered;
+}
+
+QualityController::QualityController(const std::vector<QualityLevel> &ladder, const QualityControllerConfig &config, int full_quality_input_size)
+    : ladder_(ladder), config_(config)
+{
+    if (ladder_.empty())
+        ladder_.push_back(QualityLevel());
+
+    // Full quality is the first rung at or below the requested input size; larger rungs stay unused
+    while (full_quality_index_ + 1 < ladder_.size() && ladder_[full_quality_index_].input_size > full_quality_input_size)
+        full_quality_index_++;
+    current_ = full_quality_index_;
+
+    last_cpu_sample_ = std::chrono::steady_clock::now();
+    readSystemCpuTimes(prev_idle_, prev_total_);
+}
+
+bool QualityController::shouldDetect(uint64_t frame_index) const
+{
+    return frame_index % static_cast<uint64_t>(std::max(1, ladder_[current_].detect_interval)) == 0;
+}
+
+void QualityController::sampleCpu()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_cpu_sample_ < std::chrono::milliseconds(500))
+        return;
+    last_cpu_sample_ = now;
+
+    uint64_t idle = 0, total = 0;
+    if (!readSystemCpuTimes(idle, total) || total <= prev_total_)
+        return;
+    cpu_headroom_ = static_cast<double>(idle - prev_idle_) / static_cast<double>(total - prev_total_);
+    prev_idle_ = idle;
+    prev_total_ = total;
+}
+
+void QualityController::switchTo(size_t index)
+{
+    const QualityLevel &from = ladder_[current_];
+    const QualityLevel &to = ladder_[index];
+    LOG("Quality " << (index > current_ ? "lowered" : "raised") << ": input " << from.input_size << " -> " << to.input_size
+                   << ", detect every " << from.detect_interval << " -> " << to.detect_interval << " frames"
+                   << " (latency " << cv::format("%.1f", ema_ms_) << " ms, CPU idle " << cv::format("%.0f", cpu_headroom_ * 100.0) << "%)");
+    current_ = index;
+    over_streak_ = 0;
+    under_streak_ = 0;
+    settle_remaining_ = config_.degrade_after * 2;
+}
+
+void QualityController::recordLatency(double detection_ms)
+{
+    sampleCpu();
+    ema_ms_ = has_sample_ ? ema_ms_ + config_.ema_alpha * (detection_ms - ema_ms_) : detection_ms;
+    has_sample_ = true;
+
+    if (settle_remaining_ > 0)
+    {
+        settle_remaining_--;
+        return;
+    }
+
+    const bool over_budget = ema_ms_ > config_.latency_slo_ms * config_.degrade_ratio || cpu_headroom_ < config_.min_cpu_headroom;
+    const bool comfortable = ema_ms_ < config_.latency_slo_ms * config_.upgrade_ratio && cpu_headroom_ >= config_.min_cpu_headroom * 2.0;
+
+    over_streak_ = over_budget ? over_streak_ + 1 : 0;
+    under_streak_ = comfortable ? under_streak_ + 1 : 0;
+
+    if (over_streak_ >= config_.degrade_after && current_ + 1 < ladder_.size())
+        switchTo(current_ + 1);
+    else if (under_streak_ >= config_.upgrade_after && current_ > full_quality_index_)
+        switchTo(current_ - 1);
+}
+
+void QualityController::applyTo(YoloSettings &settings) const
+{
+    settings.input_width = ladder_[current_].input_size;
+    settings.input_height = ladder_[current_].input_size;
+}
+
+const QualityLevel &QualityController::level() const
+{
+    return ladder_[current_];
+}
+
+size_t QualityController::levelIndex() const
+{
+    return current_;
+}
+
+double QualityController::smoothedLatencyMs() const
+{
+    return ema_ms_;
+}
+
+double QualityController::cpuHeadroom() const
+{
+    return cpu_headroom_;
+}
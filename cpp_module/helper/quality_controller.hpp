@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include "yolo.hpp"
+
+// One rung of the quality ladder: the network input size and how often detection runs
+// (1 = every frame, 2 = every other frame reusing the previous detections, ...)
+struct QualityLevel
+{
+    int input_size = YOLO_INPUT_WIDTH;
+    int detect_interval = 1;
+};
+
+// Ordered from highest to lowest quality
+const std::vector<QualityLevel> DEFAULT_QUALITY_LADDER = {
+    {960, 1},
+    {640, 1},
+    {480, 1},
+    {480, 2},
+    {320, 2},
+    {320, 3},
+};
+
+struct QualityControllerConfig
+{
+    double latency_slo_ms = 100.0;
+    double degrade_ratio = 0.9;      // Step down when smoothed latency exceeds this share of the SLO
+    double upgrade_ratio = 0.5;      // Step up only when smoothed latency is below this share of the SLO
+    double min_cpu_headroom = 0.10;  // Step down when less than this share of system CPU is idle
+    int degrade_after = 3;           // Consecutive over-budget detections before stepping down
+    int upgrade_after = 30;          // Consecutive comfortable detections before stepping up
+    double ema_alpha = 0.2;
+};
+
+// Drops rungs whose input size the model could not be prepared for (see prepareYoloInputSizes)
+std::vector<QualityLevel> filterQualityLadder(const std::vector<QualityLevel> &ladder, const std::vector<int> &supported_sizes);
+
+// Picks a quality level from measured detection latency and system CPU headroom. Separate
+// thresholds and streak lengths for stepping down and up give hysteresis, so the level does
+// not oscillate around the SLO, and a settle period after each switch lets the new level's
+// latency replace the old one's in the average before the next decision.
+class QualityController
+{
+public:
+    QualityController(const std::vector<QualityLevel> &ladder, const QualityControllerConfig &config, int full_quality_input_size = YOLO_INPUT_WIDTH);
+
+    bool shouldDetect(uint64_t frame_index) const;
+    void recordLatency(double detection_ms);
+    void applyTo(YoloSettings &settings) const;
+
+    const QualityLevel &level() const;
+    size_t levelIndex() const;
+    double smoothedLatencyMs() const;
+    double cpuHeadroom() const;
+
+private:
+    void sampleCpu();
+    void switchTo(size_t index);
+
+    std::vector<QualityLevel> ladder_;
+    QualityControllerConfig config_;
+    size_t full_quality_index_ = 0;
+    size_t current_ = 0;
+    double ema_ms_ = 0.0;
+    bool has_sample_ = false;
+    int over_streak_ = 0;
+    int under_streak_ = 0;
+    int settle_remaining_ = 0;
+
+    double cpu_headroom_ = 1.0;
+    std::chrono::steady_clock::time_point last_cpu_sample_;
+    uint64_t prev_idle_ = 0;
+    uint64_t prev_total_ = 0;
+};
@@ -0,0 +1,1006 @@
+#include "remote_inference.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+const uint32_t REMOTE_MAGIC = 0x49524941; // "AIRI"
+const uint16_t REMOTE_VERSION = 1;
+const size_t REMOTE_HEADER_SIZE = 16;
+const uint32_t REMOTE_MAX_PAYLOAD = 64u << 20;
+const int WORKER_MAX_QUEUED_JOBS = 64;
+// Limits on what a request may ask the worker to allocate: an input at the cap is a 48 MB blob
+const int REMOTE_MAX_INPUT_SIDE = 2048;
+const int REMOTE_MAX_FRAME_SIDE = 16384;
+const uint32_t REMOTE_MAX_CLASS_FILTER = 1024;
+const int SOCKET_POLL_MS = 200;
+
+enum RemoteMessageType : uint16_t
+{
+    MSG_BLOB_REQUEST = 1,
+    MSG_IMAGE_REQUEST = 2,
+    MSG_RESULT = 3,
+    MSG_ERROR = 4
+};
+
+// ---- Sockets ----
+
+#ifdef _WIN32
+static bool initSockets()
+{
+    static const bool ok = []
+    {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return ok;
+}
+
+static void closeSocket(SocketHandle s)
+{
+    closesocket(static_cast<SOCKET>(s));
+}
+
+static void shutdownSocket(SocketHandle s)
+{
+    shutdown(static_cast<SOCKET>(s), SD_BOTH);
+}
+
+static void setBlocking(SocketHandle s, bool blocking)
+{
+    u_long mode = blocking ? 0 : 1;
+    ioctlsocket(static_cast<SOCKET>(s), FIONBIO, &mode);
+}
+#else
+static bool initSockets()
+{
+    return true;
+}
+
+static void closeSocket(SocketHandle s)
+{
+    close(static_cast<int>(s));
+}
+
+static void shutdownSocket(SocketHandle s)
+{
+    shutdown(static_cast<int>(s), SHUT_RDWR);
+}
+
+static void setBlocking(SocketHandle s, bool blocking)
+{
+    int flags = fcntl(static_cast<int>(s), F_GETFL, 0);
+    fcntl(static_cast<int>(s), F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+}
+#endif
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL; // A dropped peer must not kill the process with SIGPIPE
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+static void configureSocket(SocketHandle s)
+{
+    // Replies are small and latency bound
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+// Waits until s is readable (or writable); false on timeout
+static bool waitSocket(SocketHandle s, bool for_write, int timeout_ms)
+{
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(s, &set);
+    timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    return select(static_cast<int>(s) + 1, for_write ? nullptr : &set, for_write ? &set : nullptr, nullptr, &timeout) > 0;
+}
+
+static bool sendAll(SocketHandle s, const uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        const int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+        const int sent = send(s, reinterpret_cast<const char *>(data), chunk, SEND_FLAGS);
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+static bool recvAll(SocketHandle s, uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        const int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+        const int received = recv(s, reinterpret_cast<char *>(data), chunk, 0);
+        if (received <= 0)
+            return false;
+        data += received;
+        size -= received;
+    }
+    return true;
+}
+
+static SocketHandle connectTo(const std::string &host, uint16_t port, int timeout_ms)
+{
+    if (!initSockets())
+        return -1;
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        return -1;
+
+    SocketHandle result = -1;
+    for (addrinfo *a = addresses; a && result == -1; a = a->ai_next)
+    {
+        SocketHandle s = static_cast<SocketHandle>(socket(a->ai_family, a->ai_socktype, a->ai_protocol));
+        if (s == -1)
+            continue;
+        // Non-blocking connect so an unreachable host costs timeout_ms, not the OS default
+        setBlocking(s, false);
+        connect(s, a->ai_addr, static_cast<int>(a->ai_addrlen));
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (waitSocket(s, true, timeout_ms) && getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length) == 0 && error == 0)
+        {
+            setBlocking(s, true);
+            configureSocket(s);
+            result = s;
+        }
+        else
+        {
+            closeSocket(s);
+        }
+    }
+    freeaddrinfo(addresses);
+    return result;
+}
+
+static SocketHandle listenOn(uint16_t port)
+{
+    if (!initSockets())
+        return -1;
+    SocketHandle s = static_cast<SocketHandle>(socket(AF_INET, SOCK_STREAM, 0));
+    if (s == -1)
+        return -1;
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&one), sizeof(one));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(s, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(s, 16) != 0)
+    {
+        closeSocket(s);
+        return -1;
+    }
+    return s;
+}
+
+// ---- Messages ----
+
+template <typename T>
+static void appendPod(std::vector<uint8_t> &out, const T &value)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static bool readPod(const std::vector<uint8_t> &in, size_t &offset, T &value)
+{
+    if (offset + sizeof(T) > in.size())
+        return false;
+    std::memcpy(&value, in.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+static void beginMessage(std::vector<uint8_t> &out, uint16_t type, uint32_t request_id)
+{
+    out.clear();
+    appendPod(out, REMOTE_MAGIC);
+    appendPod(out, REMOTE_VERSION);
+    appendPod(out, type);
+    appendPod(out, request_id);
+    appendPod(out, uint32_t(0));
+}
+
+static void finishMessage(std::vector<uint8_t> &out)
+{
+    const uint32_t length = static_cast<uint32_t>(out.size() - REMOTE_HEADER_SIZE);
+    std::memcpy(out.data() + 12, &length, sizeof(length));
+}
+
+static bool readMessage(SocketHandle s, uint16_t &out_type, uint32_t &out_id, std::vector<uint8_t> &out_payload)
+{
+    std::vector<uint8_t> header(REMOTE_HEADER_SIZE);
+    if (!recvAll(s, header.data(), header.size()))
+        return false;
+    size_t offset = 0;
+    uint32_t magic = 0, length = 0;
+    uint16_t version = 0;
+    readPod(header, offset, magic);
+    readPod(header, offset, version);
+    readPod(header, offset, out_type);
+    readPod(header, offset, out_id);
+    readPod(header, offset, length);
+    if (magic != REMOTE_MAGIC || version != REMOTE_VERSION || length > REMOTE_MAX_PAYLOAD)
+    {
+        LOG_ERR("Invalid remote inference message header (magic " << magic << ", version " << version << ", length " << length << ")");
+        return false;
+    }
+    out_payload.resize(length);
+    return length == 0 || recvAll(s, out_payload.data(), length);
+}
+
+static void appendSettings(std::vector<uint8_t> &out, const YoloSettings &settings, cv::Size frame_size)
+{
+    appendPod(out, int32_t(frame_size.width));
+    appendPod(out, int32_t(frame_size.height));
+    appendPod(out, int32_t(settings.input_width));
+    appendPod(out, int32_t(settings.input_height));
+    appendPod(out, settings.confidence_threshold);
+    appendPod(out, settings.nms_threshold);
+    appendPod(out, uint32_t(settings.class_filter.size()));
+    for (int class_id : settings.class_filter)
+        appendPod(out, int32_t(class_id));
+}
+
+static bool readSettings(const std::vector<uint8_t> &in, size_t &offset, YoloSettings &settings, cv::Size &frame_size)
+{
+    int32_t values[4];
+    uint32_t filter_size = 0;
+    for (int32_t &v : values)
+    {
+        if (!readPod(in, offset, v))
+            return false;
+    }
+    if (!readPod(in, offset, settings.confidence_threshold) || !readPod(in, offset, settings.nms_threshold) || !readPod(in, offset, filter_size))
+        return false;
+    frame_size = cv::Size(values[0], values[1]);
+    settings.input_width = values[2];
+    settings.input_height = values[3];
+    if (frame_size.width < 0 || frame_size.height < 0 || frame_size.width > REMOTE_MAX_FRAME_SIDE || frame_size.height > REMOTE_MAX_FRAME_SIDE)
+        return false;
+    if (settings.input_width <= 0 || settings.input_height <= 0 || settings.input_width > REMOTE_MAX_INPUT_SIDE || settings.input_height > REMOTE_MAX_INPUT_SIDE)
+        return false;
+    // The filter must fit in what is left of the payload, so its size cannot make us allocate more
+    if (filter_size > REMOTE_MAX_CLASS_FILTER || filter_size > (in.size() - offset) / sizeof(int32_t))
+        return false;
+    settings.class_filter.resize(filter_size);
+    for (int &class_id : settings.class_filter)
+    {
+        int32_t v;
+        if (!readPod(in, offset, v))
+            return false;
+        class_id = v;
+    }
+    return true;
+}
+
+static void encodeResult(std::vector<uint8_t> &out, uint32_t request_id, cv::Size frame_size, const std::vector<Detection> &detections)
+{
+    beginMessage(out, MSG_RESULT, request_id);
+    appendPod(out, int32_t(frame_size.width));
+    appendPod(out, int32_t(frame_size.height));
+    appendPod(out, uint32_t(detections.size()));
+    for (const Detection &det : detections)
+    {
+        appendPod(out, int32_t(det.class_id));
+        appendPod(out, det.confidence);
+        appendPod(out, int32_t(det.box.x));
+        appendPod(out, int32_t(det.box.y));
+        appendPod(out, int32_t(det.box.width));
+        appendPod(out, int32_t(det.box.height));
+    }
+    finishMessage(out);
+}
+
+static bool decodeResult(const std::vector<uint8_t> &in, RemoteResult &result)
+{
+    size_t offset = 0;
+    int32_t width = 0, height = 0;
+    uint32_t count = 0;
+    if (!readPod(in, offset, width) || !readPod(in, offset, height) || !readPod(in, offset, count) || count > in.size())
+        return false;
+    result.frame_size = cv::Size(width, height);
+    result.detections.resize(count);
+    for (Detection &det : result.detections)
+    {
+        int32_t v[5];
+        if (!readPod(in, offset, v[0]) || !readPod(in, offset, det.confidence) || !readPod(in, offset, v[1]) ||
+            !readPod(in, offset, v[2]) || !readPod(in, offset, v[3]) || !readPod(in, offset, v[4]))
+            return false;
+        det.class_id = v[0];
+        det.box = cv::Rect(v[1], v[2], v[3], v[4]);
+    }
+    return true;
+}
+
+static void encodeError(std::vector<uint8_t> &out, uint32_t request_id, const std::string &message)
+{
+    beginMessage(out, MSG_ERROR, request_id);
+    out.insert(out.end(), message.begin(), message.end());
+    finishMessage(out);
+}
+
+static bool sameDecodeSettings(const YoloSettings &a, const YoloSettings &b)
+{
+    return a.input_width == b.input_width && a.input_height == b.input_height && a.confidence_threshold == b.confidence_threshold &&
+           a.nms_threshold == b.nms_threshold && a.class_filter == b.class_filter;
+}
+
+bool parseEndpoint(const std::string &text, std::string &out_host, uint16_t &out_port)
+{
+    const size_t colon = text.rfind(':');
+    out_host = text.substr(0, colon);
+    out_port = REMOTE_DEFAULT_PORT;
+    if (colon != std::string::npos)
+    {
+        const int port = std::atoi(text.c_str() + colon + 1);
+        if (port <= 0 || port > 65535)
+            return false;
+        out_port = static_cast<uint16_t>(port);
+    }
+    return !out_host.empty();
+}
+
+// ---- Client ----
+
+RemoteDetector::RemoteDetector(const std::vector<std::string> &endpoints, const RemoteOptions &options, cv::dnn::Net *local_net)
+    : options_(options), local_net_(local_net)
+{
+    options_.max_in_flight = std::max(1, options_.max_in_flight);
+    for (const std::string &endpoint : endpoints)
+    {
+        auto worker = std::make_unique<Worker>();
+        if (!parseEndpoint(endpoint, worker->host, worker->port))
+        {
+            LOG_ERR("Invalid inference worker address " << endpoint << ", expected host:port");
+            continue;
+        }
+        worker->stats.endpoint = worker->host + ":" + std::to_string(worker->port);
+        workers_.push_back(std::move(worker));
+    }
+}
+
+RemoteDetector::~RemoteDetector()
+{
+    stop();
+}
+
+bool RemoteDetector::start()
+{
+    if (running_ || workers_.empty())
+        return false;
+    stop_ = false;
+    running_ = true;
+    dispatch_thread_ = std::thread(&RemoteDetector::dispatchLoop, this);
+    return true;
+}
+
+void RemoteDetector::stop()
+{
+    if (!running_)
+        return;
+    stop_ = true;
+    work_ready_.notify_all();
+    if (dispatch_thread_.joinable())
+        dispatch_thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &worker : workers_)
+        {
+            if (worker->connected)
+                shutdownSocket(worker->socket);
+        }
+    }
+    // The readers hand their outstanding requests back to the queue as they exit
+    for (auto &worker : workers_)
+    {
+        if (worker->reader.joinable())
+            worker->reader.join();
+        if (worker->socket != -1)
+            closeSocket(worker->socket);
+        worker->socket = -1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &request : queue_)
+        request->promise.set_exception(std::make_exception_ptr(std::runtime_error("remote detector stopped")));
+    queue_.clear();
+    running_ = false;
+}
+
+std::future<RemoteResult> RemoteDetector::enqueue(std::shared_ptr<Request> request)
+{
+    std::future<RemoteResult> future = request->promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(request));
+    }
+    work_ready_.notify_all();
+    return future;
+}
+
+std::future<RemoteResult> RemoteDetector::submit(const cv::Mat &frame, const YoloSettings &settings)
+{
+    if (options_.payload == REMOTE_PAYLOAD_BLOB)
+    {
+        cv::Mat blob;
+        prepareYoloBlob(frame, blob, settings);
+        return submitBlob(blob, frame.size(), settings);
+    }
+    std::vector<uchar> bytes;
+    cv::imencode(".jpg", frame, bytes, {cv::IMWRITE_JPEG_QUALITY, options_.jpeg_quality});
+    return submitEncoded(std::move(bytes), settings);
+}
+
+std::future<RemoteResult> RemoteDetector::submitBlob(const cv::Mat &blob, cv::Size frame_size, const YoloSettings &settings)
+{
+    CV_Assert(blob.dims == 4 && blob.size[0] == 1 && blob.size[1] == 3 && blob.type() == CV_32F && blob.isContinuous());
+    auto request = std::make_shared<Request>();
+    request->id = next_id_++;
+    request->blob = blob;
+    request->frame_size = frame_size;
+    request->settings = settings;
+
+    std::vector<uint8_t> &message = request->message;
+    beginMessage(message, MSG_BLOB_REQUEST, request->id);
+    appendSettings(message, settings, frame_size);
+    appendPod(message, int32_t(blob.size[2]));
+    appendPod(message, int32_t(blob.size[3]));
+    const uint8_t *data = blob.ptr<uint8_t>();
+    message.insert(message.end(), data, data + blob.total() * blob.elemSize());
+    finishMessage(message);
+    return enqueue(std::move(request));
+}
+
+std::future<RemoteResult> RemoteDetector::submitEncoded(std::vector<uchar> image_bytes, const YoloSettings &settings)
+{
+    auto request = std::make_shared<Request>();
+    request->id = next_id_++;
+    request->settings = settings;
+
+    std::vector<uint8_t> &message = request->message;
+    beginMessage(message, MSG_IMAGE_REQUEST, request->id);
+    appendSettings(message, settings, cv::Size());
+    message.insert(message.end(), image_bytes.begin(), image_bytes.end());
+    finishMessage(message);
+    request->image_bytes = std::move(image_bytes);
+    return enqueue(std::move(request));
+}
+
+void RemoteDetector::runLocally(Request &request)
+{
+    try
+    {
+        RemoteResult result;
+        result.local = true;
+        result.frame_size = request.frame_size;
+        cv::Mat blob = request.blob;
+        if (blob.empty())
+        {
+            cv::Mat image = cv::imdecode(request.image_bytes, cv::IMREAD_COLOR);
+            if (image.empty())
+                throw std::runtime_error("could not decode image");
+            result.frame_size = image.size();
+            prepareYoloBlob(image, blob, request.settings);
+        }
+        std::vector<std::vector<Detection>> detections;
+        detectObjectsWithYOLOBlobs({blob}, {result.frame_size}, *local_net_, detections, request.settings);
+        result.detections = std::move(detections[0]);
+        request.promise.set_value(std::move(result));
+    }
+    catch (...)
+    {
+        request.promise.set_exception(std::current_exception());
+    }
+}
+
+void RemoteDetector::dispatchLoop()
+{
+    using clock = std::chrono::steady_clock;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_)
+    {
+        bool progressed = false;
+        auto now = clock::now();
+
+        // Reconnect dropped workers whose backoff has passed. The reader of a dropped worker
+        // has already exited, and only this thread closes sockets, so nothing else uses it.
+        for (auto &worker_ptr : workers_)
+        {
+            Worker &worker = *worker_ptr;
+            if (worker.connected || worker.connecting || now < worker.retry_at)
+                continue;
+            lock.unlock();
+            if (worker.reader.joinable())
+                worker.reader.join();
+            if (worker.socket != -1)
+                closeSocket(worker.socket);
+            lock.lock();
+            worker.socket = -1;
+            worker.connecting = true;
+            worker.reader = std::thread(&RemoteDetector::connectAndRead, this, std::ref(worker));
+        }
+
+        // A worker that accepts but stops answering is treated like a dropped one
+        now = clock::now();
+        const auto timeout = std::chrono::milliseconds(options_.request_timeout_ms);
+        for (auto &worker : workers_)
+        {
+            if (!worker->connected)
+                continue;
+            for (const auto &entry : worker->in_flight)
+            {
+                if (now - entry.second->sent_at > timeout)
+                {
+                    LOG_WARN("Inference worker " << worker->stats.endpoint << " did not answer request " << entry.first << " in time, dropping it.");
+                    shutdownSocket(worker->socket);
+                    break;
+                }
+            }
+        }
+
+        while (!queue_.empty() && !stop_)
+        {
+            std::shared_ptr<Request> request = queue_.front();
+            Worker *best = nullptr;
+            bool any_connected = false;
+            bool any_starting = false;
+            for (auto &worker : workers_)
+            {
+                any_starting = any_starting || !worker->attempted;
+                if (!worker->connected)
+                    continue;
+                any_connected = true;
+                if (static_cast<int>(worker->in_flight.size()) < options_.max_in_flight && (!best || worker->in_flight.size() < best->in_flight.size()))
+                    best = worker.get();
+            }
+
+            if (!any_connected && any_starting && request->attempts < REMOTE_MAX_ATTEMPTS)
+                break; // A worker may still come up; its connect wakes us
+            if (!any_connected || request->attempts >= REMOTE_MAX_ATTEMPTS)
+            {
+                queue_.pop_front();
+                progressed = true;
+                if (!local_net_)
+                {
+                    request->promise.set_exception(std::make_exception_ptr(std::runtime_error(
+                        any_connected ? "inference workers failed the request" : "no inference worker reachable")));
+                    continue;
+                }
+                local_fallbacks_++;
+                lock.unlock();
+                runLocally(*request);
+                lock.lock();
+                break; // Give reconnects a chance between local requests
+            }
+            if (!best)
+                break; // Every window is full; a reply will wake us
+
+            queue_.pop_front();
+            request->attempts++;
+            request->sent_at = clock::now();
+            best->in_flight[request->id] = request;
+            SocketHandle s = best->socket;
+            lock.unlock();
+            // Only this thread sends, so the write needs no lock; the reader handles a failure
+            if (!sendAll(s, request->message.data(), request->message.size()))
+                shutdownSocket(s);
+            lock.lock();
+            progressed = true;
+        }
+
+        if (!progressed)
+            work_ready_.wait_for(lock, std::chrono::milliseconds(50));
+    }
+}
+
+void RemoteDetector::connectAndRead(Worker &worker)
+{
+    SocketHandle s = connectTo(worker.host, worker.port, REMOTE_CONNECT_TIMEOUT_MS);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        worker.connecting = false;
+        worker.attempted = true;
+        if (s != -1 && stop_)
+        {
+            closeSocket(s);
+            s = -1;
+        }
+        worker.socket = s;
+        if (s == -1)
+        {
+            worker.retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(worker.backoff_ms);
+            worker.backoff_ms = std::min(worker.backoff_ms * 2, REMOTE_RECONNECT_MAX_MS);
+        }
+        else
+        {
+            LOG((worker.ever_connected ? "Reconnected to inference worker " : "Connected to inference worker ") << worker.stats.endpoint);
+            if (worker.ever_connected)
+                worker.stats.reconnects++;
+            worker.ever_connected = true;
+            worker.connected = true;
+            worker.backoff_ms = REMOTE_RECONNECT_MIN_MS;
+        }
+    }
+    work_ready_.notify_all();
+    if (s != -1)
+        readLoop(worker);
+}
+
+void RemoteDetector::readLoop(Worker &worker)
+{
+    const SocketHandle s = worker.socket;
+    uint16_t type;
+    uint32_t id;
+    std::vector<uint8_t> payload;
+    while (readMessage(s, type, id, payload))
+    {
+        std::shared_ptr<Request> request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = worker.in_flight.find(id);
+            if (it == worker.in_flight.end())
+                continue;
+            request = it->second;
+            worker.in_flight.erase(it);
+            worker.stats.completed++;
+            worker.round_trip_sum_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request->sent_at).count();
+        }
+        work_ready_.notify_all();
+
+        RemoteResult result;
+        if (type == MSG_RESULT && decodeResult(payload, result))
+        {
+            if (!request->blob.empty())
+                result.frame_size = request->frame_size;
+            request->promise.set_value(std::move(result));
+        }
+        else if (type == MSG_ERROR)
+        {
+            request->promise.set_exception(std::make_exception_ptr(std::runtime_error(
+                "inference worker " + worker.stats.endpoint + ": " + std::string(payload.begin(), payload.end()))));
+        }
+        else
+        {
+            LOG_ERR("Malformed reply from inference worker " << worker.stats.endpoint);
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_front(request);
+            break;
+        }
+    }
+
+    // Outstanding requests go back to the front of the queue, oldest first
+    std::unique_lock<std::mutex> lock(mutex_);
+    worker.connected = false;
+    worker.retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(worker.backoff_ms);
+    if (!stop_)
+        LOG_WARN("Lost inference worker " << worker.stats.endpoint << ", moving " << worker.in_flight.size() << " requests to other workers.");
+    worker.stats.failovers += worker.in_flight.size();
+    for (auto it = worker.in_flight.rbegin(); it != worker.in_flight.rend(); ++it)
+        queue_.push_front(it->second);
+    worker.in_flight.clear();
+    lock.unlock();
+    work_ready_.notify_all();
+}
+
+std::vector<RemoteWorkerStats> RemoteDetector::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<RemoteWorkerStats> out;
+    for (const auto &worker : workers_)
+    {
+        RemoteWorkerStats s = worker->stats;
+        s.connected = worker->connected;
+        s.in_flight = static_cast<int>(worker->in_flight.size());
+        s.avg_round_trip_ms = s.completed ? worker->round_trip_sum_ms / s.completed : 0.0;
+        out.push_back(s);
+    }
+    return out;
+}
+
+uint64_t RemoteDetector::localFallbacks() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return local_fallbacks_;
+}
+
+// ---- Server ----
+
+InferenceWorker::Connection::~Connection()
+{
+    if (socket != -1)
+        closeSocket(socket);
+}
+
+InferenceWorker::InferenceWorker(cv::dnn::Net &net, int max_batch)
+    : net_(net), max_batch_(std::max(1, max_batch))
+{
+}
+
+InferenceWorker::~InferenceWorker()
+{
+    stop();
+}
+
+bool InferenceWorker::start(uint16_t port)
+{
+    if (listen_socket_ != -1)
+        return false;
+    listen_socket_ = listenOn(port);
+    if (listen_socket_ == -1)
+    {
+        LOG_ERR("Failed to listen on port " << port);
+        return false;
+    }
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    port_ = getsockname(listen_socket_, reinterpret_cast<sockaddr *>(&address), &length) == 0 ? ntohs(address.sin_port) : port;
+    stop_ = false;
+    accept_thread_ = std::thread(&InferenceWorker::acceptLoop, this);
+    inference_thread_ = std::thread(&InferenceWorker::inferenceLoop, this);
+    return true;
+}
+
+void InferenceWorker::stop()
+{
+    if (listen_socket_ == -1)
+        return;
+    stop_ = true;
+    jobs_ready_.notify_all();
+    jobs_taken_.notify_all();
+    if (accept_thread_.joinable())
+        accept_thread_.join();
+    if (inference_thread_.joinable())
+        inference_thread_.join();
+
+    std::vector<std::shared_ptr<Connection>> connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections.swap(connections_);
+        jobs_.clear();
+    }
+    for (auto &connection : connections)
+    {
+        shutdownSocket(connection->socket);
+        if (connection->reader.joinable())
+            connection->reader.join();
+    }
+    closeSocket(listen_socket_);
+    listen_socket_ = -1;
+}
+
+int InferenceWorker::connections() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(std::count_if(connections_.begin(), connections_.end(), [](const std::shared_ptr<Connection> &c)
+                                          { return !c->done; }));
+}
+
+void InferenceWorker::acceptLoop()
+{
+    while (!stop_)
+    {
+        // Finished connections are joined here; their socket closes with the last job holding it
+        std::vector<std::shared_ptr<Connection>> finished;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto split = std::partition(connections_.begin(), connections_.end(), [](const std::shared_ptr<Connection> &c)
+                                        { return !c->done; });
+            finished.assign(split, connections_.end());
+            connections_.erase(split, connections_.end());
+        }
+        for (auto &connection : finished)
+            connection->reader.join();
+
+        if (!waitSocket(listen_socket_, false, SOCKET_POLL_MS))
+            continue;
+        sockaddr_storage address;
+        socklen_t length = sizeof(address);
+        SocketHandle s = static_cast<SocketHandle>(accept(listen_socket_, reinterpret_cast<sockaddr *>(&address), &length));
+        if (s == -1)
+            continue;
+        configureSocket(s);
+
+        auto connection = std::make_shared<Connection>();
+        connection->socket = s;
+        char host[NI_MAXHOST] = "?";
+        char port[NI_MAXSERV] = "?";
+        getnameinfo(reinterpret_cast<sockaddr *>(&address), length, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV);
+        connection->peer = std::string(host) + ":" + port;
+        LOG("Client connected from " << connection->peer);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection->reader = std::thread(&InferenceWorker::readLoop, this, connection);
+        connections_.push_back(connection);
+    }
+}
+
+void InferenceWorker::readLoop(std::shared_ptr<Connection> connection)
+{
+    uint16_t type;
+    uint32_t id;
+    std::vector<uint8_t> payload, reply;
+    while (!stop_ && readMessage(connection->socket, type, id, payload))
+    {
+        Job job;
+        job.connection = connection;
+        job.request_id = id;
+        size_t offset = 0;
+        std::string error;
+        if ((type != MSG_BLOB_REQUEST && type != MSG_IMAGE_REQUEST) || !readSettings(payload, offset, job.settings, job.frame_size))
+        {
+            error = "malformed request";
+        }
+        else if (type == MSG_BLOB_REQUEST)
+        {
+            int32_t rows = 0, cols = 0;
+            readPod(payload, offset, rows);
+            readPod(payload, offset, cols);
+            const int sizes[] = {1, 3, rows, cols};
+            const size_t bytes = static_cast<size_t>(3) * std::max(0, rows) * std::max(0, cols) * sizeof(float);
+            if (rows != job.settings.input_height || cols != job.settings.input_width)
+                error = "blob dimensions do not match the input size";
+            else if (payload.size() - offset != bytes)
+                error = "blob size does not match its dimensions";
+            else
+                job.blob = cv::Mat(4, sizes, CV_32F, payload.data() + offset).clone();
+        }
+        else
+        {
+            // Decoding and preprocessing here keeps them off the inference thread. The bytes come
+            // from the network, so a decoder failure is answered like any other bad request.
+            try
+            {
+                cv::Mat image;
+                if (payload.size() > offset)
+                    image = cv::imdecode(cv::Mat(1, static_cast<int>(payload.size() - offset), CV_8U, payload.data() + offset), cv::IMREAD_COLOR);
+                if (image.empty())
+                {
+                    error = "could not decode image";
+                }
+                else
+                {
+                    job.frame_size = image.size();
+                    prepareYoloBlob(image, job.blob, job.settings);
+                }
+            }
+            catch (const std::exception &e)
+            {
+                error = std::string("could not decode image: ") + e.what();
+            }
+        }
+
+        if (!error.empty())
+        {
+            encodeError(reply, id, error);
+            std::lock_guard<std::mutex> write_lock(connection->write_mutex);
+            if (!sendAll(connection->socket, reply.data(), reply.size()))
+                break;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobs_taken_.wait(lock, [&]
+                         { return stop_ || jobs_.size() < static_cast<size_t>(WORKER_MAX_QUEUED_JOBS); });
+        jobs_.push_back(std::move(job));
+        lock.unlock();
+        jobs_ready_.notify_one();
+    }
+    shutdownSocket(connection->socket);
+    LOG("Client " << connection->peer << " disconnected");
+    connection->done = true;
+}
+
+void InferenceWorker::inferenceLoop()
+{
+    bool batch_supported = true;
+    std::vector<Job> batch;
+    std::vector<uint8_t> reply;
+    while (!stop_)
+    {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobs_ready_.wait(lock, [&]
+                             { return stop_ || !jobs_.empty(); });
+            if (stop_)
+                break;
+            // The oldest job plus queued ones that can share its forward pass
+            batch.push_back(std::move(jobs_.front()));
+            jobs_.pop_front();
+            for (auto it = jobs_.begin(); it != jobs_.end() && batch_supported && static_cast<int>(batch.size()) < max_batch_;)
+            {
+                if (sameDecodeSettings(it->settings, batch[0].settings))
+                {
+                    batch.push_back(std::move(*it));
+                    it = jobs_.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+        jobs_taken_.notify_all();
+
+        std::vector<cv::Mat> blobs;
+        std::vector<cv::Size> sizes;
+        for (const Job &job : batch)
+        {
+            blobs.push_back(job.blob);
+            sizes.push_back(job.frame_size);
+        }
+        std::vector<std::vector<Detection>> detections;
+        std::vector<std::string> errors(batch.size());
+        bool done = false;
+        if (batch.size() > 1)
+        {
+            try
+            {
+                detectObjectsWithYOLOBlobs(blobs, sizes, net_, detections, batch[0].settings);
+                done = true;
+            }
+            catch (const std::exception &e)
+            {
+                LOG_WARN("Batched inference failed, serving one request per forward pass: " << e.what());
+                batch_supported = false;
+            }
+        }
+        if (!done)
+        {
+            detections.assign(batch.size(), std::vector<Detection>());
+            for (size_t k = 0; k < batch.size(); ++k)
+            {
+                std::vector<std::vector<Detection>> single;
+                try
+                {
+                    detectObjectsWithYOLOBlobs({blobs[k]}, {sizes[k]}, net_, single, batch[k].settings);
+                    detections[k] = std::move(single[0]);
+                }
+                catch (const std::exception &e)
+                {
+                    errors[k] = e.what();
+                }
+            }
+        }
+
+        for (size_t k = 0; k < batch.size(); ++k)
+        {
+            if (errors[k].empty())
+                encodeResult(reply, batch[k].request_id, batch[k].frame_size, detections[k]);
+            else
+                encodeError(reply, batch[k].request_id, errors[k]);
+            std::lock_guard<std::mutex> write_lock(batch[k].connection->write_mutex);
+            // A failed write means the client left; its reader thread cleans up
+            sendAll(batch[k].connection->socket, reply.data(), reply.size());
+            served_++;
+        }
+    }
+}
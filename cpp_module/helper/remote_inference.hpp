@@ -0,0 +1,197 @@
+#pragma once
+
+#include "yolo.hpp"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <thread>
+
+// Offloads detection to agent_worker processes over TCP, so thin clients can use the GPUs of
+// other machines. Each message is a 16 byte header (magic, version, type, request id, payload
+// length) followed by the payload; both ends are assumed little-endian (x86, ARM). A request
+// carries the decode settings and either a preprocessed blob or a compressed image. Blobs cost
+// the client the preprocessing and are large (4.9 MB at 640); compressed images are a few
+// hundred KB and leave decoding and preprocessing to the worker, which is usually the better
+// trade on anything slower than a LAN.
+
+const int REMOTE_DEFAULT_PORT = 5555;
+const int REMOTE_MAX_IN_FLIGHT = 4; // Requests pipelined on one connection
+const int REMOTE_REQUEST_TIMEOUT_MS = 10000;
+const int REMOTE_CONNECT_TIMEOUT_MS = 1000;
+const int REMOTE_RECONNECT_MIN_MS = 250;
+const int REMOTE_RECONNECT_MAX_MS = 8000;
+const int REMOTE_MAX_ATTEMPTS = 3; // Workers tried for one request before it runs locally
+
+typedef intptr_t SocketHandle; // SOCKET on Windows, a file descriptor elsewhere
+
+enum RemotePayload
+{
+    REMOTE_PAYLOAD_BLOB,
+    REMOTE_PAYLOAD_IMAGE
+};
+
+struct RemoteOptions
+{
+    RemotePayload payload = REMOTE_PAYLOAD_IMAGE; // Used by submit(); the other calls choose themselves
+    int jpeg_quality = 90;
+    int max_in_flight = REMOTE_MAX_IN_FLIGHT;
+    int request_timeout_ms = REMOTE_REQUEST_TIMEOUT_MS;
+};
+
+struct RemoteResult
+{
+    cv::Size frame_size;
+    std::vector<Detection> detections;
+    bool local = false; // Answered by the local fallback network
+};
+
+struct RemoteWorkerStats
+{
+    std::string endpoint;
+    bool connected = false;
+    int in_flight = 0;
+    uint64_t completed = 0;
+    uint64_t failovers = 0; // Requests moved elsewhere because this worker dropped or stalled
+    uint64_t reconnects = 0;
+    double avg_round_trip_ms = 0.0;
+};
+
+// Accepts "host:port" or "host" (default port)
+bool parseEndpoint(const std::string &text, std::string &out_host, uint16_t &out_port);
+
+// Client side. Requests are queued and handed to the connected worker with the fewest
+// outstanding requests, up to max_in_flight each, so the network transfer of one request
+// overlaps the inference of the previous ones. When a worker drops or stops answering, its
+// outstanding requests go back to the front of the queue for the other workers and it is
+// reconnected with exponential backoff. Connecting happens on the worker's own thread, so an
+// unreachable endpoint never holds up dispatch to the others. Requests run on local_net when no
+// worker is connected (after every worker's first attempt) or after REMOTE_MAX_ATTEMPTS workers
+// failed them; without a local network they fail instead.
+// The futures throw if inference fails, including a worker's error reply.
+class RemoteDetector
+{
+public:
+    // local_net is only run from the dispatch thread; do not use it elsewhere while started
+    RemoteDetector(const std::vector<std::string> &endpoints, const RemoteOptions &options = RemoteOptions(), cv::dnn::Net *local_net = nullptr);
+    ~RemoteDetector();
+
+    bool start(); // False if no endpoint could be parsed
+    void stop();  // Fails the requests that are still pending
+
+    // frame is BGR; it is encoded or preprocessed before this returns
+    std::future<RemoteResult> submit(const cv::Mat &frame, const YoloSettings &settings = YoloSettings());
+    // blob comes from prepareYoloBlob() with the same settings
+    std::future<RemoteResult> submitBlob(const cv::Mat &blob, cv::Size frame_size, const YoloSettings &settings = YoloSettings());
+    // image_bytes is a compressed image file as stored (JPEG, PNG, ...); the result has its size
+    std::future<RemoteResult> submitEncoded(std::vector<uchar> image_bytes, const YoloSettings &settings = YoloSettings());
+
+    std::vector<RemoteWorkerStats> stats() const;
+    uint64_t localFallbacks() const;
+
+private:
+    struct Request
+    {
+        uint32_t id = 0;
+        std::vector<uint8_t> message; // Encoded once, resent as is on failover
+        // Kept for the local fallback
+        cv::Mat blob;
+        cv::Size frame_size;
+        std::vector<uchar> image_bytes;
+        YoloSettings settings;
+        int attempts = 0;
+        std::chrono::steady_clock::time_point sent_at;
+        std::promise<RemoteResult> promise;
+    };
+
+    struct Worker
+    {
+        std::string host;
+        uint16_t port = 0;
+        SocketHandle socket = -1;
+        bool connected = false;
+        bool connecting = false; // reader is running connectTo
+        bool attempted = false;  // The first connection attempt has finished
+        bool ever_connected = false;
+        std::thread reader; // Connects, then reads replies until the connection drops
+        std::map<uint32_t, std::shared_ptr<Request>> in_flight;
+        std::chrono::steady_clock::time_point retry_at;
+        int backoff_ms = REMOTE_RECONNECT_MIN_MS;
+        double round_trip_sum_ms = 0.0;
+        RemoteWorkerStats stats;
+    };
+
+    std::future<RemoteResult> enqueue(std::shared_ptr<Request> request);
+    void dispatchLoop();
+    void connectAndRead(Worker &worker);
+    void readLoop(Worker &worker);
+    void runLocally(Request &request);
+
+    RemoteOptions options_;
+    cv::dnn::Net *local_net_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::deque<std::shared_ptr<Request>> queue_;
+    std::atomic<uint32_t> next_id_{1};
+    uint64_t local_fallbacks_ = 0;
+    std::atomic<bool> stop_{false};
+    bool running_ = false;
+    std::thread dispatch_thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_ready_;
+};
+
+// Server side: listens on a port and answers RemoteDetector requests with a local network.
+// Every connection has a reader thread that decodes and preprocesses its requests, so a
+// pipelining client keeps the network busy; one inference thread batches queued requests that
+// share an input size and settings, across connections.
+class InferenceWorker
+{
+public:
+    InferenceWorker(cv::dnn::Net &net, int max_batch = 8);
+    ~InferenceWorker();
+
+    bool start(uint16_t port); // Port 0 listens on a free port; port() tells which
+    void stop();
+    uint16_t port() const { return port_; }
+    uint64_t requestsServed() const { return served_; }
+    int connections() const;
+
+private:
+    struct Connection
+    {
+        SocketHandle socket = -1;
+        std::string peer;
+        std::thread reader;
+        std::mutex write_mutex;
+        std::atomic<bool> done{false};
+        ~Connection();
+    };
+
+    struct Job
+    {
+        std::shared_ptr<Connection> connection;
+        uint32_t request_id = 0;
+        cv::Mat blob;
+        cv::Size frame_size;
+        YoloSettings settings;
+    };
+
+    void acceptLoop();
+    void readLoop(std::shared_ptr<Connection> connection);
+    void inferenceLoop();
+
+    cv::dnn::Net &net_;
+    int max_batch_;
+    SocketHandle listen_socket_ = -1;
+    uint16_t port_ = 0;
+    std::vector<std::shared_ptr<Connection>> connections_;
+    std::deque<Job> jobs_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> served_{0};
+    std::thread accept_thread_;
+    std::thread inference_thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable jobs_ready_;
+    std::condition_variable jobs_taken_;
+};
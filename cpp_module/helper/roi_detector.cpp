@@ -0,0 +1,213 @@
+#include "roi_detector.hpp"
+#include "detection_eval.hpp"
+#include <algorithm>
+#include <map>
+
+static bool sameDecodeSettings(const YoloSettings &a, const YoloSettings &b)
+{
+    return a.confidence_threshold == b.confidence_threshold && a.nms_threshold == b.nms_threshold && a.class_filter == b.class_filter;
+}
+
+RoiDetector::RoiDetector(cv::dnn::Net &net, const std::vector<int> &input_sizes)
+    : net_(net)
+{
+    for (int size : input_sizes)
+    {
+        if (size > 0)
+            input_sizes_.push_back(size);
+    }
+    if (input_sizes_.empty())
+        input_sizes_.push_back(YOLO_INPUT_WIDTH);
+    std::sort(input_sizes_.begin(), input_sizes_.end());
+    input_sizes_.erase(std::unique(input_sizes_.begin(), input_sizes_.end()), input_sizes_.end());
+}
+
+void RoiDetector::clearCache()
+{
+    cache_.clear();
+}
+
+void RoiDetector::planTiles(const cv::Rect &region, std::vector<Tile> &out_tiles) const
+{
+    if (region.empty())
+        return;
+    auto fit = std::lower_bound(input_sizes_.begin(), input_sizes_.end(), std::max(region.width, region.height));
+    if (fit != input_sizes_.end())
+    {
+        out_tiles.push_back({region, *fit});
+        return;
+    }
+
+    // Larger than every input: cover it with overlapping tiles of the largest one, the last
+    // tile in each direction aligned with the region's far edge
+    const int size = input_sizes_.back();
+    const int stride = std::max(size - ROI_TILE_OVERLAP, size / 2);
+    auto offsets = [&](int length)
+    {
+        std::vector<int> out;
+        for (int p = 0;; p += stride)
+        {
+            if (p + size >= length)
+            {
+                out.push_back(std::max(0, length - size));
+                break;
+            }
+            out.push_back(p);
+        }
+        return out;
+    };
+    for (int y : offsets(region.height))
+    {
+        for (int x : offsets(region.width))
+        {
+            Tile tile;
+            tile.rect = cv::Rect(region.x + x, region.y + y, std::min(size, region.width), std::min(size, region.height));
+            tile.input_size = size;
+            out_tiles.push_back(tile);
+        }
+    }
+}
+
+RoiDetector::CachedTile &RoiDetector::prepareTile(const cv::Mat &screen, const Tile &tile, const YoloSettings &settings, bool &out_reused)
+{
+    out_reused = false;
+    const uint64_t hash = hashMatRegion(screen, tile.rect);
+    auto it = std::find_if(cache_.begin(), cache_.end(), [&](const CachedTile &c)
+                           { return c.tile.rect == tile.rect && c.tile.input_size == tile.input_size; });
+    if (it == cache_.end())
+    {
+        cache_.emplace_back();
+        it = cache_.end() - 1;
+        it->tile = tile;
+    }
+    else if (it->pixel_hash == hash && !it->blob.empty())
+    {
+        it->last_used = ++use_counter_;
+        out_reused = true;
+        return *it;
+    }
+
+    // Only the tile's pixels are converted; the rest of the input is letterbox grey
+    CachedTile &entry = *it;
+    entry.pixel_hash = hash;
+    entry.last_used = ++use_counter_;
+    entry.has_detections = false;
+    entry.canvas.create(tile.input_size, tile.input_size, CV_8UC3);
+    entry.canvas.setTo(cv::Scalar(114, 114, 114));
+    cv::Mat target = entry.canvas(cv::Rect(0, 0, tile.rect.width, tile.rect.height));
+    if (screen.channels() == 4)
+        cv::cvtColor(screen(tile.rect), target, cv::COLOR_BGRA2BGR);
+    else
+        screen(tile.rect).copyTo(target);
+
+    YoloSettings tile_settings = settings;
+    tile_settings.input_width = tile.input_size;
+    tile_settings.input_height = tile.input_size;
+    prepareYoloBlob(entry.canvas, entry.blob, tile_settings);
+    return entry;
+}
+
+void RoiDetector::detect(const cv::Mat &screen, const std::vector<cv::Rect> &regions, std::vector<Detection> &out_detections, const YoloSettings &settings)
+{
+    out_detections.clear();
+    stats_.queries++;
+    if (screen.empty() || net_.empty())
+        return;
+    CV_Assert(screen.type() == CV_8UC3 || screen.type() == CV_8UC4);
+
+    std::vector<Tile> tiles;
+    const cv::Rect bounds(0, 0, screen.cols, screen.rows);
+    for (const cv::Rect &region : regions)
+        planTiles(region & bounds, tiles);
+
+    // Indexes into cache_, which may grow while tiles are prepared; it is trimmed afterwards
+    std::vector<size_t> used;
+    std::map<int, std::vector<size_t>> pending; // By input size, one batch each
+    for (const Tile &tile : tiles)
+    {
+        bool reused;
+        CachedTile &entry = prepareTile(screen, tile, settings, reused);
+        const size_t index = &entry - cache_.data();
+        if (std::find(used.begin(), used.end(), index) != used.end())
+            continue; // Identical regions were passed twice
+        used.push_back(index);
+        if (entry.has_detections && sameDecodeSettings(entry.detection_settings, settings))
+        {
+            stats_.tiles_reused++;
+            continue;
+        }
+        if (reused)
+            stats_.blobs_reused++;
+        pending[tile.input_size].push_back(index);
+    }
+
+    for (const auto &group : pending)
+    {
+        YoloSettings tile_settings = settings;
+        tile_settings.input_width = group.first;
+        tile_settings.input_height = group.first;
+        const std::vector<size_t> &indexes = group.second;
+
+        std::vector<std::vector<Detection>> results;
+        bool batched = false;
+        if (batch_supported_ && indexes.size() > 1)
+        {
+            std::vector<cv::Mat> blobs;
+            for (size_t index : indexes)
+                blobs.push_back(cache_[index].blob);
+            try
+            {
+                detectObjectsWithYOLOBlobs(blobs, std::vector<cv::Size>(blobs.size(), cv::Size(group.first, group.first)), net_, results, tile_settings);
+                batched = true;
+            }
+            catch (const cv::Exception &e)
+            {
+                LOG_WARN("ROI tiles cannot be batched with this model, running them one at a time: " << e.what());
+                batch_supported_ = false;
+            }
+        }
+        if (!batched)
+        {
+            results.assign(indexes.size(), std::vector<Detection>());
+            for (size_t k = 0; k < indexes.size(); ++k)
+            {
+                std::vector<std::vector<Detection>> single;
+                detectObjectsWithYOLOBlobs({cache_[indexes[k]].blob}, {cv::Size(group.first, group.first)}, net_, single, tile_settings);
+                results[k] = std::move(single[0]);
+            }
+        }
+
+        for (size_t k = 0; k < indexes.size(); ++k)
+        {
+            CachedTile &entry = cache_[indexes[k]];
+            entry.detections = std::move(results[k]);
+            entry.detection_settings = settings;
+            entry.has_detections = true;
+        }
+        stats_.tiles_run += indexes.size();
+    }
+
+    // The canvas is at native scale, so tile boxes only need the tile offset
+    for (size_t index : used)
+    {
+        const CachedTile &entry = cache_[index];
+        for (const Detection &det : entry.detections)
+        {
+            Detection mapped = det;
+            mapped.box = (det.box + entry.tile.rect.tl()) & entry.tile.rect;
+            // Boxes mostly in the letterbox padding are not inside the region
+            if (mapped.box.area() * 2 < det.box.area())
+                continue;
+            out_detections.push_back(mapped);
+        }
+    }
+    if (tiles.size() > 1)
+        suppressDuplicates(out_detections, settings.nms_threshold);
+
+    if (cache_.size() > static_cast<size_t>(ROI_CACHE_CAPACITY))
+    {
+        std::sort(cache_.begin(), cache_.end(), [](const CachedTile &a, const CachedTile &b)
+                  { return a.last_used > b.last_used; });
+        cache_.resize(ROI_CACHE_CAPACITY);
+    }
+}
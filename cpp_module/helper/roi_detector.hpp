@@ -0,0 +1,71 @@
+#pragma once
+
+#include "yolo.hpp"
+
+const int ROI_CACHE_CAPACITY = 16;
+// Neighbouring tiles of a region larger than the network input overlap by this much, so an
+// element cut by one tile edge is whole in the other
+const int ROI_TILE_OVERLAP = 64;
+
+struct RoiStats
+{
+    uint64_t queries = 0;
+    uint64_t tiles_run = 0;    // Tiles that went through the network
+    uint64_t tiles_reused = 0; // Unchanged tiles answered from the cache
+    uint64_t blobs_reused = 0; // Unchanged tiles that skipped preprocessing but not inference
+};
+
+// Detects only inside given screen regions, e.g. where an automation step expects a dialog.
+// Each region is cropped from the raw capture before color conversion and fed to the network
+// at native scale: padded into the smallest accepted input size that holds it, or cut into
+// overlapping input-sized tiles when it is larger than all of them. Small elements therefore
+// keep every pixel instead of being shrunk with the whole desktop, and a region much smaller
+// than the screen costs a fraction of a full-frame pass when the model accepts small inputs.
+// Preprocessed tiles are cached by position and pixel hash, so asking again about an unchanged
+// region skips cropping, conversion and (with the same settings) inference. Not thread-safe.
+class RoiDetector
+{
+public:
+    // input_sizes are the square network inputs the model accepts, e.g. the result of
+    // prepareYoloInputSizes(); with only a fixed 640 input every region costs a full pass.
+    explicit RoiDetector(cv::dnn::Net &net, const std::vector<int> &input_sizes = {YOLO_INPUT_WIDTH});
+
+    // screen is the whole capture, BGRA (CV_8UC4, as DXGI delivers it) or BGR; regions and the
+    // returned boxes are in its pixel coordinates, and boxes are clipped to their region.
+    // settings supply the thresholds and class filter; the input size is chosen per region.
+    // Throws cv::Exception like detectObjectsWithYOLO.
+    void detect(const cv::Mat &screen, const std::vector<cv::Rect> &regions, std::vector<Detection> &out_detections, const YoloSettings &settings = YoloSettings());
+    const RoiStats &stats() const { return stats_; }
+    void clearCache();
+
+private:
+    struct Tile
+    {
+        cv::Rect rect; // In screen coordinates
+        int input_size = 0;
+    };
+
+    struct CachedTile
+    {
+        Tile tile;
+        uint64_t pixel_hash = 0;
+        uint64_t last_used = 0;
+        cv::Mat canvas; // Padded BGR input, reused between refreshes
+        cv::Mat blob;
+        bool has_detections = false;
+        YoloSettings detection_settings;
+        std::vector<Detection> detections; // Relative to the tile
+    };
+
+    void planTiles(const cv::Rect &region, std::vector<Tile> &out_tiles) const;
+    // Returns the cache entry for tile with an up-to-date blob; out_reused tells whether the
+    // cached blob was still valid
+    CachedTile &prepareTile(const cv::Mat &screen, const Tile &tile, const YoloSettings &settings, bool &out_reused);
+
+    cv::dnn::Net &net_;
+    std::vector<int> input_sizes_; // Ascending
+    std::vector<CachedTile> cache_;
+    uint64_t use_counter_ = 0;
+    bool batch_supported_ = true;
+    RoiStats stats_;
+};
@@ -0,0 +1,416 @@
+#include "synthetic_desktop.hpp"
+#include <cmath>
+
+static const int TITLE_BAR_HEIGHT = 28;
+static const int LINE_HEIGHT = 22;
+static const int TASKBAR_HEIGHT = 40;
+static const double FONT_SCALE = 0.5;
+static const cv::Size CURSOR_SIZE(12, 19);
+static const int TEXT_FIELD_PADDING = 16; // Left margin, caret and right margin around typed text
+
+static const std::vector<std::string> WORDS = {
+    "account", "settings", "report", "invoice", "search", "profile", "update", "status", "network", "project",
+    "review", "export", "window", "password", "customer", "details", "archive", "message", "schedule", "summary"};
+static const std::vector<std::string> BUTTON_LABELS = {"OK", "Cancel", "Submit", "Login", "Next", "Save", "Open", "Close"};
+static const std::string TYPED_SENTENCE = "the quick brown fox jumps over the lazy dog ";
+
+static const cv::Size MIN_WINDOW_CELL(240, 180);
+
+// Windows are tiled on a grid above the taskbar, one per cell
+static cv::Size layoutCell(const SyntheticDesktopConfig &config, int &out_cols)
+{
+    out_cols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(config.window_count))));
+    const int rows = (config.window_count + out_cols - 1) / out_cols;
+    return cv::Size(config.resolution.width / out_cols, (config.resolution.height - TASKBAR_HEIGHT) / rows);
+}
+
+static cv::Size textSize(const std::string &text)
+{
+    int baseline = 0;
+    return cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, FONT_SCALE, 1, &baseline);
+}
+
+static cv::Rect textBox(const std::string &text, cv::Point origin)
+{
+    // origin is the top-left of the line; Hershey text is drawn from its baseline
+    cv::Size size = textSize(text);
+    return cv::Rect(origin.x, origin.y + (LINE_HEIGHT - size.height) / 2, size.width, size.height);
+}
+
+// The tail of text that fits in width, as a single-line field shows it once typing runs past its end
+static std::string visibleTail(const std::string &text, int width)
+{
+    size_t start = 0;
+    while (start < text.size() && textSize(text.substr(start)).width > width)
+        start++;
+    return text.substr(start);
+}
+
+static void drawText(cv::Mat &canvas, const std::string &text, const cv::Rect &box, const cv::Scalar &color)
+{
+    cv::putText(canvas, text, cv::Point(box.x, box.y + box.height), cv::FONT_HERSHEY_SIMPLEX, FONT_SCALE, color, 1, cv::LINE_AA);
+}
+
+SyntheticDesktopSource::SyntheticDesktopSource(const SyntheticDesktopConfig &config)
+    : config_(config)
+{
+    config_.window_count = std::max(1, config_.window_count);
+    config_.change_every = std::max(1, config_.change_every);
+}
+
+bool SyntheticDesktopSource::open()
+{
+    int cols;
+    cv::Size cell = layoutCell(config_, cols);
+    if (cell.width < MIN_WINDOW_CELL.width || cell.height < MIN_WINDOW_CELL.height)
+    {
+        LOG_ERR("Synthetic desktop " << config_.resolution.width << "x" << config_.resolution.height << " is too small for "
+                                     << config_.window_count << " windows");
+        return false;
+    }
+    rng_.seed(config_.seed);
+    frame_index_ = 0;
+    step_ = 0;
+    typed_text_.clear();
+    scroll_offset_ = 0;
+    exhausted_ = false;
+    buildLayout();
+    renderBackground();
+    return true;
+}
+
+void SyntheticDesktopSource::buildLayout()
+{
+    windows_.clear();
+    document_.clear();
+    auto pick = [&](const std::vector<std::string> &items)
+    {
+        return items[std::uniform_int_distribution<size_t>(0, items.size() - 1)(rng_)];
+    };
+    auto sentence = [&](int words)
+    {
+        std::string text = pick(WORDS);
+        for (int w = 1; w < words; ++w)
+            text += " " + pick(WORDS);
+        return text;
+    };
+
+    // Windows never overlap until one is dragged
+    const int count = config_.window_count;
+    int cols;
+    const cv::Size cell = layoutCell(config_, cols);
+    std::uniform_int_distribution<int> margin(12, 40);
+    for (int i = 0; i < count; ++i)
+    {
+        Window window;
+        int left = margin(rng_), top = margin(rng_), right = margin(rng_), bottom = margin(rng_);
+        window.rect = cv::Rect((i % cols) * cell.width + left, (i / cols) * cell.height + top,
+                               cell.width - left - right, cell.height - top - bottom);
+        window.title = sentence(2);
+        window.accent = cv::Scalar(std::uniform_int_distribution<int>(90, 200)(rng_), std::uniform_int_distribution<int>(60, 160)(rng_), 40);
+
+        const int width = window.rect.width, height = window.rect.height;
+        const int button_top = height - 46;
+        const bool front = i == 0;
+        int y = TITLE_BAR_HEIGHT + 12;
+        if (front && config_.scenario == SyntheticScenario::Video)
+        {
+            window.elements.push_back({SYNTHETIC_VIDEO, cv::Rect(12, y, width - 24, std::max(40, button_top - y - 12)), ""});
+        }
+        else if (!(front && config_.scenario == SyntheticScenario::Scrolling))
+        {
+            // Typing needs a field in the front window, so every window starts with one
+            window.elements.push_back({SYNTHETIC_TEXT_FIELD, cv::Rect(12, y, std::min(width - 24, 320), 26), ""});
+            y += 40;
+            while (y + LINE_HEIGHT < button_top - 8)
+            {
+                std::string line = sentence(std::uniform_int_distribution<int>(2, 6)(rng_));
+                cv::Rect box = textBox(line, cv::Point(12, y));
+                if (box.br().x < width - 12)
+                    window.elements.push_back({SYNTHETIC_TEXT, box, line});
+                y += LINE_HEIGHT;
+            }
+        }
+
+        int x = 12;
+        for (int b = std::uniform_int_distribution<int>(1, 3)(rng_); b > 0 && x + 90 < width - 12; --b)
+        {
+            window.elements.push_back({SYNTHETIC_BUTTON, cv::Rect(x, button_top, 90, 30), pick(BUTTON_LABELS)});
+            x += 100;
+        }
+        windows_.push_back(window);
+    }
+
+    if (config_.scenario == SyntheticScenario::Scrolling)
+    {
+        for (int i = 0; i < 200; ++i)
+            document_.push_back(std::to_string(i + 1) + ". " + sentence(std::uniform_int_distribution<int>(3, 8)(rng_)));
+    }
+
+    drag_origin_ = windows_[0].rect.tl();
+    cursor_ = windows_[0].rect.tl() + cv::Point(windows_[0].rect.width / 2, TITLE_BAR_HEIGHT / 2);
+}
+
+void SyntheticDesktopSource::renderBackground()
+{
+    background_.create(config_.resolution, CV_8UC3);
+    background_.setTo(cv::Scalar(112, 78, 48));
+    cv::rectangle(background_, cv::Rect(0, config_.resolution.height - TASKBAR_HEIGHT, config_.resolution.width, TASKBAR_HEIGHT), cv::Scalar(40, 36, 32), cv::FILLED);
+    // Back to front, so the front window (index 0) is drawn over the rest every frame
+    for (size_t i = windows_.size(); i-- > 1;)
+        renderWindow(background_, windows_[i], false);
+}
+
+void SyntheticDesktopSource::renderWindow(cv::Mat &canvas, const Window &window, bool front)
+{
+    const cv::Rect &r = window.rect;
+    cv::rectangle(canvas, r, cv::Scalar(244, 244, 244), cv::FILLED);
+    cv::rectangle(canvas, cv::Rect(r.x, r.y, r.width, TITLE_BAR_HEIGHT), front ? window.accent : window.accent * 0.6, cv::FILLED);
+    cv::rectangle(canvas, r, cv::Scalar(90, 90, 90), 1);
+    drawText(canvas, window.title, textBox(window.title, cv::Point(r.x + 10, r.y + (TITLE_BAR_HEIGHT - LINE_HEIGHT) / 2)), cv::Scalar(255, 255, 255));
+
+    bool first_field = true;
+    for (const Element &element : window.elements)
+    {
+        cv::Rect box = element.box + r.tl();
+        switch (element.class_id)
+        {
+        case SYNTHETIC_BUTTON:
+        {
+            cv::rectangle(canvas, box, window.accent * 0.4 + cv::Scalar(150, 150, 150), cv::FILLED);
+            cv::rectangle(canvas, box, cv::Scalar(70, 70, 70), 1);
+            cv::Size size = textSize(element.label);
+            drawText(canvas, element.label, cv::Rect(box.x + (box.width - size.width) / 2, box.y + (box.height - size.height) / 2, size.width, size.height), cv::Scalar(20, 20, 20));
+            break;
+        }
+        case SYNTHETIC_TEXT_FIELD:
+        {
+            cv::rectangle(canvas, box, cv::Scalar(255, 255, 255), cv::FILLED);
+            cv::rectangle(canvas, box, front && first_field ? window.accent : cv::Scalar(150, 150, 150), 1);
+            if (front && first_field && config_.scenario == SyntheticScenario::Typing)
+            {
+                const std::string shown = visibleTail(typed_text_, box.width - TEXT_FIELD_PADDING);
+                cv::Rect text = textBox(shown, cv::Point(box.x + 6, box.y + (box.height - LINE_HEIGHT) / 2));
+                if (!shown.empty())
+                    drawText(canvas, shown, text, cv::Scalar(20, 20, 20));
+                // The caret blinks on alternate keystrokes
+                if (step_ % 2 == 0)
+                {
+                    const int caret_x = box.x + 6 + (shown.empty() ? 0 : text.width + 2);
+                    cv::line(canvas, cv::Point(caret_x, box.y + 5), cv::Point(caret_x, box.y + box.height - 5), cv::Scalar(0, 0, 0), 1);
+                }
+            }
+            first_field = false;
+            break;
+        }
+        case SYNTHETIC_TEXT:
+            drawText(canvas, element.label, box, cv::Scalar(40, 40, 40));
+            break;
+        default:
+            break; // Video is painted per frame by renderFront
+        }
+    }
+}
+
+void SyntheticDesktopSource::renderFront(cv::Mat &canvas)
+{
+    const Window &front = windows_[0];
+    renderWindow(canvas, front, true);
+    const cv::Rect screen(0, 0, canvas.cols, canvas.rows);
+
+    if (config_.scenario == SyntheticScenario::Scrolling)
+    {
+        cv::Rect area = (cv::Rect(12, TITLE_BAR_HEIGHT + 8, front.rect.width - 24, front.rect.height - TITLE_BAR_HEIGHT - 64) + front.rect.tl()) & screen;
+        if (!area.empty())
+        {
+            // Drawing into the ROI clips lines that are scrolled half out of view
+            cv::Mat view = canvas(area);
+            const int first = scroll_offset_ / LINE_HEIGHT;
+            for (int y = -(scroll_offset_ % LINE_HEIGHT), line = first; y < area.height; y += LINE_HEIGHT, ++line)
+            {
+                const std::string &text = document_[line % document_.size()];
+                drawText(view, text, textBox(text, cv::Point(4, y)), cv::Scalar(40, 40, 40));
+            }
+        }
+    }
+
+    for (const Element &element : front.elements)
+    {
+        if (element.class_id != SYNTHETIC_VIDEO)
+            continue;
+        cv::Rect area = (element.box + front.rect.tl()) & screen;
+        if (area.empty())
+            continue;
+        // Moving color bars and a bouncing ball: every pixel changes every step
+        cv::Mat view = canvas(area);
+        const int bar = std::max(8, area.width / 12);
+        for (int x = 0; x < area.width; x += bar)
+        {
+            int phase = (x / bar + step_) % 6;
+            cv::Scalar color(phase * 40 + 30, 255 - phase * 35, (phase * 90 + step_ * 3) % 256);
+            cv::rectangle(view, cv::Rect(x, 0, bar, area.height), color, cv::FILLED);
+        }
+        cv::Point ball(static_cast<int>((0.5 + 0.4 * std::sin(step_ * 0.11)) * area.width), static_cast<int>((0.5 + 0.4 * std::cos(step_ * 0.07)) * area.height));
+        cv::circle(view, ball, std::max(6, area.height / 10), cv::Scalar(255, 255, 255), cv::FILLED, cv::LINE_AA);
+    }
+
+    std::vector<cv::Point> arrow = {cursor_, cursor_ + cv::Point(0, 16), cursor_ + cv::Point(4, 12), cursor_ + cv::Point(8, 18),
+                                    cursor_ + cv::Point(10, 17), cursor_ + cv::Point(7, 11), cursor_ + cv::Point(12, 11)};
+    cv::fillConvexPoly(canvas, arrow, cv::Scalar(0, 0, 0), cv::LINE_AA);
+    cv::polylines(canvas, arrow, true, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
+}
+
+bool SyntheticDesktopSource::advance()
+{
+    if (frame_index_ == 0)
+        return true;
+    if (frame_index_ % config_.change_every != 0)
+        return false;
+
+    switch (config_.scenario)
+    {
+    case SyntheticScenario::Typing:
+        step_++;
+        if (typed_text_.size() >= 32)
+            typed_text_.clear();
+        else
+            typed_text_ += TYPED_SENTENCE[step_ % TYPED_SENTENCE.size()];
+        return true;
+    case SyntheticScenario::Scrolling:
+        step_++;
+        scroll_offset_ += 4;
+        return true;
+    case SyntheticScenario::Video:
+        step_++;
+        return true;
+    case SyntheticScenario::WindowDrag:
+    {
+        step_++;
+        const cv::Size &res = config_.resolution;
+        cv::Point offset(static_cast<int>(res.width * 0.3 * std::sin(step_ * 0.03)), static_cast<int>(res.height * 0.2 * std::sin(step_ * 0.05)));
+        windows_[0].rect = cv::Rect(drag_origin_ + offset, windows_[0].rect.size());
+        // The cursor holds the title bar
+        cursor_ = windows_[0].rect.tl() + cv::Point(windows_[0].rect.width / 2, TITLE_BAR_HEIGHT / 2);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void SyntheticDesktopSource::addBox(int class_id, const cv::Rect &box, bool occludable)
+{
+    cv::Rect visible = box & cv::Rect(0, 0, config_.resolution.width, config_.resolution.height);
+    if (visible.area() * 2 < box.area() || visible.empty())
+        return;
+    if (occludable && (visible & windows_[0].rect).area() * 2 > visible.area())
+        return;
+    GroundTruthBox truth;
+    truth.class_id = class_id;
+    truth.box = visible;
+    ground_truth_.push_back(truth);
+}
+
+void SyntheticDesktopSource::collectGroundTruth()
+{
+    ground_truth_.clear();
+    for (size_t i = 0; i < windows_.size(); ++i)
+    {
+        const Window &window = windows_[i];
+        const bool back = i > 0;
+        addBox(SYNTHETIC_WINDOW, window.rect, back);
+        bool first_field = true;
+        for (const Element &element : window.elements)
+        {
+            addBox(element.class_id, element.box + window.rect.tl(), back);
+            if (element.class_id == SYNTHETIC_TEXT_FIELD && !back && first_field && config_.scenario == SyntheticScenario::Typing && !typed_text_.empty())
+            {
+                cv::Rect field = element.box + window.rect.tl();
+                const std::string shown = visibleTail(typed_text_, field.width - TEXT_FIELD_PADDING);
+                addBox(SYNTHETIC_TEXT, textBox(shown, cv::Point(field.x + 6, field.y + (field.height - LINE_HEIGHT) / 2)), false);
+            }
+            if (element.class_id == SYNTHETIC_TEXT_FIELD)
+                first_field = false;
+        }
+    }
+
+    if (config_.scenario == SyntheticScenario::Scrolling)
+    {
+        const Window &front = windows_[0];
+        cv::Rect area = cv::Rect(12, TITLE_BAR_HEIGHT + 8, front.rect.width - 24, front.rect.height - TITLE_BAR_HEIGHT - 64) + front.rect.tl();
+        const int first = scroll_offset_ / LINE_HEIGHT;
+        for (int y = -(scroll_offset_ % LINE_HEIGHT), line = first; y < area.height; y += LINE_HEIGHT, ++line)
+        {
+            const std::string &text = document_[line % document_.size()];
+            cv::Rect box = textBox(text, cv::Point(area.x + 4, area.y + y));
+            // Lines scrolled mostly out of the view are not counted
+            cv::Rect shown = box & area;
+            if (shown.area() * 2 >= box.area())
+                addBox(SYNTHETIC_TEXT, shown, false);
+        }
+    }
+
+    addBox(SYNTHETIC_CURSOR, cv::Rect(cursor_, CURSOR_SIZE), false);
+}
+
+bool SyntheticDesktopSource::read(cv::Mat &frame_bgr)
+{
+    if (exhausted_ || (config_.max_frames > 0 && frame_index_ >= static_cast<uint64_t>(config_.max_frames)))
+    {
+        exhausted_ = true;
+        return false;
+    }
+
+    last_changed_ = advance();
+    frame_index_++;
+    if (!last_changed_ && config_.skip_unchanged)
+        return false;
+
+    background_.copyTo(frame_bgr);
+    renderFront(frame_bgr);
+    collectGroundTruth();
+    return true;
+}
+
+std::string SyntheticDesktopSource::name() const
+{
+    return std::string("synthetic:") + syntheticScenarioName(config_.scenario);
+}
+
+bool SyntheticDesktopSource::exhausted() const
+{
+    return exhausted_;
+}
+
+const char *syntheticScenarioName(SyntheticScenario scenario)
+{
+    switch (scenario)
+    {
+    case SyntheticScenario::Static:
+        return "static";
+    case SyntheticScenario::Typing:
+        return "typing";
+    case SyntheticScenario::Scrolling:
+        return "scrolling";
+    case SyntheticScenario::Video:
+        return "video";
+    case SyntheticScenario::WindowDrag:
+        return "drag";
+    default:
+        return "unknown";
+    }
+}
+
+bool parseSyntheticScenario(const std::string &name, SyntheticScenario &out_scenario)
+{
+    for (SyntheticScenario scenario : {SyntheticScenario::Static, SyntheticScenario::Typing, SyntheticScenario::Scrolling,
+                                       SyntheticScenario::Video, SyntheticScenario::WindowDrag})
+    {
+        if (name == syntheticScenarioName(scenario))
+        {
+            out_scenario = scenario;
+            return true;
+        }
+    }
+    return false;
+}
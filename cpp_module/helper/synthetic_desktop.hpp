@@ -0,0 +1,109 @@
+#pragma once
+
+#include <random>
+#include "frame_source.hpp"
+#include "detection_eval.hpp"
+
+// What changes from frame to frame
+enum class SyntheticScenario
+{
+    Static,     // Nothing moves; every frame after the first is identical
+    Typing,     // Characters appear in a focused text field, which scrolls once full; the caret blinks
+    Scrolling,  // A document scrolls steadily inside the front window
+    Video,      // A video region repaints every frame, the rest stays still
+    WindowDrag, // The front window and the cursor move across the others
+};
+
+// Class ids of the ground-truth boxes, indexes into SYNTHETIC_CLASS_NAMES
+enum SyntheticClass
+{
+    SYNTHETIC_WINDOW = 0,
+    SYNTHETIC_BUTTON,
+    SYNTHETIC_TEXT_FIELD,
+    SYNTHETIC_TEXT,
+    SYNTHETIC_VIDEO,
+    SYNTHETIC_CURSOR,
+};
+
+const std::vector<std::string> SYNTHETIC_CLASS_NAMES = {"window", "button", "text_field", "text", "video", "cursor"};
+
+struct SyntheticDesktopConfig
+{
+    cv::Size resolution = cv::Size(1920, 1080);
+    SyntheticScenario scenario = SyntheticScenario::Typing;
+    uint32_t seed = 1;
+    int window_count = 4;
+    // The scenario advances once every this many frames; higher values lower the churn rate
+    int change_every = 1;
+    // Like the DXGI source, read() returns false when the frame did not change
+    bool skip_unchanged = false;
+    // Exhausted after this many frames; 0 never ends
+    int max_frames = 0;
+};
+
+// Renders desktop-like frames (windows with title bars, buttons, text fields and text, a
+// cursor) following a scripted change pattern, with exact ground-truth boxes for every frame.
+// The output depends only on the config, so two runs with the same seed produce the same
+// frames; use it to measure change gating, tracking and throughput without a real desktop.
+class SyntheticDesktopSource : public FrameSource
+{
+public:
+    explicit SyntheticDesktopSource(const SyntheticDesktopConfig &config);
+    bool open() override;
+    bool read(cv::Mat &frame_bgr) override;
+    std::string name() const override;
+    bool exhausted() const override;
+    bool unchanged() const override { return config_.skip_unchanged && !last_changed_ && !exhausted_; }
+
+    // Boxes visible in the last frame read() produced; elements mostly hidden behind the front
+    // window are left out
+    const std::vector<GroundTruthBox> &groundTruth() const { return ground_truth_; }
+    // Whether the last frame differs from the one before it
+    bool lastFrameChanged() const { return last_changed_; }
+    uint64_t frameIndex() const { return frame_index_; }
+
+private:
+    struct Element
+    {
+        int class_id;
+        cv::Rect box; // Relative to the window's top-left corner
+        std::string label;
+    };
+
+    struct Window
+    {
+        cv::Rect rect;
+        std::string title;
+        cv::Scalar accent;
+        std::vector<Element> elements;
+    };
+
+    void buildLayout();
+    bool advance();
+    void renderBackground();
+    void renderWindow(cv::Mat &canvas, const Window &window, bool front);
+    void renderFront(cv::Mat &canvas);
+    void collectGroundTruth();
+    void addBox(int class_id, const cv::Rect &box, bool occludable);
+
+    SyntheticDesktopConfig config_;
+    std::mt19937 rng_;
+    std::vector<Window> windows_; // windows_[0] is the front window
+    std::vector<std::string> document_;
+    cv::Mat background_; // Desktop and the back windows; only the front window is drawn per frame
+
+    uint64_t frame_index_ = 0;
+    int step_ = 0; // Scenario progress, advanced every change_every frames
+    std::string typed_text_;
+    int scroll_offset_ = 0;
+    cv::Point drag_origin_;
+    cv::Point cursor_;
+
+    std::vector<GroundTruthBox> ground_truth_;
+    bool last_changed_ = true;
+    bool exhausted_ = false;
+};
+
+const char *syntheticScenarioName(SyntheticScenario scenario);
+// Accepts the names syntheticScenarioName() returns: static, typing, scrolling, video, drag
+bool parseSyntheticScenario(const std::string &name, SyntheticScenario &out_scenario);
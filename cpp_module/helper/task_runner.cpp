@@ -0,0 +1,444 @@
+#include "task_runner.hpp"
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#ifdef _WIN32
+#include <windows.h>
+#include <shellapi.h>
+#endif
+
+std::string TaskStep::get(const std::string &key, const std::string &fallback) const
+{
+    auto it = params.find(key);
+    return it != params.end() ? it->second : fallback;
+}
+
+int TaskStep::getInt(const std::string &key, int fallback) const
+{
+    auto it = params.find(key);
+    return it != params.end() ? std::atoi(it->second.c_str()) : fallback;
+}
+
+bool TaskStep::getBool(const std::string &key, bool fallback) const
+{
+    auto it = params.find(key);
+    if (it == params.end())
+        return fallback;
+    return it->second == "1" || it->second == "true" || it->second == "yes";
+}
+
+cv::Rect TaskStep::getRect(const std::string &key) const
+{
+    std::vector<std::string> parts = splitString(get(key), ',');
+    if (parts.size() != 4)
+        return cv::Rect();
+    cv::Rect rect(std::atoi(parts[0].c_str()), std::atoi(parts[1].c_str()), std::atoi(parts[2].c_str()), std::atoi(parts[3].c_str()));
+    return rect.width > 0 && rect.height > 0 ? rect : cv::Rect();
+}
+
+bool loadTasks(const std::string &path, std::vector<TaskStep> &out_steps)
+{
+    out_steps.clear();
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+    {
+        LOG_ERR("Failed to open tasks file: " << path);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+
+    // FileStorage wants an object at the root, tasks.json is a bare array
+    std::string content = "{\"tasks\": " + buffer.str() + "}";
+    try
+    {
+        cv::FileStorage fs(content, cv::FileStorage::READ | cv::FileStorage::MEMORY | cv::FileStorage::FORMAT_JSON);
+        cv::FileNode tasks = fs["tasks"];
+        if (!tasks.isSeq())
+        {
+            LOG_ERR("Tasks file must contain a JSON array: " << path);
+            return false;
+        }
+        for (cv::FileNodeIterator it = tasks.begin(); it != tasks.end(); ++it)
+        {
+            cv::FileNode task = *it;
+            TaskStep step;
+            for (cv::FileNodeIterator field = task.begin(); field != task.end(); ++field)
+            {
+                cv::FileNode value = *field;
+                std::string text;
+                if (value.isString())
+                    text = value.string();
+                else if (value.isInt())
+                    text = std::to_string(static_cast<int>(value));
+                else if (value.isReal())
+                    text = cv::format("%g", static_cast<double>(value));
+                else
+                    continue;
+
+                if (value.name() == "action")
+                    step.action = text;
+                else
+                    step.params[value.name()] = text;
+            }
+            if (step.action.empty())
+            {
+                LOG_ERR("Task without an action in " << path);
+                return false;
+            }
+            out_steps.push_back(step);
+        }
+    }
+    catch (const cv::Exception &e)
+    {
+        LOG_ERR("Failed to parse tasks file " << path << ": " << e.what());
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+static bool sendInputs(std::vector<INPUT> &inputs)
+{
+    return SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT)) == inputs.size();
+}
+
+static bool sendKeyCombo(const std::vector<WORD> &keys)
+{
+    std::vector<INPUT> inputs;
+    for (WORD key : keys)
+    {
+        INPUT in = {};
+        in.type = INPUT_KEYBOARD;
+        in.ki.wVk = key;
+        inputs.push_back(in);
+    }
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it)
+    {
+        INPUT in = {};
+        in.type = INPUT_KEYBOARD;
+        in.ki.wVk = *it;
+        in.ki.dwFlags = KEYEVENTF_KEYUP;
+        inputs.push_back(in);
+    }
+    return sendInputs(inputs);
+}
+#endif
+
+// Frame coordinates are screen pixels of the captured output; the agent is DPI aware
+static bool clickAt(const cv::Point &point)
+{
+#ifdef _WIN32
+    if (!SetCursorPos(point.x, point.y))
+        return false;
+    std::vector<INPUT> inputs(2);
+    inputs[0].type = INPUT_MOUSE;
+    inputs[0].mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
+    inputs[1].type = INPUT_MOUSE;
+    inputs[1].mi.dwFlags = MOUSEEVENTF_LEFTUP;
+    return sendInputs(inputs);
+#else
+    LOG_ERR("Mouse input is only implemented on Windows; cannot click at " << point.x << "," << point.y);
+    return false;
+#endif
+}
+
+static bool sendText(const std::string &utf8)
+{
+#ifdef _WIN32
+    int length = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, nullptr, 0);
+    std::wstring wide(length > 0 ? length - 1 : 0, L'\0');
+    if (length > 1)
+        MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, &wide[0], length);
+
+    std::vector<INPUT> inputs;
+    for (wchar_t ch : wide)
+    {
+        INPUT in = {};
+        in.type = INPUT_KEYBOARD;
+        in.ki.wScan = ch;
+        in.ki.dwFlags = KEYEVENTF_UNICODE;
+        inputs.push_back(in);
+        in.ki.dwFlags = KEYEVENTF_UNICODE | KEYEVENTF_KEYUP;
+        inputs.push_back(in);
+    }
+    return inputs.empty() || sendInputs(inputs);
+#else
+    (void)utf8;
+    LOG_ERR("Keyboard input is only implemented on Windows");
+    return false;
+#endif
+}
+
+static std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+static std::string timestampString()
+{
+    std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y%m%d_%H%M%S", std::localtime(&now));
+    return buffer;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+TaskRunner::TaskRunner(DetectionBus &bus, const std::vector<std::string> &class_names, const std::string &screenshot_dir)
+    : bus_(bus), class_names_(class_names), screenshot_dir_(screenshot_dir)
+{
+}
+
+bool TaskRunner::run(const std::vector<TaskStep> &steps)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        auto step_start = std::chrono::steady_clock::now();
+        if (!runStep(steps[i]))
+        {
+            LOG_ERR("Task " << i + 1 << " (" << steps[i].action << ") failed; stopping.");
+            return false;
+        }
+        LOG("Task " << i + 1 << " (" << steps[i].action << ") done in " << cv::format("%.0f", elapsedMs(step_start)) << " ms");
+    }
+    LOG("All " << steps.size() << " tasks done in " << cv::format("%.0f", elapsedMs(start)) << " ms");
+    return true;
+}
+
+bool TaskRunner::runStep(const TaskStep &step)
+{
+    if (step.action == "open")
+        return openApplication(step.get("app", "notepad.exe"));
+    if (step.action == "navigate")
+        return navigateTo(step.get("url"));
+    if (step.action == "type")
+        return typeText(step.get("value", "Hello, AI!"));
+    if (step.action == "screenshot")
+        return takeScreenshot(step.get("prefix", "task"));
+    if (step.action == "login")
+        return login(step);
+    if (step.action == "wait_for_element")
+    {
+        cv::Rect region = step.getRect("region");
+        if (!step.get("region").empty() && region.empty())
+        {
+            LOG_ERR("Invalid region \"" << step.get("region") << "\"; expected x,y,width,height");
+            return false;
+        }
+        return waitForElement(step.get("element"), step.getInt("timeout_ms", TASK_DEFAULT_TIMEOUT_MS), step.getBool("click", false), region);
+    }
+    if (step.action == "wait_for_text")
+        return waitForText(step.get("text"), step.getInt("timeout_ms", TASK_DEFAULT_TIMEOUT_MS), step.getBool("click", false));
+
+    LOG_ERR("Unknown action: " << step.action);
+    return false;
+}
+
+bool TaskRunner::openApplication(const std::string &app)
+{
+    const bool chrome = toLower(app).find("chrome") != std::string::npos;
+#ifdef _WIN32
+    HINSTANCE result = ShellExecuteA(nullptr, "open", chrome ? "chrome" : app.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
+    if (reinterpret_cast<INT_PTR>(result) <= 32)
+    {
+        LOG_ERR("Failed to open " << app);
+        return false;
+    }
+#else
+    std::string command = (chrome ? std::string("google-chrome") : app) + " &";
+    if (std::system(command.c_str()) != 0)
+    {
+        LOG_ERR("Failed to open " << app);
+        return false;
+    }
+#endif
+    LOG("Opened " << app);
+    waitForScreenToSettle(TASK_DEFAULT_TIMEOUT_MS);
+    return true;
+}
+
+bool TaskRunner::navigateTo(const std::string &url)
+{
+    if (url.empty())
+    {
+        LOG_ERR("navigate needs a url");
+        return false;
+    }
+#ifdef _WIN32
+    if (!sendKeyCombo({VK_CONTROL, 'T'}))
+        return false;
+    waitForScreenToSettle(TASK_DEFAULT_TIMEOUT_MS); // New tab open
+    if (!sendText(url) || !sendKeyCombo({VK_RETURN}))
+        return false;
+#else
+    LOG_ERR("Keyboard input is only implemented on Windows");
+    return false;
+#endif
+    LOG("Navigated to " << url);
+    waitForScreenToSettle(TASK_DEFAULT_TIMEOUT_MS);
+    return true;
+}
+
+bool TaskRunner::typeText(const std::string &text)
+{
+    if (!sendText(text))
+        return false;
+    LOG("Typed: " << text);
+    return true;
+}
+
+bool TaskRunner::takeScreenshot(const std::string &prefix)
+{
+    DetectionEvent event;
+    if (!bus_.latest(event) || event.frame.empty())
+    {
+        LOG_ERR("No frame captured yet for screenshot");
+        return false;
+    }
+    std::filesystem::create_directories(screenshot_dir_);
+    std::string filename = (std::filesystem::path(screenshot_dir_) / (prefix + "_" + timestampString() + ".png")).generic_string();
+    if (!cv::imwrite(filename, event.frame))
+    {
+        LOG_ERR("Failed to save screenshot: " << filename);
+        return false;
+    }
+    LOG("Screenshot saved: " << filename);
+    return true;
+}
+
+bool TaskRunner::login(const TaskStep &step)
+{
+    // No dialogs here; credentials come from the task or the environment
+    std::string username = step.get("username");
+    std::string password = step.get("password");
+    if (username.empty() && std::getenv("AGENT_USERNAME"))
+        username = std::getenv("AGENT_USERNAME");
+    if (password.empty() && std::getenv("AGENT_PASSWORD"))
+        password = std::getenv("AGENT_PASSWORD");
+    if (username.empty() || password.empty())
+    {
+        LOG_ERR("login needs username and password (task fields or AGENT_USERNAME / AGENT_PASSWORD)");
+        return false;
+    }
+
+    const int timeout_ms = step.getInt("timeout_ms", TASK_DEFAULT_TIMEOUT_MS);
+    if (!openApplication("chrome") || !navigateTo(step.get("url")))
+        return false;
+    if (!waitForElement("username_field", timeout_ms, true) || !typeText(username))
+        return false;
+    if (!waitForElement("password_field", timeout_ms, true) || !sendText(password))
+        return false;
+    LOG("Entered password");
+    if (!waitForElement("login_button", timeout_ms, true))
+        return false;
+    waitForScreenToSettle(timeout_ms);
+    return takeScreenshot("login");
+}
+
+bool TaskRunner::waitForElement(const std::string &element, int timeout_ms, bool click, const cv::Rect &region)
+{
+    auto it = std::find(class_names_.begin(), class_names_.end(), element);
+    if (it == class_names_.end())
+    {
+        LOG_ERR("Invalid element type: " << element);
+        return false;
+    }
+    const int class_id = static_cast<int>(it - class_names_.begin());
+
+    // A full-frame event can satisfy a region waiter too, so the box itself must be in the region
+    auto matches = [class_id, region](const Detection &det)
+    {
+        return det.class_id == class_id && (region.empty() || region.contains((det.box.tl() + det.box.br()) / 2));
+    };
+    DetectionPredicate present = [&matches](const DetectionEvent &event)
+    {
+        return std::any_of(event.detections.begin(), event.detections.end(), matches);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    DetectionEvent event;
+    if (!bus_.waitFor(present, std::chrono::milliseconds(timeout_ms), event, true, false, region, class_id))
+    {
+        LOG_ERR(element << " not found within " << timeout_ms << " ms");
+        return false;
+    }
+
+    const Detection *best = nullptr;
+    for (const Detection &det : event.detections)
+    {
+        if (matches(det) && (!best || det.confidence > best->confidence))
+            best = &det;
+    }
+    LOG("Found " << element << " after " << cv::format("%.0f", elapsedMs(start)) << " ms at (" << best->box.x << ", " << best->box.y << ")");
+    if (click && !clickAt((best->box.tl() + best->box.br()) / 2))
+        return false;
+    return true;
+}
+
+bool TaskRunner::waitForText(const std::string &text, int timeout_ms, bool click)
+{
+    if (text.empty())
+    {
+        LOG_ERR("wait_for_text needs a text");
+        return false;
+    }
+    const std::string query = toLower(text);
+    DetectionPredicate present = [&query](const DetectionEvent &event)
+    {
+        return std::any_of(event.text_regions.begin(), event.text_regions.end(), [&query](const TextRegion &region)
+                           { return toLower(region.text).find(query) != std::string::npos; });
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    DetectionEvent event;
+    if (!bus_.waitFor(present, std::chrono::milliseconds(timeout_ms), event, true, true))
+    {
+        LOG_ERR("Text \"" << text << "\" not found within " << timeout_ms << " ms");
+        return false;
+    }
+
+    for (const TextRegion &region : event.text_regions)
+    {
+        if (toLower(region.text).find(query) == std::string::npos)
+            continue;
+        LOG("Found text \"" << region.text << "\" after " << cv::format("%.0f", elapsedMs(start)) << " ms");
+        if (click && !clickAt((region.box.tl() + region.box.br()) / 2))
+            return false;
+        break;
+    }
+    return true;
+}
+
+bool TaskRunner::waitForScreenToSettle(int timeout_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    DetectionEvent event;
+    uint64_t last_sequence = bus_.latest(event) ? event.sequence : 0;
+
+    auto newerThan = [&last_sequence](const DetectionEvent &e)
+    { return e.sequence > last_sequence; };
+    DetectionPredicate changed = newerThan;
+    if (!bus_.waitFor(changed, std::chrono::milliseconds(timeout_ms), event, false))
+    {
+        LOG("Screen did not change within " << timeout_ms << " ms, continuing");
+        return false;
+    }
+
+    // Settled once no newer frame arrives within the settle window
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        last_sequence = event.sequence;
+        if (!bus_.waitFor(changed, std::chrono::milliseconds(TASK_SETTLE_MS), event))
+            return true;
+    }
+    return true;
+}
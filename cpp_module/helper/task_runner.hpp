@@ -0,0 +1,56 @@
+#pragma once
+
+#include <map>
+#include "detection_bus.hpp"
+
+const int TASK_DEFAULT_TIMEOUT_MS = 10000;
+// The screen counts as settled once no changed frame arrives for this long
+const int TASK_SETTLE_MS = 300;
+
+// One entry of tasks.json; every field other than "action" is kept as a string
+struct TaskStep
+{
+    std::string action;
+    std::map<std::string, std::string> params;
+
+    std::string get(const std::string &key, const std::string &fallback = "") const;
+    int getInt(const std::string &key, int fallback) const;
+    bool getBool(const std::string &key, bool fallback) const;
+    // "x,y,width,height" in screen pixels; an empty rect if missing or malformed
+    cv::Rect getRect(const std::string &key) const;
+};
+
+// Reads the same schema as python_module/tasks.json: a top-level array of objects.
+bool loadTasks(const std::string &path, std::vector<TaskStep> &out_steps);
+
+// Executes tasks.json steps against the live detection stream. The Python tool's fixed sleeps
+// become waits on the DetectionBus:
+//   open / navigate       -> wait until the screen changes, then until it settles
+//   wait_for_element      -> "element" (class name), optional "timeout_ms", "click", "region"
+//                            ("x,y,w,h"; only that part of the screen is searched, at native scale)
+//   wait_for_text         -> "text" (case-insensitive substring), optional "timeout_ms", "click"
+//   type, screenshot, login behave like the Python actions.
+class TaskRunner
+{
+public:
+    TaskRunner(DetectionBus &bus, const std::vector<std::string> &class_names, const std::string &screenshot_dir = "screenshots");
+
+    // Stops at the first failing step
+    bool run(const std::vector<TaskStep> &steps);
+    bool runStep(const TaskStep &step);
+
+private:
+    bool openApplication(const std::string &app);
+    bool navigateTo(const std::string &url);
+    bool typeText(const std::string &text);
+    bool takeScreenshot(const std::string &prefix);
+    bool login(const TaskStep &step);
+    bool waitForElement(const std::string &element, int timeout_ms, bool click, const cv::Rect &region = cv::Rect());
+    bool waitForText(const std::string &text, int timeout_ms, bool click);
+    // Waits for the first changed frame, then for TASK_SETTLE_MS without further changes
+    bool waitForScreenToSettle(int timeout_ms);
+
+    DetectionBus &bus_;
+    std::vector<std::string> class_names_;
+    std::string screenshot_dir_;
+};
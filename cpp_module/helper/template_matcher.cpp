@@ -0,0 +1,339 @@
+#include "template_matcher.hpp"
+#include "vision_kernels.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+TemplateRegistry::TemplateRegistry(const std::vector<std::string> &class_names, const std::vector<double> &scales)
+    : class_names_(class_names), scales_(scales)
+{
+    if (scales_.empty())
+        scales_.push_back(1.0);
+}
+
+bool TemplateRegistry::loadDirectory(const std::string &dir)
+{
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec))
+    {
+        LOG_ERR("Template directory not found: " << dir);
+        return false;
+    }
+
+    std::vector<std::filesystem::path> class_dirs;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, ec))
+    {
+        if (entry.is_directory())
+            class_dirs.push_back(entry.path());
+    }
+    std::sort(class_dirs.begin(), class_dirs.end());
+
+    size_t loaded = 0, classes = 0;
+    for (const std::filesystem::path &class_dir : class_dirs)
+    {
+        const std::string class_name = class_dir.filename().string();
+        if (std::find(class_names_.begin(), class_names_.end(), class_name) == class_names_.end())
+        {
+            LOG_WARN("Skipping templates for unknown class " << class_name);
+            continue;
+        }
+        std::vector<std::filesystem::path> files;
+        for (const auto &entry : std::filesystem::directory_iterator(class_dir, ec))
+        {
+            std::string ext = entry.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c)
+                           { return static_cast<char>(std::tolower(c)); });
+            if (entry.is_regular_file() && (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp"))
+                files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+        size_t class_loaded = 0;
+        for (const std::filesystem::path &file : files)
+        {
+            cv::Mat image = cv::imread(file.string(), cv::IMREAD_COLOR);
+            if (image.empty())
+            {
+                LOG_WARN("Failed to read template " << file.string());
+                continue;
+            }
+            if (addTemplate(class_name, image))
+                class_loaded++;
+        }
+        loaded += class_loaded;
+        classes += class_loaded > 0;
+    }
+    LOG("Loaded " << loaded << " templates for " << classes << " classes from " << dir);
+    return true;
+}
+
+bool TemplateRegistry::addTemplate(const std::string &class_name, const cv::Mat &image)
+{
+    auto it = std::find(class_names_.begin(), class_names_.end(), class_name);
+    if (it == class_names_.end())
+    {
+        LOG_ERR("Unknown template class: " << class_name);
+        return false;
+    }
+    if (image.empty())
+        return false;
+
+    cv::Mat gray;
+    if (image.channels() == 4)
+        cv::cvtColor(image, gray, cv::COLOR_BGRA2GRAY);
+    else if (image.channels() == 3)
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    else
+        gray = image.clone();
+
+    for (double scale : scales_)
+    {
+        Template t;
+        t.class_id = static_cast<int>(it - class_names_.begin());
+        cv::Mat scaled = gray;
+        if (scale != 1.0)
+        {
+            cv::Size size(std::max(1, static_cast<int>(std::lround(gray.cols * scale))), std::max(1, static_cast<int>(std::lround(gray.rows * scale))));
+            cv::resize(gray, scaled, size, 0, 0, scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+        }
+        if (std::min(scaled.cols, scaled.rows) < 4)
+        {
+            LOG_ERR("Template for " << class_name << " is too small at scale " << scale);
+            return false;
+        }
+
+        const double n = static_cast<double>(scaled.total());
+        double sq_sum = 0.0;
+        for (int y = 0; y < scaled.rows; ++y)
+        {
+            const uchar *row = scaled.ptr<uchar>(y);
+            for (int x = 0; x < scaled.cols; ++x)
+            {
+                t.sum += row[x];
+                sq_sum += static_cast<double>(row[x]) * row[x];
+            }
+        }
+        t.centered_sq_sum = sq_sum - static_cast<double>(t.sum) * t.sum / n;
+        if (t.centered_sq_sum < n)
+        {
+            // A flat patch correlates with nothing; it would match any other flat area
+            LOG_ERR("Template for " << class_name << " has no contrast");
+            return false;
+        }
+
+        t.levels.push_back(scaled);
+        while (static_cast<int>(t.levels.size()) <= TEMPLATE_MAX_LEVEL &&
+               std::min(t.levels.back().cols, t.levels.back().rows) / 2 >= TEMPLATE_MIN_COARSE_SIZE)
+        {
+            cv::Mat down;
+            cv::pyrDown(t.levels.back(), down);
+            t.levels.push_back(down);
+        }
+        templates_.push_back(std::move(t));
+    }
+    return true;
+}
+
+bool TemplateRegistry::has(int class_id) const
+{
+    return std::any_of(templates_.begin(), templates_.end(), [class_id](const Template &t)
+                       { return t.class_id == class_id; });
+}
+
+bool TemplateRegistry::hasAll(const std::vector<int> &class_ids) const
+{
+    return !class_ids.empty() && std::all_of(class_ids.begin(), class_ids.end(), [this](int class_id)
+                                             { return has(class_id); });
+}
+
+void TemplateRegistry::clearHints()
+{
+    for (Template &t : templates_)
+        t.last_hit = cv::Rect();
+}
+
+bool TemplateRegistry::match(const cv::Mat &screen, const std::vector<int> &class_ids, const std::vector<cv::Rect> &regions, std::vector<Detection> &out_detections)
+{
+    TRACE_SCOPE("template match");
+    if (screen.empty())
+        return false;
+
+    cv::Mat gray;
+    if (screen.channels() == 4)
+        cv::cvtColor(screen, gray, cv::COLOR_BGRA2GRAY);
+    else if (screen.channels() == 3)
+        cv::cvtColor(screen, gray, cv::COLOR_BGR2GRAY);
+    else
+        gray = screen;
+
+    const cv::Rect bounds(0, 0, gray.cols, gray.rows);
+    std::vector<SearchArea> areas;
+    for (const cv::Rect &region : regions)
+    {
+        if (!(region & bounds).empty())
+            areas.push_back({region & bounds, {}});
+    }
+    if (regions.empty())
+        areas.push_back({bounds, {}});
+
+    bool all_found = true;
+    for (int class_id : class_ids)
+    {
+        stats_.queries++;
+        float best_score = 0.0f;
+        cv::Rect best_box;
+        Template *best_template = nullptr;
+        auto consider = [&](Template &t, float score, cv::Point location)
+        {
+            if (score > best_score)
+            {
+                best_score = score;
+                best_box = cv::Rect(location, t.levels[0].size());
+                best_template = &t;
+            }
+        };
+
+        // UI elements rarely move, so the previous hit is the likeliest place
+        for (Template &t : templates_)
+        {
+            if (t.class_id != class_id || t.last_hit.empty())
+                continue;
+            const cv::Rect hint(t.last_hit.x - TEMPLATE_HINT_MARGIN, t.last_hit.y - TEMPLATE_HINT_MARGIN,
+                                t.last_hit.width + 2 * TEMPLATE_HINT_MARGIN, t.last_hit.height + 2 * TEMPLATE_HINT_MARGIN);
+            for (const SearchArea &area : areas)
+            {
+                SearchArea hint_area{hint & area.rect, {}};
+                cv::Point location;
+                consider(t, search(gray, hint_area, t, location), location);
+            }
+        }
+        if (best_score >= TEMPLATE_MATCH_THRESHOLD)
+        {
+            stats_.hint_hits++;
+        }
+        else
+        {
+            for (Template &t : templates_)
+            {
+                if (t.class_id != class_id)
+                    continue;
+                for (SearchArea &area : areas)
+                {
+                    cv::Point location;
+                    consider(t, search(gray, area, t, location), location);
+                }
+            }
+        }
+
+        if (best_score < TEMPLATE_MATCH_THRESHOLD)
+        {
+            all_found = false;
+            continue;
+        }
+        stats_.found++;
+        best_template->last_hit = best_box;
+        Detection det;
+        det.class_id = class_id;
+        det.confidence = best_score;
+        det.box = best_box;
+        out_detections.push_back(det);
+    }
+    return all_found;
+}
+
+float TemplateRegistry::search(const cv::Mat &gray, SearchArea &area, const Template &t, cv::Point &out_location)
+{
+    const cv::Size size = t.levels[0].size();
+    if (area.rect.width < size.width || area.rect.height < size.height)
+        return 0.0f;
+
+    if (area.levels.empty())
+        area.levels.push_back(gray(area.rect));
+    int level = 0;
+    while (level + 1 < static_cast<int>(t.levels.size()))
+    {
+        if (static_cast<int>(area.levels.size()) <= level + 1)
+        {
+            cv::Mat down;
+            cv::pyrDown(area.levels.back(), down);
+            area.levels.push_back(down);
+        }
+        const cv::Mat &next = area.levels[level + 1];
+        if (next.cols < t.levels[level + 1].cols || next.rows < t.levels[level + 1].rows)
+            break;
+        level++;
+    }
+
+    cv::Mat scores;
+    cv::matchTemplate(area.levels[level], t.levels[level], scores, cv::TM_CCOEFF_NORMED);
+
+    float best = 0.0f;
+    const cv::Size coarse_size = t.levels[level].size();
+    for (int k = 0; k < TEMPLATE_MAX_CANDIDATES; ++k)
+    {
+        double peak;
+        cv::Point peak_location;
+        cv::minMaxLoc(scores, nullptr, &peak, nullptr, &peak_location);
+        if (peak < TEMPLATE_COARSE_THRESHOLD)
+            break;
+        stats_.refinements++;
+
+        // A coarse pixel covers 2^level screen pixels; pyrDown's rounding adds one more
+        cv::Point location;
+        const int radius = (1 << level) + 1;
+        float score = refine(gray, area.rect, t, area.rect.tl() + cv::Point(peak_location.x << level, peak_location.y << level), radius, location);
+        if (score > best)
+        {
+            best = score;
+            out_location = location;
+        }
+        cv::Rect around(peak_location.x - coarse_size.width / 2, peak_location.y - coarse_size.height / 2, coarse_size.width, coarse_size.height);
+        scores(around & cv::Rect(0, 0, scores.cols, scores.rows)).setTo(-1.0f);
+    }
+    return best;
+}
+
+float TemplateRegistry::refine(const cv::Mat &gray, const cv::Rect &area, const Template &t, cv::Point guess, int radius, cv::Point &out_location)
+{
+    const cv::Mat &tpl = t.levels[0];
+    const int x0 = std::max(area.x, guess.x - radius);
+    const int y0 = std::max(area.y, guess.y - radius);
+    const int x1 = std::min(area.x + area.width - tpl.cols, guess.x + radius);
+    const int y1 = std::min(area.y + area.height - tpl.rows, guess.y + radius);
+    if (x0 > x1 || y0 > y1)
+        return 0.0f;
+
+    // Window sums from an integral image of just the neighbourhood; the products come from
+    // dot_u8, exact in integers, so every instruction set level scores alike
+    const cv::Rect patch(x0, y0, x1 - x0 + tpl.cols, y1 - y0 + tpl.rows);
+    cv::Mat sums, sq_sums;
+    cv::integral(gray(patch), sums, sq_sums, CV_32S, CV_64F);
+    const VisionKernels &kernels = visionKernels();
+    const double n = static_cast<double>(tpl.total());
+
+    float best = 0.0f;
+    for (int y = y0; y <= y1; ++y)
+    {
+        const int py = y - y0;
+        for (int x = x0; x <= x1; ++x)
+        {
+            const int px = x - x0;
+            const double s = static_cast<double>(sums.at<int>(py + tpl.rows, px + tpl.cols)) - sums.at<int>(py, px + tpl.cols) -
+                             sums.at<int>(py + tpl.rows, px) + sums.at<int>(py, px);
+            const double s2 = sq_sums.at<double>(py + tpl.rows, px + tpl.cols) - sq_sums.at<double>(py, px + tpl.cols) -
+                              sq_sums.at<double>(py + tpl.rows, px) + sq_sums.at<double>(py, px);
+            const double variance = s2 - s * s / n;
+            if (variance < n) // Flat window
+                continue;
+            uint64_t dot = 0;
+            for (int r = 0; r < tpl.rows; ++r)
+                dot += kernels.dot_u8(gray.ptr<uchar>(y + r) + x, tpl.ptr<uchar>(r), static_cast<size_t>(tpl.cols));
+            const double ncc = (static_cast<double>(dot) - s * static_cast<double>(t.sum) / n) / std::sqrt(variance * t.centered_sq_sum);
+            if (ncc > best)
+            {
+                best = static_cast<float>(ncc);
+                out_location = cv::Point(x, y);
+            }
+        }
+    }
+    return best;
+}
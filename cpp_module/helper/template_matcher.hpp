@@ -0,0 +1,84 @@
+#pragma once
+
+#include "yolo.hpp"
+
+// Coarsest pyramid level searched, 1/8 scale
+const int TEMPLATE_MAX_LEVEL = 3;
+// A template is searched on the coarsest level where its shorter side keeps at least this many pixels
+const int TEMPLATE_MIN_COARSE_SIZE = 12;
+// Coarse scores are blurred by the downscale, so this only has to weed out the obvious misses
+const float TEMPLATE_COARSE_THRESHOLD = 0.5f;
+// Normalized cross-correlation a match needs at full resolution
+const float TEMPLATE_MATCH_THRESHOLD = 0.85f;
+const int TEMPLATE_MAX_CANDIDATES = 8; // Coarse peaks refined per template and search area
+// Around the previous hit, searched before anything else
+const int TEMPLATE_HINT_MARGIN = 48;
+
+struct TemplateStats
+{
+    uint64_t queries = 0;   // Class lookups
+    uint64_t found = 0;
+    uint64_t hint_hits = 0; // Found again next to the previous hit
+    uint64_t refinements = 0; // Coarse candidates checked at full resolution
+};
+
+// Finds fixed-look UI elements (our own login button, a particular icon) by normalized
+// cross-correlation instead of a network pass, for the elements automation_tool.py's
+// element_map points at. Each template is cut into a pyramid once when it is added. A lookup
+// first tries the neighbourhood of the element's previous hit, then matchTemplate on a
+// downscaled pyramid level of the search areas; the few coarse peaks are refined and scored at
+// full resolution with the dot_u8 vision kernel. A lookup on a whole 1080p screen costs around
+// ten milliseconds and one near the previous hit well under one, where a yolo11l pass on the CPU
+// costs hundreds. Results are Detections with the class ids of the
+// network's class names, so callers can fall back to the network on a miss. Not thread-safe.
+class TemplateRegistry
+{
+public:
+    // Class names give the detections' class ids. Every template is also looked for at the
+    // other scales, e.g. {1.0, 1.25, 1.5} when the screen may use a display scaling the
+    // templates were not captured at.
+    explicit TemplateRegistry(const std::vector<std::string> &class_names, const std::vector<double> &scales = {1.0});
+
+    // Every image in dir/<class name>/ becomes a template of that class. Folders that name no
+    // class are skipped with a warning. Returns false if dir cannot be read.
+    bool loadDirectory(const std::string &dir);
+    // image is a tight BGR, BGRA or grayscale crop of the element
+    bool addTemplate(const std::string &class_name, const cv::Mat &image);
+
+    bool has(int class_id) const;
+    bool hasAll(const std::vector<int> &class_ids) const;
+    size_t templateCount() const { return templates_.size(); }
+
+    // Looks for each class in screen (BGR, BGRA or grayscale), only inside regions unless that
+    // is empty, and appends its best match. Returns true if every class was found.
+    bool match(const cv::Mat &screen, const std::vector<int> &class_ids, const std::vector<cv::Rect> &regions, std::vector<Detection> &out_detections);
+    // Forgets the previous hits, so the next lookups search everything again
+    void clearHints();
+    const TemplateStats &stats() const { return stats_; }
+
+private:
+    struct Template
+    {
+        int class_id = -1;
+        std::vector<cv::Mat> levels; // [0] full-resolution grayscale, then pyrDown'ed once per level
+        uint64_t sum = 0;            // Of the full-resolution pixels
+        double centered_sq_sum = 0.0; // Sum of squared differences from their mean
+        cv::Rect last_hit;           // In screen coordinates
+    };
+
+    struct SearchArea
+    {
+        cv::Rect rect;               // In screen coordinates
+        std::vector<cv::Mat> levels; // The screen inside rect, pyrDown'ed as far as some template needed
+    };
+
+    // Best location of t inside area, scored at full resolution
+    float search(const cv::Mat &gray, SearchArea &area, const Template &t, cv::Point &out_location);
+    // Best full-resolution score within radius pixels of guess
+    float refine(const cv::Mat &gray, const cv::Rect &area, const Template &t, cv::Point guess, int radius, cv::Point &out_location);
+
+    std::vector<std::string> class_names_;
+    std::vector<double> scales_;
+    std::vector<Template> templates_;
+    TemplateStats stats_;
+};
@@ -0,0 +1,412 @@
+#include "trace.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <process.h>
+#define TRACE_SIGNAL SIGBREAK
+#else
+#include <unistd.h>
+#define TRACE_SIGNAL SIGUSR2
+#endif
+
+std::atomic<bool> g_tracing_active{false};
+
+namespace
+{
+    struct TraceSpan
+    {
+        const char *name = nullptr;
+        int64_t begin_ns = 0;
+        int64_t end_ns = 0;
+        int64_t frame_id = -1;
+        int source = -1;
+        int tid = 0; // Filled in by the collector
+    };
+
+    // Single producer (the owning thread), single consumer (the collector)
+    struct TraceRing
+    {
+        TraceSpan slots[TRACE_RING_CAPACITY];
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> orphaned{false};
+        int tid = 0;
+    };
+
+    static_assert((TRACE_RING_CAPACITY & (TRACE_RING_CAPACITY - 1)) == 0, "TRACE_RING_CAPACITY must be a power of two");
+
+    std::atomic<bool> g_trace_signalled{false};
+
+    void onTraceSignal(int)
+    {
+        g_trace_signalled.store(true, std::memory_order_relaxed);
+#ifdef _WIN32
+        std::signal(TRACE_SIGNAL, onTraceSignal); // The CRT resets the handler before calling it
+#endif
+    }
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int processId()
+    {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+
+    void appendJsonString(std::string &out, const std::string &text)
+    {
+        out += '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20)
+                out += c;
+        }
+        out += '"';
+    }
+
+    class Tracer
+    {
+    public:
+        static Tracer &instance()
+        {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        ~Tracer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                watcher_stop_ = true;
+            }
+            watcher_wake_.notify_all();
+            if (watcher_.joinable())
+                watcher_.join();
+            stop(); // A trace still running at exit is written rather than lost
+            if (collector_.joinable())
+                collector_.join();
+        }
+
+        TraceRing &threadRing()
+        {
+            struct Owner
+            {
+                std::shared_ptr<TraceRing> ring;
+                ~Owner()
+                {
+                    if (ring)
+                        ring->orphaned.store(true, std::memory_order_release);
+                }
+            };
+            thread_local Owner owner;
+            if (!owner.ring)
+            {
+                owner.ring = std::make_shared<TraceRing>();
+                std::lock_guard<std::mutex> lock(mutex_);
+                owner.ring->tid = ++last_tid_;
+                rings_.push_back(owner.ring);
+            }
+            return *owner.ring;
+        }
+
+        void setThreadName(const std::string &name)
+        {
+            TraceRing &ring = threadRing();
+            std::lock_guard<std::mutex> lock(mutex_);
+            thread_names_[ring.tid] = name;
+        }
+
+        bool start(double seconds, const std::string &path)
+        {
+            std::lock_guard<std::mutex> start_lock(start_mutex_); // The flag and the signal may race
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (session_running_)
+                return false;
+            // The previous collector has finished its file by now; only the thread is left
+            if (collector_.joinable())
+            {
+                lock.unlock();
+                collector_.join();
+                lock.lock();
+                if (session_running_)
+                    return false;
+            }
+            // Spans that straddled the end of the previous trace would show up out of place
+            for (const auto &ring : rings_)
+                ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+            spans_.clear();
+            dropped_ = 0;
+            path_ = path;
+            stop_requested_ = false;
+            session_running_ = true;
+            session_start_ns_ = nowNs();
+            deadline_ns_ = seconds > 0.0 ? session_start_ns_ + static_cast<int64_t>(seconds * 1e9) : 0;
+            g_tracing_active.store(true, std::memory_order_relaxed);
+            collector_ = std::thread(&Tracer::collect, this);
+            if (seconds > 0.0)
+            {
+                LOG("Tracing for " << seconds << " s to " << path);
+            }
+            else
+            {
+                LOG("Tracing to " << path << " until stopped");
+            }
+            return true;
+        }
+
+        void stop()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!session_running_)
+                return;
+            stop_requested_ = true;
+            wake_.notify_all();
+            finished_.wait(lock, [&]
+                           { return !session_running_; });
+        }
+
+        void arm(double seconds, const std::string &path_prefix)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            signal_seconds_ = seconds;
+            signal_path_prefix_ = path_prefix;
+            if (watcher_.joinable())
+                return;
+            std::signal(TRACE_SIGNAL, onTraceSignal);
+            // The handler only sets a flag; starting threads and allocating happens here
+            watcher_ = std::thread(&Tracer::watch, this);
+        }
+
+    private:
+        Tracer()
+        {
+            // Constructs the logger first, so it is still there when this destructor reports
+            flushLogs();
+        }
+
+        void drain()
+        {
+            std::vector<std::shared_ptr<TraceRing>> rings;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings = rings_;
+            }
+            for (const auto &ring : rings)
+            {
+                uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+                uint64_t head = ring->head.load(std::memory_order_acquire);
+                for (; tail != head; ++tail)
+                {
+                    spans_.push_back(ring->slots[tail & (TRACE_RING_CAPACITY - 1)]);
+                    spans_.back().tid = ring->tid;
+                }
+                ring->tail.store(tail, std::memory_order_release);
+                dropped_ += ring->dropped.exchange(0, std::memory_order_relaxed);
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<TraceRing> &r)
+                                        { return r->orphaned.load(std::memory_order_acquire) &&
+                                                 r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire); }),
+                         rings_.end());
+        }
+
+        void collect()
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wake_.wait_for(lock, std::chrono::milliseconds(TRACE_DRAIN_INTERVAL_MS), [&]
+                                   { return stop_requested_; });
+                    if (stop_requested_ || (deadline_ns_ && nowNs() >= deadline_ns_))
+                        break;
+                }
+                drain();
+            }
+            g_tracing_active.store(false, std::memory_order_relaxed);
+            // Lets spans that began just before the switch close; longer ones are cut off
+            std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_DRAIN_INTERVAL_MS));
+            drain();
+            write();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            session_running_ = false;
+            finished_.notify_all();
+        }
+
+        void write()
+        {
+            std::sort(spans_.begin(), spans_.end(), [](const TraceSpan &a, const TraceSpan &b)
+                      {
+                if (a.tid != b.tid)
+                    return a.tid < b.tid;
+                if (a.begin_ns != b.begin_ns)
+                    return a.begin_ns < b.begin_ns;
+                return a.end_ns > b.end_ns; });
+
+            std::map<int, std::string> names;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                names = thread_names_;
+            }
+            const int pid = processId();
+            std::string out = "{\"traceEvents\":[\n";
+            char line[256];
+            std::snprintf(line, sizeof(line), "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"agent\"}}", pid);
+            out += line;
+            int last_tid = 0;
+            for (const TraceSpan &span : spans_)
+            {
+                if (span.tid != last_tid)
+                {
+                    last_tid = span.tid;
+                    auto name = names.find(span.tid);
+                    std::snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":", pid, span.tid);
+                    out += line;
+                    appendJsonString(out, name != names.end() ? name->second : "thread " + std::to_string(span.tid));
+                    out += "}}";
+                }
+                // Spans that began before the trace started are clipped to it
+                const int64_t begin_ns = std::max(span.begin_ns, session_start_ns_);
+                std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"pipeline\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d",
+                              span.name, (begin_ns - session_start_ns_) / 1e3, std::max<int64_t>(0, span.end_ns - begin_ns) / 1e3, pid, span.tid);
+                out += line;
+                if (span.frame_id >= 0 && span.source >= 0)
+                    std::snprintf(line, sizeof(line), ",\"args\":{\"frame\":%lld,\"source\":%d}}", static_cast<long long>(span.frame_id), span.source);
+                else if (span.frame_id >= 0)
+                    std::snprintf(line, sizeof(line), ",\"args\":{\"frame\":%lld}}", static_cast<long long>(span.frame_id));
+                else
+                    std::snprintf(line, sizeof(line), "}");
+                out += line;
+            }
+            std::snprintf(line, sizeof(line), "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":\"%llu\"}}\n", static_cast<unsigned long long>(dropped_));
+            out += line;
+
+            std::ofstream file(path_, std::ios::binary);
+            if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size())))
+            {
+                LOG_ERR("Failed to write trace to " << path_);
+                return;
+            }
+            LOG("Wrote " << spans_.size() << " spans to " << path_ << " (open in ui.perfetto.dev or chrome://tracing)");
+            if (dropped_ > 0)
+                LOG_WARN("Trace ring full, dropped " << dropped_ << " spans");
+        }
+
+        void watch()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!watcher_stop_)
+            {
+                watcher_wake_.wait_for(lock, std::chrono::milliseconds(100));
+                if (watcher_stop_ || !g_trace_signalled.exchange(false, std::memory_order_relaxed))
+                    continue;
+                const double seconds = signal_seconds_;
+                const std::string prefix = signal_path_prefix_;
+                lock.unlock();
+                char stamp[32];
+                std::time_t now = std::time(nullptr);
+                std::tm local{};
+#ifdef _WIN32
+                localtime_s(&local, &now);
+#else
+                localtime_r(&now, &local);
+#endif
+                std::strftime(stamp, sizeof(stamp), "_%Y%m%d-%H%M%S.json", &local);
+                if (!start(seconds, prefix + stamp))
+                    LOG_WARN("Ignoring " << TRACE_SIGNAL_NAME << ": a trace is already running");
+                lock.lock();
+            }
+        }
+
+        std::mutex start_mutex_;
+        std::mutex mutex_;
+        std::vector<std::shared_ptr<TraceRing>> rings_;
+        std::map<int, std::string> thread_names_;
+        int last_tid_ = 0;
+
+        // Session state; spans_ and dropped_ belong to the collector while a session runs
+        std::thread collector_;
+        std::condition_variable wake_;
+        std::condition_variable finished_;
+        bool session_running_ = false;
+        bool stop_requested_ = false;
+        int64_t session_start_ns_ = 0;
+        int64_t deadline_ns_ = 0;
+        std::string path_;
+        std::vector<TraceSpan> spans_;
+        uint64_t dropped_ = 0;
+
+        std::thread watcher_;
+        std::condition_variable watcher_wake_;
+        bool watcher_stop_ = false;
+        double signal_seconds_ = TRACE_DEFAULT_SECONDS;
+        std::string signal_path_prefix_;
+    };
+}
+
+void TraceScope::begin(const char *name, int64_t frame_id, int source)
+{
+    name_ = name;
+    frame_id_ = frame_id;
+    source_ = source;
+    begin_ns_ = nowNs();
+}
+
+void TraceScope::end()
+{
+    TraceRing &ring = Tracer::instance().threadRing();
+    uint64_t h = ring.head.load(std::memory_order_relaxed);
+    if (h - ring.tail.load(std::memory_order_acquire) >= TRACE_RING_CAPACITY)
+    {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceSpan &span = ring.slots[h & (TRACE_RING_CAPACITY - 1)];
+    span.name = name_;
+    span.begin_ns = begin_ns_;
+    span.end_ns = nowNs();
+    span.frame_id = frame_id_;
+    span.source = source_;
+    ring.head.store(h + 1, std::memory_order_release);
+}
+
+void setTraceThreadName(const std::string &name)
+{
+    Tracer::instance().setThreadName(name);
+}
+
+bool startTracing(double seconds, const std::string &path)
+{
+    return Tracer::instance().start(seconds, path);
+}
+
+void stopTracing()
+{
+    Tracer::instance().stop();
+}
+
+void armTraceSignal(double seconds, const std::string &path_prefix)
+{
+    Tracer::instance().arm(seconds, path_prefix);
+}
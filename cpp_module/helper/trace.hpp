@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Timeline tracing for the pipeline threads. While a trace runs, every TRACE_SCOPE records a
+// begin/end span (stage name, thread, frame id) into its thread's lock-free ring; a collector
+// thread drains the rings and, when the trace ends, writes Chrome trace-event JSON that
+// chrome://tracing and ui.perfetto.dev open directly. Outside a trace a scope costs one relaxed
+// atomic load, so the instrumentation stays in release builds.
+//
+//   TRACE_SCOPE("capture")                  span on this thread
+//   TRACE_SCOPE_FRAME("detect", frame_id)   span tagged with the frame it worked on
+//   TRACE_SCOPE_SOURCE("read", frame_id, source)
+//
+// Span names must be string literals. A trace is started with startTracing() (the agents' --trace
+// flag) or, once armTraceSignal() was called, by sending TRACE_SIGNAL to the running process.
+
+const size_t TRACE_RING_CAPACITY = 4096; // Spans per thread between two collector passes, power of two
+const int TRACE_DRAIN_INTERVAL_MS = 20;
+const double TRACE_DEFAULT_SECONDS = 10.0;
+
+extern std::atomic<bool> g_tracing_active;
+
+inline bool tracingActive()
+{
+    return g_tracing_active.load(std::memory_order_relaxed);
+}
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name, int64_t frame_id = -1, int source = -1)
+    {
+        if (tracingActive())
+            begin(name, frame_id, source);
+    }
+    ~TraceScope()
+    {
+        if (name_)
+            end();
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    void begin(const char *name, int64_t frame_id, int source);
+    void end();
+
+    const char *name_ = nullptr;
+    int64_t begin_ns_ = 0;
+    int64_t frame_id_ = -1;
+    int source_ = -1;
+};
+
+// Shown as the thread's track name; the first call on a thread wins until it is renamed
+void setTraceThreadName(const std::string &name);
+
+// Records for `seconds` (0 until stopTracing) and then writes the trace to path. Returns false if
+// a trace is already running.
+bool startTracing(double seconds, const std::string &path);
+// Ends the running trace, if any, and waits until its file is written
+void stopTracing();
+// Installs a TRACE_SIGNAL handler that starts a trace of `seconds`; each one is written next to
+// path_prefix with the start time appended (agent_trace_20240101-120000.json)
+void armTraceSignal(double seconds, const std::string &path_prefix);
+
+#ifdef _WIN32
+#define TRACE_SIGNAL_NAME "SIGBREAK (Ctrl+Break)"
+#else
+#define TRACE_SIGNAL_NAME "SIGUSR2"
+#endif
+
+#define AGENT_TRACE_CONCAT_(a, b) a##b
+#define AGENT_TRACE_CONCAT(a, b) AGENT_TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope AGENT_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_SCOPE_FRAME(name, frame_id) TraceScope AGENT_TRACE_CONCAT(trace_scope_, __LINE__)(name, frame_id)
+#define TRACE_SCOPE_SOURCE(name, frame_id, source) TraceScope AGENT_TRACE_CONCAT(trace_scope_, __LINE__)(name, frame_id, source)
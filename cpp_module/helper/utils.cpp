@@ -1,4 +1,16 @@
 #include "utils.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 bool setUpEnv()
 {
@@ -13,7 +25,11 @@ bool setUpEnv()
         }
     }
 
+#ifdef _WIN32
     if (_putenv_s("OPENCV_OCL4DNN_CONFIG_PATH", opencv_kernel.generic_string().c_str()) != 0)
+#else
+    if (setenv("OPENCV_OCL4DNN_CONFIG_PATH", opencv_kernel.generic_string().c_str(), 1) != 0)
+#endif
     {
         LOG_ERR("SET Kernel Cache ENV Failed");
         return false;
@@ -65,4 +81,180 @@ void detectSystemArch(HARDWARE_INFO &hw_info)
             }
         }
     }
-}
\ No newline at end of file
+}
+
+void detectSystemArchCached(HARDWARE_INFO &hw_info, const std::string &cache_path)
+{
+    const char *reprobe = std::getenv("AGENT_REPROBE_HARDWARE");
+    const bool force_probe = reprobe && std::string(reprobe) == "1";
+
+    std::error_code ec;
+    auto written = std::filesystem::last_write_time(cache_path, ec);
+    const bool fresh = !ec && std::filesystem::file_time_type::clock::now() - written < std::chrono::hours(HARDWARE_CACHE_MAX_AGE_HOURS);
+
+    std::ifstream ifs(cache_path);
+    if (!force_probe && fresh && ifs.is_open())
+    {
+        std::map<std::string, std::string> values;
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            size_t eq = line.find('=');
+            if (eq != std::string::npos)
+                values[line.substr(0, eq)] = line.substr(eq + 1);
+        }
+        if (values["opencv"] == cv::getVersionString())
+        {
+            hw_info.has_cuda = values["cuda"] == "1";
+            hw_info.has_opencl = values["opencl"] == "1";
+            hw_info.has_amd = values["amd"] == "1";
+            hw_info.has_intel = values["intel"] == "1";
+            hw_info.has_nvidia = values["nvidia"] == "1";
+            hw_info.gpu_name = values["gpu_name"];
+            hw_info.gpu_vendor = values["gpu_vendor"];
+            LOG("Using cached hardware probe from " << cache_path);
+            return;
+        }
+    }
+    ifs.close();
+
+    detectSystemArch(hw_info);
+
+    std::ofstream ofs(cache_path, std::ios::trunc);
+    if (!ofs.is_open())
+    {
+        LOG_ERR("Failed to write hardware probe cache: " << cache_path);
+        return;
+    }
+    ofs << "opencv=" << cv::getVersionString() << "\n"
+        << "cuda=" << hw_info.has_cuda << "\n"
+        << "opencl=" << hw_info.has_opencl << "\n"
+        << "amd=" << hw_info.has_amd << "\n"
+        << "intel=" << hw_info.has_intel << "\n"
+        << "nvidia=" << hw_info.has_nvidia << "\n"
+        << "gpu_name=" << hw_info.gpu_name << "\n"
+        << "gpu_vendor=" << hw_info.gpu_vendor << "\n";
+}
+
+StartupTrace::StartupTrace()
+    : start_(std::chrono::steady_clock::now())
+{
+}
+
+void StartupTrace::mark(const std::string &step)
+{
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    marks_.emplace_back(step, ms);
+}
+
+void StartupTrace::firstFrame()
+{
+    if (reported_.exchange(true))
+        return;
+
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    LOG_REPORT("Startup trace:");
+    for (const auto &mark : marks_)
+    {
+        LOG_REPORT(cv::format("  %8.1f ms  ", mark.second) << mark.first);
+    }
+    LOG_REPORT("Time to first annotated frame: " << cv::format("%.1f", total_ms) << " ms");
+}
+
+uint64_t hashMatRegion(const cv::Mat &image, const cv::Rect &region)
+{
+    const cv::Rect roi = region & cv::Rect(0, 0, image.cols, image.rows);
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = 0xCBF29CE484222325ull ^ (static_cast<uint64_t>(roi.width) << 32 | static_cast<uint32_t>(roi.height));
+
+    if (roi.empty())
+        return hash;
+
+    const size_t row_bytes = static_cast<size_t>(roi.width) * image.elemSize();
+    for (int y = roi.y; y < roi.y + roi.height; ++y)
+    {
+        const uchar *row = image.ptr<uchar>(y) + roi.x * image.elemSize();
+        size_t i = 0;
+        // Mix eight bytes at a time; the tail is folded in byte by byte
+        for (; i + 8 <= row_bytes; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, row + i, sizeof(word));
+            hash = (hash ^ word) * PRIME;
+            hash ^= hash >> 29;
+        }
+        for (; i < row_bytes; ++i)
+        {
+            hash = (hash ^ row[i]) * PRIME;
+        }
+    }
+    return hash;
+}
+
+std::vector<std::string> splitString(const std::string &text, char delimiter)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, delimiter))
+    {
+        if (!item.empty())
+            items.push_back(item);
+    }
+    return items;
+}
+
+std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            out += cv::format("\\u%04x", static_cast<unsigned char>(c));
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+
+size_t getCurrentRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.WorkingSetSize;
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0, resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages))
+        return 0;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+size_t getPeakRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // Reported in kilobytes on Linux
+#endif
+}
@@ -1,12 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <opencv2/core/ocl.hpp>
 
-#define LOG(...) std::cout << "[INFO] " << __VA_ARGS__ << std::endl;
-#define LOG_ERR(...) std::cout << "[ERROR] " << __VA_ARGS__ << std::endl;
+#include "logger.hpp"
+#include "trace.hpp"
 
 struct HARDWARE_INFO
 {
@@ -20,4 +23,40 @@ struct HARDWARE_INFO
 };
 
 bool setUpEnv();
-void detectSystemArch(HARDWARE_INFO &hw_info);
\ No newline at end of file
+void detectSystemArch(HARDWARE_INFO &hw_info);
+// Reuses a previous probe stored at cache_path when it was written by the same OpenCV build less
+// than HARDWARE_CACHE_MAX_AGE_HOURS ago; otherwise probes and rewrites the cache. Set
+// AGENT_REPROBE_HARDWARE=1 to force a fresh probe after driver or GPU changes.
+void detectSystemArchCached(HARDWARE_INFO &hw_info, const std::string &cache_path);
+
+const int HARDWARE_CACHE_MAX_AGE_HOURS = 24 * 7;
+
+// Milestones from process start to the first annotated frame. mark() may be called from any
+// thread; firstFrame() logs the timeline once, so it is cheap to call on every frame.
+class StartupTrace
+{
+public:
+    StartupTrace();
+    void mark(const std::string &step);
+    void firstFrame();
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    std::mutex mutex_;
+    std::vector<std::pair<std::string, double>> marks_;
+    std::atomic<bool> reported_{false};
+};
+
+// Fast 64-bit content hash of an image region (not cryptographic).
+// Used to key caches on pixel content, so identical regions hash equal.
+uint64_t hashMatRegion(const cv::Mat &image, const cv::Rect &region);
+
+// Splits "a,b,c" style command-line lists, dropping empty items
+std::vector<std::string> splitString(const std::string &text, char delimiter);
+// Escapes text for use inside a JSON string literal
+std::string jsonEscape(const std::string &text);
+
+// Resident memory of this process in bytes; 0 if it cannot be read
+size_t getCurrentRssBytes();
+// High-water mark of resident memory since process start
+size_t getPeakRssBytes();
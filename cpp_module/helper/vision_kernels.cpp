@@ -0,0 +1,71 @@
+#include "vision_kernels.hpp"
+
+static void updateClassArgmaxScalar(const float *row, int n, int class_id, float *best_scores, int *best_classes)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (row[i] > best_scores[i])
+        {
+            best_scores[i] = row[i];
+            best_classes[i] = class_id;
+        }
+    }
+}
+
+static int maxAbsDiffU8Scalar(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    int max_diff = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        int diff = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (diff > max_diff)
+            max_diff = diff;
+    }
+    return max_diff;
+}
+
+static uint32_t dotU8Scalar(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < n; ++i)
+        sum += static_cast<uint32_t>(a[i]) * b[i];
+    return sum;
+}
+
+const VisionKernels VISION_KERNELS_SCALAR = {
+    CpuIsa::Scalar,
+    &updateClassArgmaxScalar,
+    &maxAbsDiffU8Scalar,
+    &dotU8Scalar,
+};
+
+const VisionKernels *visionKernelsFor(CpuIsa isa)
+{
+    if (isa > detectCpuIsa())
+        return nullptr;
+    switch (isa)
+    {
+    case CpuIsa::Scalar:
+        return &VISION_KERNELS_SCALAR;
+#ifdef AGENT_VISION_KERNELS_X86
+    case CpuIsa::SSE42:
+        return &VISION_KERNELS_SSE42;
+    case CpuIsa::AVX2:
+        return &VISION_KERNELS_AVX2;
+    case CpuIsa::AVX512:
+        return &VISION_KERNELS_AVX512;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const VisionKernels &visionKernels()
+{
+    static const VisionKernels &kernels = []() -> const VisionKernels &
+    {
+        const VisionKernels *k = visionKernelsFor(selectedCpuIsa());
+        return k ? *k : VISION_KERNELS_SCALAR;
+    }();
+    return kernels;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "cpu_features.hpp"
+
+// Hand-vectorized inner loops, built once per instruction set level (vision_kernels_*.cpp are
+// compiled with their own -m/arch flags) and picked at startup from selectedCpuIsa(). Every
+// variant must return bit-identical results to the scalar one; bench_kernels checks this.
+// The per-level files must not call inline or template library code: the linker may keep
+// their copy, built with wider instructions, for the whole program.
+struct VisionKernels
+{
+    CpuIsa isa;
+    // For i < n: if row[i] > best_scores[i], best_scores[i] = row[i] and best_classes[i] = class_id.
+    // One call per class score row of a [4 + C, N] YOLO output.
+    void (*update_class_argmax)(const float *row, int n, int class_id, float *best_scores, int *best_classes);
+    // max |a[i] - b[i]| over n bytes, e.g. to tell whether two images differ visibly
+    int (*max_abs_diff_u8)(const uint8_t *a, const uint8_t *b, size_t n);
+    // sum of a[i] * b[i] over n bytes, modulo 2^32 (exact for n <= 66051); one template row of
+    // a normalized cross-correlation
+    uint32_t (*dot_u8)(const uint8_t *a, const uint8_t *b, size_t n);
+};
+
+// Kernels for selectedCpuIsa()
+const VisionKernels &visionKernels();
+// Kernels for a specific level; nullptr if that level was not compiled in or this CPU lacks it
+const VisionKernels *visionKernelsFor(CpuIsa isa);
+
+// Per-level tables, each defined in its own translation unit
+extern const VisionKernels VISION_KERNELS_SCALAR;
+#ifdef AGENT_VISION_KERNELS_X86
+extern const VisionKernels VISION_KERNELS_SSE42;
+extern const VisionKernels VISION_KERNELS_AVX2;
+extern const VisionKernels VISION_KERNELS_AVX512;
+#endif
@@ -0,0 +1,77 @@
+#include "vision_kernels.hpp"
+#include <immintrin.h>
+
+static void updateClassArgmaxAvx2(const float *row, int n, int class_id, float *best_scores, int *best_classes)
+{
+    const __m256i cls = _mm256_set1_epi32(class_id);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(row + i);
+        __m256 best = _mm256_loadu_ps(best_scores + i);
+        __m256 greater = _mm256_cmp_ps(v, best, _CMP_GT_OQ); // Ordered: false for NaN, like the scalar '>'
+        _mm256_storeu_ps(best_scores + i, _mm256_blendv_ps(best, v, greater));
+        __m256i classes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(best_classes + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(best_classes + i), _mm256_blendv_epi8(classes, cls, _mm256_castps_si256(greater)));
+    }
+    for (; i < n; ++i)
+    {
+        if (row[i] > best_scores[i])
+        {
+            best_scores[i] = row[i];
+            best_classes[i] = class_id;
+        }
+    }
+}
+
+static int maxAbsDiffU8Avx2(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        acc = _mm256_max_epu8(acc, _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va)));
+    }
+    alignas(32) uint8_t lanes[32];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    int max_diff = 0;
+    for (uint8_t lane : lanes)
+        max_diff = lane > max_diff ? lane : max_diff;
+    for (; i < n; ++i)
+    {
+        int diff = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (diff > max_diff)
+            max_diff = diff;
+    }
+    return max_diff;
+}
+
+static uint32_t dotU8Avx2(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(va)), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(vb))));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(va, 1)), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(vb, 1))));
+    }
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    uint32_t sum = 0;
+    for (uint32_t lane : lanes)
+        sum += lane;
+    for (; i < n; ++i)
+        sum += static_cast<uint32_t>(a[i]) * b[i];
+    return sum;
+}
+
+const VisionKernels VISION_KERNELS_AVX2 = {
+    CpuIsa::AVX2,
+    &updateClassArgmaxAvx2,
+    &maxAbsDiffU8Avx2,
+    &dotU8Avx2,
+};
@@ -0,0 +1,84 @@
+#include "vision_kernels.hpp"
+#include <immintrin.h>
+
+static void updateClassArgmaxAvx512(const float *row, int n, int class_id, float *best_scores, int *best_classes)
+{
+    const __m512i cls = _mm512_set1_epi32(class_id);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512 v = _mm512_loadu_ps(row + i);
+        __m512 best = _mm512_loadu_ps(best_scores + i);
+        __mmask16 greater = _mm512_cmp_ps_mask(v, best, _CMP_GT_OQ);
+        _mm512_storeu_ps(best_scores + i, _mm512_mask_mov_ps(best, greater, v));
+        __m512i classes = _mm512_loadu_si512(best_classes + i);
+        _mm512_storeu_si512(best_classes + i, _mm512_mask_mov_epi32(classes, greater, cls));
+    }
+    // The tail uses masked loads and stores instead of a scalar loop
+    if (i < n)
+    {
+        const __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 v = _mm512_maskz_loadu_ps(tail, row + i);
+        __m512 best = _mm512_maskz_loadu_ps(tail, best_scores + i);
+        __mmask16 greater = _mm512_mask_cmp_ps_mask(tail, v, best, _CMP_GT_OQ);
+        _mm512_mask_storeu_ps(best_scores + i, greater, v);
+        _mm512_mask_storeu_epi32(best_classes + i, greater, cls);
+    }
+}
+
+static int maxAbsDiffU8Avx512(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + i);
+        acc = _mm512_max_epu8(acc, _mm512_or_si512(_mm512_subs_epu8(va, vb), _mm512_subs_epu8(vb, va)));
+    }
+    if (i < n)
+    {
+        const __mmask64 tail = (1ull << (n - i)) - 1;
+        __m512i va = _mm512_maskz_loadu_epi8(tail, a + i);
+        __m512i vb = _mm512_maskz_loadu_epi8(tail, b + i);
+        acc = _mm512_max_epu8(acc, _mm512_or_si512(_mm512_subs_epu8(va, vb), _mm512_subs_epu8(vb, va)));
+    }
+    alignas(64) uint8_t lanes[64];
+    _mm512_store_si512(lanes, acc);
+    int max_diff = 0;
+    for (uint8_t lane : lanes)
+        max_diff = lane > max_diff ? lane : max_diff;
+    return max_diff;
+}
+
+static uint32_t dotU8Avx512(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(_mm512_cvtepu8_epi16(va), _mm512_cvtepu8_epi16(vb)));
+    }
+    if (i < n)
+    {
+        const __mmask64 tail = (1ull << (n - i)) - 1;
+        __m256i va = _mm512_castsi512_si256(_mm512_maskz_loadu_epi8(tail, a + i));
+        __m256i vb = _mm512_castsi512_si256(_mm512_maskz_loadu_epi8(tail, b + i));
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(_mm512_cvtepu8_epi16(va), _mm512_cvtepu8_epi16(vb)));
+    }
+    alignas(64) uint32_t lanes[16];
+    _mm512_store_si512(lanes, acc);
+    uint32_t sum = 0;
+    for (uint32_t lane : lanes)
+        sum += lane;
+    return sum;
+}
+
+const VisionKernels VISION_KERNELS_AVX512 = {
+    CpuIsa::AVX512,
+    &updateClassArgmaxAvx512,
+    &maxAbsDiffU8Avx512,
+    &dotU8Avx512,
+};
@@ -0,0 +1,78 @@
+#include "vision_kernels.hpp"
+#include <nmmintrin.h>
+
+static void updateClassArgmaxSse42(const float *row, int n, int class_id, float *best_scores, int *best_classes)
+{
+    const __m128i cls = _mm_set1_epi32(class_id);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(row + i);
+        __m128 best = _mm_loadu_ps(best_scores + i);
+        __m128 greater = _mm_cmpgt_ps(v, best); // False for NaN, like the scalar '>'
+        _mm_storeu_ps(best_scores + i, _mm_blendv_ps(best, v, greater));
+        __m128i classes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(best_classes + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(best_classes + i), _mm_blendv_epi8(classes, cls, _mm_castps_si128(greater)));
+    }
+    for (; i < n; ++i)
+    {
+        if (row[i] > best_scores[i])
+        {
+            best_scores[i] = row[i];
+            best_classes[i] = class_id;
+        }
+    }
+}
+
+static int maxAbsDiffU8Sse42(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        // One of the two saturating differences is zero, the other is |a - b|
+        acc = _mm_max_epu8(acc, _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)));
+    }
+    alignas(16) uint8_t lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    int max_diff = 0;
+    for (uint8_t lane : lanes)
+        max_diff = lane > max_diff ? lane : max_diff;
+    for (; i < n; ++i)
+    {
+        int diff = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (diff > max_diff)
+            max_diff = diff;
+    }
+    return max_diff;
+}
+
+static uint32_t dotU8Sse42(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    // Widened to 16 bits, madd sums pairs of products into 32-bit lanes; wrapping adds match
+    // the scalar uint32_t sum
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_cvtepu8_epi16(va), _mm_cvtepu8_epi16(vb)));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(va, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(vb, 8))));
+    }
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    uint32_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i)
+        sum += static_cast<uint32_t>(a[i]) * b[i];
+    return sum;
+}
+
+const VisionKernels VISION_KERNELS_SSE42 = {
+    CpuIsa::SSE42,
+    &updateClassArgmaxSse42,
+    &maxAbsDiffU8Sse42,
+    &dotU8Sse42,
+};
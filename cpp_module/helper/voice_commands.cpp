@@ -0,0 +1,438 @@
+#include "voice_commands.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <vosk_api.h>
+#ifdef AGENT_HAS_PORTAUDIO
+#include <portaudio.h>
+#endif
+
+struct VoiceState
+{
+    VoskModel *model = nullptr;
+    VoskRecognizer *recognizer = nullptr;
+};
+
+AudioRing::AudioRing(size_t min_capacity)
+{
+    size_t capacity = 1;
+    while (capacity < min_capacity)
+        capacity <<= 1;
+    buffer_.resize(capacity);
+    mask_ = capacity - 1;
+}
+
+size_t AudioRing::push(const int16_t *samples, size_t count)
+{
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    const size_t free = buffer_.size() - static_cast<size_t>(head - tail_.load(std::memory_order_acquire));
+    const size_t n = std::min(count, free);
+    // At most two runs: up to the end of the buffer, then from its start
+    const size_t start = static_cast<size_t>(head & mask_);
+    const size_t first = std::min(n, buffer_.size() - start);
+    std::memcpy(&buffer_[start], samples, first * sizeof(int16_t));
+    std::memcpy(&buffer_[0], samples + first, (n - first) * sizeof(int16_t));
+    last_push_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(),
+                        std::memory_order_relaxed);
+    head_.store(head + n, std::memory_order_release);
+    if (n < count)
+        dropped_.fetch_add(count - n, std::memory_order_relaxed);
+    return n;
+}
+
+size_t AudioRing::pop(int16_t *out, size_t max_count)
+{
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t n = std::min(max_count, static_cast<size_t>(head_.load(std::memory_order_acquire) - tail));
+    const size_t start = static_cast<size_t>(tail & mask_);
+    const size_t first = std::min(n, buffer_.size() - start);
+    std::memcpy(out, &buffer_[start], first * sizeof(int16_t));
+    std::memcpy(out + first, &buffer_[0], (n - first) * sizeof(int16_t));
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+size_t AudioRing::available() const
+{
+    return static_cast<size_t>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+}
+
+std::chrono::steady_clock::time_point AudioRing::lastPushTime() const
+{
+    const std::chrono::nanoseconds since_epoch(last_push_ns_.load(std::memory_order_relaxed));
+    return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(since_epoch));
+}
+
+std::string normalizeCommandPhrase(std::string text)
+{
+    for (char &c : text)
+        c = std::isspace(static_cast<unsigned char>(c)) ? ' ' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    std::string out;
+    for (const std::string &word : splitString(text, ' '))
+        out += (out.empty() ? "" : " ") + word;
+    return out;
+}
+
+bool loadCommandPhrases(const std::string &path, std::vector<std::string> &out_phrases)
+{
+    out_phrases.clear();
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+    {
+        LOG_ERR("Failed to open command phrases file: " << path);
+        return false;
+    }
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        line = normalizeCommandPhrase(line);
+        if (!line.empty() && line[0] != '#')
+            out_phrases.push_back(line);
+    }
+    if (out_phrases.empty())
+    {
+        LOG_ERR("No command phrases in " << path);
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> defaultCommandPhrases()
+{
+    return {"open chrome", "open notepad", "screenshot", "take screenshot", "read text", "execute tasks", "go to", "log in", "type", "stop listening"};
+}
+
+VoiceCommandRecognizer::VoiceCommandRecognizer(const VoiceOptions &options)
+    : options_(options), ring_(static_cast<size_t>(options.sample_rate) * VOICE_RING_MS / 1000)
+{
+}
+
+VoiceCommandRecognizer::~VoiceCommandRecognizer()
+{
+    stop();
+    if (state_)
+    {
+        if (state_->recognizer)
+            vosk_recognizer_free(state_->recognizer);
+        if (state_->model)
+            vosk_model_free(state_->model);
+    }
+}
+
+bool VoiceCommandRecognizer::load(const std::string &model_dir, const std::vector<std::string> &phrases)
+{
+    if (state_)
+        return false;
+    vosk_set_log_level(-1);
+    auto state = std::make_unique<VoiceState>();
+    state->model = vosk_model_new(model_dir.c_str());
+    if (!state->model)
+    {
+        LOG_ERR("Failed to load Vosk model from " << model_dir);
+        return false;
+    }
+
+    // Vosk rejects a grammar with one unknown word outright; drop just that phrase instead
+    phrases_.clear();
+    for (const std::string &raw : phrases)
+    {
+        const std::string phrase = normalizeCommandPhrase(raw);
+        bool known = !phrase.empty();
+        for (const std::string &word : splitString(phrase, ' '))
+        {
+            if (vosk_model_find_word(state->model, word.c_str()) < 0)
+            {
+                LOG_WARN("Voice command \"" << phrase << "\" skipped: the model does not know \"" << word << "\"");
+                known = false;
+                break;
+            }
+        }
+        if (known && std::find(phrases_.begin(), phrases_.end(), phrase) == phrases_.end())
+            phrases_.push_back(phrase);
+    }
+    if (phrases_.empty())
+    {
+        LOG_ERR("None of the voice command phrases can be recognized with " << model_dir);
+        vosk_model_free(state->model);
+        return false;
+    }
+
+    if (options_.use_grammar)
+    {
+        // Everything else is heard as [unk] instead of being forced onto the nearest command
+        std::string grammar = "[";
+        for (const std::string &phrase : phrases_)
+            grammar += "\"" + phrase + "\", ";
+        grammar += "\"[unk]\"]";
+        state->recognizer = vosk_recognizer_new_grm(state->model, static_cast<float>(options_.sample_rate), grammar.c_str());
+    }
+    else
+    {
+        state->recognizer = vosk_recognizer_new(state->model, static_cast<float>(options_.sample_rate));
+    }
+    if (!state->recognizer)
+    {
+        LOG_ERR("Failed to create a Vosk recognizer for " << model_dir << (options_.use_grammar ? " (the model may not support grammars)" : ""));
+        vosk_model_free(state->model);
+        return false;
+    }
+    // Word times are what the end-of-utterance latency is measured from
+    vosk_recognizer_set_words(state->recognizer, 1);
+    state_ = std::move(state);
+    LOG("Listening for " << phrases_.size() << " voice commands" << (options_.use_grammar ? "" : " (open vocabulary)"));
+    return true;
+}
+
+void VoiceCommandRecognizer::setPartialCallback(PartialCallback callback)
+{
+    partial_callback_ = std::move(callback);
+}
+
+void VoiceCommandRecognizer::setCommandCallback(CommandCallback callback)
+{
+    command_callback_ = std::move(callback);
+}
+
+void VoiceCommandRecognizer::setRejectCallback(RejectCallback callback)
+{
+    reject_callback_ = std::move(callback);
+}
+
+bool VoiceCommandRecognizer::start()
+{
+    if (!state_ || thread_.joinable())
+        return false;
+    stop_ = false;
+    thread_ = std::thread(&VoiceCommandRecognizer::decodeLoop, this);
+    return true;
+}
+
+void VoiceCommandRecognizer::stop()
+{
+    stop_ = true;
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void VoiceCommandRecognizer::decodeLoop()
+{
+    using clock = std::chrono::steady_clock;
+    VoskRecognizer *recognizer = state_->recognizer;
+    std::vector<int16_t> chunk(std::max(1, options_.sample_rate * options_.chunk_ms / 1000));
+    while (true)
+    {
+        // Taken before the pop, so it is no later than the push of the newest audio decoded;
+        // latencies err long by at most one push
+        const clock::time_point pushed_at = ring_.lastPushTime();
+        const size_t n = ring_.pop(chunk.data(), chunk.size());
+        if (n == 0)
+        {
+            if (stop_)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(VOICE_POLL_MS));
+            continue;
+        }
+
+        auto start = clock::now();
+        const int status = vosk_recognizer_accept_waveform_s(recognizer, reinterpret_cast<const short *>(chunk.data()), static_cast<int>(n));
+        samples_decoded_ += n;
+        {
+            std::lock_guard<std::mutex> lock(metrics_mutex_);
+            metrics_.audio_seconds = static_cast<double>(samples_decoded_) / options_.sample_rate;
+            metrics_.decode_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        }
+        if (status > 0)
+        {
+            handleFinal(vosk_recognizer_result(recognizer), false, pushed_at);
+        }
+        else if (status == 0)
+        {
+            checkEarlyCommit(vosk_recognizer_partial_result(recognizer), pushed_at);
+        }
+        else
+        {
+            LOG_ERR("Vosk failed to decode " << n << " samples");
+        }
+    }
+    // Whatever was said last, without waiting for silence that will not come
+    handleFinal(vosk_recognizer_final_result(recognizer), false, ring_.lastPushTime());
+}
+
+// One top-level string field of a Vosk JSON result
+static std::string jsonString(const cv::FileStorage &fs, const char *key)
+{
+    cv::FileNode node = fs[key];
+    return node.isString() ? node.string() : std::string();
+}
+
+void VoiceCommandRecognizer::checkEarlyCommit(const char *partial_json, std::chrono::steady_clock::time_point pushed_at)
+{
+    std::string partial;
+    try
+    {
+        cv::FileStorage fs(partial_json, cv::FileStorage::READ | cv::FileStorage::MEMORY | cv::FileStorage::FORMAT_JSON);
+        partial = jsonString(fs, "partial");
+    }
+    catch (const cv::Exception &e)
+    {
+        LOG_ERR("Unreadable Vosk partial result: " << e.what());
+        return;
+    }
+
+    if (partial != last_partial_)
+    {
+        last_partial_ = partial;
+        partial_since_ = samples_decoded_;
+        if (!partial.empty() && partial_callback_)
+            partial_callback_(partial);
+        return;
+    }
+    if (options_.early_commit_ms <= 0 || partial.empty())
+        return;
+    if (samples_decoded_ - partial_since_ < static_cast<uint64_t>(options_.sample_rate) * options_.early_commit_ms / 1000)
+        return;
+    // Only a whole command, and not one that starts a longer command ("open" of "open chrome")
+    if (std::find(phrases_.begin(), phrases_.end(), partial) == phrases_.end())
+        return;
+    for (const std::string &phrase : phrases_)
+    {
+        if (phrase.compare(0, partial.size() + 1, partial + " ") == 0)
+            return;
+    }
+    // Ends the utterance; the next chunk starts a new one
+    handleFinal(vosk_recognizer_final_result(state_->recognizer), true, pushed_at);
+}
+
+std::string VoiceCommandRecognizer::matchPhrase(const std::string &text) const
+{
+    // The longest command said anywhere in the text, on word boundaries
+    const std::string padded = " " + text + " ";
+    std::string best;
+    for (const std::string &phrase : phrases_)
+    {
+        if (phrase.size() > best.size() && padded.find(" " + phrase + " ") != std::string::npos)
+            best = phrase;
+    }
+    return best;
+}
+
+void VoiceCommandRecognizer::handleFinal(const char *result_json, bool early, std::chrono::steady_clock::time_point pushed_at)
+{
+    last_partial_.clear();
+    partial_since_ = samples_decoded_;
+
+    VoiceCommand command;
+    const double decoded_s = static_cast<double>(samples_decoded_) / options_.sample_rate;
+    command.start_s = command.end_s = decoded_s;
+    try
+    {
+        cv::FileStorage fs(result_json, cv::FileStorage::READ | cv::FileStorage::MEMORY | cv::FileStorage::FORMAT_JSON);
+        command.heard = normalizeCommandPhrase(jsonString(fs, "text"));
+        cv::FileNode words = fs["result"];
+        if (words.isSeq() && words.size() > 0)
+        {
+            command.start_s = static_cast<double>(words[0]["start"]);
+            command.end_s = static_cast<double>(words[static_cast<int>(words.size()) - 1]["end"]);
+        }
+    }
+    catch (const cv::Exception &e)
+    {
+        LOG_ERR("Unreadable Vosk result: " << e.what());
+        return;
+    }
+    if (command.heard.empty())
+        return;
+
+    command.phrase = matchPhrase(command.heard);
+    command.early = early;
+    // Audio decoded after the last word (Vosk's endpoint or the early commit) plus how far the
+    // decoder trails the audio source
+    command.latency_ms = 1000.0 * std::max(0.0, decoded_s - command.end_s) +
+                         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pushed_at).count();
+    {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        metrics_.utterances++;
+        if (command.phrase.empty())
+        {
+            metrics_.rejected++;
+        }
+        else
+        {
+            metrics_.commands++;
+            if (early)
+                metrics_.early_commits++;
+            latency_sum_ms_ += command.latency_ms;
+            metrics_.avg_latency_ms = latency_sum_ms_ / metrics_.commands;
+            metrics_.max_latency_ms = std::max(metrics_.max_latency_ms, command.latency_ms);
+            recent_latencies_.push_back(command.latency_ms);
+            if (recent_latencies_.size() > VOICE_LATENCY_WINDOW)
+                recent_latencies_.pop_front();
+        }
+    }
+
+    if (command.phrase.empty())
+    {
+        if (reject_callback_)
+            reject_callback_(command.heard);
+    }
+    else if (command_callback_)
+    {
+        command_callback_(command);
+    }
+}
+
+VoiceMetrics VoiceCommandRecognizer::metrics() const
+{
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    VoiceMetrics out = metrics_;
+    out.dropped_samples = ring_.dropped();
+    out.recent_latencies_ms.assign(recent_latencies_.begin(), recent_latencies_.end());
+    return out;
+}
+
+#ifdef AGENT_HAS_PORTAUDIO
+static int onMicrophoneAudio(const void *input, void *, unsigned long frames, const PaStreamCallbackTimeInfo *, PaStreamCallbackFlags, void *user)
+{
+    if (input)
+        static_cast<VoiceCommandRecognizer *>(user)->pushAudio(static_cast<const int16_t *>(input), frames);
+    return paContinue;
+}
+
+bool MicrophoneInput::open(VoiceCommandRecognizer &recognizer)
+{
+    close();
+    PaError error = Pa_Initialize();
+    if (error != paNoError)
+    {
+        LOG_ERR("PortAudio initialization failed: " << Pa_GetErrorText(error));
+        return false;
+    }
+    // 10 ms per callback; PyAudio's listener read 250 ms at a time
+    const int sample_rate = recognizer.options().sample_rate;
+    PaStream *stream = nullptr;
+    error = Pa_OpenDefaultStream(&stream, 1, 0, paInt16, sample_rate, sample_rate / 100, onMicrophoneAudio, &recognizer);
+    if (error == paNoError)
+        error = Pa_StartStream(stream);
+    if (error != paNoError)
+    {
+        LOG_ERR("Cannot open the default microphone at " << sample_rate << " Hz: " << Pa_GetErrorText(error));
+        if (stream)
+            Pa_CloseStream(stream);
+        Pa_Terminate();
+        return false;
+    }
+    stream_ = stream;
+    return true;
+}
+
+void MicrophoneInput::close()
+{
+    if (!stream_)
+        return;
+    Pa_StopStream(stream_);
+    Pa_CloseStream(stream_);
+    Pa_Terminate();
+    stream_ = nullptr;
+}
+#endif
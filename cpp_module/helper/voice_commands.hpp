@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils.hpp"
+
+// Voice commands through the Vosk C API, replacing the Python listener in automation_tool.py.
+// Audio is pushed into a lock-free ring by the capture callback (or a WAV feeder) and decoded
+// on a thread of its own. The recognizer is restricted to the command phrases, so it cannot
+// drift into dictation, and a complete phrase that stays unchanged for a short stretch of audio
+// is reported without waiting for Vosk's end-of-utterance silence.
+
+const int VOICE_SAMPLE_RATE = 16000; // What the bundled small English model was trained on
+const int VOICE_CHUNK_MS = 20;       // Audio handed to Vosk per step
+const int VOICE_RING_MS = 4000;      // Buffered audio before the newest samples are dropped
+const int VOICE_POLL_MS = 5;         // Decoder sleep while the ring is empty; a callback cannot signal
+const int VOICE_EARLY_COMMIT_MS = 250;
+const size_t VOICE_LATENCY_WINDOW = 256; // Command latencies kept for percentiles
+
+// Single-producer single-consumer queue of 16-bit samples. push() never blocks, locks or
+// allocates, so it is safe in a real-time audio callback; when the decoder falls behind the
+// newest samples are dropped and counted.
+class AudioRing
+{
+public:
+    explicit AudioRing(size_t min_capacity);
+    // Returns how many samples fit; the rest are dropped
+    size_t push(const int16_t *samples, size_t count);
+    size_t pop(int16_t *out, size_t max_count);
+    size_t available() const;
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    // When the newest samples were pushed, for latency measurement
+    std::chrono::steady_clock::time_point lastPushTime() const;
+
+private:
+    std::vector<int16_t> buffer_; // Power of two
+    size_t mask_;
+    alignas(64) std::atomic<uint64_t> head_{0}; // Next sample to write
+    alignas(64) std::atomic<uint64_t> tail_{0}; // Next sample to read
+    std::atomic<int64_t> last_push_ns_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+struct VoiceOptions
+{
+    int sample_rate = VOICE_SAMPLE_RATE; // Of the pushed audio; Vosk resamples to the model's
+    int chunk_ms = VOICE_CHUNK_MS;
+    // Decode against the command phrases only; off, any speech is transcribed and a command is
+    // found by substring, like the Python listener
+    bool use_grammar = true;
+    // A partial result that is a complete command and unchanged for this much audio is final;
+    // 0 waits for Vosk's endpoint. A phrase that starts a longer one always waits.
+    int early_commit_ms = VOICE_EARLY_COMMIT_MS;
+};
+
+struct VoiceCommand
+{
+    std::string phrase; // As listed in the command phrases
+    std::string heard;  // Vosk's full text for the utterance
+    double start_s = 0.0; // Position in the audio stream
+    double end_s = 0.0;
+    double latency_ms = 0.0; // End of the last word to the command being reported
+    bool early = false;      // Reported before Vosk's endpoint
+};
+
+struct VoiceMetrics
+{
+    double audio_seconds = 0.0;  // Decoded so far
+    double decode_seconds = 0.0; // Spent inside Vosk
+    uint64_t utterances = 0;     // Non-empty final results
+    uint64_t commands = 0;
+    uint64_t rejected = 0; // Speech that matched no command
+    uint64_t early_commits = 0;
+    uint64_t dropped_samples = 0;
+    double avg_latency_ms = 0.0;
+    double max_latency_ms = 0.0;
+    std::vector<double> recent_latencies_ms; // Last VOICE_LATENCY_WINDOW commands
+};
+
+typedef std::function<void(const std::string &partial)> PartialCallback;
+typedef std::function<void(const VoiceCommand &command)> CommandCallback;
+typedef std::function<void(const std::string &text)> RejectCallback;
+
+struct VoiceState; // Vosk handles, kept out of this header so users need not have vosk_api.h
+
+// Lower case, single spaces, no surrounding blanks
+std::string normalizeCommandPhrase(std::string text);
+// Phrases are lower-case words separated by single spaces; blank lines and '#' comments are
+// skipped
+bool loadCommandPhrases(const std::string &path, std::vector<std::string> &out_phrases);
+// The commands automation_tool.py understands that a closed grammar can express; "type ..."
+// and "go to <url>" take free text and only match as far as their fixed words
+std::vector<std::string> defaultCommandPhrases();
+
+class VoiceCommandRecognizer
+{
+public:
+    explicit VoiceCommandRecognizer(const VoiceOptions &options = VoiceOptions());
+    ~VoiceCommandRecognizer();
+
+    // Phrases with words the model does not know are dropped with a warning
+    bool load(const std::string &model_dir, const std::vector<std::string> &phrases);
+    // Callbacks run on the decoder thread; keep them short
+    void setPartialCallback(PartialCallback callback);
+    void setCommandCallback(CommandCallback callback);
+    void setRejectCallback(RejectCallback callback);
+    bool start();
+    // Decodes what is still buffered, finishes the last utterance and joins the decoder
+    void stop();
+
+    // Producer side; call from one thread (or audio callback) at a time
+    size_t pushAudio(const int16_t *samples, size_t count) { return ring_.push(samples, count); }
+    // True while pushed audio is still waiting for the decoder
+    bool pending() const { return ring_.available() > 0; }
+
+    VoiceMetrics metrics() const;
+    const VoiceOptions &options() const { return options_; }
+    const std::vector<std::string> &phrases() const { return phrases_; }
+
+private:
+    void decodeLoop();
+    void checkEarlyCommit(const char *partial_json, std::chrono::steady_clock::time_point pushed_at);
+    void handleFinal(const char *result_json, bool early, std::chrono::steady_clock::time_point pushed_at);
+    std::string matchPhrase(const std::string &text) const;
+
+    VoiceOptions options_;
+    std::vector<std::string> phrases_;
+    std::unique_ptr<VoiceState> state_;
+    AudioRing ring_;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    PartialCallback partial_callback_;
+    CommandCallback command_callback_;
+    RejectCallback reject_callback_;
+
+    // Decoder thread only
+    uint64_t samples_decoded_ = 0;
+    std::string last_partial_;
+    uint64_t partial_since_ = 0; // samples_decoded_ when last_partial_ last changed
+
+    mutable std::mutex metrics_mutex_;
+    VoiceMetrics metrics_;
+    std::deque<double> recent_latencies_;
+    double latency_sum_ms_ = 0.0;
+};
+
+#ifdef AGENT_HAS_PORTAUDIO
+// Default input device through PortAudio (the library behind PyAudio). Its callback only
+// pushes into the recognizer's ring.
+class MicrophoneInput
+{
+public:
+    ~MicrophoneInput() { close(); }
+    bool open(VoiceCommandRecognizer &recognizer);
+    void close();
+
+private:
+    void *stream_ = nullptr; // PaStream
+};
+#endif
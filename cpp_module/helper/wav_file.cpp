@@ -0,0 +1,91 @@
+#include "wav_file.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static uint32_t readLittleEndian(const unsigned char *bytes, int count)
+{
+    uint32_t value = 0;
+    for (int i = count - 1; i >= 0; --i)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static uint64_t bytesLeft(std::ifstream &ifs, uint64_t file_size)
+{
+    const uint64_t position = static_cast<uint64_t>(ifs.tellg());
+    return position < file_size ? file_size - position : 0;
+}
+
+bool readWavFile(const std::string &path, std::vector<int16_t> &out_samples, int &out_sample_rate)
+{
+    out_samples.clear();
+    std::ifstream ifs(path, std::ios::binary);
+    unsigned char riff[12];
+    if (!ifs.read(reinterpret_cast<char *>(riff), sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        LOG_ERR("Not a WAV file: " << path);
+        return false;
+    }
+    ifs.seekg(0, std::ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(ifs.tellg());
+    ifs.seekg(sizeof(riff));
+
+    int channels = 0, bits = 0;
+    uint32_t format = 0;
+    out_sample_rate = 0;
+    unsigned char header[8];
+    while (ifs.read(reinterpret_cast<char *>(header), sizeof(header)))
+    {
+        const uint32_t size = readLittleEndian(header + 4, 4);
+        if (std::memcmp(header, "fmt ", 4) == 0 && size >= 16)
+        {
+            if (size > bytesLeft(ifs, file_size))
+            {
+                LOG_ERR("Truncated format chunk in WAV file: " << path);
+                return false;
+            }
+            std::vector<unsigned char> fmt(size);
+            if (!ifs.read(reinterpret_cast<char *>(fmt.data()), size))
+                break;
+            format = readLittleEndian(&fmt[0], 2);
+            channels = static_cast<int>(readLittleEndian(&fmt[2], 2));
+            out_sample_rate = static_cast<int>(readLittleEndian(&fmt[4], 4));
+            bits = static_cast<int>(readLittleEndian(&fmt[14], 2));
+        }
+        else if (std::memcmp(header, "data", 4) == 0)
+        {
+            // 1 is PCM, 0xFFFE the extensible header recorders write for the same samples
+            if ((format != 1 && format != 0xFFFE) || bits != 16 || channels < 1)
+            {
+                LOG_ERR("Unsupported WAV format in " << path << ": expected 16-bit PCM, got format " << format << ", " << bits << " bits, " << channels
+                                                     << " channels");
+                return false;
+            }
+            const uint64_t bytes = std::min<uint64_t>(size, bytesLeft(ifs, file_size));
+            std::vector<int16_t> interleaved(static_cast<size_t>(bytes / sizeof(int16_t)));
+            ifs.read(reinterpret_cast<char *>(interleaved.data()), interleaved.size() * sizeof(int16_t));
+            interleaved.resize(static_cast<size_t>(ifs.gcount()) / sizeof(int16_t));
+            const size_t frames = interleaved.size() / channels;
+            out_samples.resize(frames);
+            for (size_t f = 0; f < frames; ++f)
+            {
+                int sum = 0;
+                for (int c = 0; c < channels; ++c)
+                    sum += interleaved[f * channels + c];
+                out_samples[f] = static_cast<int16_t>(sum / channels);
+            }
+            return out_sample_rate > 0;
+        }
+        else
+        {
+            ifs.seekg(size, std::ios::cur);
+        }
+        // Chunks are padded to an even size
+        if (size % 2 != 0)
+            ifs.seekg(1, std::ios::cur);
+    }
+    LOG_ERR("No audio data in WAV file: " << path);
+    return false;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reads 16-bit PCM WAV files; multi-channel audio is mixed down to mono. Chunk sizes are
+// trusted only as far as the file goes: a data chunk that claims more than is left (streaming
+// recorders write 0 or 0xFFFFFFFF there) is read to the end of the file.
+bool readWavFile(const std::string &path, std::vector<int16_t> &out_samples, int &out_sample_rate);
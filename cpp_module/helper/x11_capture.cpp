@@ -0,0 +1,306 @@
+#include "x11_capture.hpp"
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+struct X11CaptureState
+{
+    Display *display = nullptr;
+    Window root = 0;
+    XImage *image = nullptr; // Shared memory image; null when capturing through XGetImage
+    XShmSegmentInfo shm = {};
+    Damage damage = 0;
+    int damage_event_base = 0;
+    XserverRegion region = 0; // Receives the damage taken by XDamageSubtract
+};
+
+// The error handler is process-wide, so errors are kept per connection: one source's failed
+// grab must not be taken for another's. Only displays opened by a source are in the map.
+static std::mutex x_errors_mutex;
+static std::unordered_map<Display *, int> x_errors;
+
+// Xlib's default error handler exits the process; a capture must survive a refused shared
+// memory segment (remote display) or a grab racing a resolution change
+static int onXError(Display *display, XErrorEvent *event)
+{
+    char text[256] = "";
+    XGetErrorText(display, event->error_code, text, sizeof(text));
+    LOG_WARN("X error " << static_cast<int>(event->error_code) << " (" << text << ") in request " << static_cast<int>(event->request_code));
+    std::lock_guard<std::mutex> lock(x_errors_mutex);
+    auto it = x_errors.find(display);
+    if (it != x_errors.end())
+        it->second = event->error_code;
+    return 0;
+}
+
+// Also registers the display
+static void clearXError(Display *display)
+{
+    std::lock_guard<std::mutex> lock(x_errors_mutex);
+    x_errors[display] = 0;
+}
+
+static int lastXError(Display *display)
+{
+    std::lock_guard<std::mutex> lock(x_errors_mutex);
+    auto it = x_errors.find(display);
+    return it == x_errors.end() ? 0 : it->second;
+}
+
+// Unregisters before closing, so a display opened later at the same address starts clean
+static void closeXDisplay(Display *display)
+{
+    {
+        std::lock_guard<std::mutex> lock(x_errors_mutex);
+        x_errors.erase(display);
+    }
+    XCloseDisplay(display);
+}
+
+static void releaseShm(X11CaptureState &state, bool attached)
+{
+    if (attached)
+        XShmDetach(state.display, &state.shm);
+    if (state.image)
+    {
+        state.image->data = nullptr; // Not malloc'ed; XDestroyImage must not free it
+        XDestroyImage(state.image);
+        state.image = nullptr;
+    }
+    if (state.shm.shmaddr && state.shm.shmaddr != reinterpret_cast<char *>(-1))
+        shmdt(state.shm.shmaddr);
+    state.shm = XShmSegmentInfo();
+}
+
+X11ScreenSource::X11ScreenSource(const X11CaptureOptions &options)
+    : options_(options)
+{
+}
+
+X11ScreenSource::~X11ScreenSource()
+{
+    close();
+}
+
+bool X11ScreenSource::open()
+{
+    close();
+    // Several sources may capture from their own threads
+    static const bool threads_initialized = XInitThreads() != 0;
+    (void)threads_initialized;
+
+    auto state = std::make_unique<X11CaptureState>();
+    state->display = XOpenDisplay(options_.display_name.empty() ? nullptr : options_.display_name.c_str());
+    if (!state->display)
+    {
+        LOG_ERR("Cannot open X display " << name());
+        return false;
+    }
+    XSetErrorHandler(onXError);
+    Display *display = state->display;
+    clearXError(display);
+    state->root = DefaultRootWindow(display);
+
+    XWindowAttributes attributes;
+    XGetWindowAttributes(display, state->root, &attributes);
+    size_ = cv::Size(attributes.width, attributes.height);
+    // Frames are handed on as BGRA, which is how 24 and 32 bit little-endian servers store pixels
+    if ((attributes.depth != 24 && attributes.depth != 32) || ImageByteOrder(display) != LSBFirst)
+    {
+        LOG_ERR("Unsupported X display " << name() << ": depth " << attributes.depth << ", expected a 24 or 32 bit little-endian screen");
+        closeXDisplay(display);
+        return false;
+    }
+
+    if (options_.use_shm && XShmQueryExtension(display))
+    {
+        state->image = XShmCreateImage(display, attributes.visual, attributes.depth, ZPixmap, nullptr, &state->shm, size_.width, size_.height);
+        bool attached = false;
+        if (state->image && state->image->bits_per_pixel == 32)
+        {
+            state->shm.shmid = shmget(IPC_PRIVATE, static_cast<size_t>(state->image->bytes_per_line) * state->image->height, IPC_CREAT | 0600);
+            if (state->shm.shmid != -1)
+            {
+                state->shm.shmaddr = state->image->data = static_cast<char *>(shmat(state->shm.shmid, nullptr, 0));
+                state->shm.readOnly = False;
+                if (state->shm.shmaddr != reinterpret_cast<char *>(-1))
+                {
+                    // A remote server accepts the request and fails it later; sync to find out
+                    clearXError(display);
+                    if (XShmAttach(display, &state->shm))
+                    {
+                        XSync(display, False);
+                        attached = lastXError(display) == 0;
+                    }
+                }
+                // Removed once the last process detaches, so the segment cannot outlive a crash
+                shmctl(state->shm.shmid, IPC_RMID, nullptr);
+            }
+        }
+        if (!attached)
+        {
+            LOG_WARN("MIT-SHM is not available on " << name() << ", capturing through XGetImage.");
+            releaseShm(*state, false);
+        }
+    }
+
+    int damage_error_base = 0, fixes_event_base = 0, fixes_error_base = 0;
+    if (options_.use_damage && XDamageQueryExtension(display, &state->damage_event_base, &damage_error_base) &&
+        XFixesQueryExtension(display, &fixes_event_base, &fixes_error_base))
+    {
+        // One event whenever the damage goes from empty to non-empty; the rectangles are read
+        // and cleared together with XDamageSubtract
+        state->damage = XDamageCreate(display, state->root, XDamageReportNonEmpty);
+        state->region = XFixesCreateRegion(display, nullptr, 0);
+    }
+    else if (options_.use_damage)
+    {
+        LOG_WARN("XDamage is not available on " << name() << ", every read grabs the whole screen.");
+    }
+
+    state_ = std::move(state);
+    first_frame_ = true;
+    LOG("Capturing X display " << name() << " (" << size_.width << "x" << size_.height << (usingShm() ? ", MIT-SHM" : ", XGetImage")
+                               << (usingDamage() ? ", XDamage)" : ")"));
+    return true;
+}
+
+bool X11ScreenSource::collectDamage()
+{
+    Display *display = state_->display;
+    bool damaged = first_frame_;
+    while (XPending(display) > 0)
+    {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.type == state_->damage_event_base + XDamageNotify)
+            damaged = true;
+    }
+    if (!damaged)
+        return false;
+
+    // Takes everything drawn so far and clears it before the grab, so drawing that races the
+    // grab raises a new event and is reported again next frame instead of being lost
+    XDamageSubtract(display, state_->damage, None, state_->region);
+    int count = 0;
+    XRectangle bounds;
+    XRectangle *rects = XFixesFetchRegionAndBounds(display, state_->region, &count, &bounds);
+    changed_regions_.clear();
+    const cv::Rect screen(cv::Point(0, 0), size_);
+    if (first_frame_)
+    {
+        changed_regions_.push_back(screen);
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            cv::Rect rect = cv::Rect(rects[i].x, rects[i].y, rects[i].width, rects[i].height) & screen;
+            if (!rect.empty())
+                changed_regions_.push_back(rect);
+        }
+    }
+    if (rects)
+        XFree(rects);
+    // Damage outside the screen (e.g. a window moved off-screen) changed nothing visible
+    return !changed_regions_.empty();
+}
+
+bool X11ScreenSource::read(cv::Mat &frame_bgr)
+{
+    cv::Mat frame;
+    if (!readBgra(frame))
+        return false;
+    cv::cvtColor(frame, frame_bgr, cv::COLOR_BGRA2BGR);
+    return true;
+}
+
+bool X11ScreenSource::readBgra(cv::Mat &frame_bgra)
+{
+    unchanged_ = false;
+    if (!state_ && !open())
+        return false;
+
+    if (state_->damage && !collectDamage())
+    {
+        unchanged_ = true;
+        return false;
+    }
+
+    Display *display = state_->display;
+    clearXError(display);
+    if (state_->image)
+    {
+        if (!XShmGetImage(display, state_->root, state_->image, 0, 0, AllPlanes) || lastXError(display) != 0)
+        {
+            // Usually a resolution change; the next read reopens at the new size
+            LOG_ERR("XShmGetImage failed on " << name() << ", reopening the display.");
+            close();
+            return false;
+        }
+        frame_bgra = cv::Mat(size_, CV_8UC4, state_->image->data, state_->image->bytes_per_line);
+    }
+    else
+    {
+        XImage *image = XGetImage(display, state_->root, 0, 0, size_.width, size_.height, AllPlanes, ZPixmap);
+        if (!image || image->bits_per_pixel != 32)
+        {
+            LOG_ERR("XGetImage failed on " << name() << ", reopening the display.");
+            if (image)
+                XDestroyImage(image);
+            close();
+            return false;
+        }
+        cv::Mat(size_, CV_8UC4, image->data, image->bytes_per_line).copyTo(fallback_buffer_);
+        XDestroyImage(image);
+        frame_bgra = fallback_buffer_;
+    }
+    first_frame_ = false;
+    return true;
+}
+
+void X11ScreenSource::close()
+{
+    if (!state_)
+        return;
+    Display *display = state_->display;
+    if (state_->damage)
+        XDamageDestroy(display, state_->damage);
+    if (state_->region)
+        XFixesDestroyRegion(display, state_->region);
+    if (state_->image)
+        releaseShm(*state_, true);
+    closeXDisplay(display);
+    state_.reset();
+}
+
+std::string X11ScreenSource::name() const
+{
+    const char *env_display = std::getenv("DISPLAY");
+    return "x11:" + (options_.display_name.empty() ? std::string(env_display ? env_display : "") : options_.display_name);
+}
+
+bool X11ScreenSource::changedRegions(std::vector<cv::Rect> &out_regions) const
+{
+    if (!usingDamage())
+        return false;
+    out_regions = changed_regions_;
+    return true;
+}
+
+bool X11ScreenSource::usingShm() const
+{
+    return state_ && state_->image;
+}
+
+bool X11ScreenSource::usingDamage() const
+{
+    return state_ && state_->damage;
+}
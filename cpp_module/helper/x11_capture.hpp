@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include "frame_source.hpp"
+
+struct X11CaptureState; // Xlib handles, kept out of this header: Xlib defines None, Bool, Status
+
+struct X11CaptureOptions
+{
+    std::string display_name; // Empty uses $DISPLAY
+    // Reads the root window into a shared memory segment instead of through the X socket;
+    // falls back to XGetImage when the server is remote or refuses the segment
+    bool use_shm = true;
+    // Grabs only after the server reported damage; otherwise every read grabs the whole screen
+    bool use_damage = true;
+};
+
+// The root window of an X11 display (Linux desktops, VDI hosts, Xvfb) as a FrameSource. With
+// XDamage, read() returns false without touching the screen when nothing was drawn since the
+// last frame, like the DXGI source, and changedRegions() lists the damaged rectangles of the
+// frame it did return. With MIT-SHM the server writes the screen straight into memory shared
+// with this process; readBgra() wraps that memory without a copy.
+class X11ScreenSource : public FrameSource
+{
+public:
+    explicit X11ScreenSource(const X11CaptureOptions &options = X11CaptureOptions());
+    ~X11ScreenSource() override;
+    bool open() override;
+    bool read(cv::Mat &frame_bgr) override;
+    // Like read(), without the color conversion: frame_bgra wraps the capture buffer and stays
+    // valid until the next read
+    bool readBgra(cv::Mat &frame_bgra);
+    void close() override;
+    std::string name() const override;
+    bool unchanged() const override { return unchanged_; }
+    bool changedRegions(std::vector<cv::Rect> &out_regions) const override;
+
+    bool usingShm() const;
+    bool usingDamage() const;
+    cv::Size size() const { return size_; }
+
+private:
+    bool collectDamage();
+
+    X11CaptureOptions options_;
+    std::unique_ptr<X11CaptureState> state_;
+    cv::Size size_;
+    bool unchanged_ = false;
+    bool first_frame_ = true;
+    std::vector<cv::Rect> changed_regions_;
+    cv::Mat fallback_buffer_; // Owns the pixels when XGetImage is used
+};
@@ -1,11 +1,33 @@
 #include "yolo.hpp"
+#include "yolo_decode.hpp"
+#include "alloc_tracker.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+// Decoder picked for each network by warmUpYoloNetwork. A network's layout and class count are
+// fixed once it is loaded; only the proposal count follows the input size.
+struct YoloDecoderChoice
+{
+    YoloOutputInfo info;
+    YoloDecodeFn decode = nullptr;
+};
+static std::mutex g_decoders_mutex;
+static std::unordered_map<const cv::dnn::Net *, YoloDecoderChoice> g_decoders;
+
+static void rememberYoloDecoder(const cv::dnn::Net &net, const YoloOutputInfo &info, YoloDecodeFn decode)
+{
+    std::lock_guard<std::mutex> lock(g_decoders_mutex);
+    g_decoders[&net] = {info, decode};
+}
 
 bool loadClassNames(const std::string &path, std::vector<std::string> &class_names_out)
 {
     std::ifstream ifs(path.c_str());
     if (!ifs.is_open())
     {
-        std::cerr << "Error: Failed to open class names file: " << path << std::endl;
+        LOG_ERR("Failed to open class names file: " << path);
         return false;
     }
     std::string line;
@@ -17,51 +39,85 @@ bool loadClassNames(const std::string &path, std::vector<std::string> &class_nam
     return true;
 }
 
-bool setupYoloNetwork(cv::dnn::Net &net, const std::string &model_path, const std::string &class_names_path, std::vector<std::string> &out_class_names_vec, HARDWARE_INFO &hw_info)
+bool loadYoloNetwork(cv::dnn::Net &net, const std::string &model_path)
 {
     LOG("Loading YOLO model from: " << model_path);
     try
     {
         net = cv::dnn::readNetFromONNX(model_path);
-
-        if (net.empty() || class_names_path.empty())
+        if (net.empty())
         {
-            std::cerr << "Error: Failed to load YOLO model." << std::endl;
+            LOG_ERR("Failed to load YOLO model.");
             return false;
         }
+        LOG("Loaded YOLO model " << model_path);
+        return true;
+    }
+    catch (const cv::Exception &e)
+    {
+        LOG_ERR("OpenCV error during YOLO model loading: " << e.what());
+        return false;
+    }
+}
 
-        // Optimize backend based on detected hardware
-        if (hw_info.has_cuda && hw_info.has_nvidia)
+void configureYoloBackend(cv::dnn::Net &net, const HARDWARE_INFO &hw_info)
+{
+    // Optimize backend based on detected hardware
+    if (hw_info.has_cuda && hw_info.has_nvidia)
+    {
+        // NVIDIA GPU - Use CUDA
+        LOG("Using CUDA backend for NVIDIA GPU");
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
+    }
+    else if (hw_info.has_opencl)
+    {
+        if (hw_info.has_amd)
         {
-            // NVIDIA GPU - Use CUDA
-            LOG("Using CUDA backend for NVIDIA GPU");
-            net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
-            net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
+            // AMD GPU - Use OpenCL with AMD optimizations
+            LOG("Using OpenCL backend for AMD GPU");
+            net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+            net.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL);
         }
-        else if (hw_info.has_opencl)
+    }
+    else
+    {
+        LOG("Using CPU: Will be Slower");
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    }
+}
+
+bool warmUpYoloNetwork(cv::dnn::Net &net, const std::vector<std::string> &class_names_list)
+{
+    try
+    {
+        YoloOutputInfo output_info;
+        if (!probeYoloOutputLayout(net, YOLO_INPUT_WIDTH, YOLO_INPUT_HEIGHT, output_info))
         {
-            if (hw_info.has_amd)
-            {
-                // AMD GPU - Use OpenCL with AMD optimizations
-                LOG("Using OpenCL backend for AMD GPU");
-                net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-                net.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL);
-            }
+            LOG_ERR("Unsupported YOLO model output layout; expected [1, 4+C, N], [1, N, 5+C] or [1, K, 6].");
+            return false;
         }
-        else
+        LOG("YOLO output layout: " << yoloOutputLayoutName(output_info.layout) << ", " << output_info.num_proposals << " proposals");
+        rememberYoloDecoder(net, output_info, selectYoloDecoder(output_info));
+        if (output_info.layout != YoloOutputLayout::EndToEnd && output_info.num_classes != static_cast<int>(class_names_list.size()))
         {
-            LOG("Using CPU: Will be Slower");
-            net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-            net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            LOG_ERR("Warning: model predicts " << output_info.num_classes << " classes but the class names file lists " << class_names_list.size() << ".");
         }
-
-        LOG("YOLO11l model loaded successfully.");
+        return true;
     }
     catch (const cv::Exception &e)
     {
-        LOG_ERR("OpenCV error during YOLO model loading: " << e.what());
+        LOG_ERR("OpenCV exception during YOLO warm-up: " << e.what());
         return false;
     }
+}
+
+bool setupYoloNetwork(cv::dnn::Net &net, const std::string &model_path, const std::string &class_names_path, std::vector<std::string> &out_class_names_vec, HARDWARE_INFO &hw_info)
+{
+    if (class_names_path.empty() || !loadYoloNetwork(net, model_path))
+        return false;
+    configureYoloBackend(net, hw_info);
 
     // Load Yolo Class names
 
@@ -74,14 +130,12 @@ bool setupYoloNetwork(cv::dnn::Net &net, const std::string &model_path, const st
             return false;
         }
         LOG("Class names loaded: " << out_class_names_vec.size() << " classes.");
+
+        if (!warmUpYoloNetwork(net, out_class_names_vec))
+            return false;
         LOG("YOLO network setup complete.");
         return true;
     }
-    catch (const cv::Exception &e)
-    {
-        LOG_ERR("OpenCV exception during YOLO setup: " << e.what());
-        return false;
-    }
     catch (const std::exception &e)
     {
         LOG_ERR("Standard exception during YOLO setup: " << e.what());
@@ -89,22 +143,54 @@ bool setupYoloNetwork(cv::dnn::Net &net, const std::string &model_path, const st
     }
 }
 
-void processFrameWithYOLO(cv::Mat &frame, cv::dnn::Net &net, const std::vector<std::string> &class_names_list)
+// The decoder chosen at warm-up, as long as the output still has that layout. Networks that were
+// not warmed up, or whose output changed shape, are probed from this output and remembered.
+static YoloDecodeFn yoloDecoderFor(const cv::dnn::Net &net, const cv::Mat &output, const YoloSettings &settings, YoloOutputInfo &out_info)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_decoders_mutex);
+        auto it = g_decoders.find(&net);
+        if (it != g_decoders.end() && matchYoloOutput(it->second.info, output, out_info))
+            return it->second.decode;
+    }
+    out_info = describeYoloOutput(output, settings.input_width, settings.input_height);
+    YoloDecodeFn decode = selectYoloDecoder(out_info);
+    if (decode)
+        rememberYoloDecoder(net, out_info, decode);
+    return decode;
+}
+
+// Runs the network's specialized decoder on one image of the output
+static void decodeYoloOutput(const cv::dnn::Net &net, const cv::Mat &output, int batch_index, const cv::Size &frame_size, const YoloSettings &settings, std::vector<Detection> &out_detections)
 {
+    YoloOutputInfo info;
+    YoloDecodeFn decode = yoloDecoderFor(net, output, settings, info);
+    if (!decode)
+    {
+        CV_Error(cv::Error::StsUnsupportedFormat, "YOLO: unrecognized model output layout");
+    }
+    decode(output.ptr<float>(batch_index), info, frame_size, settings, out_detections);
+}
+
+void detectObjectsWithYOLO(const cv::Mat &frame, cv::dnn::Net &net, std::vector<Detection> &out_detections, const YoloSettings &settings)
+{
+    out_detections.clear();
     if (frame.empty() || net.empty())
     {
         if (frame.empty())
-            LOG_ERR("YOLO: processFrameWithYOLO called with empty frame.");
+            LOG_ERR("YOLO: detectObjectsWithYOLO called with empty frame.");
         if (net.empty())
-            LOG_ERR("YOLO: processFrameWithYOLO called with empty network.");
+            LOG_ERR("YOLO: detectObjectsWithYOLO called with empty network.");
         return;
     }
 
     cv::Mat blob;
     try
     {
+        AllocStageScope stage(ALLOC_STAGE_PREPROCESS);
+        TRACE_SCOPE("preprocess");
         // LOG("YOLO: Creating blob..."); // Uncomment for very verbose logging
-        cv::dnn::blobFromImage(frame, blob, 1.0 / 255.0, cv::Size(YOLO_INPUT_WIDTH, YOLO_INPUT_HEIGHT), cv::Scalar(), true, false);
+        cv::dnn::blobFromImage(frame, blob, 1.0 / 255.0, cv::Size(settings.input_width, settings.input_height), cv::Scalar(), true, false);
         // LOG("YOLO: Blob created. Setting input."); // Uncomment for very verbose logging
         net.setInput(blob);
     }
@@ -118,6 +204,8 @@ void processFrameWithYOLO(cv::Mat &frame, cv::dnn::Net &net, const std::vector<s
     // The actual forward call is within the try-catch block below
     try
     {
+        AllocStageScope stage(ALLOC_STAGE_INFERENCE);
+        TRACE_SCOPE("forward");
         net.forward(outs, net.getUnconnectedOutLayersNames());
     }
     catch (const cv::Exception &e)
@@ -126,63 +214,176 @@ void processFrameWithYOLO(cv::Mat &frame, cv::dnn::Net &net, const std::vector<s
         throw; // Re-throw to allow main loop to attempt re-initialization
     }
 
-    // Post-processing
-    // YOLOv8 output tensor shape is typically [batch_size, num_classes + 4, num_proposals]
-    // e.g., [1, 84, 8400] for COCO (80 classes) + 4 box coords.
-    cv::Mat detections = outs[0]; // Assuming the first output is the main detection layer
+    // The first output is the detection layer; its shape tells which model family produced it
+    AllocStageScope stage(ALLOC_STAGE_POSTPROCESS);
+    TRACE_SCOPE("decode");
+    decodeYoloOutput(net, outs[0], 0, frame.size(), settings, out_detections);
+}
 
-    // The detections Mat has 3 dimensions. For easier access, treat the relevant part as 2D.
-    // detection_data points to the [num_channels, num_proposals] part.
-    const int num_channels = detections.size[1];  // e.g., 84 (cx, cy, w, h, class_scores...)
-    const int num_proposals = detections.size[2]; // e.g., 8400
+void detectObjectsWithYOLOBatch(const std::vector<cv::Mat> &frames, cv::dnn::Net &net, std::vector<std::vector<Detection>> &out_detections, const YoloSettings &settings)
+{
+    out_detections.assign(frames.size(), std::vector<Detection>());
+    if (frames.empty() || net.empty())
+        return;
 
-    cv::Mat detection_matrix = cv::Mat(num_channels, num_proposals, CV_32F, detections.ptr<float>());
+    // blobFromImages resizes every frame to the network input, so sources of different resolutions batch together
+    cv::Mat blob;
+    {
+        AllocStageScope stage(ALLOC_STAGE_PREPROCESS);
+        TRACE_SCOPE("preprocess");
+        cv::dnn::blobFromImages(frames, blob, 1.0 / 255.0, cv::Size(settings.input_width, settings.input_height), cv::Scalar(), true, false);
+        net.setInput(blob);
+    }
 
-    std::vector<int> class_ids;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
+    std::vector<cv::Mat> outs;
+    {
+        AllocStageScope stage(ALLOC_STAGE_INFERENCE);
+        TRACE_SCOPE("forward");
+        net.forward(outs, net.getUnconnectedOutLayersNames());
+    }
 
-    float x_factor = frame.cols / (float)YOLO_INPUT_WIDTH;
-    float y_factor = frame.rows / (float)YOLO_INPUT_HEIGHT;
+    cv::Mat detections = outs[0]; // [batch_size, ...] in any supported layout
+    if (detections.dims != 3 || detections.size[0] != static_cast<int>(frames.size()))
+    {
+        CV_Error(cv::Error::StsUnmatchedSizes, "YOLO: model output batch does not match the number of input frames");
+    }
+
+    AllocStageScope stage(ALLOC_STAGE_POSTPROCESS);
+    TRACE_SCOPE("decode");
+    for (size_t b = 0; b < frames.size(); ++b)
+    {
+        decodeYoloOutput(net, detections, static_cast<int>(b), frames[b].size(), settings, out_detections[b]);
+    }
+}
+
+void prepareYoloBlob(const cv::Mat &frame, cv::Mat &out_blob, const YoloSettings &settings)
+{
+    AllocStageScope stage(ALLOC_STAGE_PREPROCESS);
+    TRACE_SCOPE("preprocess");
+    cv::dnn::blobFromImage(frame, out_blob, 1.0 / 255.0, cv::Size(settings.input_width, settings.input_height), cv::Scalar(), true, false);
+}
 
-    for (int i = 0; i < num_proposals; ++i)
-    {                                                                                // Iterate over each proposal column
-        cv::Mat proposal_scores = detection_matrix.col(i).rowRange(4, num_channels); // Class scores start from 5th row (index 4)
-        cv::Point class_id_point;
-        double max_score;
-        cv::minMaxLoc(proposal_scores, nullptr, &max_score, nullptr, &class_id_point);
+void detectObjectsWithYOLOBlobs(const std::vector<cv::Mat> &blobs, const std::vector<cv::Size> &frame_sizes, cv::dnn::Net &net, std::vector<std::vector<Detection>> &out_detections, const YoloSettings &settings)
+{
+    out_detections.assign(blobs.size(), std::vector<Detection>());
+    if (blobs.empty() || net.empty())
+        return;
+    CV_Assert(blobs.size() == frame_sizes.size());
 
-        if (max_score > CONFIDENCE_THRESHOLD)
+    AllocStageScope preprocess_stage(ALLOC_STAGE_PREPROCESS);
+    cv::Mat batch;
+    if (blobs.size() == 1)
+    {
+        batch = blobs[0];
+    }
+    else
+    {
+        // Each blob is one contiguous [1, 3, H, W] image; copy them back to back
+        const int shape[] = {static_cast<int>(blobs.size()), 3, settings.input_height, settings.input_width};
+        batch.create(4, shape, CV_32F);
+        const size_t image_bytes = batch.total() / blobs.size() * batch.elemSize();
+        for (size_t b = 0; b < blobs.size(); ++b)
         {
-            confidences.push_back((float)max_score);
-            class_ids.push_back(class_id_point.y); // class_id_point.y is the index relative to proposal_scores
+            CV_Assert(blobs[b].isContinuous() && blobs[b].total() * blobs[b].elemSize() == image_bytes);
+            memcpy(batch.ptr<uchar>() + b * image_bytes, blobs[b].ptr<uchar>(), image_bytes);
+        }
+    }
+    net.setInput(batch);
 
-            // Box coordinates are cx, cy, w, h
-            float cx = detection_matrix.at<float>(0, i);
-            float cy = detection_matrix.at<float>(1, i);
-            float w = detection_matrix.at<float>(2, i);
-            float h = detection_matrix.at<float>(3, i);
+    std::vector<cv::Mat> outs;
+    {
+        AllocStageScope stage(ALLOC_STAGE_INFERENCE);
+        TRACE_SCOPE("forward");
+        net.forward(outs, net.getUnconnectedOutLayersNames());
+    }
 
-            int left = static_cast<int>((cx - w / 2) * x_factor);
-            int top = static_cast<int>((cy - h / 2) * y_factor);
-            int width = static_cast<int>(w * x_factor);
-            int height = static_cast<int>(h * y_factor);
+    cv::Mat detections = outs[0];
+    if (detections.dims != 3 || detections.size[0] != static_cast<int>(blobs.size()))
+    {
+        CV_Error(cv::Error::StsUnmatchedSizes, "YOLO: model output batch does not match the number of input blobs");
+    }
+    AllocStageScope stage(ALLOC_STAGE_POSTPROCESS);
+    TRACE_SCOPE("decode");
+    for (size_t b = 0; b < blobs.size(); ++b)
+    {
+        decodeYoloOutput(net, detections, static_cast<int>(b), frame_sizes[b], settings, out_detections[b]);
+    }
+}
 
-            boxes.push_back(cv::Rect(left, top, width, height));
+std::vector<int> prepareYoloInputSizes(cv::dnn::Net &net, const std::vector<int> &input_sizes)
+{
+    std::vector<int> supported;
+    for (int size : input_sizes)
+    {
+        try
+        {
+            cv::Mat blank(size, size, CV_8UC3, cv::Scalar(114, 114, 114));
+            YoloSettings settings;
+            settings.input_width = size;
+            settings.input_height = size;
+            std::vector<Detection> detections;
+            detectObjectsWithYOLO(blank, net, detections, settings);
+            supported.push_back(size);
+        }
+        catch (const cv::Exception &e)
+        {
+            LOG("YOLO: input size " << size << " is not supported by this model, skipping it.");
         }
     }
+    return supported;
+}
 
-    std::vector<int> nms_indices;
-    cv::dnn::NMSBoxes(boxes, confidences, CONFIDENCE_THRESHOLD, NMS_THRESHOLD, nms_indices);
-
-    for (int idx : nms_indices)
+bool buildClassFilter(const std::vector<std::string> &class_names_list, const std::vector<std::string> &wanted_names, std::vector<int> &out_class_ids)
+{
+    out_class_ids.clear();
+    bool all_found = true;
+    for (const std::string &name : wanted_names)
     {
-        cv::Rect box = boxes[idx];
-        int class_id = class_ids[idx];
+        auto it = std::find(class_names_list.begin(), class_names_list.end(), name);
+        if (it == class_names_list.end())
+        {
+            LOG_ERR("YOLO: class filter name not found in class names: " << name);
+            all_found = false;
+            continue;
+        }
+        out_class_ids.push_back(static_cast<int>(it - class_names_list.begin()));
+    }
+    std::sort(out_class_ids.begin(), out_class_ids.end());
+    out_class_ids.erase(std::unique(out_class_ids.begin(), out_class_ids.end()), out_class_ids.end());
+    return all_found && !out_class_ids.empty();
+}
 
-        cv::rectangle(frame, box, cv::Scalar(0, 255, 0), 2);
-        std::string label = (class_id < class_names_list.size()) ? class_names_list[class_id] : "Unknown";
-        label += cv::format(": %.2f", confidences[idx]);
-        cv::putText(frame, label, cv::Point(box.x, box.y - 10), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
+void drawDetections(cv::Mat &frame, const std::vector<Detection> &detections, const std::vector<std::string> &class_names_list)
+{
+    for (const Detection &det : detections)
+    {
+        cv::rectangle(frame, det.box, cv::Scalar(0, 255, 0), 2);
+        std::string label = (det.class_id >= 0 && det.class_id < static_cast<int>(class_names_list.size())) ? class_names_list[det.class_id] : "Unknown";
+        label += cv::format(": %.2f", det.confidence);
+        cv::putText(frame, label, cv::Point(det.box.x, det.box.y - 10), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
     }
+}
+
+void processFrameWithYOLO(cv::Mat &frame, cv::dnn::Net &net, const std::vector<std::string> &class_names_list)
+{
+    std::vector<Detection> detections;
+    detectObjectsWithYOLO(frame, net, detections);
+    drawDetections(frame, detections, class_names_list);
+}
+
+
+bool probeYoloOutputLayout(cv::dnn::Net &net, int input_width, int input_height, YoloOutputInfo &out_info)
+{
+    cv::Mat blank(input_height, input_width, CV_8UC3, cv::Scalar(114, 114, 114));
+    cv::Mat blob;
+    cv::dnn::blobFromImage(blank, blob, 1.0 / 255.0, cv::Size(input_width, input_height), cv::Scalar(), true, false);
+    net.setInput(blob);
+
+    std::vector<cv::Mat> outs;
+    net.forward(outs, net.getUnconnectedOutLayersNames());
+    if (outs.empty())
+        return false;
+
+    out_info = describeYoloOutput(outs[0], input_width, input_height);
+    return out_info.layout != YoloOutputLayout::Unknown;
 }
\ No newline at end of file
@@ -12,6 +12,47 @@ const float NMS_THRESHOLD = 0.4f;
 const int YOLO_INPUT_WIDTH = 640;
 const int YOLO_INPUT_HEIGHT = 640;
 
+// Runtime detection parameters; defaults match the compile-time constants above
+struct YoloSettings
+{
+    int input_width = YOLO_INPUT_WIDTH;
+    int input_height = YOLO_INPUT_HEIGHT;
+    float confidence_threshold = CONFIDENCE_THRESHOLD;
+    float nms_threshold = NMS_THRESHOLD;
+    // Class ids to decode; empty decodes every class. Only these score rows are read.
+    std::vector<int> class_filter;
+};
+
+struct Detection
+{
+    int class_id = -1;
+    float confidence = 0.0f;
+    cv::Rect box; // In frame pixel coordinates
+};
+
 void processFrameWithYOLO(cv::Mat &frame, cv::dnn::Net &net, const std::vector<std::string> &class_names_list);
+void detectObjectsWithYOLO(const cv::Mat &frame, cv::dnn::Net &net, std::vector<Detection> &out_detections, const YoloSettings &settings = YoloSettings());
+// Runs all frames through one forward pass. Throws cv::Exception if the model has a fixed batch size of 1.
+void detectObjectsWithYOLOBatch(const std::vector<cv::Mat> &frames, cv::dnn::Net &net, std::vector<std::vector<Detection>> &out_detections, const YoloSettings &settings = YoloSettings());
+// The two halves of detectObjectsWithYOLOBatch, so preprocessing can run on other threads than
+// inference: prepareYoloBlob turns one BGR frame into a [1, 3, H, W] input blob, and
+// detectObjectsWithYOLOBlobs stacks such blobs into one batch and runs it. frame_sizes are the
+// original frame sizes the boxes are scaled back to. Throws cv::Exception like the batch call.
+void prepareYoloBlob(const cv::Mat &frame, cv::Mat &out_blob, const YoloSettings &settings = YoloSettings());
+void detectObjectsWithYOLOBlobs(const std::vector<cv::Mat> &blobs, const std::vector<cv::Size> &frame_sizes, cv::dnn::Net &net, std::vector<std::vector<Detection>> &out_detections, const YoloSettings &settings = YoloSettings());
+// Runs one warm-up forward pass per square input size so later switches do not pay first-use
+// allocation. Models exported with a fixed input shape reject other sizes; only the sizes that
+// worked are returned.
+std::vector<int> prepareYoloInputSizes(cv::dnn::Net &net, const std::vector<int> &input_sizes);
+// Resolves class names (e.g. "person", "login_button") to ids for YoloSettings::class_filter.
+// Returns false if any name is unknown or nothing matched.
+bool buildClassFilter(const std::vector<std::string> &class_names_list, const std::vector<std::string> &wanted_names, std::vector<int> &out_class_ids);
+void drawDetections(cv::Mat &frame, const std::vector<Detection> &detections, const std::vector<std::string> &class_names_list);
 bool loadClassNames(const std::string &path, std::vector<std::string> &class_names_out);
+// The steps of setupYoloNetwork, for callers that overlap them with other startup work:
+// loading needs no hardware information, and the warm-up forward pass (lazy kernel
+// compilation, output layout check) can run while capture is being initialized.
+bool loadYoloNetwork(cv::dnn::Net &net, const std::string &model_path);
+void configureYoloBackend(cv::dnn::Net &net, const HARDWARE_INFO &hw_info);
+bool warmUpYoloNetwork(cv::dnn::Net &net, const std::vector<std::string> &class_names_list);
 bool setupYoloNetwork(cv::dnn::Net &net, const std::string &model_path, const std::string &class_names_path, std::vector<std::string> &out_class_names_vec, HARDWARE_INFO &hw_info);
\ No newline at end of file
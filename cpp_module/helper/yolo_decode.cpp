@@ -0,0 +1,307 @@
+#include "yolo_decode.hpp"
+#include "vision_kernels.hpp"
+#include <algorithm>
+
+// Classes in the COCO-trained models shipped under models/yolo
+const int COCO_CLASS_COUNT = 80;
+
+// NC > 0 fixes the class count at compile time so the class loops have a constant trip count
+template <int NC>
+static inline int classCount(const YoloOutputInfo &info)
+{
+    if constexpr (NC > 0)
+        return NC;
+    else
+        return info.num_classes;
+}
+
+static void finishDetections(const std::vector<cv::Rect> &boxes, const std::vector<float> &confidences, const std::vector<int> &class_ids,
+                             const YoloSettings &settings, bool run_nms, std::vector<Detection> &out_detections)
+{
+    out_detections.clear();
+    std::vector<int> keep;
+    if (run_nms)
+    {
+        cv::dnn::NMSBoxes(boxes, confidences, settings.confidence_threshold, settings.nms_threshold, keep);
+    }
+    else
+    {
+        keep.resize(boxes.size());
+        for (size_t i = 0; i < keep.size(); ++i)
+            keep[i] = static_cast<int>(i);
+    }
+
+    for (int idx : keep)
+    {
+        Detection det;
+        det.class_id = class_ids[idx];
+        det.confidence = confidences[idx];
+        det.box = boxes[idx];
+        out_detections.push_back(det);
+    }
+}
+
+// [4 + C, N]: walk the class rows rather than the proposal columns. Each row is contiguous
+// in memory, and with a class filter only the selected rows are read at all.
+template <int NC>
+static void decodeV8(const float *data, const YoloOutputInfo &info, const cv::Size &frame_size, const YoloSettings &settings, std::vector<Detection> &out_detections)
+{
+    const int num_classes = classCount<NC>(info);
+    const int num_proposals = info.num_proposals;
+    const float x_factor = frame_size.width / (float)settings.input_width;
+    const float y_factor = frame_size.height / (float)settings.input_height;
+
+    thread_local std::vector<float> best_scores;
+    thread_local std::vector<int> best_classes;
+    best_scores.assign(num_proposals, 0.0f);
+    best_classes.assign(num_proposals, -1);
+
+    const VisionKernels &kernels = visionKernels();
+    auto scanClassRow = [&](int class_id)
+    {
+        const float *row = data + static_cast<size_t>(4 + class_id) * num_proposals; // Class scores start from 5th row (index 4)
+        kernels.update_class_argmax(row, num_proposals, class_id, best_scores.data(), best_classes.data());
+    };
+
+    if (settings.class_filter.empty())
+    {
+        for (int c = 0; c < num_classes; ++c)
+            scanClassRow(c);
+    }
+    else
+    {
+        for (int c : settings.class_filter)
+        {
+            if (c >= 0 && c < num_classes)
+                scanClassRow(c);
+        }
+    }
+
+    std::vector<int> class_ids;
+    std::vector<float> confidences;
+    std::vector<cv::Rect> boxes;
+    const float *row_cx = data;
+    const float *row_cy = data + num_proposals;
+    const float *row_w = data + 2 * num_proposals;
+    const float *row_h = data + 3 * num_proposals;
+    for (int i = 0; i < num_proposals; ++i)
+    {
+        // Early out: box coordinates are only read for proposals that pass the threshold
+        if (best_scores[i] <= settings.confidence_threshold)
+            continue;
+
+        confidences.push_back(best_scores[i]);
+        class_ids.push_back(best_classes[i]);
+
+        // Box coordinates are cx, cy, w, h
+        float cx = row_cx[i];
+        float cy = row_cy[i];
+        float w = row_w[i];
+        float h = row_h[i];
+
+        int left = static_cast<int>((cx - w / 2) * x_factor);
+        int top = static_cast<int>((cy - h / 2) * y_factor);
+        int width = static_cast<int>(w * x_factor);
+        int height = static_cast<int>(h * y_factor);
+
+        boxes.push_back(cv::Rect(left, top, width, height));
+    }
+
+    finishDetections(boxes, confidences, class_ids, settings, true, out_detections);
+}
+
+// [N, 5 + C]: one contiguous record per proposal. Objectness gates the class scan, and the
+// final confidence is objectness times the best class score.
+template <int NC>
+static void decodeV5(const float *data, const YoloOutputInfo &info, const cv::Size &frame_size, const YoloSettings &settings, std::vector<Detection> &out_detections)
+{
+    const int num_classes = classCount<NC>(info);
+    const int record_size = 5 + num_classes;
+    const float x_factor = frame_size.width / (float)settings.input_width;
+    const float y_factor = frame_size.height / (float)settings.input_height;
+
+    std::vector<int> class_ids;
+    std::vector<float> confidences;
+    std::vector<cv::Rect> boxes;
+    for (int i = 0; i < info.num_proposals; ++i)
+    {
+        const float *record = data + static_cast<size_t>(i) * record_size;
+        const float objectness = record[4];
+        if (objectness <= settings.confidence_threshold)
+            continue;
+
+        const float *scores = record + 5;
+        float best_score = 0.0f;
+        int best_class = -1;
+        if (settings.class_filter.empty())
+        {
+            for (int c = 0; c < num_classes; ++c)
+            {
+                if (scores[c] > best_score)
+                {
+                    best_score = scores[c];
+                    best_class = c;
+                }
+            }
+        }
+        else
+        {
+            for (int c : settings.class_filter)
+            {
+                if (c >= 0 && c < num_classes && scores[c] > best_score)
+                {
+                    best_score = scores[c];
+                    best_class = c;
+                }
+            }
+        }
+
+        const float confidence = objectness * best_score;
+        if (best_class < 0 || confidence <= settings.confidence_threshold)
+            continue;
+
+        confidences.push_back(confidence);
+        class_ids.push_back(best_class);
+
+        float cx = record[0];
+        float cy = record[1];
+        float w = record[2];
+        float h = record[3];
+        boxes.push_back(cv::Rect(static_cast<int>((cx - w / 2) * x_factor), static_cast<int>((cy - h / 2) * y_factor),
+                                 static_cast<int>(w * x_factor), static_cast<int>(h * y_factor)));
+    }
+
+    finishDetections(boxes, confidences, class_ids, settings, true, out_detections);
+}
+
+// [K, 6]: boxes are already suppressed inside the model, so only thresholding and scaling remain
+static void decodeEndToEnd(const float *data, const YoloOutputInfo &info, const cv::Size &frame_size, const YoloSettings &settings, std::vector<Detection> &out_detections)
+{
+    const float x_factor = frame_size.width / (float)settings.input_width;
+    const float y_factor = frame_size.height / (float)settings.input_height;
+
+    std::vector<int> class_ids;
+    std::vector<float> confidences;
+    std::vector<cv::Rect> boxes;
+    for (int k = 0; k < info.num_proposals; ++k)
+    {
+        const float *record = data + static_cast<size_t>(k) * 6;
+        const float score = record[4];
+        if (score <= settings.confidence_threshold)
+            continue;
+
+        const int class_id = static_cast<int>(record[5]);
+        if (!settings.class_filter.empty() &&
+            std::find(settings.class_filter.begin(), settings.class_filter.end(), class_id) == settings.class_filter.end())
+            continue;
+
+        confidences.push_back(score);
+        class_ids.push_back(class_id);
+        int left = static_cast<int>(record[0] * x_factor);
+        int top = static_cast<int>(record[1] * y_factor);
+        int right = static_cast<int>(record[2] * x_factor);
+        int bottom = static_cast<int>(record[3] * y_factor);
+        boxes.push_back(cv::Rect(left, top, right - left, bottom - top));
+    }
+
+    finishDetections(boxes, confidences, class_ids, settings, false, out_detections);
+}
+
+YoloOutputInfo describeYoloOutput(const cv::Mat &output, int input_width, int input_height)
+{
+    YoloOutputInfo info;
+    if (output.dims != 3 || output.type() != CV_32F)
+        return info;
+
+    const int rows = output.size[1];
+    const int cols = output.size[2];
+    const int anchor_free_count = yoloProposalCount(input_width, input_height, 1);
+    const int anchor_based_count = yoloProposalCount(input_width, input_height, 3);
+
+    // Exact proposal counts for a P3-P5 grid are unambiguous
+    if (cols == anchor_free_count && rows > 4)
+    {
+        info.layout = YoloOutputLayout::V8;
+        info.num_classes = rows - 4;
+        info.num_proposals = cols;
+    }
+    else if (rows == anchor_based_count && cols > 5)
+    {
+        info.layout = YoloOutputLayout::V5;
+        info.num_classes = cols - 5;
+        info.num_proposals = rows;
+    }
+    else if (cols == 6)
+    {
+        // A single-class v5 head at a non-standard grid would also end up here
+        info.layout = YoloOutputLayout::EndToEnd;
+        info.num_proposals = rows;
+    }
+    // Other grids (P6 heads, stretched inputs): proposals outnumber channels
+    else if (rows > 4 && rows < cols)
+    {
+        info.layout = YoloOutputLayout::V8;
+        info.num_classes = rows - 4;
+        info.num_proposals = cols;
+    }
+    else if (cols > 5 && rows > cols)
+    {
+        info.layout = YoloOutputLayout::V5;
+        info.num_classes = cols - 5;
+        info.num_proposals = rows;
+    }
+    return info;
+}
+
+bool matchYoloOutput(const YoloOutputInfo &known, const cv::Mat &output, YoloOutputInfo &out_info)
+{
+    if (output.dims != 3 || output.type() != CV_32F)
+        return false;
+    const int rows = output.size[1];
+    const int cols = output.size[2];
+    out_info = known;
+    switch (known.layout)
+    {
+    case YoloOutputLayout::V8:
+        out_info.num_proposals = cols;
+        return rows == known.num_classes + 4;
+    case YoloOutputLayout::V5:
+        out_info.num_proposals = rows;
+        return cols == known.num_classes + 5;
+    case YoloOutputLayout::EndToEnd:
+        out_info.num_proposals = rows;
+        return cols == 6;
+    default:
+        return false;
+    }
+}
+
+YoloDecodeFn selectYoloDecoder(const YoloOutputInfo &info)
+{
+    switch (info.layout)
+    {
+    case YoloOutputLayout::V8:
+        return info.num_classes == COCO_CLASS_COUNT ? &decodeV8<COCO_CLASS_COUNT> : &decodeV8<0>;
+    case YoloOutputLayout::V5:
+        return info.num_classes == COCO_CLASS_COUNT ? &decodeV5<COCO_CLASS_COUNT> : &decodeV5<0>;
+    case YoloOutputLayout::EndToEnd:
+        return &decodeEndToEnd;
+    default:
+        return nullptr;
+    }
+}
+
+const char *yoloOutputLayoutName(YoloOutputLayout layout)
+{
+    switch (layout)
+    {
+    case YoloOutputLayout::V8:
+        return "YOLOv8 [4+C, N]";
+    case YoloOutputLayout::V5:
+        return "YOLOv5 [N, 5+C]";
+    case YoloOutputLayout::EndToEnd:
+        return "end-to-end [K, 6]";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include "yolo.hpp"
+
+// Output tensor layouts produced by the YOLO exports we load
+enum class YoloOutputLayout
+{
+    Unknown,
+    V8,        // [batch, 4 + C, N]: cx, cy, w, h rows then one score row per class (YOLOv8/v11)
+    V5,        // [batch, N, 5 + C]: cx, cy, w, h, objectness, class scores per proposal (YOLOv5/v7)
+    EndToEnd,  // [batch, K, 6]: x1, y1, x2, y2, score, class after in-model NMS (YOLOv10, end2end exports)
+};
+
+struct YoloOutputInfo
+{
+    YoloOutputLayout layout = YoloOutputLayout::Unknown;
+    int num_classes = 0;
+    int num_proposals = 0;
+};
+
+// Detection head strides of the P3-P5 exports
+constexpr std::array<int, 3> YOLO_STRIDES = {8, 16, 32};
+
+// Number of proposals a P3-P5 head emits for an input size; anchor-based heads (v5) predict
+// three boxes per grid cell, anchor-free heads (v8) one.
+constexpr int yoloProposalCount(int input_width, int input_height, int anchors_per_cell)
+{
+    int count = 0;
+    for (int stride : YOLO_STRIDES)
+        count += ((input_width + stride - 1) / stride) * ((input_height + stride - 1) / stride);
+    return count * anchors_per_cell;
+}
+
+static_assert(yoloProposalCount(640, 640, 1) == 8400, "YOLOv8 grid at 640 must have 8400 proposals");
+static_assert(yoloProposalCount(640, 640, 3) == 25200, "YOLOv5 grid at 640 must have 25200 proposals");
+
+// Decodes one image's output into NMS-filtered detections in frame coordinates
+typedef void (*YoloDecodeFn)(const float *data, const YoloOutputInfo &info, const cv::Size &frame_size, const YoloSettings &settings, std::vector<Detection> &out_detections);
+
+// Identifies the layout of a [batch, rows, cols] output tensor produced for the given input size.
+// Returns an Unknown layout if the shape matches none of them.
+YoloOutputInfo describeYoloOutput(const cv::Mat &output, int input_width, int input_height);
+
+// Whether output still has the layout and class count of known, e.g. after the input size changed;
+// out_info then carries the proposal count of this output
+bool matchYoloOutput(const YoloOutputInfo &known, const cv::Mat &output, YoloOutputInfo &out_info);
+
+// Picks the decoder specialized for the layout; COCO-sized heads get a decoder with the class
+// count fixed at compile time. Returns nullptr for an Unknown layout.
+YoloDecodeFn selectYoloDecoder(const YoloOutputInfo &info);
+
+// Runs one forward pass on a blank frame and identifies the network's output layout.
+// Throws cv::Exception if the forward pass fails.
+bool probeYoloOutputLayout(cv::dnn::Net &net, int input_width, int input_height, YoloOutputInfo &out_info);
+
+const char *yoloOutputLayoutName(YoloOutputLayout layout);
@@ -0,0 +1,88 @@
+import argparse
+import string
+
+import torch
+from torch import nn
+
+HASH_DIM = 512  # INTENT_HASH_DIM in cpp_module/helper/intent_classifier.hpp
+
+
+def tokenize(text: str) -> list:
+    """Same words as tokenizeCommand(): split on blanks, strip punctuation, ASCII lower case."""
+    words = []
+    for token in text.split():
+        word = token.strip(string.punctuation).translate(str.maketrans(string.ascii_uppercase, string.ascii_lowercase))
+        if word:
+            words.append(word)
+    return words
+
+
+def fnv1a(text: str) -> int:
+    value = 2166136261
+    for byte in text.encode("utf-8"):
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def hash_features(words: list) -> torch.Tensor:
+    """Same features as hashIntentFeatures(): hashed words and word pairs, L2-normalized."""
+    features = torch.zeros(HASH_DIM)
+    for i, word in enumerate(words):
+        features[fnv1a(word) % HASH_DIM] += 1.0
+        if i + 1 < len(words):
+            features[fnv1a(word + " " + words[i + 1]) % HASH_DIM] += 1.0
+    norm = features.norm()
+    return features / norm if norm > 0 else features
+
+
+def load_examples(path: str) -> list:
+    examples = []
+    with open(path, "r", encoding="utf-8") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not line.strip() or line.startswith("#"):
+                continue
+            action, command = line.split("\t", 1)
+            examples.append((action.strip(), command))
+    return examples
+
+
+def train(examples: list, epochs: int, hidden: int) -> tuple:
+    labels = sorted({action for action, _ in examples})
+    inputs = torch.stack([hash_features(tokenize(command)) for _, command in examples])
+    targets = torch.tensor([labels.index(action) for action, _ in examples])
+
+    model = nn.Sequential(nn.Linear(HASH_DIM, hidden), nn.ReLU(), nn.Linear(hidden, len(labels)))
+    optimizer = torch.optim.Adam(model.parameters(), lr=1e-2, weight_decay=1e-4)
+    loss_fn = nn.CrossEntropyLoss()
+    for epoch in range(epochs):
+        optimizer.zero_grad()
+        loss = loss_fn(model(inputs), targets)
+        loss.backward()
+        optimizer.step()
+        if (epoch + 1) % 50 == 0:
+            accuracy = (model(inputs).argmax(dim=1) == targets).float().mean().item()
+            print(f"epoch {epoch + 1}: loss {loss.item():.4f}, training accuracy {accuracy:.2%}")
+    return model.eval(), labels
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Train the fallback intent classifier for the C++ IntentClassifier.")
+    parser.add_argument("--data", default="intents.tsv", help="action<TAB>command lines")
+    parser.add_argument("--output", default="intent.onnx")
+    parser.add_argument("--labels", default="intent_labels.txt")
+    parser.add_argument("--epochs", type=int, default=300)
+    parser.add_argument("--hidden", type=int, default=64)
+    args = parser.parse_args()
+
+    model, labels = train(load_examples(args.data), args.epochs, args.hidden)
+    # Logits out; the C++ side applies the softmax
+    torch.onnx.export(model, torch.zeros(1, HASH_DIM), args.output, input_names=["features"], output_names=["logits"], opset_version=11)
+    with open(args.labels, "w", encoding="utf-8") as f:
+        f.write("\n".join(labels) + "\n")
+    print(f"Wrote {args.output} and {args.labels} ({len(labels)} intents)")
+
+
+if __name__ == "__main__":
+    main()
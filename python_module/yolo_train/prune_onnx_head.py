@@ -0,0 +1,201 @@
+import argparse
+
+import numpy as np
+import onnx
+from onnx import helper, numpy_helper
+
+
+def load_class_names(path: str) -> list:
+    with open(path, "r") as f:
+        return [line.strip() for line in f if line.strip()]
+
+
+def _initializer_map(graph) -> dict:
+    return {init.name: init for init in graph.initializer}
+
+
+def _replace_initializer(graph, name: str, array: np.ndarray):
+    for i, init in enumerate(graph.initializer):
+        if init.name == name:
+            graph.initializer[i].CopyFrom(numpy_helper.from_array(array, name))
+            return
+
+
+def prune_with_gather(model, keep_ids: list, nc: int):
+    """
+    Append a Gather on the channel axis so the output is [1, 4 + len(keep_ids), N].
+    Works for any YOLOv8/11 export; only the output tensor and the decode shrink.
+    """
+    graph = model.graph
+    output = graph.output[0]
+    channels = [0, 1, 2, 3] + [4 + c for c in keep_ids]
+
+    indices_name = output.name + "_class_indices"
+    graph.initializer.append(numpy_helper.from_array(np.array(channels, dtype=np.int64), indices_name))
+
+    pruned_name = output.name + "_pruned"
+    graph.node.append(helper.make_node("Gather", [output.name, indices_name], [pruned_name], axis=1))
+
+    dims = [d.dim_value if d.HasField("dim_value") else d.dim_param for d in output.type.tensor_type.shape.dim]
+    if len(dims) == 3:
+        dims[1] = len(channels)
+    new_output = helper.make_tensor_value_info(pruned_name, output.type.tensor_type.elem_type, dims)
+    graph.output.remove(output)
+    graph.output.insert(0, new_output)
+
+
+def find_class_convs(graph, nc: int, reg_channels: int = 64) -> list:
+    """
+    The last convolution of each class branch (cv3), found from the graph: per detection scale
+    the head concatenates the box branch output (reg_channels) with the class branch output
+    (nc) on the channel axis. Intermediate class branch convolutions can have nc channels too
+    (yolo11n has 80), so the channel count alone does not identify them.
+    """
+    inits = _initializer_map(graph)
+    producers = {output: node for node in graph.node for output in node.output}
+
+    def conv_channels(name):
+        node = producers.get(name)
+        if node is None or node.op_type != "Conv" or node.input[1] not in inits:
+            return None, None
+        return node, numpy_helper.to_array(inits[node.input[1]]).shape
+
+    class_convs = []
+    for node in graph.node:
+        if node.op_type != "Concat" or len(node.input) != 2:
+            continue
+        axis = next((attr.i for attr in node.attribute if attr.name == "axis"), None)
+        if axis != 1:
+            continue
+        (box, box_shape), (cls, cls_shape) = conv_channels(node.input[0]), conv_channels(node.input[1])
+        if box is None or cls is None:
+            continue
+        if box_shape[0] == reg_channels and cls_shape[0] == nc and cls_shape[2:] == (1, 1):
+            class_convs.append(cls)
+    return class_convs
+
+
+def prune_class_convs(model, keep_ids: list, nc: int, reg_channels: int = 64):
+    """
+    Slice the final 1x1 class convolutions (see find_class_convs) down to the kept classes and
+    patch the Split/Reshape constants that carry nc, so the classification head itself does
+    less work. Returns the number of convolutions rewritten.
+    """
+    graph = model.graph
+    inits = _initializer_map(graph)
+    keep = np.array(keep_ids, dtype=np.int64)
+    rewritten = 0
+
+    for node in find_class_convs(graph, nc, reg_channels):
+        weight = numpy_helper.to_array(inits[node.input[1]])
+        _replace_initializer(graph, node.input[1], weight[keep])
+        if len(node.input) > 2 and node.input[2] in inits:
+            bias = numpy_helper.to_array(inits[node.input[2]])
+            _replace_initializer(graph, node.input[2], bias[keep])
+        rewritten += 1
+
+    # Split sizes [reg, nc] and reshape/slice constants containing reg + nc
+    old_total, new_total = reg_channels + nc, reg_channels + len(keep_ids)
+    for init in graph.initializer:
+        if init.data_type != onnx.TensorProto.INT64:
+            continue
+        values = numpy_helper.to_array(init)
+        if values.ndim != 1 or values.size > 4:
+            continue
+        patched = values.copy()
+        if values.tolist() == [reg_channels, nc]:
+            patched[1] = len(keep_ids)
+        elif old_total in values.tolist():
+            patched[values == old_total] = new_total
+        elif values.tolist() == [4, nc]:
+            patched[1] = len(keep_ids)
+        else:
+            continue
+        _replace_initializer(graph, init.name, patched)
+
+    for node in graph.node:
+        for attr in node.attribute:
+            if attr.name == "split" and list(attr.ints) == [reg_channels, nc]:
+                attr.ints[:] = [reg_channels, len(keep_ids)]
+            elif attr.name == "split" and list(attr.ints) == [4, nc]:
+                attr.ints[:] = [4, len(keep_ids)]
+
+    # Stale shape annotations would contradict the new channel count
+    del graph.value_info[:]
+    for dim in graph.output[0].type.tensor_type.shape.dim:
+        if dim.HasField("dim_value") and dim.dim_value == 4 + nc:
+            dim.dim_value = 4 + len(keep_ids)
+    return rewritten
+
+
+def verify(original_path: str, pruned_path: str, keep_ids: list, imgsz: int, atol: float):
+    """
+    Compare the pruned output against the matching channels of the original. Returns False on a
+    mismatch or a shape change; None when onnxruntime is missing and nothing was checked.
+    """
+    try:
+        import onnxruntime as ort
+    except ImportError:
+        print("onnxruntime not installed; verification SKIPPED, the pruned model was not checked")
+        return None
+
+    x = np.random.rand(1, 3, imgsz, imgsz).astype(np.float32)
+    ref_sess = ort.InferenceSession(original_path, providers=["CPUExecutionProvider"])
+    new_sess = ort.InferenceSession(pruned_path, providers=["CPUExecutionProvider"])
+    ref = ref_sess.run(None, {ref_sess.get_inputs()[0].name: x})[0]
+    out = new_sess.run(None, {new_sess.get_inputs()[0].name: x})[0]
+    expected = ref[:, [0, 1, 2, 3] + [4 + c for c in keep_ids], :]
+    if out.shape != expected.shape:
+        print(f"Verification FAILED: output {out.shape}, expected {expected.shape}")
+        return False
+    diff = float(np.abs(out - expected).max())
+    print(f"Output {ref.shape} -> {out.shape}, max abs diff {diff:.6f} (tolerance {atol})")
+    if not diff <= atol:
+        print("Verification FAILED: the pruned model does not reproduce the kept channels")
+        return False
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Rewrite a YOLO ONNX detection head to emit only selected classes.")
+    parser.add_argument("model", help="Input ONNX model")
+    parser.add_argument("names", help="Class names file, one per line")
+    parser.add_argument("--classes", required=True, help="Comma-separated class names to keep")
+    parser.add_argument("--output", default=None, help="Output model path (default: <model>_pruned.onnx)")
+    parser.add_argument("--mode", choices=["gather", "conv"], default="gather",
+                        help="gather: select output channels (any export); conv: slice the class convolutions")
+    parser.add_argument("--imgsz", type=int, default=640, help="Input size used for verification")
+    parser.add_argument("--atol", type=float, default=1e-4, help="Largest output difference verification accepts")
+    args = parser.parse_args()
+
+    names = load_class_names(args.names)
+    wanted = [c.strip() for c in args.classes.split(",") if c.strip()]
+    missing = [c for c in wanted if c not in names]
+    if missing:
+        raise SystemExit(f"Unknown classes: {', '.join(missing)}")
+    keep_ids = [names.index(c) for c in wanted]
+
+    output_path = args.output or args.model.replace(".onnx", "_pruned.onnx")
+    model = onnx.load(args.model)
+    if args.mode == "conv":
+        rewritten = prune_class_convs(model, keep_ids, len(names))
+        if rewritten == 0:
+            raise SystemExit("No class convolutions found; use --mode gather for this export")
+        print(f"Sliced {rewritten} class convolutions")
+    else:
+        prune_with_gather(model, keep_ids, len(names))
+    onnx.checker.check_model(model)
+    onnx.save(model, output_path)
+
+    # Class ids in the pruned model index into this list
+    names_path = output_path.replace(".onnx", ".names.txt")
+    with open(names_path, "w") as f:
+        f.write("\n".join(wanted) + "\n")
+    print(f"Saved {output_path} and {names_path}")
+
+    if verify(args.model, output_path, keep_ids, args.imgsz, args.atol) is False:
+        raise SystemExit(1)
+
+
+if __name__ == "__main__":
+    main()